@@ -0,0 +1,48 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "test.h"
+
+//
+// NOTE(koekeishiya): Benchmarks are built with optimizations and print one line per case.
+// They also validate their own results, so that a benchmark which got faster by doing less
+// work fails instead of reporting a better number.
+//
+
+static volatile uint64_t bench_sink;
+
+#define bench_check(x) \
+    do { \
+        if (!(x)) { \
+            fprintf(stderr, "%s:%d: %s: check failed: %s\n", __FILE__, __LINE__, __FUNCTION__, #x); \
+            exit(EXIT_FAILURE); \
+        } \
+    } while (0)
+
+static inline void bench_report(const char *name, uint64_t ops, uint64_t elapsed_ns)
+{
+    double seconds = (double) elapsed_ns / 1e9;
+    printf("%-48s %12llu ops %10.3f ms %14.1f ops/s %10.1f ns/op\n",
+           name, (unsigned long long) ops, seconds * 1e3,
+           seconds > 0 ? ops / seconds : 0.0,
+           ops ? (double) elapsed_ns / ops : 0.0);
+}
+
+static int bench_compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *) a;
+    uint64_t y = *(const uint64_t *) b;
+    return x < y ? -1 : x > y;
+}
+
+static inline void bench_report_latency(const char *name, uint64_t *samples, int count)
+{
+    qsort(samples, count, sizeof(uint64_t), bench_compare_u64);
+    printf("%-48s %12d samples p50 %8.1f us p99 %8.1f us max %8.1f us\n",
+           name, count,
+           samples[count / 2] / 1e3,
+           samples[(count * 99) / 100] / 1e3,
+           samples[count - 1] / 1e3);
+}
+
+#endif
@@ -0,0 +1,153 @@
+//
+// NOTE(koekeishiya): The chained table that misc/hashtable.h replaced, with its names prefixed
+// so that both can be linked into hashtable_bench. It is kept unchanged otherwise; it is the
+// baseline the open-addressing table is measured against.
+//
+
+#ifndef CHAINED_TABLE_H
+#define CHAINED_TABLE_H
+
+#define CHAINED_TABLE_HASH_FUNC(name) unsigned long name(void *key)
+typedef CHAINED_TABLE_HASH_FUNC(chained_table_hash_func);
+
+#define CHAINED_TABLE_COMPARE_FUNC(name) int name(void *key_a, void *key_b)
+typedef CHAINED_TABLE_COMPARE_FUNC(chained_table_compare_func);
+
+struct chained_bucket
+{
+    void *key;
+    void *value;
+    struct chained_bucket *next;
+};
+struct chained_table
+{
+    int count;
+    int capacity;
+    float max_load;
+    chained_table_hash_func *hash;
+    chained_table_compare_func *cmp;
+    struct chained_bucket **buckets;
+};
+
+void chained_table_init(struct chained_table *table, int capacity, chained_table_hash_func hash, chained_table_compare_func cmp);
+void chained_table_free(struct chained_table *table);
+
+#define chained_table_add(table, key, value) _chained_table_add(table, key, sizeof(*key), value)
+void _chained_table_add(struct chained_table *table, void *key, int key_size, void *value);
+void chained_table_remove(struct chained_table *table, void *key);
+void *chained_table_find(struct chained_table *table, void *key);
+
+#endif
+
+#ifdef CHAINED_TABLE_IMPLEMENTATION
+void chained_table_init(struct chained_table *table, int capacity, chained_table_hash_func hash, chained_table_compare_func cmp)
+{
+    table->count = 0;
+    table->capacity = capacity;
+    table->max_load = 0.75f;
+    table->hash = hash;
+    table->cmp = cmp;
+    table->buckets = malloc(sizeof(struct chained_bucket *) * capacity);
+    memset(table->buckets, 0, sizeof(struct chained_bucket *) * capacity);
+}
+
+void chained_table_free(struct chained_table *table)
+{
+    for (int i = 0; i < table->capacity; ++i) {
+        struct chained_bucket *next, *bucket = table->buckets[i];
+        while (bucket) {
+            next = bucket->next;
+            free(bucket->key);
+            free(bucket);
+            bucket = next;
+        }
+    }
+
+    if (table->buckets) {
+        free(table->buckets);
+        table->buckets = NULL;
+    }
+}
+
+static struct chained_bucket **
+chained_table_get_bucket(struct chained_table *table, void *key)
+{
+    struct chained_bucket **bucket = table->buckets + (table->hash(key) % table->capacity);
+    while (*bucket) {
+        if (table->cmp((*bucket)->key, key)) {
+            break;
+        }
+        bucket = &(*bucket)->next;
+    }
+    return bucket;
+}
+
+static void
+chained_table_rehash(struct chained_table *table)
+{
+    struct chained_bucket **old_buckets = table->buckets;
+    int old_capacity = table->capacity;
+
+    table->count = 0;
+    table->capacity = 2 * table->capacity;
+    table->buckets = malloc(sizeof(struct chained_bucket *) * table->capacity);
+    memset(table->buckets, 0, sizeof(struct chained_bucket *) * table->capacity);
+
+    for (int i = 0; i < old_capacity; ++i) {
+        struct chained_bucket *next_bucket, *old_bucket = old_buckets[i];
+        while (old_bucket) {
+            struct chained_bucket **new_bucket = chained_table_get_bucket(table, old_bucket->key);
+            *new_bucket = malloc(sizeof(struct chained_bucket));
+            (*new_bucket)->key = old_bucket->key;
+            (*new_bucket)->value = old_bucket->value;
+            (*new_bucket)->next = NULL;
+            ++table->count;
+            next_bucket = old_bucket->next;
+            free(old_bucket);
+            old_bucket = next_bucket;
+        }
+    }
+
+    free(old_buckets);
+}
+
+void _chained_table_add(struct chained_table *table, void *key, int key_size, void *value)
+{
+    struct chained_bucket **bucket = chained_table_get_bucket(table, key);
+    if (*bucket) {
+        if (!(*bucket)->value) {
+            (*bucket)->value = value;
+        }
+    } else {
+        *bucket = malloc(sizeof(struct chained_bucket));
+        (*bucket)->key = malloc(key_size);
+        (*bucket)->value = value;
+        memcpy((*bucket)->key, key, key_size);
+        (*bucket)->next = NULL;
+        ++table->count;
+
+        float load = (1.0f * table->count) / table->capacity;
+        if (load > table->max_load) {
+            chained_table_rehash(table);
+        }
+    }
+}
+
+void chained_table_remove(struct chained_table *table, void *key)
+{
+    struct chained_bucket *next, **bucket = chained_table_get_bucket(table, key);
+    if (*bucket) {
+        free((*bucket)->key);
+        next = (*bucket)->next;
+        free(*bucket);
+        *bucket = next;
+        --table->count;
+    }
+}
+
+void *chained_table_find(struct chained_table *table, void *key)
+{
+    struct chained_bucket *bucket = *chained_table_get_bucket(table, key);
+    return bucket ? bucket->value : NULL;
+}
+#endif
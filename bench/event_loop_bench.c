@@ -0,0 +1,240 @@
+#include "bench.h"
+#include "event_loop_harness.h"
+
+#define MAX_PRODUCERS 16
+#define EVENTS        2000000
+
+static struct event_loop g_event_loop;
+
+static volatile uint64_t handled;
+static volatile uint64_t out_of_order;
+static int last_seen[MAX_PRODUCERS];
+
+static uint32_t sequence_handler(enum event_type type, void *context, int param1)
+{
+    int producer = param1 >> 24;
+    int sequence = param1 & 0xffffff;
+
+    if (sequence != last_seen[producer] + 1) ++out_of_order;
+    last_seen[producer] = sequence;
+
+    __atomic_add_fetch(&handled, 1, __ATOMIC_RELEASE);
+    return EVENT_SUCCESS;
+}
+
+struct producer
+{
+    pthread_t thread;
+    int id;
+    int count;
+};
+
+static void *producer_main(void *context)
+{
+    struct producer *producer = context;
+
+    for (int i = 0; i < producer->count; ++i) {
+        event_loop_post(&g_event_loop, WINDOW_FOCUSED, NULL, (producer->id << 24) | i, NULL);
+    }
+
+    return NULL;
+}
+
+//
+// NOTE(koekeishiya): Producers post as fast as they can, so the queue is full most of the time
+// and every path of event_loop_post is exercised: the lock-free push, the retry throttle and the
+// overflow list. The consumer validates that every event arrives exactly once and in the order
+// its producer posted it.
+//
+
+static void bench_producers(int producer_count)
+{
+    char name[64];
+    struct producer producers[MAX_PRODUCERS];
+    int per_producer = EVENTS / producer_count;
+    uint64_t total = (uint64_t) per_producer * producer_count;
+
+    handled = 0;
+    out_of_order = 0;
+    for (int i = 0; i < producer_count; ++i) last_seen[i] = -1;
+
+    harness_handler = sequence_handler;
+    bench_check(event_loop_init(&g_event_loop));
+    event_loop_begin(&g_event_loop);
+
+    uint64_t start = test_now_ns();
+    for (int i = 0; i < producer_count; ++i) {
+        producers[i].id = i;
+        producers[i].count = per_producer;
+        pthread_create(&producers[i].thread, NULL, producer_main, &producers[i]);
+    }
+
+    for (int i = 0; i < producer_count; ++i) {
+        pthread_join(producers[i].thread, NULL);
+    }
+
+    while (__atomic_load_n(&handled, __ATOMIC_ACQUIRE) < total) usleep(50);
+    uint64_t elapsed = test_now_ns() - start;
+
+    bench_check(handled == total);
+    bench_check(out_of_order == 0);
+    bench_check(g_event_loop.stats.dropped == 0);
+    for (int i = 0; i < producer_count; ++i) bench_check(last_seen[i] == per_producer - 1);
+
+    snprintf(name, sizeof(name), "mpmc post/handle %2d producers", producer_count);
+    bench_report(name, total, elapsed);
+    printf("%-48s stalled %llu overflowed %llu\n", "",
+           (unsigned long long) g_event_loop.stats.stalled,
+           (unsigned long long) g_event_loop.stats.overflowed);
+
+    event_loop_end(&g_event_loop);
+    harness_event_loop_destroy(&g_event_loop);
+}
+
+static void bench_queue_single_thread(void)
+{
+    struct queue queue;
+    struct event event = {0};
+    uint64_t sum = 0, expected = 0;
+    int rounds = EVENTS / EVENT_QUEUE_SIZE;
+
+    bench_check(queue_init(&queue));
+
+    uint64_t start = test_now_ns();
+    for (int round = 0; round < rounds; ++round) {
+        for (int i = 0; i < EVENT_QUEUE_SIZE; ++i) {
+            event.param1 = i;
+            queue_push(&queue, &event);
+        }
+
+        while (queue_pop(&queue, &event)) sum += event.param1;
+    }
+    uint64_t elapsed = test_now_ns() - start;
+
+    for (int i = 0; i < EVENT_QUEUE_SIZE; ++i) expected += i;
+    bench_check(sum == expected * rounds);
+
+    bench_report("mpmc push/pop uncontended", (uint64_t) rounds * EVENT_QUEUE_SIZE, elapsed);
+    free(queue.slots);
+}
+
+//
+// NOTE(koekeishiya): A wakeup is one sem_wait that returned because a producer rang the
+// semaphore. Ringing it for every event, as the loop used to, costs exactly one wakeup per
+// event; a burst that arrives while the consumer is busy should cost one wakeup in total. The
+// first event of every burst holds the consumer until the whole burst has been posted, so the
+// result does not depend on how the scheduler interleaves the two threads.
+//
+
+#define BURSTS      2000
+#define BURST_SIZE  64
+#define SAMPLES     5000
+
+static uint64_t *posted_at;
+static uint64_t *latency;
+static volatile int burst_posted;
+
+static uint32_t counting_handler(enum event_type type, void *context, int param1)
+{
+    if (param1 == 0) {
+        while (!__atomic_load_n(&burst_posted, __ATOMIC_ACQUIRE)) sched_yield();
+    }
+
+    __atomic_add_fetch(&handled, 1, __ATOMIC_RELEASE);
+    return EVENT_SUCCESS;
+}
+
+static void bench_wakeups_per_event(int burst_size)
+{
+    char name[64];
+    uint64_t total = (uint64_t) BURSTS * burst_size;
+
+    handled = 0;
+    harness_handler = counting_handler;
+    bench_check(event_loop_init(&g_event_loop));
+    event_loop_begin(&g_event_loop);
+
+    uint64_t start = test_now_ns();
+    for (int burst = 0; burst < BURSTS; ++burst) {
+        __atomic_store_n(&burst_posted, 0, __ATOMIC_RELEASE);
+
+        for (int i = 0; i < burst_size; ++i) {
+            event_loop_post(&g_event_loop, WINDOW_FOCUSED, NULL, i, NULL);
+        }
+
+        __atomic_store_n(&burst_posted, 1, __ATOMIC_RELEASE);
+        while (__atomic_load_n(&handled, __ATOMIC_ACQUIRE) < (uint64_t)(burst + 1) * burst_size) sched_yield();
+        usleep(50);
+    }
+    uint64_t elapsed = test_now_ns() - start;
+
+    bench_check(handled == total);
+    bench_check(g_event_loop.stats.wakeups <= BURSTS);
+
+    snprintf(name, sizeof(name), "bursts of %2d events", burst_size);
+    bench_report(name, total, elapsed);
+    printf("%-48s wakeups %llu, %.3f per event (per-event sem_post: 1.000)\n", "",
+           (unsigned long long) g_event_loop.stats.wakeups,
+           (double) g_event_loop.stats.wakeups / total);
+
+    event_loop_end(&g_event_loop);
+    harness_event_loop_destroy(&g_event_loop);
+}
+
+static uint32_t latency_handler(enum event_type type, void *context, int param1)
+{
+    latency[param1] = test_now_ns() - posted_at[param1];
+    __atomic_add_fetch(&handled, 1, __ATOMIC_RELEASE);
+    return EVENT_SUCCESS;
+}
+
+//
+// NOTE(koekeishiya): Every event is posted to an idle loop, so each sample includes a full
+// sleep -> wake transition of the consumer thread.
+//
+
+static void bench_wake_to_handle_latency(void)
+{
+    posted_at = malloc(sizeof(uint64_t) * SAMPLES);
+    latency = malloc(sizeof(uint64_t) * SAMPLES);
+
+    handled = 0;
+    harness_handler = latency_handler;
+    bench_check(event_loop_init(&g_event_loop));
+    event_loop_begin(&g_event_loop);
+
+    for (int i = 0; i < SAMPLES; ++i) {
+        usleep(100);
+        posted_at[i] = test_now_ns();
+        event_loop_post(&g_event_loop, WINDOW_FOCUSED, NULL, i, NULL);
+        while (__atomic_load_n(&handled, __ATOMIC_ACQUIRE) < (uint64_t)(i + 1)) sched_yield();
+    }
+
+    bench_check(handled == SAMPLES);
+    bench_check(g_event_loop.stats.wakeups <= SAMPLES);
+
+    bench_report_latency("post to handle, idle loop", latency, SAMPLES);
+    printf("%-48s wakeups %llu, %.3f per event\n", "",
+           (unsigned long long) g_event_loop.stats.wakeups,
+           (double) g_event_loop.stats.wakeups / SAMPLES);
+
+    event_loop_end(&g_event_loop);
+    harness_event_loop_destroy(&g_event_loop);
+    free(posted_at);
+    free(latency);
+}
+
+int main(int argc, char **argv)
+{
+    bench_queue_single_thread();
+
+    for (int producers = 1; producers <= MAX_PRODUCERS; producers *= 2) {
+        bench_producers(producers);
+    }
+
+    bench_wakeups_per_event(1);
+    bench_wakeups_per_event(BURST_SIZE);
+    bench_wake_to_handle_latency();
+
+    return 0;
+}
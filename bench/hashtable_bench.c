@@ -0,0 +1,126 @@
+#include "bench.h"
+#include "compat.h"
+
+#define HASHTABLE_IMPLEMENTATION
+#include "misc/hashtable.h"
+#undef HASHTABLE_IMPLEMENTATION
+
+#define CHAINED_TABLE_IMPLEMENTATION
+#include "chained_table.h"
+#undef CHAINED_TABLE_IMPLEMENTATION
+
+#define TARGET_OPS 2000000
+
+//
+// NOTE(koekeishiya): Keys look like window ids: increasing, with gaps where windows were
+// closed. Misses use ids past the last key. Every case builds the table, looks up every key
+// several times, looks up as many missing keys and removes every key again; the sum of the
+// values that were found is checked so that no case can skip work.
+//
+
+static uint32_t *keys;
+
+static inline uint32_t key_at(int index) { return keys[index]; }
+static inline uint32_t miss_at(int index, int count) { return keys[count - 1] + 1 + index; }
+
+static CHAINED_TABLE_HASH_FUNC(chained_hash) { return *(uint32_t *) key; }
+static CHAINED_TABLE_COMPARE_FUNC(chained_compare) { return *(uint32_t *) key_a == *(uint32_t *) key_b; }
+static TABLE_HASH_FUNC(generic_hash) { return *(uint32_t *) key; }
+static TABLE_COMPARE_FUNC(generic_compare) { return *(uint32_t *) key_a == *(uint32_t *) key_b; }
+
+typedef struct chained_table chained_table;
+static inline void chained_init(chained_table *table) { chained_table_init(table, 150, chained_hash, chained_compare); }
+static inline void chained_free(chained_table *table) { chained_table_free(table); }
+static inline void chained_add(chained_table *table, uint32_t key, void *value) { chained_table_add(table, &key, value); }
+static inline void chained_remove(chained_table *table, uint32_t key) { chained_table_remove(table, &key); }
+static inline void *chained_find(chained_table *table, uint32_t key) { return chained_table_find(table, &key); }
+
+typedef struct table generic_table;
+static inline void generic_init(generic_table *table) { table_init(table, 150, generic_hash, generic_compare); }
+static inline void generic_free(generic_table *table) { table_free(table); }
+static inline void generic_add(generic_table *table, uint32_t key, void *value) { table_add(table, &key, value); }
+static inline void generic_remove(generic_table *table, uint32_t key) { table_remove(table, &key); }
+static inline void *generic_find(generic_table *table, uint32_t key) { return table_find(table, &key); }
+
+static inline void wid_init(wid_table *table) { wid_table_init(table, 150); }
+static inline void wid_free(wid_table *table) { wid_table_free(table); }
+static inline void wid_add(wid_table *table, uint32_t key, void *value) { wid_table_add(table, key, value); }
+static inline void wid_remove(wid_table *table, uint32_t key) { wid_table_remove(table, key); }
+static inline void *wid_find(wid_table *table, uint32_t key) { return wid_table_find(table, key); }
+
+#define BENCH_TABLE(name, table_type, label) \
+static void bench_##name(int count) \
+{ \
+    char title[96]; \
+    table_type table; \
+    int rounds = max(1, TARGET_OPS / count); \
+    uint64_t build = 0, hit = 0, miss = 0, teardown = 0; \
+    uint64_t sum = 0, expected = 0; \
+\
+    for (int round = 0; round < rounds; ++round) { \
+        uint64_t t0 = test_now_ns(); \
+        name##_init(&table); \
+        for (int i = 0; i < count; ++i) name##_add(&table, key_at(i), (void *)(uintptr_t)(i + 1)); \
+\
+        uint64_t t1 = test_now_ns(); \
+        for (int pass = 0; pass < 4; ++pass) { \
+            for (int i = 0; i < count; ++i) sum += (uintptr_t) name##_find(&table, key_at(i)); \
+        } \
+\
+        uint64_t t2 = test_now_ns(); \
+        for (int i = 0; i < count; ++i) sum += (uintptr_t) name##_find(&table, miss_at(i, count)); \
+\
+        uint64_t t3 = test_now_ns(); \
+        for (int i = 0; i < count; ++i) name##_remove(&table, key_at(i)); \
+        bench_check(table.count == 0); \
+        name##_free(&table); \
+        uint64_t t4 = test_now_ns(); \
+\
+        build += t1 - t0; \
+        hit += t2 - t1; \
+        miss += t3 - t2; \
+        teardown += t4 - t3; \
+    } \
+\
+    for (int i = 0; i < count; ++i) expected += 4 * (uint64_t)(i + 1); \
+    bench_check(sum == expected * rounds); \
+\
+    uint64_t ops = (uint64_t) rounds * count; \
+    snprintf(title, sizeof(title), "%-8s %6d add", label, count); \
+    bench_report(title, ops, build); \
+    snprintf(title, sizeof(title), "%-8s %6d find hit", label, count); \
+    bench_report(title, 4 * ops, hit); \
+    snprintf(title, sizeof(title), "%-8s %6d find miss", label, count); \
+    bench_report(title, ops, miss); \
+    snprintf(title, sizeof(title), "%-8s %6d remove", label, count); \
+    bench_report(title, ops, teardown); \
+}
+
+BENCH_TABLE(chained, chained_table, "chained")
+BENCH_TABLE(generic, generic_table, "generic")
+#ifdef HASHTABLE_GENERIC
+BENCH_TABLE(wid, wid_table, "wid(gen)")
+#else
+BENCH_TABLE(wid, wid_table, "wid")
+#endif
+
+int main(int argc, char **argv)
+{
+    int sizes[] = { 10, 1000, 100000 };
+    uint64_t seed = 0x9e3779b97f4a7c15ULL;
+
+    keys = malloc(sizeof(uint32_t) * 100000);
+    for (int i = 0, id = 1000; i < 100000; ++i) {
+        id += 1 + (test_rand(&seed) % 4 == 0) * (test_rand(&seed) % 16);
+        keys[i] = id;
+    }
+
+    for (int i = 0; i < array_count(sizes); ++i) {
+        bench_chained(sizes[i]);
+        bench_generic(sizes[i]);
+        bench_wid(sizes[i]);
+    }
+
+    free(keys);
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include "bench.h"
+#include "json_harness.h"
+
+#define WINDOWS 1000
+#define ROUNDS  500
+
+static struct json_writer json;
+
+static size_t serialized_size(struct synthetic_window *windows, int count, bool legacy)
+{
+    char *data = NULL;
+    size_t size = 0;
+
+    FILE *rsp = open_memstream(&data, &size);
+    if (legacy) {
+        legacy_windows_serialize(windows, count, rsp);
+    } else {
+        synthetic_windows_serialize(&json, windows, count, rsp);
+    }
+    fclose(rsp);
+
+    free(data);
+    return size;
+}
+
+//
+// NOTE(koekeishiya): Both variants write a query --windows response for the same windows into a
+// stream that discards it, so that the numbers only include formatting and the stdio copy.
+//
+
+static void bench_serialize(struct synthetic_window *windows, FILE *rsp, bool legacy)
+{
+    uint64_t start = test_now_ns();
+    for (int round = 0; round < ROUNDS; ++round) {
+        if (legacy) {
+            legacy_windows_serialize(windows, WINDOWS, rsp);
+        } else {
+            synthetic_windows_serialize(&json, windows, WINDOWS, rsp);
+        }
+    }
+    fflush(rsp);
+    uint64_t elapsed = test_now_ns() - start;
+
+    bench_report(legacy ? "serialize 1000 windows, fprintf" : "serialize 1000 windows, json writer", (uint64_t) ROUNDS * WINDOWS, elapsed);
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t seed = 0x9b05688c1f83d9abULL;
+    struct synthetic_window *windows = malloc(sizeof(struct synthetic_window) * WINDOWS);
+
+    for (int i = 0; i < WINDOWS; ++i) {
+        synthetic_window_init(&windows[i], i, &seed);
+    }
+
+    size_t size = serialized_size(windows, WINDOWS, false);
+    bench_check(size > WINDOWS * 400);
+    bench_check(size == serialized_size(windows, WINDOWS, true));
+
+    FILE *rsp = fopen("/dev/null", "w");
+    bench_check(rsp != NULL);
+
+    bench_serialize(windows, rsp, false);
+    bench_serialize(windows, rsp, true);
+
+    fclose(rsp);
+    free(json.data);
+    free(windows);
+
+    return 0;
+}
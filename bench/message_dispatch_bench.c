@@ -0,0 +1,280 @@
+#include "bench.h"
+#include "misc/socket.h"
+#include "message.h"
+#include "message_token.c"
+
+#define ROUNDS 200000
+
+//
+// NOTE(koekeishiya): Measures what it costs to get from a received message to the handler of
+// its command: indexing the arguments, and looking up the domain, the command and the keyword
+// that the command takes. The handlers themselves need a running window server and are left
+// out. The same lookups are done through the token_equals chains that message.c used before the
+// keyword tables, in the order in which those chains tested the keywords.
+//
+
+static char *focus_corpus[] =
+{
+    "window --focus west",
+    "window --focus east",
+    "window --focus north",
+    "window --focus south",
+    "window --focus prev",
+    "window --focus next",
+    "window --focus recent",
+    "window --focus mouse",
+    "window --focus stack.next",
+    "window --focus stack.prev",
+};
+
+static char *query_corpus[] =
+{
+    "query --windows",
+    "query --windows --window",
+    "query --windows --space",
+    "query --windows --display",
+    "query --windows --space 2",
+    "query --windows --window 12345",
+};
+
+static char *window_corpus[] =
+{
+    "window --focus west",
+    "window --swap west",
+    "window --warp east",
+    "window --stack next",
+    "window --insert south",
+    "window --grid 4:4:1:1:2:2",
+    "window --move rel:-20:0",
+    "window --resize left:-20:0",
+    "window --ratio rel:0.05",
+    "window --minimize",
+    "window --deminimize 12345",
+    "window --close",
+    "window --layer above",
+    "window --opacity 0.90",
+    "window --toggle float",
+    "window --display next",
+    "window --space 2",
+};
+
+static char *legacy_window_commands[] =
+{
+    COMMAND_WINDOW_FOCUS, COMMAND_WINDOW_SWAP, COMMAND_WINDOW_WARP, COMMAND_WINDOW_STACK,
+    COMMAND_WINDOW_INSERT, COMMAND_WINDOW_GRID, COMMAND_WINDOW_MOVE, COMMAND_WINDOW_RESIZE,
+    COMMAND_WINDOW_RATIO, COMMAND_WINDOW_MIN, COMMAND_WINDOW_DEMIN, COMMAND_WINDOW_CLOSE,
+    COMMAND_WINDOW_LAYER, COMMAND_WINDOW_OPACITY, COMMAND_WINDOW_TOGGLE, COMMAND_WINDOW_DISPLAY,
+    COMMAND_WINDOW_SPACE
+};
+
+static enum keyword legacy_window_command_keywords[] =
+{
+    KEYWORD_COMMAND_WINDOW_FOCUS, KEYWORD_COMMAND_WINDOW_SWAP, KEYWORD_COMMAND_WINDOW_WARP, KEYWORD_COMMAND_WINDOW_STACK,
+    KEYWORD_COMMAND_WINDOW_INSERT, KEYWORD_COMMAND_WINDOW_GRID, KEYWORD_COMMAND_WINDOW_MOVE, KEYWORD_COMMAND_WINDOW_RESIZE,
+    KEYWORD_COMMAND_WINDOW_RATIO, KEYWORD_COMMAND_WINDOW_MIN, KEYWORD_COMMAND_WINDOW_DEMIN, KEYWORD_COMMAND_WINDOW_CLOSE,
+    KEYWORD_COMMAND_WINDOW_LAYER, KEYWORD_COMMAND_WINDOW_OPACITY, KEYWORD_COMMAND_WINDOW_TOGGLE, KEYWORD_COMMAND_WINDOW_DISPLAY,
+    KEYWORD_COMMAND_WINDOW_SPACE
+};
+
+static char *legacy_window_selectors[] =
+{
+    ARGUMENT_COMMON_SEL_NORTH, ARGUMENT_COMMON_SEL_EAST, ARGUMENT_COMMON_SEL_SOUTH, ARGUMENT_COMMON_SEL_WEST,
+    ARGUMENT_COMMON_SEL_MOUSE, ARGUMENT_WINDOW_SEL_LARGEST, ARGUMENT_WINDOW_SEL_SMALLEST, ARGUMENT_COMMON_SEL_PREV,
+    ARGUMENT_COMMON_SEL_NEXT, ARGUMENT_COMMON_SEL_FIRST, ARGUMENT_COMMON_SEL_LAST, ARGUMENT_COMMON_SEL_RECENT,
+    ARGUMENT_COMMON_SEL_STACK_PREV, ARGUMENT_COMMON_SEL_STACK_NEXT, ARGUMENT_COMMON_SEL_STACK_FIRST,
+    ARGUMENT_COMMON_SEL_STACK_LAST, ARGUMENT_COMMON_SEL_STACK_RECENT
+};
+
+static enum keyword legacy_window_selector_keywords[] =
+{
+    KEYWORD_COMMON_SEL_NORTH, KEYWORD_COMMON_SEL_EAST, KEYWORD_COMMON_SEL_SOUTH, KEYWORD_COMMON_SEL_WEST,
+    KEYWORD_COMMON_SEL_MOUSE, KEYWORD_WINDOW_SEL_LARGEST, KEYWORD_WINDOW_SEL_SMALLEST, KEYWORD_COMMON_SEL_PREV,
+    KEYWORD_COMMON_SEL_NEXT, KEYWORD_COMMON_SEL_FIRST, KEYWORD_COMMON_SEL_LAST, KEYWORD_COMMON_SEL_RECENT,
+    KEYWORD_COMMON_SEL_STACK_PREV, KEYWORD_COMMON_SEL_STACK_NEXT, KEYWORD_COMMON_SEL_STACK_FIRST,
+    KEYWORD_COMMON_SEL_STACK_LAST, KEYWORD_COMMON_SEL_STACK_RECENT
+};
+
+static char *legacy_domains[] =
+{
+    DOMAIN_CONFIG, DOMAIN_DISPLAY, DOMAIN_SPACE, DOMAIN_WINDOW, DOMAIN_QUERY, DOMAIN_RULE, DOMAIN_SIGNAL,
+    DOMAIN_BATCH, DOMAIN_SUBSCRIBE
+};
+
+static enum keyword legacy_domain_keywords[] =
+{
+    KEYWORD_DOMAIN_CONFIG, KEYWORD_DOMAIN_DISPLAY, KEYWORD_DOMAIN_SPACE, KEYWORD_DOMAIN_WINDOW, KEYWORD_DOMAIN_QUERY,
+    KEYWORD_DOMAIN_RULE, KEYWORD_DOMAIN_SIGNAL, KEYWORD_DOMAIN_BATCH, KEYWORD_DOMAIN_SUBSCRIBE
+};
+
+static char *legacy_query_commands[] = { COMMAND_QUERY_DISPLAYS, COMMAND_QUERY_SPACES, COMMAND_QUERY_WINDOWS };
+static enum keyword legacy_query_command_keywords[] = { KEYWORD_COMMAND_QUERY_DISPLAYS, KEYWORD_COMMAND_QUERY_SPACES, KEYWORD_COMMAND_QUERY_WINDOWS };
+
+static bool legacy_token_equals(struct token token, char *match)
+{
+    char *at = match;
+    for (int i = 0; i < token.length; ++i, ++at) {
+        if ((*at == 0) || (token.text[i] != *at)) {
+            return false;
+        }
+    }
+    return *at == 0;
+}
+
+static enum keyword legacy_lookup(struct token token, char **keywords, enum keyword *values, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        if (legacy_token_equals(token, keywords[i])) return values[i];
+    }
+
+    return KEYWORD_UNKNOWN;
+}
+
+//
+// NOTE(koekeishiya): The options of query --windows are tested with token_equals in both
+// variants, the way handle_domain_query does.
+//
+
+static int query_windows_option(struct token option)
+{
+    if (token_equals(option, ARGUMENT_QUERY_FRESH))   return 1;
+    if (token_equals(option, ARGUMENT_QUERY_DISPLAY)) return 2;
+    if (token_equals(option, ARGUMENT_QUERY_SPACE))   return 3;
+    if (token_equals(option, ARGUMENT_QUERY_WINDOW))  return 4;
+    return 0;
+}
+
+static uint64_t dispatch(struct token_index *message)
+{
+    struct token domain = get_token(message);
+    enum keyword domain_keyword = keyword_domain(domain);
+    enum keyword command_keyword = KEYWORD_UNKNOWN;
+    uint64_t argument = 0;
+
+    switch (domain_keyword) {
+    case KEYWORD_DOMAIN_WINDOW: {
+        command_keyword = keyword_window_command(get_token(message));
+        if (command_keyword == KEYWORD_COMMAND_WINDOW_FOCUS) {
+            argument = keyword_window_selector(get_token(message));
+        }
+    } break;
+    case KEYWORD_DOMAIN_QUERY: {
+        command_keyword = keyword_query_command(get_token(message));
+        if (command_keyword == KEYWORD_COMMAND_QUERY_WINDOWS) {
+            argument = query_windows_option(get_token(message));
+        }
+    } break;
+    default: break;
+    }
+
+    return (uint64_t) domain_keyword << 32 | (uint64_t) command_keyword << 16 | argument;
+}
+
+static uint64_t legacy_dispatch(struct token_index *message)
+{
+    struct token domain = get_token(message);
+    enum keyword domain_keyword = legacy_lookup(domain, legacy_domains, legacy_domain_keywords, array_count(legacy_domains));
+    enum keyword command_keyword = KEYWORD_UNKNOWN;
+    uint64_t argument = 0;
+
+    switch (domain_keyword) {
+    case KEYWORD_DOMAIN_WINDOW: {
+        command_keyword = legacy_lookup(get_token(message), legacy_window_commands, legacy_window_command_keywords, array_count(legacy_window_commands));
+        if (command_keyword == KEYWORD_COMMAND_WINDOW_FOCUS) {
+            argument = legacy_lookup(get_token(message), legacy_window_selectors, legacy_window_selector_keywords, array_count(legacy_window_selectors));
+        }
+    } break;
+    case KEYWORD_DOMAIN_QUERY: {
+        command_keyword = legacy_lookup(get_token(message), legacy_query_commands, legacy_query_command_keywords, array_count(legacy_query_commands));
+        if (command_keyword == KEYWORD_COMMAND_QUERY_WINDOWS) {
+            argument = query_windows_option(get_token(message));
+        }
+    } break;
+    default: break;
+    }
+
+    return (uint64_t) domain_keyword << 32 | (uint64_t) command_keyword << 16 | argument;
+}
+
+static char **make_messages(char **corpus, int count)
+{
+    char **messages = malloc(sizeof(char *) * count);
+
+    for (int i = 0; i < count; ++i) {
+        char *message = NULL;
+        for (char *at = corpus[i]; *at; ++at) buf_push(message, *at == ' ' ? '\0' : *at);
+        buf_push(message, '\0');
+        buf_push(message, '\0');
+        messages[i] = message;
+    }
+
+    return messages;
+}
+
+static uint64_t run(char **messages, int count, bool legacy)
+{
+    uint64_t sum = 0;
+
+    for (int round = 0; round < ROUNDS; ++round) {
+        for (int i = 0; i < count; ++i) {
+            struct token_index index;
+            token_index_build(&index, messages[i]);
+            sum += legacy ? legacy_dispatch(&index) : dispatch(&index);
+            token_index_destroy(&index);
+        }
+    }
+
+    return sum;
+}
+
+static void bench_corpus(char *name, char **corpus, int count)
+{
+    char **messages = make_messages(corpus, count);
+    char row[128];
+
+    //
+    // NOTE(koekeishiya): Every command must resolve to a known command, and both variants must
+    // resolve it to the same keywords, before either of them is timed.
+    //
+
+    for (int i = 0; i < count; ++i) {
+        struct token_index a, b;
+        token_index_build(&a, messages[i]);
+        token_index_build(&b, messages[i]);
+
+        uint64_t result = dispatch(&a);
+        bench_check(result == legacy_dispatch(&b));
+        bench_check(((result >> 16) & 0xffff) != KEYWORD_UNKNOWN);
+
+        token_index_destroy(&a);
+        token_index_destroy(&b);
+    }
+
+    uint64_t start = test_now_ns();
+    uint64_t sum = run(messages, count, false);
+    uint64_t elapsed = test_now_ns() - start;
+
+    snprintf(row, sizeof(row), "%s, keyword tables", name);
+    bench_report(row, (uint64_t) ROUNDS * count, elapsed);
+
+    start = test_now_ns();
+    uint64_t legacy_sum = run(messages, count, true);
+    elapsed = test_now_ns() - start;
+
+    snprintf(row, sizeof(row), "%s, token_equals chains", name);
+    bench_report(row, (uint64_t) ROUNDS * count, elapsed);
+
+    bench_check(sum == legacy_sum);
+    bench_sink += sum;
+
+    for (int i = 0; i < count; ++i) buf_free(messages[i]);
+    free(messages);
+}
+
+int main(int argc, char **argv)
+{
+    bench_corpus("dispatch window --focus", focus_corpus, array_count(focus_corpus));
+    bench_corpus("dispatch query --windows", query_corpus, array_count(query_corpus));
+    bench_corpus("dispatch window --<any>", window_corpus, array_count(window_corpus));
+
+    return 0;
+}
@@ -0,0 +1,263 @@
+#include "bench.h"
+#include "misc/socket.h"
+#include "message.h"
+#include "message_token.c"
+
+#define ROUNDS          20000
+#define NUMBER_ROUNDS   200000
+
+//
+// NOTE(koekeishiya): Command lines as they show up in yabairc files and skhd bindings. Arguments
+// are separated by a single space here, and by a null-terminator once they have been turned into
+// the message that the client sends.
+//
+
+static char *corpus[] =
+{
+    "window --focus west",
+    "window --focus east",
+    "window --focus north",
+    "window --focus south",
+    "window --focus recent",
+    "window --focus stack.next",
+    "window --swap west",
+    "window --warp east",
+    "window --insert south",
+    "window --toggle float",
+    "window --toggle zoom-fullscreen",
+    "window --toggle sticky --toggle topmost --grid 4:4:1:1:2:2",
+    "window --grid 1:1:0:0:1:1",
+    "window --move rel:-20:0",
+    "window --resize left:-20:0",
+    "window --resize bottom:0:20",
+    "window --ratio rel:0.05",
+    "window --opacity 0.90",
+    "window --space 2 --focus",
+    "window --display next",
+    "window 12345 --layer above",
+    "query --windows",
+    "query --windows --window",
+    "query --windows --space 3",
+    "query --windows --fresh --display 1",
+    "query --spaces --display",
+    "query --spaces --space recent",
+    "query --displays",
+    "space --focus 3",
+    "space --focus recent",
+    "space --layout bsp",
+    "space --balance",
+    "space --rotate 90",
+    "space --mirror y-axis",
+    "space --padding abs:12:12:12:12",
+    "space --gap rel:10",
+    "space --toggle padding --toggle gap",
+    "space --create",
+    "space --label code",
+    "display --focus next",
+    "config layout bsp",
+    "config top_padding 12",
+    "config window_gap 06",
+    "config split_ratio 0.50",
+    "config window_opacity_duration 0.0",
+    "config active_window_opacity 1.0",
+    "config normal_window_opacity 0.90",
+    "config active_window_border_color 0xff775759",
+    "config normal_window_border_color 0xff505050",
+    "config insert_feedback_color 0xffd75f5f",
+    "config --space 2 layout float",
+    "config mouse_modifier fn",
+    "config external_bar all:26:0",
+    "rule --add app=^System Preferences$ manage=off",
+    "rule --add app=^Finder$ title=Copy manage=off layer=above",
+    "rule --add label=terminal app=^Alacritty$ space=^2 opacity=0.95",
+    "rule --list",
+    "signal --add event=window_focused app=^Firefox$ action=echo label=focus",
+    "signal --add event=space_changed action=reload",
+    "signal --list",
+};
+
+static char *int_corpus[]   = { "0", "1", "2", "3", "12", "06", "-20", "90", "180", "12345", "4", "26" };
+static char *float_corpus[] = { "0.0", "1.0", "0.90", "0.95", "0.50", "0.05", "-0.05", "0.25", "1", "0.333" };
+static char *hex_corpus[]   = { "0xff775759", "0xff505050", "0xffd75f5f", "0xaad5c4a1", "0x00000000", "ffffffff" };
+
+static char *messages[array_count(corpus)];
+static uint64_t corpus_bytes;
+static int corpus_tokens;
+
+static char *make_message(char *line)
+{
+    char *message = NULL;
+
+    for (char *at = line; *at; ++at) {
+        buf_push(message, *at == ' ' ? '\0' : *at);
+        if (*at != ' ') corpus_bytes++;
+        if (*at != ' ' && (at == line || at[-1] == ' ')) ++corpus_tokens;
+    }
+
+    buf_push(message, '\0');
+    buf_push(message, '\0');
+    return message;
+}
+
+//
+// NOTE(koekeishiya): What message.c did before the arguments were indexed: every call walks the
+// next argument byte by byte, and numbers are copied into a temporary buffer for sscanf.
+//
+
+static struct token legacy_get_token(char **message)
+{
+    struct token token;
+
+    token.text = *message;
+    while (**message) {
+        ++(*message);
+    }
+    token.length = *message - token.text;
+
+    if ((*message)[0] == '\0' && (*message)[1] != '\0') {
+        ++(*message);
+    }
+
+    return token;
+}
+
+static bool legacy_token_to_int(struct token token, int *value)
+{
+    int result = 0;
+    char buffer[token.length + 1];
+    memcpy(buffer, token.text, token.length);
+    buffer[token.length] = '\0';
+    bool success = sscanf(buffer, "%d", &result) == 1;
+    *value = result;
+    return success;
+}
+
+static float legacy_token_to_float(struct token token)
+{
+    float result = 0.0f;
+    char buffer[token.length + 1];
+    memcpy(buffer, token.text, token.length);
+    buffer[token.length] = '\0';
+    sscanf(buffer, "%f", &result);
+    return result;
+}
+
+static uint32_t legacy_token_to_uint32t(struct token token)
+{
+    uint32_t result = 0;
+    char buffer[token.length + 1];
+    memcpy(buffer, token.text, token.length);
+    buffer[token.length] = '\0';
+    sscanf(buffer, "%x", &result);
+    return result;
+}
+
+static void bench_tokenize_indexed(void)
+{
+    uint64_t bytes = 0;
+    uint64_t tokens = 0;
+
+    uint64_t start = test_now_ns();
+    for (int round = 0; round < ROUNDS; ++round) {
+        for (int i = 0; i < array_count(messages); ++i) {
+            struct token_index index;
+            bench_check(token_index_build(&index, messages[i]));
+
+            for (struct token token = get_token(&index); token_is_valid(token); token = get_token(&index)) {
+                bytes += token.length;
+                ++tokens;
+            }
+
+            token_index_destroy(&index);
+        }
+    }
+    uint64_t elapsed = test_now_ns() - start;
+
+    bench_check(bytes == corpus_bytes * ROUNDS);
+    bench_check(tokens == (uint64_t) corpus_tokens * ROUNDS);
+    bench_report("tokenize, indexed", (uint64_t) ROUNDS * array_count(messages), elapsed);
+}
+
+static void bench_tokenize_legacy(void)
+{
+    uint64_t bytes = 0;
+    uint64_t tokens = 0;
+
+    uint64_t start = test_now_ns();
+    for (int round = 0; round < ROUNDS; ++round) {
+        for (int i = 0; i < array_count(messages); ++i) {
+            char *message = messages[i];
+
+            for (struct token token = legacy_get_token(&message); token_is_valid(token); token = legacy_get_token(&message)) {
+                bytes += token.length;
+                ++tokens;
+            }
+        }
+    }
+    uint64_t elapsed = test_now_ns() - start;
+
+    bench_check(bytes == corpus_bytes * ROUNDS);
+    bench_check(tokens == (uint64_t) corpus_tokens * ROUNDS);
+    bench_report("tokenize, legacy get_token", (uint64_t) ROUNDS * array_count(messages), elapsed);
+}
+
+//
+// NOTE(koekeishiya): Both variants parse the same numbers; the results are summed and compared,
+// so that neither of them can be optimized away or parse differently from the other.
+//
+
+static double bench_numbers(bool in_place)
+{
+    struct token ints[array_count(int_corpus)];
+    struct token floats[array_count(float_corpus)];
+    struct token hexes[array_count(hex_corpus)];
+    double sum = 0.0;
+    uint64_t ops = 0;
+
+    for (int i = 0; i < array_count(int_corpus); ++i)   ints[i]   = (struct token) { int_corpus[i], strlen(int_corpus[i]) };
+    for (int i = 0; i < array_count(float_corpus); ++i) floats[i] = (struct token) { float_corpus[i], strlen(float_corpus[i]) };
+    for (int i = 0; i < array_count(hex_corpus); ++i)   hexes[i]  = (struct token) { hex_corpus[i], strlen(hex_corpus[i]) };
+
+    uint64_t start = test_now_ns();
+    for (int round = 0; round < NUMBER_ROUNDS; ++round) {
+        for (int i = 0; i < array_count(ints); ++i) {
+            int value;
+            bench_check(in_place ? token_to_int(ints[i], &value) : legacy_token_to_int(ints[i], &value));
+            sum += value;
+        }
+
+        for (int i = 0; i < array_count(floats); ++i) {
+            sum += in_place ? token_to_float(floats[i]) : legacy_token_to_float(floats[i]);
+        }
+
+        for (int i = 0; i < array_count(hexes); ++i) {
+            sum += in_place ? token_to_uint32t(hexes[i]) : legacy_token_to_uint32t(hexes[i]);
+        }
+
+        ops += array_count(ints) + array_count(floats) + array_count(hexes);
+    }
+    uint64_t elapsed = test_now_ns() - start;
+
+    bench_report(in_place ? "parse numbers, in place" : "parse numbers, sscanf", ops, elapsed);
+    return sum;
+}
+
+int main(int argc, char **argv)
+{
+    for (int i = 0; i < array_count(corpus); ++i) {
+        messages[i] = make_message(corpus[i]);
+    }
+
+    bench_tokenize_indexed();
+    bench_tokenize_legacy();
+
+    double in_place = bench_numbers(true);
+    double legacy = bench_numbers(false);
+    bench_check(fabs(in_place - legacy) <= fabs(legacy) * 1e-6);
+
+    for (int i = 0; i < array_count(messages); ++i) {
+        buf_free(messages[i]);
+    }
+
+    return 0;
+}
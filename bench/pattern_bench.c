@@ -0,0 +1,118 @@
+#include "bench.h"
+#include "pattern_harness.h"
+
+#define TITLES       4096
+#define ROUNDS       20
+#define COLD_ROUNDS  20
+#define TITLE_LENGTH 256
+
+static char titles[TITLES][TITLE_LENGTH];
+
+static void pattern_set_create(struct pattern_set *set, char **patterns)
+{
+    for (int i = 0; i < buf_len(patterns); ++i) {
+        bench_check(pattern_set_add(set, patterns[i]) == i);
+    }
+}
+
+//
+// NOTE(koekeishiya): A cold pass starts from a fresh set, so it includes building the states for
+// the titles as they are first seen. This is what the first window after a rule or signal was
+// added or removed pays. Every other pass only follows transitions that already exist.
+//
+
+static void bench_pattern_set_cold(char **patterns)
+{
+    uint64_t elapsed = 0;
+
+    for (int round = 0; round < COLD_ROUNDS; ++round) {
+        struct pattern_set set = {};
+
+        uint64_t start = test_now_ns();
+        pattern_set_create(&set, patterns);
+        for (int i = 0; i < TITLES; ++i) {
+            bench_sink += pattern_set_match(&set, titles[i])[0];
+        }
+        elapsed += test_now_ns() - start;
+
+        pattern_set_free(&set);
+    }
+
+    bench_report("match 100 patterns, pattern set (cold)", (uint64_t) COLD_ROUNDS * TITLES, elapsed);
+}
+
+static void bench_pattern_set(struct pattern_set *set)
+{
+    uint64_t start = test_now_ns();
+    for (int round = 0; round < ROUNDS; ++round) {
+        for (int i = 0; i < TITLES; ++i) {
+            bench_sink += pattern_set_match(set, titles[i])[0];
+        }
+    }
+    uint64_t elapsed = test_now_ns() - start;
+
+    bench_report("match 100 patterns, pattern set", (uint64_t) ROUNDS * TITLES, elapsed);
+}
+
+static void bench_regexec(regex_t *regex, int count)
+{
+    uint64_t result[(count + 63) / 64];
+
+    uint64_t start = test_now_ns();
+    for (int round = 0; round < ROUNDS; ++round) {
+        for (int i = 0; i < TITLES; ++i) {
+            harness_regex_match(regex, count, titles[i], result);
+            bench_sink += result[0];
+        }
+    }
+    uint64_t elapsed = test_now_ns() - start;
+
+    bench_report("match 100 patterns, regexec", (uint64_t) ROUNDS * TITLES, elapsed);
+}
+
+int main(int argc, char **argv)
+{
+    char **patterns = NULL;
+    harness_rule_patterns_create(&patterns);
+
+    int count = buf_len(patterns);
+    int words = (count + 63) / 64;
+    bench_check(count == 100);
+
+    regex_t *regex = malloc(count * sizeof(regex_t));
+    for (int i = 0; i < count; ++i) {
+        bench_check(harness_regex_compile(&regex[i], patterns[i]));
+    }
+
+    uint64_t seed = 0x2545f4914f6cdd1dULL;
+    for (int i = 0; i < TITLES; ++i) {
+        harness_title(titles[i], TITLE_LENGTH, &seed);
+    }
+
+    struct pattern_set set = {};
+    pattern_set_create(&set, patterns);
+
+    int matched = 0;
+    for (int i = 0; i < TITLES; ++i) {
+        uint64_t expected[words];
+        harness_regex_match(regex, count, titles[i], expected);
+
+        uint64_t *result = pattern_set_match(&set, titles[i]);
+        for (int j = 0; j < words; ++j) {
+            bench_check(result[j] == expected[j]);
+            matched += __builtin_popcountll(result[j]);
+        }
+    }
+    bench_check(matched > TITLES / 2);
+
+    bench_pattern_set_cold(patterns);
+    bench_pattern_set(&set);
+    bench_regexec(regex, count);
+
+    for (int i = 0; i < count; ++i) regfree(&regex[i]);
+    pattern_set_free(&set);
+    harness_patterns_destroy(&patterns);
+    free(regex);
+
+    return 0;
+}
@@ -0,0 +1,102 @@
+#include "bench.h"
+#include "sa_client_harness.h"
+
+#define WAIT_COMMANDS       20000
+#define PIPELINED_COMMANDS  200000
+#define MOVES_PER_FRAME     (SA_MAX_FRAME_SIZE / 13)
+
+static void bench_check_records(int count, uint8_t op)
+{
+    bench_check(buf_len(harness_payload.records) == count);
+    bench_check(harness_payload.malformed == 0);
+
+    for (int i = 0; i < count; ++i) {
+        bench_check(harness_payload.records[i].command.op == op);
+        bench_check(harness_payload.records[i].command.window.wid == (uint32_t) i + 1);
+    }
+}
+
+//
+// NOTE(koekeishiya): Every command waits for its reply, so each one costs a full round trip
+// through the stand-in payload. This is what focusing a window costs.
+//
+
+static void bench_wait(void)
+{
+    harness_payload_reset();
+
+    uint64_t start = test_now_ns();
+    for (int i = 0; i < WAIT_COMMANDS; ++i) {
+        bench_check(scripting_addition_focus_window(i + 1));
+    }
+    uint64_t elapsed = test_now_ns() - start;
+
+    bench_check(harness_payload.frames == WAIT_COMMANDS);
+    bench_check_records(WAIT_COMMANDS, SA_OP_WINDOW_FOCUS);
+    bench_report("sa send, wait for every reply", WAIT_COMMANDS, elapsed);
+}
+
+//
+// NOTE(koekeishiya): Commands that do not wait are written back to back, and their replies are
+// only collected once SA_MAX_PENDING of them are outstanding. The time until the payload has
+// received the last command is included.
+//
+
+static void bench_pipelined(void)
+{
+    harness_payload_reset();
+
+    uint64_t start = test_now_ns();
+    for (int i = 0; i < PIPELINED_COMMANDS; ++i) {
+        bench_check(scripting_addition_move_window(i + 1, i, i));
+    }
+    bench_check(harness_payload_wait_frames(PIPELINED_COMMANDS));
+    uint64_t elapsed = test_now_ns() - start;
+
+    bench_check_records(PIPELINED_COMMANDS, SA_OP_WINDOW_MOVE);
+    bench_check(sa_pending <= SA_MAX_PENDING);
+    bench_report("sa send, pipelined", PIPELINED_COMMANDS, elapsed);
+
+    bench_check(scripting_addition_drain());
+}
+
+//
+// NOTE(koekeishiya): The same moves, issued inside a batch the way an event handler issues them.
+// They are packed into as few frames as fit, so the payload sees one frame per MOVES_PER_FRAME
+// commands instead of one frame per command.
+//
+
+static void bench_batched(void)
+{
+    int frames = (PIPELINED_COMMANDS + MOVES_PER_FRAME - 1) / MOVES_PER_FRAME;
+    harness_payload_reset();
+
+    uint64_t start = test_now_ns();
+    scripting_addition_begin_batch();
+    for (int i = 0; i < PIPELINED_COMMANDS; ++i) {
+        bench_check(scripting_addition_move_window(i + 1, i, i));
+    }
+    scripting_addition_end_batch();
+    bench_check(harness_payload_wait_frames(frames));
+    uint64_t elapsed = test_now_ns() - start;
+
+    bench_check(harness_payload.frames == frames);
+    bench_check_records(PIPELINED_COMMANDS, SA_OP_WINDOW_MOVE);
+    bench_report("sa send, batched", PIPELINED_COMMANDS, elapsed);
+
+    bench_check(scripting_addition_drain());
+}
+
+int main(int argc, char **argv)
+{
+    bench_check(harness_payload_begin());
+
+    bench_wait();
+    bench_pipelined();
+    bench_batched();
+
+    bench_check(harness_payload.connections == 1);
+    harness_payload_end();
+
+    return 0;
+}
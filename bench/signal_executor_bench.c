@@ -0,0 +1,216 @@
+#include "bench.h"
+#include "misc/socket.h"
+#include "misc/socket.c"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/stat.h>
+
+#define LATENCY_SAMPLES 200
+#define RATE_COMMANDS   1000
+#define DAEMON_SIZE     (64 * 1024 * 1024)
+#define READ_TIMEOUT    10000
+
+//
+// NOTE(koekeishiya): The executor only reads the names and values of the arguments, so the
+// struct below is a stand-in for the one in misc/helpers.h, which needs Cocoa.
+//
+
+struct signal_args
+{
+    char name[2][255];
+    char value[2][255];
+    void *entity;
+    void *param1;
+};
+
+#include "event_signal_executor.h"
+#include "event_signal_executor.c"
+
+//
+// NOTE(koekeishiya): This is how signals used to be executed; event_signal_transmit forked the
+// daemon for every event, and the child ran fork_exec for every matching signal.
+//
+
+static void legacy_fork_exec(char *command, struct signal_args *args)
+{
+    if (fork() != 0) return;
+
+    if (*args->name[0]) setenv(args->name[0], args->value[0], 1);
+    if (*args->name[1]) setenv(args->name[1], args->value[1], 1);
+
+    char *exec[] = { "/usr/bin/env", "sh", "-c", command, NULL};
+    exit(execvp(exec[0], exec));
+}
+
+static void legacy_transmit(char *command, struct signal_args *args)
+{
+    if (fork() != 0) return;
+
+    legacy_fork_exec(command, args);
+    exit(EXIT_SUCCESS);
+}
+
+static bool executor_transmit(char *command, struct signal_args *args)
+{
+    int result;
+    while ((result = event_signal_executor_send(command, args)) == 0);
+    return result == 1;
+}
+
+static char fifo_path[MAXLEN];
+static int fifo_fd;
+static int fifo_writer_fd;
+
+static void fifo_open(void)
+{
+    snprintf(fifo_path, sizeof(fifo_path), "/tmp/yabai-signal-bench_%d.fifo", getpid());
+    unlink(fifo_path);
+    bench_check(mkfifo(fifo_path, 0600) == 0);
+
+    //
+    // NOTE(koekeishiya): We keep a write end open ourselves, so that the read end does not see
+    // end-of-file every time one of the shells is done writing to it.
+    //
+
+    fifo_fd = open(fifo_path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    bench_check(fifo_fd != -1);
+    fifo_writer_fd = open(fifo_path, O_WRONLY | O_CLOEXEC);
+    bench_check(fifo_writer_fd != -1);
+}
+
+static void fifo_close(void)
+{
+    close(fifo_writer_fd);
+    close(fifo_fd);
+    unlink(fifo_path);
+}
+
+static int fifo_read(char *buffer, int size)
+{
+    struct pollfd pfd = { fifo_fd, POLLIN, 0 };
+    bench_check(poll(&pfd, 1, READ_TIMEOUT) == 1);
+
+    ssize_t bytes = read(fifo_fd, buffer, size);
+    bench_check(bytes > 0);
+    return bytes;
+}
+
+static void fifo_read_line(char *buffer, int size)
+{
+    int length = 0;
+    while (length == 0 || buffer[length - 1] != '\n') {
+        bench_check(length < size);
+        length += fifo_read(buffer + length, size - length);
+    }
+    buffer[length - 1] = '\0';
+}
+
+//
+// NOTE(koekeishiya): Every sample is a single event with one matching signal. The command echoes
+// the environment variable the event carries back through a fifo, which is the earliest point we
+// can observe the action. Dispatch cost is the part that is paid on the event loop thread.
+//
+
+static void bench_latency(bool legacy)
+{
+    uint64_t dispatch[LATENCY_SAMPLES];
+    uint64_t action[LATENCY_SAMPLES];
+
+    char command[MAXLEN * 2];
+    snprintf(command, sizeof(command), "printf '%%s\\n' \"$YABAI_WINDOW_ID\" > %s", fifo_path);
+
+    for (int i = 0; i < LATENCY_SAMPLES; ++i) {
+        struct signal_args args = {};
+        snprintf(args.name[0], sizeof(args.name[0]), "%s", "YABAI_WINDOW_ID");
+        snprintf(args.value[0], sizeof(args.value[0]), "%d", i + 1);
+
+        uint64_t start = test_now_ns();
+        if (legacy) {
+            legacy_transmit(command, &args);
+        } else {
+            bench_check(executor_transmit(command, &args));
+        }
+        dispatch[i] = test_now_ns() - start;
+
+        char line[64];
+        fifo_read_line(line, sizeof(line));
+        action[i] = test_now_ns() - start;
+
+        bench_check(atoi(line) == i + 1);
+    }
+
+    bench_report_latency(legacy ? "dispatch cost, fork per event" : "dispatch cost, executor", dispatch, LATENCY_SAMPLES);
+    bench_report_latency(legacy ? "event to action, fork per event" : "event to action, executor", action, LATENCY_SAMPLES);
+}
+
+//
+// NOTE(koekeishiya): A burst of events, each running a command that writes one byte. The rate
+// is measured until the last process has written its byte, not just until all were dispatched.
+//
+
+static void bench_rate(bool legacy)
+{
+    char command[MAXLEN * 2];
+    snprintf(command, sizeof(command), "printf x > %s", fifo_path);
+
+    struct signal_args args = {};
+
+    uint64_t start = test_now_ns();
+    for (int i = 0; i < RATE_COMMANDS; ++i) {
+        if (legacy) {
+            legacy_transmit(command, &args);
+        } else {
+            bench_check(executor_transmit(command, &args));
+        }
+    }
+
+    int received = 0;
+    while (received < RATE_COMMANDS) {
+        char buffer[256];
+        int bytes = fifo_read(buffer, sizeof(buffer));
+        for (int i = 0; i < bytes; ++i) bench_check(buffer[i] == 'x');
+        received += bytes;
+    }
+    uint64_t elapsed = test_now_ns() - start;
+
+    bench_check(received == RATE_COMMANDS);
+    bench_report(legacy ? "spawn rate, fork per event" : "spawn rate, executor", RATE_COMMANDS, elapsed);
+}
+
+int main(int argc, char **argv)
+{
+    //
+    // NOTE(koekeishiya): The legacy children exit through exit(), which flushes whatever stdio
+    // buffers they inherited, so nothing may be left sitting in them when we fork.
+    //
+
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    signal(SIGCHLD, SIG_IGN);
+
+    //
+    // NOTE(koekeishiya): The cost of forking grows with the size of the process being forked,
+    // so we touch some memory first to have page tables to copy, as the daemon would.
+    //
+
+    char *daemon_memory = malloc(DAEMON_SIZE);
+    for (int i = 0; i < DAEMON_SIZE; i += 4096) daemon_memory[i] = (char) i;
+    bench_sink += daemon_memory[DAEMON_SIZE / 2];
+
+    fifo_open();
+    bench_check(event_signal_executor_begin());
+
+    bench_latency(false);
+    bench_latency(true);
+    bench_rate(false);
+    bench_rate(true);
+
+    event_signal_executor_end();
+    fifo_close();
+    free(signal_executor.buffer);
+    free(daemon_memory);
+
+    return 0;
+}
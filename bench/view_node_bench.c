@@ -0,0 +1,298 @@
+#include "bench.h"
+#include "view_node_harness.h"
+
+#define TARGET_NODES 4000000
+
+//
+// NOTE(koekeishiya): legacy_node is struct window_node as it was before the pool: every node
+// carries both window stacks and its feedback window inline, and is allocated and zeroed on its
+// own. Both trees are built by the same split, so the only difference is where nodes come from
+// and how many cache lines a walk over the tree touches.
+//
+
+struct legacy_node
+{
+    struct area area;
+    struct legacy_node *parent;
+    struct legacy_node *left;
+    struct legacy_node *right;
+    struct legacy_node *zoom;
+    uint32_t window_list[NODE_MAX_WINDOW_COUNT];
+    uint32_t window_order[NODE_MAX_WINDOW_COUNT];
+    uint32_t window_count;
+    float ratio;
+    enum window_node_split split;
+    enum window_node_child child;
+    int insert_dir;
+    struct feedback_window feedback_window;
+};
+
+static struct legacy_node *legacy_node_create(void)
+{
+    struct legacy_node *node = malloc(sizeof(struct legacy_node));
+    memset(node, 0, sizeof(struct legacy_node));
+    return node;
+}
+
+static void legacy_node_destroy(struct legacy_node *node)
+{
+    if (node->left)  legacy_node_destroy(node->left);
+    if (node->right) legacy_node_destroy(node->right);
+    free(node);
+}
+
+static inline bool legacy_node_is_leaf(struct legacy_node *node)
+{
+    return node->left == NULL && node->right == NULL;
+}
+
+static struct legacy_node *legacy_find_first_leaf(struct legacy_node *node)
+{
+    while (!legacy_node_is_leaf(node)) node = node->left;
+    return node;
+}
+
+static struct legacy_node *legacy_find_next_leaf(struct legacy_node *node)
+{
+    if (!node->parent) return NULL;
+
+    if (node->parent->right == node) {
+        return legacy_find_next_leaf(node->parent);
+    }
+
+    if (legacy_node_is_leaf(node->parent->right)) {
+        return node->parent->right;
+    }
+
+    return legacy_find_first_leaf(node->parent->right->left);
+}
+
+#define SPLIT_NODE(node, left, right, window_id) \
+    do { \
+        memcpy(left->window_list, node->window_list, sizeof(uint32_t) * node->window_count); \
+        memcpy(left->window_order, node->window_order, sizeof(uint32_t) * node->window_count); \
+        left->window_count = node->window_count; \
+        right->window_list[0] = window_id; \
+        right->window_order[0] = window_id; \
+        right->window_count = 1; \
+        left->parent = node; \
+        right->parent = node; \
+        node->window_count = 0; \
+        node->left = left; \
+        node->right = right; \
+        node->split = node->area.w >= node->area.h ? SPLIT_Y : SPLIT_X; \
+        node->ratio = 0.5f; \
+        left->area = right->area = node->area; \
+        if (node->split == SPLIT_Y) { \
+            left->area.w *= 0.5f; \
+            right->area.w *= 0.5f; \
+            right->area.x += left->area.w; \
+        } else { \
+            left->area.h *= 0.5f; \
+            right->area.h *= 0.5f; \
+            right->area.y += left->area.h; \
+        } \
+    } while (0)
+
+//
+// NOTE(koekeishiya): Windows are inserted by splitting a random existing leaf, using the same
+// sequence of choices for both trees, so that both end up with an identical shape.
+//
+
+static int *split_choice;
+
+static struct legacy_node *legacy_build(int window_count, struct legacy_node **leaves)
+{
+    struct legacy_node *root = legacy_node_create();
+    root->area = (struct area) { 0, 0, 2560, 1440 };
+    root->window_list[0] = root->window_order[0] = 1;
+    root->window_count = 1;
+    leaves[0] = root;
+
+    for (int i = 1; i < window_count; ++i) {
+        struct legacy_node *node = leaves[split_choice[i] % i];
+        struct legacy_node *left = legacy_node_create();
+        struct legacy_node *right = legacy_node_create();
+        SPLIT_NODE(node, left, right, i + 1);
+        leaves[split_choice[i] % i] = left;
+        leaves[i] = right;
+    }
+
+    return root;
+}
+
+static struct window_node *pool_build(struct view *view, int window_count, struct window_node **leaves)
+{
+    struct window_node *root = window_node_create(view);
+    root->area = (struct area) { 0, 0, 2560, 1440 };
+    root->window_list[0] = root->window_order[0] = 1;
+    root->window_count = 1;
+    leaves[0] = root;
+
+    for (int i = 1; i < window_count; ++i) {
+        struct window_node *node = leaves[split_choice[i] % i];
+        struct window_node *left = window_node_create(view);
+        struct window_node *right = window_node_create(view);
+        SPLIT_NODE(node, left, right, i + 1);
+        leaves[split_choice[i] % i] = left;
+        leaves[i] = right;
+    }
+
+    return root;
+}
+
+static void bench_tree(int window_count)
+{
+    char name[64];
+    int nodes = 2 * window_count - 1;
+    int rounds = max(1, TARGET_NODES / nodes);
+    int walks = 16;
+    uint64_t expected = (uint64_t) window_count * (window_count + 1) / 2;
+    uint64_t legacy_build_ns = 0, legacy_walk_ns = 0, legacy_teardown_ns = 0;
+    uint64_t pool_build_ns = 0, pool_walk_ns = 0, pool_teardown_ns = 0;
+    uint64_t legacy_sum = 0, pool_sum = 0;
+
+    void **leaves = malloc(sizeof(void *) * window_count);
+    struct view view = {0};
+
+    for (int round = 0; round < rounds; ++round) {
+        uint64_t t0 = test_now_ns();
+        struct legacy_node *legacy_root = legacy_build(window_count, (struct legacy_node **) leaves);
+        uint64_t t1 = test_now_ns();
+        for (int walk = 0; walk < walks; ++walk) {
+            for (struct legacy_node *node = legacy_find_first_leaf(legacy_root); node; node = legacy_find_next_leaf(node)) {
+                legacy_sum += node->window_list[0];
+            }
+        }
+        uint64_t t2 = test_now_ns();
+        legacy_node_destroy(legacy_root);
+        uint64_t t3 = test_now_ns();
+
+        struct window_node *pool_root = pool_build(&view, window_count, (struct window_node **) leaves);
+        uint64_t t4 = test_now_ns();
+        for (int walk = 0; walk < walks; ++walk) {
+            for (struct window_node *node = window_node_find_first_leaf(pool_root); node; node = window_node_find_next_leaf(node)) {
+                pool_sum += node->window_list[0];
+            }
+        }
+        uint64_t t5 = test_now_ns();
+        harness_destroy_layout(&view, pool_root);
+        uint64_t t6 = test_now_ns();
+
+        legacy_build_ns += t1 - t0;
+        legacy_walk_ns += t2 - t1;
+        legacy_teardown_ns += t3 - t2;
+        pool_build_ns += t4 - t3;
+        pool_walk_ns += t5 - t4;
+        pool_teardown_ns += t6 - t5;
+    }
+
+    bench_check(legacy_sum == expected * walks * rounds);
+    bench_check(pool_sum == expected * walks * rounds);
+
+    snprintf(name, sizeof(name), "malloc %4d windows build", window_count);
+    bench_report(name, (uint64_t) rounds * nodes, legacy_build_ns);
+    snprintf(name, sizeof(name), "pool   %4d windows build", window_count);
+    bench_report(name, (uint64_t) rounds * nodes, pool_build_ns);
+    snprintf(name, sizeof(name), "malloc %4d windows leaf walk", window_count);
+    bench_report(name, (uint64_t) rounds * walks * window_count, legacy_walk_ns);
+    snprintf(name, sizeof(name), "pool   %4d windows leaf walk", window_count);
+    bench_report(name, (uint64_t) rounds * walks * window_count, pool_walk_ns);
+    snprintf(name, sizeof(name), "malloc %4d windows teardown", window_count);
+    bench_report(name, (uint64_t) rounds * nodes, legacy_teardown_ns);
+    snprintf(name, sizeof(name), "pool   %4d windows teardown", window_count);
+    bench_report(name, (uint64_t) rounds * nodes, pool_teardown_ns);
+
+    harness_view_free(&view);
+    free(leaves);
+}
+
+//
+// NOTE(koekeishiya): Every leaf queries all four directions, once against the edge index and
+// once with the walk over all leaves that it replaced; both must return the same node. The index
+// is rebuilt after every layout change, so the cost of one rebuild is reported as well.
+//
+
+static void bench_directional_query(int leaf_count)
+{
+    char name[64];
+    struct view view = {0};
+    uint64_t seed = 0x2545f4914f6cdd1dULL ^ leaf_count;
+    int directions[] = { DIR_NORTH, DIR_EAST, DIR_SOUTH, DIR_WEST };
+    int rounds = max(1, 4000 / leaf_count);
+    uint64_t indexed_ns = 0, linear_ns = 0, rebuild_ns = 0, queries = 0;
+
+    harness_build_layout(&view, leaf_count, 4.0f, true, &seed);
+    struct window_node **leaves = malloc(sizeof(struct window_node *) * leaf_count);
+    struct window_node **indexed = malloc(sizeof(struct window_node *) * leaf_count * 4);
+
+    int count = 0;
+    for (struct window_node *node = window_node_find_first_leaf(view.root); node; node = window_node_find_next_leaf(node)) {
+        leaves[count++] = node;
+    }
+
+    bench_check(count == leaf_count);
+
+    for (int round = 0; round < rounds; ++round) {
+        uint64_t t0 = test_now_ns();
+        view_build_edge_index(&view);
+        uint64_t t1 = test_now_ns();
+
+        for (int i = 0; i < count; ++i) {
+            for (int d = 0; d < 4; ++d) {
+                indexed[i * 4 + d] = view_find_window_node_in_direction(&view, leaves[i], directions[d]);
+            }
+        }
+
+        uint64_t t2 = test_now_ns();
+
+        for (int i = 0; i < count; ++i) {
+            for (int d = 0; d < 4; ++d) {
+                bench_check(harness_find_window_node_in_direction(&view, leaves[i], directions[d]) == indexed[i * 4 + d]);
+            }
+        }
+
+        uint64_t t3 = test_now_ns();
+
+        rebuild_ns += t1 - t0;
+        indexed_ns += t2 - t1;
+        linear_ns += t3 - t2;
+        queries += count * 4;
+    }
+
+    snprintf(name, sizeof(name), "edge index rebuild %4d leaves", leaf_count);
+    bench_report(name, rounds, rebuild_ns);
+    snprintf(name, sizeof(name), "edge index query   %4d leaves", leaf_count);
+    bench_report(name, queries, indexed_ns);
+    snprintf(name, sizeof(name), "linear walk query  %4d leaves", leaf_count);
+    bench_report(name, queries, linear_ns);
+
+    free(indexed);
+    free(leaves);
+    harness_destroy_layout(&view, view.root);
+    harness_view_free(&view);
+}
+
+int main(int argc, char **argv)
+{
+    int sizes[] = { 16, 100, 300, 800 };
+    uint64_t seed = 0x853c49e6748fea9bULL;
+
+    printf("sizeof(struct legacy_node) %zu, sizeof(struct window_node) %zu\n", sizeof(struct legacy_node), sizeof(struct window_node));
+
+    split_choice = malloc(sizeof(int) * 800);
+    for (int i = 0; i < 800; ++i) split_choice[i] = test_rand(&seed) & 0x7fffffff;
+
+    for (int i = 0; i < array_count(sizes); ++i) {
+        bench_tree(sizes[i]);
+    }
+
+    free(split_choice);
+
+    int leaf_counts[] = { 4, 16, 100, 1000 };
+    for (int i = 0; i < array_count(leaf_counts); ++i) {
+        bench_directional_query(leaf_counts[i]);
+    }
+
+    return 0;
+}
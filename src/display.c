@@ -16,7 +16,7 @@ static DISPLAY_EVENT_HANDLER(display_handler)
     }
 }
 
-void display_serialize(FILE *rsp, uint32_t did)
+void display_serialize(struct json_writer *json, uint32_t did)
 {
     CGRect frame = display_bounds(did);
 
@@ -27,39 +27,31 @@ void display_serialize(FILE *rsp, uint32_t did)
         CFRelease(uuid_ref);
     }
 
-    int buffer_size = MAXLEN;
-    size_t bytes_written = 0;
-    char buffer[MAXLEN] = {};
-    char *cursor = buffer;
+    json_begin_object(json);
+    json_key(json, "id");     json_int(json, did);
+    json_key(json, "uuid");   json_string(json, uuid ? uuid : "<unknown>");
+    json_key(json, "index");  json_int(json, display_arrangement(did));
+    json_key(json, "spaces");
+    json_begin_array(json);
 
     int count;
     uint64_t *space_list = display_space_list(did, &count);
     if (space_list) {
         for (int i = 0; i < count; ++i) {
-            if (i < count - 1) {
-                bytes_written = snprintf(cursor, buffer_size, "%d, ", space_manager_mission_control_index(space_list[i]));
-            } else {
-                bytes_written = snprintf(cursor, buffer_size, "%d", space_manager_mission_control_index(space_list[i]));
-            }
-
-            cursor += bytes_written;
-            buffer_size -= bytes_written;
-            if (buffer_size <= 0) break;
+            json_int(json, space_manager_mission_control_index(space_list[i]));
         }
         free(space_list);
     }
 
-    fprintf(rsp,
-            "{\n"
-            "\t\"id\":%d,\n"
-            "\t\"uuid\":\"%s\",\n"
-            "\t\"index\":%d,\n"
-            "\t\"spaces\":[%s],\n"
-            "\t\"frame\":{\n\t\t\"x\":%.4f,\n\t\t\"y\":%.4f,\n\t\t\"w\":%.4f,\n\t\t\"h\":%.4f\n\t}\n"
-            "}",
-            did, uuid ? uuid : "<unknown>", display_arrangement(did), buffer,
-            frame.origin.x, frame.origin.y,
-            frame.size.width, frame.size.height);
+    json_end_array(json);
+    json_key(json, "frame");
+    json_begin_object(json);
+    json_key(json, "x");      json_float(json, frame.origin.x);
+    json_key(json, "y");      json_float(json, frame.origin.y);
+    json_key(json, "w");      json_float(json, frame.size.width);
+    json_key(json, "h");      json_float(json, frame.size.height);
+    json_end_object(json);
+    json_end_object(json);
 
     if (uuid) {
         free(uuid);
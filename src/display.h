@@ -8,7 +8,7 @@ extern CFUUIDRef CGDisplayCreateUUIDFromDisplayID(uint32_t did);
 extern CFArrayRef SLSCopyManagedDisplays(int cid);
 extern uint64_t SLSManagedDisplayGetCurrentSpace(int cid, CFStringRef uuid);
 
-void display_serialize(FILE *rsp, uint32_t did);
+void display_serialize(struct json_writer *json, uint32_t did);
 CFStringRef display_uuid(uint32_t did);
 uint32_t display_id(CFStringRef uuid);
 CGRect display_bounds(uint32_t did);
@@ -3,6 +3,7 @@
 extern struct display_manager g_display_manager;
 extern struct window_manager g_window_manager;
 extern int g_connection;
+extern struct json_writer g_json_writer;
 
 bool display_manager_query_displays(FILE *rsp)
 {
@@ -10,12 +11,13 @@ bool display_manager_query_displays(FILE *rsp)
     uint32_t *display_list = display_manager_active_display_list(&count);
     if (!display_list) return false;
 
-    fprintf(rsp, "[");
+    struct json_writer *json = json_writer_begin(&g_json_writer);
+    json_begin_array(json);
     for (int i = 0; i < count; ++i) {
-        display_serialize(rsp, display_list[i]);
-        fprintf(rsp, "%c", i < count - 1 ? ',' : ']');
+        display_serialize(json, display_list[i]);
     }
-    fprintf(rsp, "\n");
+    json_end_array(json);
+    json_writer_end(json, rsp);
 
     free(display_list);
     return true;
@@ -377,11 +377,15 @@ static EVENT_CALLBACK(EVENT_HANDLER_WINDOW_MOVED)
     struct window *window = window_manager_find_window(&g_window_manager, window_id);
     if (!window) return EVENT_FAILURE;
 
+    window_invalidate_attributes(window, WINDOW_ATTRIBUTE_FRAME | WINDOW_ATTRIBUTE_SPACE);
+
     if (!__sync_bool_compare_and_swap(window->id_ptr, &window->id, &window->id)) {
         debug("%s: %d has been marked invalid by the system, ignoring event..\n", __FUNCTION__, window_id);
         return EVENT_FAILURE;
     }
 
+    window_manager_check_applied_frame(window);
+
     if (window->application->is_hidden) {
         debug("%s: %d was moved while the application is hidden, ignoring event..\n", __FUNCTION__, window_id);
         return EVENT_FAILURE;
@@ -397,11 +401,15 @@ static EVENT_CALLBACK(EVENT_HANDLER_WINDOW_RESIZED)
     struct window *window = window_manager_find_window(&g_window_manager, window_id);
     if (!window) return EVENT_FAILURE;
 
+    window_invalidate_attributes(window, WINDOW_ATTRIBUTE_FRAME | WINDOW_ATTRIBUTE_SPACE | WINDOW_ATTRIBUTE_CAPABILITY | WINDOW_ATTRIBUTE_FULLSCREEN);
+
     if (!__sync_bool_compare_and_swap(window->id_ptr, &window->id, &window->id)) {
         debug("%s: %d has been marked invalid by the system, ignoring event..\n", __FUNCTION__, window_id);
         return EVENT_FAILURE;
     }
 
+    window_manager_check_applied_frame(window);
+
     if (window->application->is_hidden) {
         debug("%s: %d was resized while the application is hidden, ignoring event..\n", __FUNCTION__, window_id);
         return EVENT_FAILURE;
@@ -460,6 +468,8 @@ static EVENT_CALLBACK(EVENT_HANDLER_WINDOW_MINIMIZED)
     struct window *window = window_manager_find_window(&g_window_manager, window_id);
     if (!window) return EVENT_FAILURE;
 
+    window_invalidate_attributes(window, WINDOW_ATTRIBUTE_MINIMIZED);
+
     if (!__sync_bool_compare_and_swap(window->id_ptr, &window->id, &window->id)) {
         debug("%s: %d has been marked invalid by the system, ignoring event..\n", __FUNCTION__, window_id);
         return EVENT_FAILURE;
@@ -488,6 +498,8 @@ static EVENT_CALLBACK(EVENT_HANDLER_WINDOW_DEMINIMIZED)
     struct window *window = window_manager_find_window(&g_window_manager, window_id);
     if (!window) return EVENT_FAILURE;
 
+    window_invalidate_attributes(window, WINDOW_ATTRIBUTE_MINIMIZED | WINDOW_ATTRIBUTE_FRAME | WINDOW_ATTRIBUTE_SPACE);
+
     if (!__sync_bool_compare_and_swap(window->id_ptr, &window->id, &window->id)) {
         debug("%s: %d has been marked invalid by the system, ignoring event..\n", __FUNCTION__, window_id);
         window_manager_remove_lost_focused_event(&g_window_manager, window_id);
@@ -522,6 +534,8 @@ static EVENT_CALLBACK(EVENT_HANDLER_WINDOW_TITLE_CHANGED)
     struct window *window = window_manager_find_window(&g_window_manager, window_id);
     if (!window) return EVENT_FAILURE;
 
+    window_invalidate_attributes(window, WINDOW_ATTRIBUTE_TITLE);
+
     if (!__sync_bool_compare_and_swap(window->id_ptr, &window->id, &window->id)) {
         debug("%s: %d has been marked invalid by the system, ignoring event..\n", __FUNCTION__, window_id);
         return EVENT_FAILURE;
@@ -535,6 +549,7 @@ static EVENT_CALLBACK(EVENT_HANDLER_SPACE_CHANGED)
 {
     g_space_manager.last_space_id = g_space_manager.current_space_id;
     g_space_manager.current_space_id = space_manager_active_space();
+    window_manager_invalidate_window_attributes(&g_window_manager);
 
     debug("%s: %lld\n", __FUNCTION__, g_space_manager.current_space_id);
     struct view *view = space_manager_find_view(&g_space_manager, g_space_manager.current_space_id);
@@ -561,6 +576,7 @@ static EVENT_CALLBACK(EVENT_HANDLER_DISPLAY_CHANGED)
 {
     g_display_manager.last_display_id = g_display_manager.current_display_id;
     g_display_manager.current_display_id = display_manager_active_display_id();
+    window_manager_invalidate_window_attributes(&g_window_manager);
 
     g_space_manager.last_space_id = g_space_manager.current_space_id;
     g_space_manager.current_space_id = display_space_id(g_display_manager.current_display_id);
@@ -596,6 +612,7 @@ static EVENT_CALLBACK(EVENT_HANDLER_DISPLAY_ADDED)
 {
     uint32_t did = (uint32_t)(intptr_t) context;
     debug("%s: %d\n", __FUNCTION__, did);
+    window_manager_invalidate_window_attributes(&g_window_manager);
     space_manager_handle_display_add(&g_space_manager, did);
     window_manager_handle_display_add_and_remove(&g_space_manager, &g_window_manager, did);
     return EVENT_SUCCESS;
@@ -605,6 +622,7 @@ static EVENT_CALLBACK(EVENT_HANDLER_DISPLAY_REMOVED)
 {
     uint32_t did = display_manager_main_display_id();
     debug("%s: %d\n", __FUNCTION__, did);
+    window_manager_invalidate_window_attributes(&g_window_manager);
     window_manager_handle_display_add_and_remove(&g_space_manager, &g_window_manager, did);
     return EVENT_SUCCESS;
 }
@@ -613,6 +631,7 @@ static EVENT_CALLBACK(EVENT_HANDLER_DISPLAY_MOVED)
 {
     uint32_t did = (uint32_t)(intptr_t) context;
     debug("%s: %d\n", __FUNCTION__, did);
+    window_manager_invalidate_window_attributes(&g_window_manager);
     space_manager_mark_spaces_invalid(&g_space_manager);
     return EVENT_SUCCESS;
 }
@@ -621,6 +640,7 @@ static EVENT_CALLBACK(EVENT_HANDLER_DISPLAY_RESIZED)
 {
     uint32_t did = (uint32_t)(intptr_t) context;
     debug("%s: %d\n", __FUNCTION__, did);
+    window_manager_invalidate_window_attributes(&g_window_manager);
     space_manager_mark_spaces_invalid_for_display(&g_space_manager, did);
     return EVENT_SUCCESS;
 }
@@ -752,6 +772,8 @@ static EVENT_CALLBACK(EVENT_HANDLER_MOUSE_DRAGGED)
         }
 
         scripting_addition_move_window(g_mouse_state.window->id, new_point.x, new_point.y);
+        g_mouse_state.window->has_applied_frame = false;
+        window_invalidate_attributes(g_mouse_state.window, WINDOW_ATTRIBUTE_FRAME);
     } else if (g_mouse_state.current_action == MOUSE_MODE_RESIZE) {
         uint64_t event_time = CGEventGetTimestamp(context);
         float dt = ((float) event_time - g_mouse_state.last_moved_time) * (1.0f / 1E6);
@@ -925,6 +947,7 @@ static EVENT_CALLBACK(EVENT_HANDLER_MISSION_CONTROL_EXIT)
 {
     debug("%s:\n", __FUNCTION__);
     g_mission_control_active = false;
+    window_manager_invalidate_window_attributes(&g_window_manager);
 
     for (int i = 0; i < buf_len(g_window_manager.insert_feedback_windows); ++i) {
         uint32_t feedback_wid = g_window_manager.insert_feedback_windows[i];
@@ -943,20 +966,16 @@ static EVENT_CALLBACK(EVENT_HANDLER_MISSION_CONTROL_EXIT)
 static EVENT_CALLBACK(EVENT_HANDLER_DOCK_DID_RESTART)
 {
     debug("%s:\n", __FUNCTION__);
+    window_manager_invalidate_window_attributes(&g_window_manager);
 
     if (!workspace_is_macos_bigsur() && scripting_addition_is_installed()) {
         scripting_addition_load();
 
         for (int window_index = 0; window_index < g_window_manager.window.capacity; ++window_index) {
-            struct bucket *bucket = g_window_manager.window.buckets[window_index];
-            while (bucket) {
-                if (bucket->value) {
-                    struct window *window = bucket->value;
-                    window_manager_purify_window(&g_window_manager, window);
-                }
+            struct window *window = g_window_manager.window.buckets[window_index].value;
+            if (!window) continue;
 
-                bucket = bucket->next;
-            }
+            window_manager_purify_window(&g_window_manager, window);
         }
     }
 
@@ -991,6 +1010,7 @@ static EVENT_CALLBACK(EVENT_HANDLER_DOCK_DID_CHANGE_PREF)
 static EVENT_CALLBACK(EVENT_HANDLER_SYSTEM_WOKE)
 {
     debug("%s:\n", __FUNCTION__);
+    window_manager_invalidate_window_attributes(&g_window_manager);
     struct window *focused_window = window_manager_find_window(&g_window_manager, g_window_manager.focused_window_id);
     if (focused_window) {
         window_manager_set_window_opacity(&g_window_manager, focused_window, g_window_manager.active_window_opacity);
@@ -1017,3 +1037,38 @@ out:
 
     return EVENT_SUCCESS;
 }
+
+static EVENT_CALLBACK(EVENT_HANDLER_DAEMON_SESSION_MESSAGE)
+{
+    if (!context) {
+        socket_close(param1);
+        return EVENT_SUCCESS;
+    }
+
+    char *response = NULL;
+    size_t length = 0;
+
+    FILE *rsp = open_memstream(&response, &length);
+    if (!rsp) {
+        socket_write_frame(param1, FAILURE_MESSAGE, 1);
+        goto out;
+    }
+
+    debug_message(__FUNCTION__, context);
+    handle_message(rsp, context);
+    fclose(rsp);
+
+    //
+    // NOTE(koekeishiya): Every message is answered with exactly one frame, even when the
+    // response is empty, so that the client can pair responses with the commands it sent.
+    // A failed write means the client went away; the session thread will notice and end it.
+    //
+
+    socket_write_frame(param1, response, length);
+
+out:
+    if (response) free(response);
+    free(context);
+
+    return EVENT_SUCCESS;
+}
@@ -38,6 +38,7 @@ static EVENT_CALLBACK(EVENT_HANDLER_MENU_BAR_HIDDEN_CHANGED);
 static EVENT_CALLBACK(EVENT_HANDLER_DOCK_DID_CHANGE_PREF);
 static EVENT_CALLBACK(EVENT_HANDLER_SYSTEM_WOKE);
 static EVENT_CALLBACK(EVENT_HANDLER_DAEMON_MESSAGE);
+static EVENT_CALLBACK(EVENT_HANDLER_DAEMON_SESSION_MESSAGE);
 
 #define EVENT_QUEUED    0x0
 #define EVENT_PROCESSED 0x1
@@ -86,6 +87,7 @@ enum event_type
     DOCK_DID_CHANGE_PREF,
     SYSTEM_WOKE,
     DAEMON_MESSAGE,
+    DAEMON_SESSION_MESSAGE,
 
     EVENT_TYPE_COUNT
 };
@@ -128,6 +130,7 @@ static const char *event_type_str[] =
     [DOCK_DID_CHANGE_PREF]           = "dock_did_change_pref",
     [SYSTEM_WOKE]                    = "system_woke",
     [DAEMON_MESSAGE]                 = "daemon_message",
+    [DAEMON_SESSION_MESSAGE]         = "daemon_session_message",
 
     [EVENT_TYPE_COUNT]               = "event_type_count"
 };
@@ -168,6 +171,7 @@ static event_callback *event_handler[] =
     [DOCK_DID_CHANGE_PREF]           = EVENT_HANDLER_DOCK_DID_CHANGE_PREF,
     [SYSTEM_WOKE]                    = EVENT_HANDLER_SYSTEM_WOKE,
     [DAEMON_MESSAGE]                 = EVENT_HANDLER_DAEMON_MESSAGE,
+    [DAEMON_SESSION_MESSAGE]         = EVENT_HANDLER_DAEMON_SESSION_MESSAGE,
 };
 
 struct event
@@ -2,51 +2,169 @@
 
 static inline bool queue_init(struct queue *queue)
 {
-    if (!memory_pool_init(&queue->pool, QUEUE_POOL_SIZE)) return false;
-    queue->head = memory_pool_push(&queue->pool, struct queue_item);
-    queue->head->data = NULL;
-    queue->head->next = NULL;
-    queue->tail = queue->head;
+    queue->slots = malloc(EVENT_QUEUE_SIZE * sizeof(struct queue_slot));
+    if (!queue->slots) return false;
+
+    for (uint64_t i = 0; i < EVENT_QUEUE_SIZE; ++i) {
+        queue->slots[i].sequence = i;
+    }
+
+    queue->head = 0;
+    queue->tail = 0;
     return true;
 }
 
-static inline void queue_push(struct queue *queue, struct event *event)
+//
+// NOTE(koekeishiya): Bounded MPMC ring-buffer. Every slot carries a sequence number
+// that tells producers and consumers whether the slot is free for the current lap,
+// so a full queue is reported to the caller instead of overwriting live events.
+//
+
+static inline bool queue_push(struct queue *queue, struct event *event)
+{
+    struct queue_slot *slot;
+    uint64_t pos = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+
+    for (;;) {
+        slot = &queue->slots[pos & EVENT_QUEUE_MASK];
+        uint64_t sequence = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        int64_t diff = (int64_t) sequence - (int64_t) pos;
+
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&queue->head, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+        }
+    }
+
+    slot->event = *event;
+    __atomic_store_n(&slot->sequence, pos + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+static inline bool queue_pop(struct queue *queue, struct event *event)
+{
+    struct queue_slot *slot;
+    uint64_t pos = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+
+    for (;;) {
+        slot = &queue->slots[pos & EVENT_QUEUE_MASK];
+        uint64_t sequence = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        int64_t diff = (int64_t) sequence - (int64_t) (pos + 1);
+
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&queue->tail, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+        }
+    }
+
+    *event = slot->event;
+    __atomic_store_n(&slot->sequence, pos + EVENT_QUEUE_SIZE, __ATOMIC_RELEASE);
+    return true;
+}
+
+static inline bool queue_is_empty(struct queue *queue)
+{
+    uint64_t pos = __atomic_load_n(&queue->tail, __ATOMIC_SEQ_CST);
+    struct queue_slot *slot = &queue->slots[pos & EVENT_QUEUE_MASK];
+    return __atomic_load_n(&slot->sequence, __ATOMIC_SEQ_CST) != pos + 1;
+}
+
+static inline bool event_loop_is_droppable(enum event_type type)
 {
-    bool success;
-    struct queue_item *tail, *new_tail;
+    return type == MOUSE_DRAGGED || type == MOUSE_MOVED;
+}
 
-    new_tail = memory_pool_push(&queue->pool, struct queue_item);
-    new_tail->data = event;
-    new_tail->next = NULL;
-    __asm__ __volatile__ ("" ::: "memory");
+static inline bool event_loop_is_message(enum event_type type)
+{
+    return type == DAEMON_MESSAGE || type == DAEMON_SESSION_MESSAGE;
+}
+
+//
+// NOTE(koekeishiya): Events that can not be dropped are moved to an unbounded overflow list
+// when the queue is full. While the list is non-empty every new event is appended to it as
+// well, so that events are still handled in the order they were posted; the consumer only
+// takes from the list once the queue is empty, and the queue is used again once it is drained.
+//
 
-    do {
-        tail = queue->tail;
-        success = __sync_bool_compare_and_swap(&tail->next, NULL, new_tail);
-    } while (!success);
-    __sync_bool_compare_and_swap(&queue->tail, tail, new_tail);
+static inline bool event_loop_has_overflow(struct event_loop *event_loop)
+{
+    return __atomic_load_n(&event_loop->overflow.count, __ATOMIC_ACQUIRE) > 0;
 }
 
-static inline struct event *queue_pop(struct queue *queue)
+static void event_loop_push_overflow(struct event_loop *event_loop, struct event *event)
 {
-    struct queue_item *head;
+    struct event_overflow *overflow = &event_loop->overflow;
 
-    do {
-        head = queue->head;
-        if (!head->next) return NULL;
-    } while (!__sync_bool_compare_and_swap(&queue->head, head, head->next));
+    pthread_mutex_lock(&overflow->lock);
+    if (overflow->head == buf_len(overflow->events)) {
+        buf_truncate(overflow->events, 0);
+        overflow->head = 0;
+    }
+
+    buf_push(overflow->events, *event);
+    __atomic_add_fetch(&overflow->count, 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&overflow->lock);
 
-    return head->next->data;
+    __atomic_add_fetch(&event_loop->stats.overflowed, 1, __ATOMIC_RELAXED);
 }
 
-static inline struct event *event_loop_create_event(struct event_loop *event_loop, enum event_type type, void *context, int param1, volatile uint32_t *info)
+static bool event_loop_pop_overflow(struct event_loop *event_loop, struct event *event)
 {
-    struct event *event = memory_pool_push(&event_loop->pool, struct event);
-    event->type = type;
-    event->context = context;
-    event->param1 = param1;
-    event->info = info;
-    return event;
+    struct event_overflow *overflow = &event_loop->overflow;
+    if (!event_loop_has_overflow(event_loop)) return false;
+
+    pthread_mutex_lock(&overflow->lock);
+    *event = overflow->events[overflow->head++];
+    __atomic_sub_fetch(&overflow->count, 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&overflow->lock);
+
+    return true;
+}
+
+//
+// NOTE(koekeishiya): The handlers for WINDOW_MOVED and WINDOW_RESIZED read the current
+// frame of the window, so there is no point in queueing another one while an event for
+// the same window is still pending. The producer that claims the slot queues the event;
+// the slot is released right before the handler runs, so no update is ever missed.
+// Two windows that map to the same slot simply bypass coalescing.
+//
+
+static inline volatile uint32_t *event_loop_pending_slot(struct event_loop *event_loop, enum event_type type, void *context)
+{
+    uint32_t window_id = (uint32_t)(uintptr_t) context;
+
+    switch (type) {
+    default: return NULL;
+    case WINDOW_MOVED:   return &event_loop->pending.moved[window_id & EVENT_PENDING_MASK];
+    case WINDOW_RESIZED: return &event_loop->pending.resized[window_id & EVENT_PENDING_MASK];
+    }
+}
+
+static inline bool event_loop_claim_pending(struct event_loop *event_loop, enum event_type type, void *context)
+{
+    volatile uint32_t *pending = event_loop_pending_slot(event_loop, type, context);
+    if (!pending) return true;
+
+    uint32_t expected = 0;
+    uint32_t window_id = (uint32_t)(uintptr_t) context;
+    if (__atomic_compare_exchange_n(pending, &expected, window_id, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) return true;
+
+    return expected != window_id;
+}
+
+static inline void event_loop_release_pending(struct event_loop *event_loop, enum event_type type, void *context)
+{
+    volatile uint32_t *pending = event_loop_pending_slot(event_loop, type, context);
+    if (!pending) return;
+
+    uint32_t expected = (uint32_t)(uintptr_t) context;
+    __atomic_compare_exchange_n(pending, &expected, 0, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
 }
 
 static inline void event_loop_destroy_event(struct event *event)
@@ -69,39 +187,176 @@ static inline void event_loop_destroy_event(struct event *event)
     }
 }
 
+static inline void event_loop_drop_event(struct event_loop *event_loop, struct event *event)
+{
+    __atomic_add_fetch(&event_loop->stats.dropped, 1, __ATOMIC_RELAXED);
+    debug("%s: queue is full, dropped %s\n", __FUNCTION__, event_type_str[event->type]);
+
+    if (event->type == DAEMON_MESSAGE) {
+        socket_write(event->param1, FAILURE_MESSAGE"event queue is full, try again\n");
+        socket_close(event->param1);
+        free(event->context);
+    } else if (event->type == DAEMON_SESSION_MESSAGE) {
+        // the session thread still owns the message and will post it again
+    } else {
+        event_loop_release_pending(event_loop, event->type, event->context);
+        event_loop_destroy_event(event);
+    }
+
+    if (event->info) *event->info = (EVENT_FAILURE << 0x1) | EVENT_PROCESSED;
+}
+
+//
+// NOTE(koekeishiya): Only the most recent position of a mouse drag matters, so when the
+// event tap has queued several MOUSE_DRAGGED events back-to-back we skip straight to the
+// newest one. The first event that is not part of the run is kept for the next iteration.
+//
+
+static inline bool event_loop_coalesce_drag(struct event_loop *event_loop, struct event *event, struct event *next)
+{
+    while (queue_pop(&event_loop->queue, next)) {
+        if (next->type != MOUSE_DRAGGED) return true;
+
+        if (event->info) *event->info = (EVENT_SUCCESS << 0x1) | EVENT_PROCESSED;
+        event_loop_destroy_event(event);
+        __atomic_add_fetch(&event_loop->stats.coalesced, 1, __ATOMIC_RELAXED);
+        *event = *next;
+    }
+
+    return false;
+}
+
+//
+// NOTE(koekeishiya): The consumer drains the queue completely and only then announces that
+// it is going to sleep. Producers ring the semaphore solely when they observe that flag,
+// which turns one sem_post/sem_wait pair per event into one pair per empty -> non-empty
+// transition. The queue is checked again after the flag is raised so that an event which
+// was published concurrently is never left behind; if a producer already took the flag,
+// the matching post is consumed to keep the semaphore count balanced.
+//
+
+static inline void event_loop_wait(struct event_loop *event_loop)
+{
+    __atomic_store_n(&event_loop->is_sleeping, true, __ATOMIC_SEQ_CST);
+
+    if (queue_is_empty(&event_loop->queue) && !event_loop_has_overflow(event_loop)) {
+        sem_wait(event_loop->semaphore);
+        __atomic_add_fetch(&event_loop->stats.wakeups, 1, __ATOMIC_RELAXED);
+    } else if (!__atomic_exchange_n(&event_loop->is_sleeping, false, __ATOMIC_SEQ_CST)) {
+        sem_wait(event_loop->semaphore);
+    }
+}
+
+static inline void event_loop_wake(struct event_loop *event_loop)
+{
+    if (__atomic_exchange_n(&event_loop->is_sleeping, false, __ATOMIC_SEQ_CST)) {
+        sem_post(event_loop->semaphore);
+    }
+}
+
 static void *event_loop_run(void *context)
 {
+    struct event event, next;
+    bool has_next = false;
     struct event_loop *event_loop = (struct event_loop *) context;
+
     while (event_loop->is_running) {
-        struct event *event = queue_pop(&event_loop->queue);
-        if (event) {
-            uint32_t result = event_handler[event->type](event->context, event->param1);
+        if (has_next) {
+            event = next;
+            has_next = false;
+        } else if (!queue_pop(&event_loop->queue, &event) && !event_loop_pop_overflow(event_loop, &event)) {
+            event_loop_wait(event_loop);
+            continue;
+        }
+
+        if (event.type == MOUSE_DRAGGED) {
+            has_next = event_loop_coalesce_drag(event_loop, &event, &next);
+        } else {
+            event_loop_release_pending(event_loop, event.type, event.context);
+        }
 
-            if (result == EVENT_SUCCESS) event_signal_transmit(event->context, event->type);
+        //
+        // NOTE(koekeishiya): The message handlers free the message, so whether a session event
+        // carried a message must be decided before the handler runs, and the signal is sent
+        // without a context; the daemon_message signal does not read it.
+        //
 
-            if (event->info) *event->info = (result << 0x1) | EVENT_PROCESSED;
+        bool is_session_message = event.type == DAEMON_SESSION_MESSAGE && event.context;
 
-            event_loop_destroy_event(event);
-        } else {
-            sem_wait(event_loop->semaphore);
+        scripting_addition_begin_batch();
+        uint32_t result = event_handler[event.type](event.context, event.param1);
+        scripting_addition_end_batch();
+
+        if (result == EVENT_SUCCESS) {
+            if (event.type == DAEMON_MESSAGE || is_session_message) {
+                event_signal_transmit(NULL, DAEMON_MESSAGE);
+            } else if (event.type != DAEMON_SESSION_MESSAGE) {
+                event_signal_transmit(event.context, event.type);
+            }
         }
+
+        if (event.info) *event.info = (result << 0x1) | EVENT_PROCESSED;
+
+        event_loop_destroy_event(&event);
     }
 
     return NULL;
 }
 
-void event_loop_post(struct event_loop *event_loop, enum event_type type, void *context, int param1, volatile uint32_t *info)
+bool event_loop_post(struct event_loop *event_loop, enum event_type type, void *context, int param1, volatile uint32_t *info)
 {
     assert(event_loop->is_running);
-    queue_push(&event_loop->queue, event_loop_create_event(event_loop, type, context, param1, info));
-    sem_post(event_loop->semaphore);
+
+    struct event event = {
+        .context = context,
+        .info    = info,
+        .type    = type,
+        .param1  = param1
+    };
+
+    if (!info && !event_loop_claim_pending(event_loop, type, context)) {
+        __atomic_add_fetch(&event_loop->stats.coalesced, 1, __ATOMIC_RELAXED);
+        return true;
+    }
+
+    //
+    // NOTE(koekeishiya): Handlers also post events, from the thread that drains the queue. That
+    // thread must never wait for the queue to make room, so its events go to the overflow list
+    // right away. Other producers are throttled for a while before falling back to the list.
+    // Only mouse motion, which is superseded by the next event anyway, and daemon messages,
+    // whose client is told to try again, are ever dropped.
+    //
+
+    bool is_consumer = pthread_equal(pthread_self(), event_loop->thread);
+
+    for (int retry = 0; event_loop_has_overflow(event_loop) || !queue_push(&event_loop->queue, &event); ++retry) {
+        if (event_loop_is_droppable(type) || (event_loop_is_message(type) && retry >= EVENT_QUEUE_MAX_RETRY)) {
+            event_loop_drop_event(event_loop, &event);
+            return false;
+        }
+
+        if (is_consumer || retry >= EVENT_QUEUE_MAX_RETRY || event_loop_has_overflow(event_loop)) {
+            event_loop_push_overflow(event_loop, &event);
+            break;
+        }
+
+        if (retry == 0) __atomic_add_fetch(&event_loop->stats.stalled, 1, __ATOMIC_RELAXED);
+        usleep(EVENT_QUEUE_RETRY_DELAY);
+    }
+
+    event_loop_wake(event_loop);
+    return true;
 }
 
 bool event_loop_init(struct event_loop *event_loop)
 {
     if (!queue_init(&event_loop->queue)) return false;
-    if (!memory_pool_init(&event_loop->pool, EVENT_POOL_SIZE)) return false;
+    memset(&event_loop->pending, 0, sizeof(struct event_pending));
+    memset(&event_loop->stats, 0, sizeof(struct event_loop_stats));
+    memset(&event_loop->overflow, 0, sizeof(struct event_overflow));
+    pthread_mutex_init(&event_loop->overflow.lock, NULL);
     event_loop->is_running = false;
+    event_loop->is_sleeping = false;
     event_loop->semaphore = sem_open("yabai_event_loop_semaphore", O_CREAT, 0600, 0);
     sem_unlink("yabai_event_loop_semaphore");
     return event_loop->semaphore != SEM_FAILED;
@@ -119,6 +374,7 @@ bool event_loop_end(struct event_loop *event_loop)
 {
     if (!event_loop->is_running) return false;
     event_loop->is_running = false;
+    sem_post(event_loop->semaphore);
     pthread_join(event_loop->thread, NULL);
     return true;
 }
@@ -1,37 +1,65 @@
 #ifndef EVENT_LOOP_H
 #define EVENT_LOOP_H
 
-#define EVENT_POOL_SIZE KILOBYTES(36)
-#define EVENT_MAX_COUNT ((EVENT_POOL_SIZE) / (sizeof(struct event)))
+#define EVENT_QUEUE_SIZE        4096
+#define EVENT_QUEUE_MASK        (EVENT_QUEUE_SIZE - 1)
+#define EVENT_QUEUE_MAX_RETRY   100
+#define EVENT_QUEUE_RETRY_DELAY 1000
 
-#define QUEUE_POOL_SIZE KILOBYTES(16)
-#define QUEUE_MAX_COUNT ((QUEUE_POOL_SIZE) / (sizeof(struct queue_item)))
+#define EVENT_PENDING_SIZE      256
+#define EVENT_PENDING_MASK      (EVENT_PENDING_SIZE - 1)
 
-struct queue_item
+struct queue_slot
 {
-    struct event *data;
-    struct queue_item *next;
+    volatile uint64_t sequence;
+    struct event event;
 };
 
 struct queue
 {
-    struct memory_pool pool;
-    struct queue_item *head;
-    struct queue_item *tail;
+    struct queue_slot *slots;
+    volatile uint64_t head __attribute__((aligned(64)));
+    volatile uint64_t tail __attribute__((aligned(64)));
+};
+
+struct event_pending
+{
+    volatile uint32_t moved[EVENT_PENDING_SIZE];
+    volatile uint32_t resized[EVENT_PENDING_SIZE];
+};
+
+struct event_overflow
+{
+    pthread_mutex_t lock;
+    struct event *events;
+    int head;
+    volatile int count;
+};
+
+struct event_loop_stats
+{
+    volatile uint64_t dropped;
+    volatile uint64_t overflowed;
+    volatile uint64_t stalled;
+    volatile uint64_t coalesced;
+    volatile uint64_t wakeups;
 };
 
 struct event_loop
 {
     bool is_running;
+    volatile bool is_sleeping;
     pthread_t thread;
     sem_t *semaphore;
     struct queue queue;
-    struct memory_pool pool;
+    struct event_pending pending;
+    struct event_overflow overflow;
+    struct event_loop_stats stats;
 };
 
 bool event_loop_init(struct event_loop *event_loop);
 bool event_loop_begin(struct event_loop *event_loop);
 bool event_loop_end(struct event_loop *event_loop);
-void event_loop_post(struct event_loop *event_loop, enum event_type type, void *context, int param1, volatile uint32_t *info);
+bool event_loop_post(struct event_loop *event_loop, enum event_type type, void *context, int param1, volatile uint32_t *info);
 
 #endif
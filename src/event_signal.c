@@ -5,31 +5,9 @@ extern struct process_manager g_process_manager;
 extern struct display_manager g_display_manager;
 extern struct space_manager g_space_manager;
 extern struct window_manager g_window_manager;
+extern struct json_writer g_json_writer;
 
-static void event_signal_serialize(FILE *rsp, struct signal *signal, enum event_type type, int index)
-{
-    char *escaped_action = string_escape(signal->command);
-
-    fprintf(rsp,
-            "{\n"
-            "\t\"index\":%d,\n"
-            "\t\"label\":\"%s\",\n"
-            "\t\"app\":\"%s\",\n"
-            "\t\"title\":\"%s\",\n"
-            "\t\"event\":\"%s\",\n"
-            "\t\"action\":\"%s\"\n"
-            "}",
-            index,
-            signal->label ? signal->label : "",
-            signal->app ? signal->app : "",
-            signal->title ? signal->title : "",
-            event_type_str[type],
-            escaped_action ? escaped_action : signal->command ? signal->command : "");
-
-    if (escaped_action) free(escaped_action);
-}
-
-static void event_signal_populate_args(void *context, enum event_type type, struct signal_args *args)
+static void event_signal_populate_args(void *context, enum event_type type, struct signal_args *args, bool need_title)
 {
     switch (type) {
     default: break;
@@ -62,7 +40,7 @@ static void event_signal_populate_args(void *context, enum event_type type, stru
         snprintf(args->name[0], sizeof(args->name[0]), "%s", "YABAI_WINDOW_ID");
         snprintf(args->value[0], sizeof(args->value[0]), "%d", wid);
         args->entity = window_manager_find_window(&g_window_manager, wid);
-        if (args->entity) args->param1 = window_title(args->entity);
+        if (args->entity && need_title) args->param1 = window_title(args->entity);
     } break;
     case WINDOW_DESTROYED: {
         uint32_t wid = (uint32_t)(uintptr_t) context;
@@ -79,7 +57,7 @@ static void event_signal_populate_args(void *context, enum event_type type, stru
         snprintf(args->name[0], sizeof(args->name[0]), "%s", "YABAI_WINDOW_ID");
         snprintf(args->value[0], sizeof(args->value[0]), "%d", wid);
         args->entity = window_manager_find_window(&g_window_manager, wid);
-        if (args->entity) args->param1 = window_title(args->entity);
+        if (args->entity && need_title) args->param1 = window_title(args->entity);
     } break;
     case SPACE_CHANGED: {
         snprintf(args->name[0], sizeof(args->name[0]), "%s", "YABAI_SPACE_ID");
@@ -136,28 +114,144 @@ static void event_signal_destroy_args(enum event_type type, struct signal_args *
     }
 }
 
-static bool event_signal_filter(struct signal *signal, enum event_type type, struct signal_args *args)
+//
+// NOTE(koekeishiya): The app and title filters of all signals for an event type are compiled into
+// an index, where identical patterns share a single entry. Literal patterns are compared directly
+// (see regex_literal), and patterns of the form ^literal$ are exact matches that are resolved with
+// a single hash lookup of the app name or title. The remaining patterns are combined into a single
+// automaton (see pattern.h) that finds all of them in one pass, and only patterns it does not
+// support still use regexec. Every entry is evaluated at most once per event, so that signals using
+// the same filter do not match again. The index is rebuilt lazily after signals are added or
+// removed. The window title is only fetched if some signal filters on it.
+//
+
+static struct signal_filter_index signal_filter_index[EVENT_TYPE_COUNT];
+
+static int event_signal_filter_set_add(struct signal_filter_set *set, char *pattern, regex_t *regex)
+{
+    for (int i = 0; i < buf_len(set->filter); ++i) {
+        if (string_equals(set->filter[i].pattern, pattern)) return i;
+    }
+
+    int id = buf_len(set->filter);
+    struct signal_filter filter = { .pattern = pattern, .regex = regex, .next = -1 };
+    filter.kind = regex_literal(pattern, &filter.literal);
+    filter.pattern_id = filter.kind == REGEX_LITERAL_NONE ? pattern_set_add(&set->patterns, pattern) : -1;
+
+    if (filter.kind == REGEX_LITERAL_EXACT) {
+        uint64_t hash = table_hash_string(filter.literal, strlen(filter.literal));
+        void *head = literal_table_find(&set->exact, hash);
+
+        if (head) {
+            struct signal_filter *collision = &set->filter[(intptr_t) head - 1];
+            filter.next = collision->next;
+            collision->next = id;
+        } else {
+            literal_table_add(&set->exact, hash, (void *)(intptr_t)(id + 1));
+        }
+    }
+
+    buf_push(set->filter, filter);
+    return id;
+}
+
+static void event_signal_filter_set_free(struct signal_filter_set *set)
+{
+    for (int i = 0; i < buf_len(set->filter); ++i) {
+        if (set->filter[i].literal) free(set->filter[i].literal);
+    }
+
+    buf_free(set->filter);
+    set->filter = NULL;
+    literal_table_free(&set->exact);
+    pattern_set_free(&set->patterns);
+}
+
+static struct signal_filter_index *event_signal_filter_index(enum event_type type)
+{
+    struct signal_filter_index *index = &signal_filter_index[type];
+    if (index->is_built) return index;
+
+    event_signal_filter_set_free(&index->app);
+    event_signal_filter_set_free(&index->title);
+    literal_table_init(&index->app.exact, 8);
+    literal_table_init(&index->title.exact, 8);
+
+    for (int i = 0; i < buf_len(g_signal_event[type]); ++i) {
+        struct signal *signal = &g_signal_event[type][i];
+        signal->app_filter   = signal->app_regex_valid   ? event_signal_filter_set_add(&index->app,   signal->app,   &signal->app_regex)   : -1;
+        signal->title_filter = signal->title_regex_valid ? event_signal_filter_set_add(&index->title, signal->title, &signal->title_regex) : -1;
+    }
+
+    index->is_built = true;
+    return index;
+}
+
+static void event_signal_filter_set_begin(struct signal_filter_set *set, char *subject)
+{
+    set->subject = subject;
+    set->matches = NULL;
+
+    for (int i = 0; i < buf_len(set->filter); ++i) {
+        if (!subject) {
+            set->filter[i].result = REGEX_MATCH_UD;
+        } else if (set->filter[i].kind == REGEX_LITERAL_EXACT) {
+            set->filter[i].result = REGEX_MATCH_NO;
+        } else {
+            set->filter[i].result = SIGNAL_FILTER_UNRESOLVED;
+        }
+    }
+
+    if (!subject || !set->exact.count) return;
+
+    void *head = literal_table_find(&set->exact, table_hash_string(subject, strlen(subject)));
+    for (int id = head ? (intptr_t) head - 1 : -1; id != -1; id = set->filter[id].next) {
+        if (string_equals(set->filter[id].literal, subject)) set->filter[id].result = REGEX_MATCH_YES;
+    }
+}
+
+static int event_signal_filter_set_match(struct signal_filter_set *set, int id)
+{
+    if (id == -1) return REGEX_MATCH_UD;
+
+    struct signal_filter *filter = &set->filter[id];
+    if (filter->result == SIGNAL_FILTER_UNRESOLVED) {
+        if (filter->kind != REGEX_LITERAL_NONE) {
+            filter->result = regex_literal_match(filter->kind, filter->literal, set->subject);
+        } else if (filter->pattern_id != -1) {
+            if (!set->matches) set->matches = pattern_set_match(&set->patterns, set->subject);
+            filter->result = pattern_set_has(set->matches, filter->pattern_id) ? REGEX_MATCH_YES : REGEX_MATCH_NO;
+        } else {
+            filter->result = regex_match(true, filter->regex, set->subject);
+        }
+    }
+
+    return filter->result;
+}
+
+static bool event_signal_filter_begin(struct signal_filter_index *index, enum event_type type, struct signal_args *args)
 {
+    char *app = NULL;
+    char *title = NULL;
+
     switch (type) {
-    default: return false;
+    default: break;
 
     case APPLICATION_LAUNCHED:
     case APPLICATION_TERMINATED: {
         struct process *process = args->entity;
-        if (!process) return true;
+        if (!process) return false;
 
-        int regex_match_app = signal->app_regex_exclude ? REGEX_MATCH_YES : REGEX_MATCH_NO;
-        return regex_match(signal->app_regex_valid, &signal->app_regex, process->name) == regex_match_app;
+        app = process->name;
     } break;
     case APPLICATION_ACTIVATED:
     case APPLICATION_DEACTIVATED:
     case APPLICATION_VISIBLE:
     case APPLICATION_HIDDEN: {
         struct application *application = args->entity;
-        if (!application) return true;
+        if (!application) return false;
 
-        int regex_match_app = signal->app_regex_exclude ? REGEX_MATCH_YES : REGEX_MATCH_NO;
-        return regex_match(signal->app_regex_valid, &signal->app_regex, application->name) == regex_match_app;
+        app = application->name;
     } break;
     case WINDOW_CREATED:
     case WINDOW_FOCUSED:
@@ -167,41 +261,241 @@ static bool event_signal_filter(struct signal *signal, enum event_type type, str
     case WINDOW_DEMINIMIZED:
     case WINDOW_TITLE_CHANGED: {
         struct window *window = args->entity;
-        if (!window) return true;
+        if (!window) return false;
+
+        app = window->application->name;
+        title = args->param1;
+    } break;
+    }
 
-        int regex_match_app = signal->app_regex_exclude ? REGEX_MATCH_YES : REGEX_MATCH_NO;
-        bool app_no_match = regex_match(signal->app_regex_valid,   &signal->app_regex,   window->application->name) == regex_match_app;
+    event_signal_filter_set_begin(&index->app, app);
+    event_signal_filter_set_begin(&index->title, title);
+    return true;
+}
 
-        int regex_match_title = signal->title_regex_exclude ? REGEX_MATCH_YES : REGEX_MATCH_NO;
-        bool title_no_match = regex_match(signal->title_regex_valid, &signal->title_regex, args->param1)            == regex_match_title;
+static bool event_signal_filter(struct signal_filter_index *index, struct signal *signal)
+{
+    int regex_match_app = signal->app_regex_exclude ? REGEX_MATCH_YES : REGEX_MATCH_NO;
+    bool app_no_match = event_signal_filter_set_match(&index->app, signal->app_filter) == regex_match_app;
 
-        return app_no_match || title_no_match;
-    } break;
+    int regex_match_title = signal->title_regex_exclude ? REGEX_MATCH_YES : REGEX_MATCH_NO;
+    bool title_no_match = event_signal_filter_set_match(&index->title, signal->title_filter) == regex_match_title;
+
+    return app_no_match || title_no_match;
+}
+
+static inline uint64_t event_signal_time_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void event_signal_count(struct signal *signal, bool dispatched)
+{
+    uint64_t now = event_signal_time_ms();
+    uint64_t elapsed = now - signal->rate_window;
+
+    if (elapsed >= 1000) {
+        signal->rate = elapsed < 2000 ? signal->rate_count : 0;
+        signal->rate_window = now;
+        signal->rate_count = 0;
+    }
+
+    ++signal->rate_count;
+
+    if (dispatched) {
+        ++signal->dispatch_count;
+    } else {
+        ++signal->drop_count;
+    }
+}
+
+static uint32_t event_signal_rate(struct signal *signal)
+{
+    uint64_t elapsed = event_signal_time_ms() - signal->rate_window;
+    if (elapsed >= 2000) return 0;
+    if (elapsed >= 1000) return signal->rate_count;
+    return signal->rate;
+}
+
+static bool event_signal_dispatch(struct signal *signal, struct signal_args *args)
+{
+    if (signal_executor.sockfd == -1 && !event_signal_executor_begin()) {
+        return fork_exec(signal->command, args);
+    }
+
+    int result = event_signal_executor_send(signal->command, args);
+    if (result != -1) return result == 1;
+
+    debug("%s: signal executor %d is gone, restarting..\n", __FUNCTION__, signal_executor.pid);
+    event_signal_executor_end();
+
+    if (event_signal_executor_begin() && event_signal_executor_send(signal->command, args) == 1) {
+        return true;
+    }
+
+    return fork_exec(signal->command, args);
+}
+
+//
+// NOTE(koekeishiya): A subscriber is a client that asked to receive events over its own connection,
+// instead of having us execute a command. Every event is written as a single line of JSON. Writes
+// never block the event loop; bytes that the socket does not accept right away are kept in a buffer
+// owned by the subscriber, and sent when the next event is processed. An event that does not fit
+// in that buffer is dropped, and once there is room again the subscriber receives a record with
+// the number of events that were lost.
+//
+
+static struct signal_subscriber *signal_subscribers;
+
+bool event_signal_subscribe(int sockfd, uint64_t event_mask)
+{
+    if (buf_len(signal_subscribers) >= SIGNAL_SUBSCRIBER_MAX_COUNT) return false;
+
+    int subscriber_sockfd = dup(sockfd);
+    if (subscriber_sockfd == -1) return false;
+
+    fcntl(subscriber_sockfd, F_SETFD, FD_CLOEXEC);
+    buf_push(signal_subscribers, ((struct signal_subscriber) {
+        .sockfd     = subscriber_sockfd,
+        .event_mask = event_mask
+    }));
+
+    debug("%s: %d subscribed to events %llx\n", __FUNCTION__, subscriber_sockfd, event_mask);
+    return true;
+}
+
+static bool event_signal_subscriber_flush(struct signal_subscriber *subscriber)
+{
+    while (subscriber->length > 0) {
+        ssize_t bytes_sent = send(subscriber->sockfd, subscriber->buffer, subscriber->length, MSG_DONTWAIT);
+
+        if (bytes_sent == -1) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+
+        subscriber->length -= bytes_sent;
+        memmove(subscriber->buffer, subscriber->buffer + bytes_sent, subscriber->length);
+    }
+
+    return true;
+}
+
+static bool event_signal_subscriber_push(struct signal_subscriber *subscriber, char *data, uint32_t length)
+{
+    if (subscriber->length + length > SIGNAL_SUBSCRIBER_BUFFER_SIZE) return false;
+
+    if (!subscriber->buffer) {
+        subscriber->buffer = malloc(SIGNAL_SUBSCRIBER_BUFFER_SIZE);
+        if (!subscriber->buffer) return false;
+    }
+
+    memcpy(subscriber->buffer + subscriber->length, data, length);
+    subscriber->length += length;
+    return true;
+}
+
+static bool event_signal_subscriber_write(struct signal_subscriber *subscriber, char *record, uint32_t length)
+{
+    if (!event_signal_subscriber_flush(subscriber)) return false;
+
+    if (subscriber->drop_count) {
+        char dropped[64];
+        int dropped_length = snprintf(dropped, sizeof(dropped), "{\"event\":\"dropped\",\"count\":%u}\n", subscriber->drop_count);
+
+        if (!event_signal_subscriber_push(subscriber, dropped, dropped_length)) {
+            ++subscriber->drop_count;
+            return true;
+        }
+
+        subscriber->drop_count = 0;
+    }
+
+    if (!event_signal_subscriber_push(subscriber, record, length)) {
+        ++subscriber->drop_count;
+        return true;
+    }
+
+    return event_signal_subscriber_flush(subscriber);
+}
+
+static bool event_signal_is_subscribed(enum event_type type)
+{
+    for (int i = 0; i < buf_len(signal_subscribers); ++i) {
+        if (signal_subscribers[i].event_mask & (1ULL << type)) return true;
+    }
+
+    return false;
+}
+
+static void event_signal_notify_subscribers(enum event_type type, char *record, uint32_t length)
+{
+    for (int i = buf_len(signal_subscribers) - 1; i >= 0; --i) {
+        struct signal_subscriber *subscriber = &signal_subscribers[i];
+
+        bool is_alive = record && (subscriber->event_mask & (1ULL << type))
+                      ? event_signal_subscriber_write(subscriber, record, length)
+                      : event_signal_subscriber_flush(subscriber);
+
+        if (!is_alive) {
+            debug("%s: %d unsubscribed\n", __FUNCTION__, subscriber->sockfd);
+            socket_close(subscriber->sockfd);
+            if (subscriber->buffer) free(subscriber->buffer);
+            buf_del(signal_subscribers, i);
+        }
     }
 }
 
+static void event_signal_publish(enum event_type type, struct signal_args *args)
+{
+    struct json_writer *json = json_writer_begin_compact(&g_json_writer);
+    json_begin_object(json);
+    json_key(json, "event");
+    json_string(json, event_type_str[type]);
+    json_key(json, "args");
+    json_begin_object(json);
+
+    for (int i = 0; i < array_count(args->name); ++i) {
+        if (!*args->name[i]) continue;
+        json_key(json, args->name[i]);
+        json_string(json, args->value[i]);
+    }
+
+    json_end_object(json);
+    json_end_object(json);
+    json_write_char(json, '\n');
+
+    event_signal_notify_subscribers(type, json->data, json->length);
+}
+
 void event_signal_transmit(void *context, enum event_type type)
 {
     int signal_count = buf_len(g_signal_event[type]);
-    if (!signal_count) return;
+    bool is_subscribed = event_signal_is_subscribed(type);
 
-    struct signal_args args = {};
-    event_signal_populate_args(context, type, &args);
-    debug("%s: transmitting %s to %d subscriber(s)\n", __FUNCTION__, event_type_str[type], signal_count);
-
-    if (fork() != 0) {
-        event_signal_destroy_args(type, &args);
+    if (!signal_count && !is_subscribed) {
+        if (buf_len(signal_subscribers)) event_signal_notify_subscribers(type, NULL, 0);
         return;
     }
 
-    for (int i = 0; i < signal_count; ++i) {
-        struct signal *signal = &g_signal_event[type][i];
-        if (!event_signal_filter(signal, type, &args)) {
-            fork_exec(signal->command, &args);
+    struct signal_filter_index *index = event_signal_filter_index(type);
+    struct signal_args args = {};
+    event_signal_populate_args(context, type, &args, buf_len(index->title.filter) > 0);
+    debug("%s: transmitting %s to %d subscriber(s)\n", __FUNCTION__, event_type_str[type], signal_count);
+
+    if (signal_count && event_signal_filter_begin(index, type, &args)) {
+        for (int i = 0; i < signal_count; ++i) {
+            struct signal *signal = &g_signal_event[type][i];
+            if (!event_signal_filter(index, signal)) {
+                event_signal_count(signal, event_signal_dispatch(signal, &args));
+            }
         }
     }
 
-    exit(EXIT_SUCCESS);
+    if (is_subscribed) event_signal_publish(type, &args);
+    event_signal_destroy_args(type, &args);
 }
 
 enum event_type event_signal_type_from_string(const char *str)
@@ -217,6 +511,7 @@ void event_signal_add(enum event_type type, struct signal *signal)
 {
     if (signal->label) event_signal_remove(signal->label);
     buf_push(g_signal_event[type], *signal);
+    signal_filter_index[type].is_built = false;
 }
 
 void event_signal_destroy(struct signal *signal)
@@ -237,6 +532,7 @@ bool event_signal_remove_by_index(int index)
             if (signal_index == index) {
                 event_signal_destroy(&g_signal_event[i][j]);
                 buf_del(g_signal_event[i], j);
+                signal_filter_index[i].is_built = false;
                 return true;
             }
             ++signal_index;
@@ -253,6 +549,7 @@ bool event_signal_remove(char *label)
             if (string_equals(label, g_signal_event[i][j].label)) {
                 event_signal_destroy(&g_signal_event[i][j]);
                 buf_del(g_signal_event[i], j);
+                signal_filter_index[i].is_built = false;
                 return true;
             }
         }
@@ -261,25 +558,33 @@ bool event_signal_remove(char *label)
     return false;
 }
 
+static void event_signal_serialize(struct json_writer *json, struct signal *signal, enum event_type type, int index)
+{
+    json_begin_object(json);
+    json_key(json, "index");      json_int(json, index);
+    json_key(json, "label");      json_string(json, signal->label);
+    json_key(json, "app");        json_string(json, signal->app);
+    json_key(json, "title");      json_string(json, signal->title);
+    json_key(json, "event");      json_string(json, event_type_str[type]);
+    json_key(json, "action");     json_string(json, signal->command);
+    json_key(json, "dispatched"); json_int(json, signal->dispatch_count);
+    json_key(json, "dropped");    json_int(json, signal->drop_count);
+    json_key(json, "rate");       json_int(json, event_signal_rate(signal));
+    json_end_object(json);
+}
+
 void event_signal_list(FILE *rsp)
 {
-    fprintf(rsp, "[");
+    struct json_writer *json = json_writer_begin(&g_json_writer);
+    json_begin_array(json);
+
     int signal_index = 0;
-    bool event_did_output = false;
     for (int i = 0; i < EVENT_TYPE_COUNT; ++i) {
-        int count = buf_len(g_signal_event[i]);
-
-        if (count > 0 && event_did_output) {
-            fprintf(rsp, ",");
-        }
-
-        for (int j = 0; j < count; ++j) {
-            event_signal_serialize(rsp, &g_signal_event[i][j], i, signal_index);
-            if (j < buf_len(g_signal_event[i]) - 1) fprintf(rsp, ",");
-            ++signal_index;
+        for (int j = 0; j < buf_len(g_signal_event[i]); ++j) {
+            event_signal_serialize(json, &g_signal_event[i][j], i, signal_index++);
         }
-
-        if (!event_did_output) event_did_output = count > 0;
     }
-    fprintf(rsp, "]\n");
+
+    json_end_array(json);
+    json_writer_end(json, rsp);
 }
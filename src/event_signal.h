@@ -1,6 +1,47 @@
 #ifndef EVENT_SIGNAL_H
 #define EVENT_SIGNAL_H
 
+#define SIGNAL_SUBSCRIBER_MAX_COUNT   64
+#define SIGNAL_SUBSCRIBER_BUFFER_SIZE (64 * 1024)
+
+struct signal_subscriber
+{
+    int sockfd;
+    uint64_t event_mask;
+    char *buffer;
+    uint32_t length;
+    uint32_t drop_count;
+};
+
+#define SIGNAL_FILTER_UNRESOLVED -1
+
+struct signal_filter
+{
+    char *pattern;
+    char *literal;
+    regex_t *regex;
+    int kind;
+    int pattern_id;
+    int next;
+    int result;
+};
+
+struct signal_filter_set
+{
+    struct signal_filter *filter;
+    literal_table exact;
+    struct pattern_set patterns;
+    char *subject;
+    uint64_t *matches;
+};
+
+struct signal_filter_index
+{
+    bool is_built;
+    struct signal_filter_set app;
+    struct signal_filter_set title;
+};
+
 struct signal
 {
     char *app;
@@ -11,10 +52,18 @@ struct signal
     bool title_regex_exclude;
     regex_t app_regex;
     regex_t title_regex;
+    int app_filter;
+    int title_filter;
     char *command;
     char *label;
+    uint64_t dispatch_count;
+    uint64_t drop_count;
+    uint64_t rate_window;
+    uint32_t rate_count;
+    uint32_t rate;
 };
 
+bool event_signal_subscribe(int sockfd, uint64_t event_mask);
 void event_signal_transmit(void *context, enum event_type type);
 void event_signal_add(enum event_type type, struct signal *signal);
 void event_signal_destroy(struct signal *signal);
@@ -0,0 +1,162 @@
+#include "event_signal_executor.h"
+
+extern char **environ;
+
+//
+// NOTE(koekeishiya): Signal commands used to be executed by forking the daemon for every event,
+// and then forking once more per matching signal to exec the shell. With frequent events such as
+// window_moved, this meant copying the page tables of the entire daemon multiple times per event.
+// Instead, we fork a small helper once at startup and send it a record for every signal that
+// should run. The helper spawns the shell directly using posix_spawn. If the helper can not keep
+// up, we wait a short while for it to catch up before the dispatch is dropped and counted.
+//
+
+static struct signal_executor signal_executor = { .pid = -1, .sockfd = -1 };
+
+static void event_signal_executor_spawn(posix_spawnattr_t *attr, char *command)
+{
+    pid_t pid;
+    char *argv[] = { "sh", "-c", command, NULL };
+    posix_spawn(&pid, SIGNAL_EXECUTOR_SHELL, NULL, attr, argv, environ);
+}
+
+static void event_signal_executor_run(int sockfd)
+{
+    sigset_t default_signals;
+    sigemptyset(&default_signals);
+    sigaddset(&default_signals, SIGCHLD);
+    sigaddset(&default_signals, SIGPIPE);
+
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setsigdefault(&attr, &default_signals);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGDEF);
+
+    uint32_t length;
+    char *record;
+
+    while ((record = socket_read_frame_alloc(sockfd, SIGNAL_EXECUTOR_MAX_RECORD_SIZE, &length))) {
+        char *field[5];
+        char *cursor = record;
+        char *end = record + length;
+
+        for (int i = 0; i < array_count(field); ++i) {
+            field[i] = cursor < end ? cursor : "";
+            cursor += strnlen(cursor, end - cursor) + 1;
+        }
+
+        if (*field[1]) setenv(field[1], field[2], 1);
+        if (*field[3]) setenv(field[3], field[4], 1);
+
+        event_signal_executor_spawn(&attr, field[0]);
+
+        if (*field[1]) unsetenv(field[1]);
+        if (*field[3]) unsetenv(field[3]);
+
+        free(record);
+    }
+
+    posix_spawnattr_destroy(&attr);
+    _exit(EXIT_SUCCESS);
+}
+
+bool event_signal_executor_begin(void)
+{
+    int sockfd[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockfd) == -1) return false;
+
+    pid_t pid = fork();
+    if (pid == -1) {
+        close(sockfd[0]);
+        close(sockfd[1]);
+        return false;
+    }
+
+    if (pid == 0) {
+        close(sockfd[0]);
+        fcntl(sockfd[1], F_SETFD, FD_CLOEXEC);
+        event_signal_executor_run(sockfd[1]);
+    }
+
+    close(sockfd[1]);
+
+    int buffer_size = SIGNAL_EXECUTOR_BUFFER_SIZE;
+    setsockopt(sockfd[0], SOL_SOCKET, SO_SNDBUF, &buffer_size, sizeof(buffer_size));
+    fcntl(sockfd[0], F_SETFD, FD_CLOEXEC);
+
+    signal_executor.pid = pid;
+    signal_executor.sockfd = sockfd[0];
+    debug("%s: signal executor started with pid %d\n", __FUNCTION__, pid);
+    return true;
+}
+
+void event_signal_executor_end(void)
+{
+    if (signal_executor.sockfd != -1) {
+        close(signal_executor.sockfd);
+        signal_executor.sockfd = -1;
+    }
+
+    signal_executor.pid = -1;
+}
+
+//
+// NOTE(koekeishiya): A record is a frame containing the command followed by the two environment
+// variable names and values, each terminated by a null byte. Returns 1 if the record was sent,
+// 0 if it was dropped because the helper is busy, and -1 if the helper is gone.
+//
+
+int event_signal_executor_send(char *command, struct signal_args *args)
+{
+    size_t size[5] = {
+        strlen(command) + 1,
+        strlen(args->name[0]) + 1,
+        strlen(args->value[0]) + 1,
+        strlen(args->name[1]) + 1,
+        strlen(args->value[1]) + 1
+    };
+
+    char *field[5] = { command, args->name[0], args->value[0], args->name[1], args->value[1] };
+
+    size_t length = 0;
+    for (int i = 0; i < array_count(size); ++i) length += size[i];
+    if (length > SIGNAL_EXECUTOR_MAX_RECORD_SIZE) return 0;
+
+    size_t total = sizeof(uint32_t) + length;
+    if (total > signal_executor.capacity) {
+        signal_executor.buffer = realloc(signal_executor.buffer, total);
+        signal_executor.capacity = total;
+    }
+
+    char *cursor = signal_executor.buffer;
+    *(uint32_t *) cursor = length;
+    cursor += sizeof(uint32_t);
+
+    for (int i = 0; i < array_count(field); ++i) {
+        memcpy(cursor, field[i], size[i]);
+        cursor += size[i];
+    }
+
+    ssize_t bytes_sent = send(signal_executor.sockfd, signal_executor.buffer, total, MSG_DONTWAIT);
+    if (bytes_sent == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        struct pollfd pfd = { signal_executor.sockfd, POLLOUT, 0 };
+        if (poll(&pfd, 1, SIGNAL_EXECUTOR_SEND_TIMEOUT) <= 0) return 0;
+        bytes_sent = send(signal_executor.sockfd, signal_executor.buffer, total, MSG_DONTWAIT);
+        if (bytes_sent == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) return 0;
+    }
+
+    if (bytes_sent == -1) return -1;
+
+    //
+    // NOTE(koekeishiya): Part of the record made it into the socket buffer, so the rest of it
+    // has to follow, or the helper would lose track of where the next record begins.
+    //
+
+    while (bytes_sent < total) {
+        ssize_t bytes = send(signal_executor.sockfd, signal_executor.buffer + bytes_sent, total - bytes_sent, 0);
+        if (bytes <= 0) return -1;
+        bytes_sent += bytes;
+    }
+
+    return 1;
+}
@@ -0,0 +1,23 @@
+#ifndef EVENT_SIGNAL_EXECUTOR_H
+#define EVENT_SIGNAL_EXECUTOR_H
+
+#define SIGNAL_EXECUTOR_SHELL           "/bin/sh"
+#define SIGNAL_EXECUTOR_MAX_RECORD_SIZE (1 << 20)
+#define SIGNAL_EXECUTOR_BUFFER_SIZE     (256 * 1024)
+#define SIGNAL_EXECUTOR_SEND_TIMEOUT    250
+
+struct signal_args;
+
+struct signal_executor
+{
+    pid_t pid;
+    int sockfd;
+    char *buffer;
+    uint32_t capacity;
+};
+
+bool event_signal_executor_begin(void);
+void event_signal_executor_end(void);
+int event_signal_executor_send(char *command, struct signal_args *args);
+
+#endif
@@ -0,0 +1,104 @@
+#include "frame_batch.h"
+
+extern int g_connection;
+
+//
+// NOTE(koekeishiya): A relayout collects the target frame of every window into a batch, which is
+// then committed in one pass. Frames equal to the one last applied to a window are dropped. Every
+// application serves accessibility requests on its own, so when the batch spans multiple
+// applications, the writes for each application are issued concurrently. Anything that moves or
+// resizes a window outside of a batch must clear has_applied_frame, or a later relayout back to
+// the same frame would be dropped.
+//
+
+void frame_batch_begin(struct frame_batch *batch)
+{
+    batch->entries = NULL;
+    batch->skipped = 0;
+}
+
+void frame_batch_add(struct frame_batch *batch, struct window *window, float x, float y, float width, float height)
+{
+    CGRect frame = {{x, y}, {width, height}};
+
+    if (window->has_applied_frame && CGRectEqualToRect(window->applied_frame, frame)) {
+        ++batch->skipped;
+        return;
+    }
+
+    buf_push(batch->entries, ((struct frame_batch_entry) { .window = window, .frame = frame }));
+}
+
+static int frame_batch_entry_compare(const void *a, const void *b)
+{
+    const struct frame_batch_entry *entry_a = a;
+    const struct frame_batch_entry *entry_b = b;
+
+    if (entry_a->window->application < entry_b->window->application) return -1;
+    if (entry_a->window->application > entry_b->window->application) return  1;
+
+    return entry_a->window->id < entry_b->window->id ? -1 : entry_a->window->id > entry_b->window->id;
+}
+
+struct frame_batch_groups
+{
+    struct frame_batch_entry *entries;
+    int *group;
+};
+
+static void frame_batch_apply_group(void *context, size_t index)
+{
+    struct frame_batch_groups *groups = context;
+    struct frame_batch_entry *entries = groups->entries;
+
+    for (int i = groups->group[index]; i < groups->group[index+1]; ++i) {
+        entries[i].moved = frame_batch_apply(entries[i].window, entries[i].frame);
+    }
+}
+
+void frame_batch_commit(struct frame_batch *batch)
+{
+    struct frame_batch_entry *entries = batch->entries;
+    int count = buf_len(entries);
+    if (!count) goto out;
+
+    qsort(entries, count, sizeof(struct frame_batch_entry), frame_batch_entry_compare);
+
+    int group_count = 0;
+    int *group = malloc(sizeof(int) * (count + 1));
+
+    for (int i = 0; i < count; ++i) {
+        if (i == 0 || entries[i].window->application != entries[i-1].window->application) {
+            group[group_count++] = i;
+        }
+    }
+
+    group[group_count] = count;
+
+    struct frame_batch_groups groups = { entries, group };
+    if (group_count == 1) {
+        frame_batch_apply_group(&groups, 0);
+    } else {
+        dispatch_apply_f(group_count, dispatch_get_global_queue(QOS_CLASS_USER_INTERACTIVE, 0), &groups, frame_batch_apply_group);
+    }
+
+    for (int i = 0; i < count; ++i) {
+        struct window *window = entries[i].window;
+        window_invalidate_attributes(window, WINDOW_ATTRIBUTE_FRAME);
+
+        if (entries[i].moved) {
+            if (window->border.id) SLSMoveWindow(g_connection, window->border.id, &entries[i].frame.origin);
+            window->applied_frame = entries[i].frame;
+            window->has_applied_frame = true;
+        } else {
+            window->has_applied_frame = false;
+        }
+    }
+
+    debug("%s: committed %d frames for %d applications, skipped %d\n", __FUNCTION__, count, group_count, batch->skipped);
+    free(group);
+
+out:
+    buf_free(entries);
+    batch->entries = NULL;
+}
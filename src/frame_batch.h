@@ -0,0 +1,30 @@
+#ifndef FRAME_BATCH_H
+#define FRAME_BATCH_H
+
+struct window;
+
+struct frame_batch_entry
+{
+    struct window *window;
+    CGRect frame;
+    bool moved;
+};
+
+struct frame_batch
+{
+    struct frame_batch_entry *entries;
+    int skipped;
+};
+
+//
+// NOTE(koekeishiya): frame_batch_apply performs the actual write of a single frame and is
+// defined by window_manager.c. It is called concurrently for windows of different applications.
+//
+
+static bool frame_batch_apply(struct window *window, CGRect frame);
+
+void frame_batch_begin(struct frame_batch *batch);
+void frame_batch_add(struct frame_batch *batch, struct window *window, float x, float y, float width, float height);
+void frame_batch_commit(struct frame_batch *batch);
+
+#endif
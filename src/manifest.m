@@ -19,27 +19,32 @@
 #include <sys/wait.h>
 #include <sys/stat.h>
 #include <semaphore.h>
+#include <spawn.h>
 #include <pthread.h>
 
 #include "misc/macros.h"
 #include "misc/notify.h"
 #include "misc/log.h"
 #include "misc/helpers.h"
-#include "misc/memory_pool.h"
 #include "misc/sbuffer.h"
+#include "misc/json.h"
 #define HASHTABLE_IMPLEMENTATION
 #include "misc/hashtable.h"
 #undef HASHTABLE_IMPLEMENTATION
+#include "misc/pattern.h"
+#include "misc/pattern.c"
 #include "misc/socket.h"
 #include "misc/socket.c"
 
 #include "osax/sa.h"
 #include "osax/mach_loader.c"
+#include "osax/client.c"
 #include "osax/sa.m"
 
 #include "event.h"
 #include "event_loop.h"
 #include "event_signal.h"
+#include "event_signal_executor.h"
 #include "event_tap.h"
 #include "workspace.h"
 #include "rule.h"
@@ -54,17 +59,21 @@
 #include "display_manager.h"
 #include "space_manager.h"
 #include "window_manager.h"
+#include "frame_batch.h"
 #include "mouse.h"
 
 #include "event_loop.c"
 #include "event.c"
+#include "event_signal_executor.c"
 #include "event_signal.c"
 #include "event_tap.c"
 #include "workspace.m"
 #include "rule.c"
+#include "message_token.c"
 #include "message.c"
 #include "display.c"
 #include "space.c"
+#include "view_node.c"
 #include "view.c"
 #include "border.c"
 #include "window.c"
@@ -72,6 +81,7 @@
 #include "application.c"
 #include "display_manager.c"
 #include "space_manager.c"
+#include "frame_batch.c"
 #include "window_manager.c"
 #include "mouse.c"
 
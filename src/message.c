@@ -7,318 +7,7 @@ extern struct space_manager g_space_manager;
 extern struct window_manager g_window_manager;
 extern struct mouse_state g_mouse_state;
 extern bool g_verbose;
-
-#define DOMAIN_CONFIG  "config"
-#define DOMAIN_DISPLAY "display"
-#define DOMAIN_SPACE   "space"
-#define DOMAIN_WINDOW  "window"
-#define DOMAIN_QUERY   "query"
-#define DOMAIN_RULE    "rule"
-#define DOMAIN_SIGNAL  "signal"
-
-/* --------------------------------DOMAIN CONFIG-------------------------------- */
-#define COMMAND_CONFIG_DEBUG_OUTPUT          "debug_output"
-#define COMMAND_CONFIG_MFF                   "mouse_follows_focus"
-#define COMMAND_CONFIG_FFM                   "focus_follows_mouse"
-#define COMMAND_CONFIG_WINDOW_PLACEMENT      "window_placement"
-#define COMMAND_CONFIG_TOPMOST               "window_topmost"
-#define COMMAND_CONFIG_OPACITY               "window_opacity"
-#define COMMAND_CONFIG_OPACITY_DURATION      "window_opacity_duration"
-#define COMMAND_CONFIG_BORDER                "window_border"
-#define COMMAND_CONFIG_BORDER_WIDTH          "window_border_width"
-#define COMMAND_CONFIG_BORDER_ACTIVE_COLOR   "active_window_border_color"
-#define COMMAND_CONFIG_BORDER_NORMAL_COLOR   "normal_window_border_color"
-#define COMMAND_CONFIG_SHADOW                "window_shadow"
-#define COMMAND_CONFIG_ACTIVE_WINDOW_OPACITY "active_window_opacity"
-#define COMMAND_CONFIG_NORMAL_WINDOW_OPACITY "normal_window_opacity"
-#define COMMAND_CONFIG_INSERT_FEEDBACK_COLOR "insert_feedback_color"
-#define COMMAND_CONFIG_TOP_PADDING           "top_padding"
-#define COMMAND_CONFIG_BOTTOM_PADDING        "bottom_padding"
-#define COMMAND_CONFIG_LEFT_PADDING          "left_padding"
-#define COMMAND_CONFIG_RIGHT_PADDING         "right_padding"
-#define COMMAND_CONFIG_LAYOUT                "layout"
-#define COMMAND_CONFIG_WINDOW_GAP            "window_gap"
-#define COMMAND_CONFIG_SPLIT_RATIO           "split_ratio"
-#define COMMAND_CONFIG_AUTO_BALANCE          "auto_balance"
-#define COMMAND_CONFIG_MOUSE_MOD             "mouse_modifier"
-#define COMMAND_CONFIG_MOUSE_ACTION1         "mouse_action1"
-#define COMMAND_CONFIG_MOUSE_ACTION2         "mouse_action2"
-#define COMMAND_CONFIG_MOUSE_DROP_ACTION     "mouse_drop_action"
-#define COMMAND_CONFIG_EXTERNAL_BAR          "external_bar"
-
-#define SELECTOR_CONFIG_SPACE                "--space"
-
-#define ARGUMENT_CONFIG_FFM_AUTOFOCUS        "autofocus"
-#define ARGUMENT_CONFIG_FFM_AUTORAISE        "autoraise"
-#define ARGUMENT_CONFIG_WINDOW_PLACEMENT_FST "first_child"
-#define ARGUMENT_CONFIG_WINDOW_PLACEMENT_SND "second_child"
-#define ARGUMENT_CONFIG_SHADOW_FLT           "float"
-#define ARGUMENT_CONFIG_LAYOUT_BSP           "bsp"
-#define ARGUMENT_CONFIG_LAYOUT_STACK         "stack"
-#define ARGUMENT_CONFIG_LAYOUT_FLOAT         "float"
-#define ARGUMENT_CONFIG_MOUSE_MOD_ALT        "alt"
-#define ARGUMENT_CONFIG_MOUSE_MOD_SHIFT      "shift"
-#define ARGUMENT_CONFIG_MOUSE_MOD_CMD        "cmd"
-#define ARGUMENT_CONFIG_MOUSE_MOD_CTRL       "ctrl"
-#define ARGUMENT_CONFIG_MOUSE_MOD_FN         "fn"
-#define ARGUMENT_CONFIG_MOUSE_ACTION_MOVE    "move"
-#define ARGUMENT_CONFIG_MOUSE_ACTION_RESIZE  "resize"
-#define ARGUMENT_CONFIG_MOUSE_ACTION_SWAP    "swap"
-#define ARGUMENT_CONFIG_MOUSE_ACTION_STACK   "stack"
-#define ARGUMENT_CONFIG_EXTERNAL_BAR_MAIN    "main"
-#define ARGUMENT_CONFIG_EXTERNAL_BAR_ALL     "all"
-#define ARGUMENT_CONFIG_EXTERNAL_BAR         "%5[^:]:%d:%d"
-/* ----------------------------------------------------------------------------- */
-
-/* --------------------------------DOMAIN DISPLAY------------------------------- */
-#define COMMAND_DISPLAY_FOCUS "--focus"
-/* ----------------------------------------------------------------------------- */
-
-/* --------------------------------DOMAIN SPACE--------------------------------- */
-#define COMMAND_SPACE_FOCUS   "--focus"
-#define COMMAND_SPACE_CREATE  "--create"
-#define COMMAND_SPACE_DESTROY "--destroy"
-#define COMMAND_SPACE_MOVE    "--move"
-#define COMMAND_SPACE_SWAP    "--swap"
-#define COMMAND_SPACE_DISPLAY "--display"
-#define COMMAND_SPACE_BALANCE "--balance"
-#define COMMAND_SPACE_MIRROR  "--mirror"
-#define COMMAND_SPACE_ROTATE  "--rotate"
-#define COMMAND_SPACE_PADDING "--padding"
-#define COMMAND_SPACE_GAP     "--gap"
-#define COMMAND_SPACE_TOGGLE  "--toggle"
-#define COMMAND_SPACE_LAYOUT  "--layout"
-#define COMMAND_SPACE_LABEL   "--label"
-
-#define ARGUMENT_SPACE_MIRROR_X     "x-axis"
-#define ARGUMENT_SPACE_MIRROR_Y     "y-axis"
-#define ARGUMENT_SPACE_ROTATE_90    "90"
-#define ARGUMENT_SPACE_ROTATE_180   "180"
-#define ARGUMENT_SPACE_ROTATE_270   "270"
-#define ARGUMENT_SPACE_PADDING      "%255[^:]:%d:%d:%d:%d"
-#define ARGUMENT_SPACE_GAP          "%255[^:]:%d"
-#define ARGUMENT_SPACE_TGL_PADDING  "padding"
-#define ARGUMENT_SPACE_TGL_GAP      "gap"
-#define ARGUMENT_SPACE_TGL_MC       "mission-control"
-#define ARGUMENT_SPACE_TGL_SD       "show-desktop"
-#define ARGUMENT_SPACE_LAYOUT_BSP   "bsp"
-#define ARGUMENT_SPACE_LAYOUT_STACK "stack"
-#define ARGUMENT_SPACE_LAYOUT_FLT   "float"
-/* ----------------------------------------------------------------------------- */
-
-/* --------------------------------DOMAIN WINDOW-------------------------------- */
-#define COMMAND_WINDOW_FOCUS   "--focus"
-#define COMMAND_WINDOW_SWAP    "--swap"
-#define COMMAND_WINDOW_WARP    "--warp"
-#define COMMAND_WINDOW_STACK   "--stack"
-#define COMMAND_WINDOW_INSERT  "--insert"
-#define COMMAND_WINDOW_GRID    "--grid"
-#define COMMAND_WINDOW_MOVE    "--move"
-#define COMMAND_WINDOW_RESIZE  "--resize"
-#define COMMAND_WINDOW_RATIO   "--ratio"
-#define COMMAND_WINDOW_MIN     "--minimize"
-#define COMMAND_WINDOW_DEMIN   "--deminimize"
-#define COMMAND_WINDOW_CLOSE   "--close"
-#define COMMAND_WINDOW_LAYER   "--layer"
-#define COMMAND_WINDOW_OPACITY "--opacity"
-#define COMMAND_WINDOW_TOGGLE  "--toggle"
-#define COMMAND_WINDOW_DISPLAY "--display"
-#define COMMAND_WINDOW_SPACE   "--space"
-
-#define ARGUMENT_WINDOW_SEL_LARGEST   "largest"
-#define ARGUMENT_WINDOW_SEL_SMALLEST  "smallest"
-#define ARGUMENT_WINDOW_GRID          "%d:%d:%d:%d:%d:%d"
-#define ARGUMENT_WINDOW_MOVE          "%255[^:]:%f:%f"
-#define ARGUMENT_WINDOW_RESIZE        "%255[^:]:%f:%f"
-#define ARGUMENT_WINDOW_RATIO         "%255[^:]:%f"
-#define ARGUMENT_WINDOW_LAYER_BELOW   "below"
-#define ARGUMENT_WINDOW_LAYER_NORMAL  "normal"
-#define ARGUMENT_WINDOW_LAYER_ABOVE   "above"
-#define ARGUMENT_WINDOW_TOGGLE_ON_TOP "topmost"
-#define ARGUMENT_WINDOW_TOGGLE_FLOAT  "float"
-#define ARGUMENT_WINDOW_TOGGLE_STICKY "sticky"
-#define ARGUMENT_WINDOW_TOGGLE_SHADOW "shadow"
-#define ARGUMENT_WINDOW_TOGGLE_SPLIT  "split"
-#define ARGUMENT_WINDOW_TOGGLE_PARENT "zoom-parent"
-#define ARGUMENT_WINDOW_TOGGLE_FULLSC "zoom-fullscreen"
-#define ARGUMENT_WINDOW_TOGGLE_NATIVE "native-fullscreen"
-#define ARGUMENT_WINDOW_TOGGLE_EXPOSE "expose"
-#define ARGUMENT_WINDOW_TOGGLE_PIP    "pip"
-#define ARGUMENT_WINDOW_TOGGLE_BORDER "border"
-/* ----------------------------------------------------------------------------- */
-
-/* --------------------------------DOMAIN QUERY--------------------------------- */
-#define COMMAND_QUERY_DISPLAYS "--displays"
-#define COMMAND_QUERY_SPACES   "--spaces"
-#define COMMAND_QUERY_WINDOWS  "--windows"
-
-#define ARGUMENT_QUERY_DISPLAY "--display"
-#define ARGUMENT_QUERY_SPACE   "--space"
-#define ARGUMENT_QUERY_WINDOW  "--window"
-/* ----------------------------------------------------------------------------- */
-
-/* --------------------------------DOMAIN RULE---------------------------------- */
-#define COMMAND_RULE_ADD "--add"
-#define COMMAND_RULE_REM "--remove"
-#define COMMAND_RULE_LS  "--list"
-
-#define ARGUMENT_RULE_KEY_APP     "app"
-#define ARGUMENT_RULE_KEY_TITLE   "title"
-#define ARGUMENT_RULE_KEY_DISPLAY "display"
-#define ARGUMENT_RULE_KEY_SPACE   "space"
-#define ARGUMENT_RULE_KEY_ALPHA   "opacity"
-#define ARGUMENT_RULE_KEY_MANAGE  "manage"
-#define ARGUMENT_RULE_KEY_STICKY  "sticky"
-#define ARGUMENT_RULE_KEY_LAYER   "layer"
-#define ARGUMENT_RULE_KEY_BORDER  "border"
-#define ARGUMENT_RULE_KEY_FULLSCR "native-fullscreen"
-#define ARGUMENT_RULE_KEY_GRID    "grid"
-#define ARGUMENT_RULE_KEY_LABEL   "label"
-
-#define ARGUMENT_RULE_VALUE_SPACE '^'
-#define ARGUMENT_RULE_VALUE_GRID  "%d:%d:%d:%d:%d:%d"
-/* ----------------------------------------------------------------------------- */
-
-/* --------------------------------DOMAIN SIGNAL-------------------------------- */
-#define COMMAND_SIGNAL_ADD "--add"
-#define COMMAND_SIGNAL_REM "--remove"
-#define COMMAND_SIGNAL_LS  "--list"
-
-#define ARGUMENT_SIGNAL_KEY_APP      "app"
-#define ARGUMENT_SIGNAL_KEY_TITLE    "title"
-#define ARGUMENT_SIGNAL_KEY_EVENT    "event"
-#define ARGUMENT_SIGNAL_KEY_ACTION   "action"
-#define ARGUMENT_SIGNAL_KEY_LABEL    "label"
-/* ----------------------------------------------------------------------------- */
-
-/* --------------------------------COMMON ARGUMENTS----------------------------- */
-#define ARGUMENT_COMMON_VAL_ON           "on"
-#define ARGUMENT_COMMON_VAL_OFF          "off"
-#define ARGUMENT_COMMON_SEL_PREV         "prev"
-#define ARGUMENT_COMMON_SEL_NEXT         "next"
-#define ARGUMENT_COMMON_SEL_FIRST        "first"
-#define ARGUMENT_COMMON_SEL_LAST         "last"
-#define ARGUMENT_COMMON_SEL_RECENT       "recent"
-#define ARGUMENT_COMMON_SEL_NORTH        "north"
-#define ARGUMENT_COMMON_SEL_EAST         "east"
-#define ARGUMENT_COMMON_SEL_SOUTH        "south"
-#define ARGUMENT_COMMON_SEL_WEST         "west"
-#define ARGUMENT_COMMON_SEL_MOUSE        "mouse"
-#define ARGUMENT_COMMON_SEL_STACK        "stack"
-#define ARGUMENT_COMMON_SEL_STACK_PREV   "stack.prev"
-#define ARGUMENT_COMMON_SEL_STACK_NEXT   "stack.next"
-#define ARGUMENT_COMMON_SEL_STACK_FIRST  "stack.first"
-#define ARGUMENT_COMMON_SEL_STACK_LAST   "stack.last"
-#define ARGUMENT_COMMON_SEL_STACK_RECENT "stack.recent"
-/* ----------------------------------------------------------------------------- */
-
-static bool token_equals(struct token token, char *match)
-{
-    char *at = match;
-    for (int i = 0; i < token.length; ++i, ++at) {
-        if ((*at == 0) || (token.text[i] != *at)) {
-            return false;
-        }
-    }
-    return *at == 0;
-}
-
-static bool token_is_valid(struct token token)
-{
-    return token.text && token.length > 0;
-}
-
-static char *token_to_string(struct token token)
-{
-    char *result = malloc(token.length + 1);
-    if (!result) return NULL;
-
-    memcpy(result, token.text, token.length);
-    result[token.length] = '\0';
-    return result;
-}
-
-static uint32_t token_to_uint32t(struct token token)
-{
-    uint32_t result = 0;
-    char buffer[token.length + 1];
-    memcpy(buffer, token.text, token.length);
-    buffer[token.length] = '\0';
-    sscanf(buffer, "%x", &result);
-    return result;
-}
-
-static bool token_to_int(struct token token, int *value)
-{
-    int result = 0;
-    char buffer[token.length + 1];
-    memcpy(buffer, token.text, token.length);
-    buffer[token.length] = '\0';
-    bool success = sscanf(buffer, "%d", &result) == 1;
-    *value = result;
-    return success;
-}
-
-static float token_to_float(struct token token)
-{
-    float result = 0.0f;
-    char buffer[token.length + 1];
-    memcpy(buffer, token.text, token.length);
-    buffer[token.length] = '\0';
-    sscanf(buffer, "%f", &result);
-    return result;
-}
-
-static struct token get_token(char **message)
-{
-    struct token token;
-
-    token.text = *message;
-    while (**message) {
-        ++(*message);
-    }
-    token.length = *message - token.text;
-
-    if ((*message)[0] == '\0' && (*message)[1] != '\0') {
-        ++(*message);
-    } else {
-        // NOTE(koekeishiya): don't go past the null-terminator
-    }
-
-    return token;
-}
-
-static void get_key_value_pair(char *token, char **key, char **value, bool *exclusion)
-{
-    *key = token;
-
-    while (*token) {
-        char fst = token[0];
-        char snd = token[1];
-
-        if (fst == '!' && snd == '=') {
-            break;
-        } else if (fst == '=') {
-            break;
-        }
-
-        ++token;
-    }
-
-    int index = (token[0] == '!' && token[1] == '=') ? 2 : 1;
-    char check = (index == 2) ? '!' : '=';
-
-    if (*token != check) {
-        *key = NULL;
-        *value = NULL;
-    } else if (token[index]) {
-        *token = '\0';
-        *value = token+index;
-        *exclusion = index == 2;
-    } else {
-        *value = NULL;
-    }
-}
+extern struct json_writer g_json_writer;
 
 static void daemon_fail(FILE *rsp, char *fmt, ...)
 {
@@ -353,17 +42,17 @@ __unused static void daemon_deprecated(FILE *rsp, char *fmt, ...)
                     view_flush(view); \
                     }
 
-static void handle_domain_config(FILE *rsp, struct token domain, char *message)
+static void handle_domain_config(FILE *rsp, struct token domain, struct token_index *message)
 {
     int sel_mci = 0;
     uint64_t sel_sid = 0;
     bool found_selector = true;
 
-    struct token selector = get_token(&message);
+    struct token selector = get_token(message);
     struct token command  = selector;
 
     if (token_equals(selector, SELECTOR_CONFIG_SPACE)) {
-        struct token value = get_token(&message);
+        struct token value = get_token(message);
         if (token_to_int(value, &sel_mci) && sel_mci) {
             sel_sid = space_manager_mission_control_space(sel_mci);
         }
@@ -371,10 +60,11 @@ static void handle_domain_config(FILE *rsp, struct token domain, char *message)
         found_selector = false;
     }
 
-    if (found_selector) command = get_token(&message);
+    if (found_selector) command = get_token(message);
 
-    if (token_equals(command, COMMAND_CONFIG_DEBUG_OUTPUT)) {
-        struct token value = get_token(&message);
+    switch (keyword_config_command(command)) {
+    case KEYWORD_COMMAND_CONFIG_DEBUG_OUTPUT: {
+        struct token value = get_token(message);
         if (!token_is_valid(value)) {
             fprintf(rsp, "%s\n", bool_str[g_verbose]);
         } else if (token_equals(value, ARGUMENT_COMMON_VAL_OFF)) {
@@ -384,8 +74,9 @@ static void handle_domain_config(FILE *rsp, struct token domain, char *message)
         } else {
             daemon_fail(rsp, "unknown value '%.*s' given to command '%.*s' for domain '%.*s'\n", value.length, value.text, command.length, command.text, domain.length, domain.text);
         }
-    } else if (token_equals(command, COMMAND_CONFIG_MFF)) {
-        struct token value = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_CONFIG_MFF: {
+        struct token value = get_token(message);
         if (!token_is_valid(value)) {
             fprintf(rsp, "%s\n", bool_str[g_window_manager.enable_mff]);
         } else if (token_equals(value, ARGUMENT_COMMON_VAL_OFF)) {
@@ -395,8 +86,9 @@ static void handle_domain_config(FILE *rsp, struct token domain, char *message)
         } else {
             daemon_fail(rsp, "unknown value '%.*s' given to command '%.*s' for domain '%.*s'\n", value.length, value.text, command.length, command.text, domain.length, domain.text);
         }
-    } else if (token_equals(command, COMMAND_CONFIG_FFM)) {
-        struct token value = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_CONFIG_FFM: {
+        struct token value = get_token(message);
         if (!token_is_valid(value)) {
             fprintf(rsp, "%s\n", ffm_mode_str[g_window_manager.ffm_mode]);
         } else if (token_equals(value, ARGUMENT_COMMON_VAL_OFF)) {
@@ -408,8 +100,9 @@ static void handle_domain_config(FILE *rsp, struct token domain, char *message)
         } else {
             daemon_fail(rsp, "unknown value '%.*s' given to command '%.*s' for domain '%.*s'\n", value.length, value.text, command.length, command.text, domain.length, domain.text);
         }
-    } else if (token_equals(command, COMMAND_CONFIG_WINDOW_PLACEMENT)) {
-        struct token value = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_CONFIG_WINDOW_PLACEMENT: {
+        struct token value = get_token(message);
         if (!token_is_valid(value)) {
             fprintf(rsp, "%s\n", window_node_child_str[g_space_manager.window_placement]);
         } else if (token_equals(value, ARGUMENT_CONFIG_WINDOW_PLACEMENT_FST)) {
@@ -419,8 +112,9 @@ static void handle_domain_config(FILE *rsp, struct token domain, char *message)
         } else {
             daemon_fail(rsp, "unknown value '%.*s' given to command '%.*s' for domain '%.*s'\n", value.length, value.text, command.length, command.text, domain.length, domain.text);
         }
-    } else if (token_equals(command, COMMAND_CONFIG_TOPMOST)) {
-        struct token value = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_CONFIG_TOPMOST: {
+        struct token value = get_token(message);
         if (!token_is_valid(value)) {
             fprintf(rsp, "%s\n", bool_str[g_window_manager.enable_window_topmost]);
         } else if (token_equals(value, ARGUMENT_COMMON_VAL_OFF)) {
@@ -430,8 +124,9 @@ static void handle_domain_config(FILE *rsp, struct token domain, char *message)
         } else {
             daemon_fail(rsp, "unknown value '%.*s' given to command '%.*s' for domain '%.*s'\n", value.length, value.text, command.length, command.text, domain.length, domain.text);
         }
-    } else if (token_equals(command, COMMAND_CONFIG_OPACITY)) {
-        struct token value = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_CONFIG_OPACITY: {
+        struct token value = get_token(message);
         if (!token_is_valid(value)) {
             fprintf(rsp, "%s\n", bool_str[g_window_manager.enable_window_opacity]);
         } else if (token_equals(value, ARGUMENT_COMMON_VAL_OFF)) {
@@ -441,8 +136,9 @@ static void handle_domain_config(FILE *rsp, struct token domain, char *message)
         } else {
             daemon_fail(rsp, "unknown value '%.*s' given to command '%.*s' for domain '%.*s'\n", value.length, value.text, command.length, command.text, domain.length, domain.text);
         }
-    } else if (token_equals(command, COMMAND_CONFIG_OPACITY_DURATION)) {
-        struct token value = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_CONFIG_OPACITY_DURATION: {
+        struct token value = get_token(message);
         if (!token_is_valid(value)) {
             fprintf(rsp, "%f\n", g_window_manager.window_opacity_duration);
         } else if (!workspace_is_macos_catalina()) {
@@ -450,8 +146,9 @@ static void handle_domain_config(FILE *rsp, struct token domain, char *message)
         } else {
             daemon_fail(rsp, "'%s' cannot be changed on macOS Catalina because of an Apple bug in the WindowServer\n", COMMAND_CONFIG_OPACITY_DURATION);
         }
-    } else if (token_equals(command, COMMAND_CONFIG_BORDER)) {
-        struct token value = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_CONFIG_BORDER: {
+        struct token value = get_token(message);
         if (!token_is_valid(value)) {
             fprintf(rsp, "%s\n", bool_str[g_window_manager.enable_window_border]);
         } else if (token_equals(value, ARGUMENT_COMMON_VAL_OFF)) {
@@ -461,8 +158,9 @@ static void handle_domain_config(FILE *rsp, struct token domain, char *message)
         } else {
             daemon_fail(rsp, "unknown value '%.*s' given to command '%.*s' for domain '%.*s'\n", value.length, value.text, command.length, command.text, domain.length, domain.text);
         }
-    } else if (token_equals(command, COMMAND_CONFIG_BORDER_WIDTH)) {
-        struct token value = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_CONFIG_BORDER_WIDTH: {
+        struct token value = get_token(message);
         if (!token_is_valid(value)) {
             fprintf(rsp, "%d\n", g_window_manager.border_width);
         } else {
@@ -473,8 +171,9 @@ static void handle_domain_config(FILE *rsp, struct token domain, char *message)
                 daemon_fail(rsp, "unknown value '%.*s' given to command '%.*s' for domain '%.*s'\n", value.length, value.text, command.length, command.text, domain.length, domain.text);
             }
         }
-    } else if (token_equals(command, COMMAND_CONFIG_BORDER_ACTIVE_COLOR)) {
-        struct token value = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_CONFIG_BORDER_ACTIVE_COLOR: {
+        struct token value = get_token(message);
         if (!token_is_valid(value)) {
             fprintf(rsp, "0x%x\n", g_window_manager.active_border_color.p);
         } else {
@@ -485,8 +184,9 @@ static void handle_domain_config(FILE *rsp, struct token domain, char *message)
                 daemon_fail(rsp, "unknown value '%.*s' given to command '%.*s' for domain '%.*s'\n", value.length, value.text, command.length, command.text, domain.length, domain.text);
             }
         }
-    } else if (token_equals(command, COMMAND_CONFIG_BORDER_NORMAL_COLOR)) {
-        struct token value = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_CONFIG_BORDER_NORMAL_COLOR: {
+        struct token value = get_token(message);
         if (!token_is_valid(value)) {
             fprintf(rsp, "0x%x\n", g_window_manager.normal_border_color.p);
         } else {
@@ -497,8 +197,9 @@ static void handle_domain_config(FILE *rsp, struct token domain, char *message)
                 daemon_fail(rsp, "unknown value '%.*s' given to command '%.*s' for domain '%.*s'\n", value.length, value.text, command.length, command.text, domain.length, domain.text);
             }
         }
-    } else if (token_equals(command, COMMAND_CONFIG_SHADOW)) {
-        struct token value = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_CONFIG_SHADOW: {
+        struct token value = get_token(message);
         if (!token_is_valid(value)) {
             fprintf(rsp, "%s\n", purify_mode_str[g_window_manager.purify_mode]);
         } else if (token_equals(value, ARGUMENT_COMMON_VAL_OFF)) {
@@ -510,8 +211,9 @@ static void handle_domain_config(FILE *rsp, struct token domain, char *message)
         } else {
             daemon_fail(rsp, "unknown value '%.*s' given to command '%.*s' for domain '%.*s'\n", value.length, value.text, command.length, command.text, domain.length, domain.text);
         }
-    } else if (token_equals(command, COMMAND_CONFIG_ACTIVE_WINDOW_OPACITY)) {
-        struct token value = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_CONFIG_ACTIVE_WINDOW_OPACITY: {
+        struct token value = get_token(message);
         if (!token_is_valid(value)) {
             fprintf(rsp, "%.4f\n", g_window_manager.active_window_opacity);
         } else {
@@ -522,8 +224,9 @@ static void handle_domain_config(FILE *rsp, struct token domain, char *message)
                 daemon_fail(rsp, "unknown value '%.*s' given to command '%.*s' for domain '%.*s'\n", value.length, value.text, command.length, command.text, domain.length, domain.text);
             }
         }
-    } else if (token_equals(command, COMMAND_CONFIG_NORMAL_WINDOW_OPACITY)) {
-        struct token value = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_CONFIG_NORMAL_WINDOW_OPACITY: {
+        struct token value = get_token(message);
         if (!token_is_valid(value)) {
             fprintf(rsp, "%.4f\n", g_window_manager.normal_window_opacity);
         } else {
@@ -534,8 +237,9 @@ static void handle_domain_config(FILE *rsp, struct token domain, char *message)
                 daemon_fail(rsp, "unknown value '%.*s' given to command '%.*s' for domain '%.*s'\n", value.length, value.text, command.length, command.text, domain.length, domain.text);
             }
         }
-    } else if (token_equals(command, COMMAND_CONFIG_INSERT_FEEDBACK_COLOR)) {
-        struct token value = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_CONFIG_INSERT_FEEDBACK_COLOR: {
+        struct token value = get_token(message);
         if (!token_is_valid(value)) {
             fprintf(rsp, "0x%x\n", g_window_manager.insert_feedback_color.p);
         } else {
@@ -546,8 +250,9 @@ static void handle_domain_config(FILE *rsp, struct token domain, char *message)
                 daemon_fail(rsp, "unknown value '%.*s' given to command '%.*s' for domain '%.*s'\n", value.length, value.text, command.length, command.text, domain.length, domain.text);
             }
         }
-    } else if (token_equals(command, COMMAND_CONFIG_TOP_PADDING)) {
-        struct token value = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_CONFIG_TOP_PADDING: {
+        struct token value = get_token(message);
         if (sel_mci) {
             if (sel_sid) {
                 struct view *view = space_manager_find_view(&g_space_manager, sel_sid);
@@ -569,8 +274,9 @@ static void handle_domain_config(FILE *rsp, struct token domain, char *message)
                 }
             }
         }
-    } else if (token_equals(command, COMMAND_CONFIG_BOTTOM_PADDING)) {
-        struct token value = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_CONFIG_BOTTOM_PADDING: {
+        struct token value = get_token(message);
         if (sel_mci) {
             if (sel_sid) {
                 struct view *view = space_manager_find_view(&g_space_manager, sel_sid);
@@ -592,8 +298,9 @@ static void handle_domain_config(FILE *rsp, struct token domain, char *message)
                 }
             }
         }
-    } else if (token_equals(command, COMMAND_CONFIG_LEFT_PADDING)) {
-        struct token value = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_CONFIG_LEFT_PADDING: {
+        struct token value = get_token(message);
         if (sel_mci) {
             if (sel_sid) {
                 struct view *view = space_manager_find_view(&g_space_manager, sel_sid);
@@ -615,8 +322,9 @@ static void handle_domain_config(FILE *rsp, struct token domain, char *message)
                 }
             }
         }
-    } else if (token_equals(command, COMMAND_CONFIG_RIGHT_PADDING)) {
-        struct token value = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_CONFIG_RIGHT_PADDING: {
+        struct token value = get_token(message);
         if (sel_mci) {
             if (sel_sid) {
                 struct view *view = space_manager_find_view(&g_space_manager, sel_sid);
@@ -638,8 +346,9 @@ static void handle_domain_config(FILE *rsp, struct token domain, char *message)
                 }
             }
         }
-    } else if (token_equals(command, COMMAND_CONFIG_WINDOW_GAP)) {
-        struct token value = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_CONFIG_WINDOW_GAP: {
+        struct token value = get_token(message);
         if (sel_mci) {
             if (sel_sid) {
                 struct view *view = space_manager_find_view(&g_space_manager, sel_sid);
@@ -661,8 +370,9 @@ static void handle_domain_config(FILE *rsp, struct token domain, char *message)
                 }
             }
         }
-    } else if (token_equals(command, COMMAND_CONFIG_LAYOUT)) {
-        struct token value = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_CONFIG_LAYOUT: {
+        struct token value = get_token(message);
         if (sel_mci) {
             if (sel_sid) {
                 struct view *view = space_manager_find_view(&g_space_manager, sel_sid);
@@ -713,15 +423,17 @@ static void handle_domain_config(FILE *rsp, struct token domain, char *message)
                 daemon_fail(rsp, "unknown value '%.*s' given to command '%.*s' for domain '%.*s'\n", value.length, value.text, command.length, command.text, domain.length, domain.text);
             }
         }
-    } else if (token_equals(command, COMMAND_CONFIG_SPLIT_RATIO)) {
-        struct token value = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_CONFIG_SPLIT_RATIO: {
+        struct token value = get_token(message);
         if (!token_is_valid(value)) {
             fprintf(rsp, "%.4f\n", g_space_manager.split_ratio);
         } else {
             g_space_manager.split_ratio = token_to_float(value);
         }
-    } else if (token_equals(command, COMMAND_CONFIG_AUTO_BALANCE)) {
-        struct token value = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_CONFIG_AUTO_BALANCE: {
+        struct token value = get_token(message);
         if (!token_is_valid(value)) {
             fprintf(rsp, "%s\n", bool_str[g_space_manager.auto_balance]);
         } else if (token_equals(value, ARGUMENT_COMMON_VAL_OFF)) {
@@ -731,8 +443,9 @@ static void handle_domain_config(FILE *rsp, struct token domain, char *message)
         } else {
             daemon_fail(rsp, "unknown value '%.*s' given to command '%.*s' for domain '%.*s'\n", value.length, value.text, command.length, command.text, domain.length, domain.text);
         }
-    } else if (token_equals(command, COMMAND_CONFIG_MOUSE_MOD)) {
-        struct token value = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_CONFIG_MOUSE_MOD: {
+        struct token value = get_token(message);
         if (!token_is_valid(value)) {
             fprintf(rsp, "%s\n", mouse_mod_str[g_mouse_state.modifier]);
         } else if (token_equals(value, ARGUMENT_CONFIG_MOUSE_MOD_ALT)) {
@@ -748,8 +461,9 @@ static void handle_domain_config(FILE *rsp, struct token domain, char *message)
         } else {
             daemon_fail(rsp, "unknown value '%.*s' given to command '%.*s' for domain '%.*s'\n", value.length, value.text, command.length, command.text, domain.length, domain.text);
         }
-    } else if (token_equals(command, COMMAND_CONFIG_MOUSE_ACTION1)) {
-        struct token value = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_CONFIG_MOUSE_ACTION1: {
+        struct token value = get_token(message);
         if (!token_is_valid(value)) {
             fprintf(rsp, "%s\n", mouse_mode_str[g_mouse_state.action1]);
         } else if (token_equals(value, ARGUMENT_CONFIG_MOUSE_ACTION_MOVE)) {
@@ -759,8 +473,9 @@ static void handle_domain_config(FILE *rsp, struct token domain, char *message)
         } else {
             daemon_fail(rsp, "unknown value '%.*s' given to command '%.*s' for domain '%.*s'\n", value.length, value.text, command.length, command.text, domain.length, domain.text);
         }
-    } else if (token_equals(command, COMMAND_CONFIG_MOUSE_ACTION2)) {
-        struct token value = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_CONFIG_MOUSE_ACTION2: {
+        struct token value = get_token(message);
         if (!token_is_valid(value)) {
             fprintf(rsp, "%s\n", mouse_mode_str[g_mouse_state.action2]);
         } else if (token_equals(value, ARGUMENT_CONFIG_MOUSE_ACTION_MOVE)) {
@@ -770,8 +485,9 @@ static void handle_domain_config(FILE *rsp, struct token domain, char *message)
         } else {
             daemon_fail(rsp, "unknown value '%.*s' given to command '%.*s' for domain '%.*s'\n", value.length, value.text, command.length, command.text, domain.length, domain.text);
         }
-    } else if (token_equals(command, COMMAND_CONFIG_MOUSE_DROP_ACTION)) {
-        struct token value = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_CONFIG_MOUSE_DROP_ACTION: {
+        struct token value = get_token(message);
         if (!token_is_valid(value)) {
             fprintf(rsp, "%s\n", mouse_mode_str[g_mouse_state.drop_action]);
         } else if (token_equals(value, ARGUMENT_CONFIG_MOUSE_ACTION_SWAP)) {
@@ -781,10 +497,11 @@ static void handle_domain_config(FILE *rsp, struct token domain, char *message)
         } else {
             daemon_fail(rsp, "unknown value '%.*s' given to command '%.*s' for domain '%.*s'\n", value.length, value.text, command.length, command.text, domain.length, domain.text);
         }
-    } else if (token_equals(command, COMMAND_CONFIG_EXTERNAL_BAR)) {
+    } break;
+    case KEYWORD_COMMAND_CONFIG_EXTERNAL_BAR: {
         int t, b;
         char mode[6];
-        struct token value = get_token(&message);
+        struct token value = get_token(message);
         if ((sscanf(value.text, ARGUMENT_CONFIG_EXTERNAL_BAR, mode, &t, &b) == 3)) {
             if (string_equals(mode, ARGUMENT_CONFIG_EXTERNAL_BAR_MAIN)) {
                 g_display_manager.mode = EXTERNAL_BAR_MAIN;
@@ -807,8 +524,10 @@ static void handle_domain_config(FILE *rsp, struct token domain, char *message)
         } else {
             fprintf(rsp, "%s:%d:%d\n", external_bar_mode_str[g_display_manager.mode], g_display_manager.top_padding, g_display_manager.bottom_padding);
         }
-    } else {
+    } break;
+    default: {
         daemon_fail(rsp, "unknown command '%.*s' for domain '%.*s'\n", command.length, command.text, domain.length, domain.text);
+    } break;
     }
 }
 
@@ -841,7 +560,7 @@ static char *reserved_space_identifiers[] =
     ARGUMENT_COMMON_SEL_RECENT
 };
 
-static bool parse_label(FILE *rsp, char **message, enum label_type type, char **label)
+static bool parse_label(FILE *rsp, struct token_index *message, enum label_type type, char **label)
 {
     struct token value = get_token(message);
 
@@ -907,14 +626,15 @@ static uint8_t parse_resize_handle(char *handle)
     }
 }
 
-static struct selector parse_display_selector(FILE *rsp, char **message, uint32_t acting_did)
+static struct selector parse_display_selector(FILE *rsp, struct token_index *message, uint32_t acting_did)
 {
     struct selector result = {
         .token = get_token(message),
         .did_parse = true
     };
 
-    if (token_equals(result.token, ARGUMENT_COMMON_SEL_NORTH)) {
+    switch (keyword_display_selector(result.token)) {
+    case KEYWORD_COMMON_SEL_NORTH: {
         if (acting_did) {
             uint32_t did = display_manager_find_closest_display_in_direction(acting_did, DIR_NORTH);
             if (did) {
@@ -925,7 +645,8 @@ static struct selector parse_display_selector(FILE *rsp, char **message, uint32_
         } else {
             daemon_fail(rsp, "could not locate the selected display.\n");
         }
-    } else if (token_equals(result.token, ARGUMENT_COMMON_SEL_EAST)) {
+    } break;
+    case KEYWORD_COMMON_SEL_EAST: {
         if (acting_did) {
             uint32_t did = display_manager_find_closest_display_in_direction(acting_did, DIR_EAST);
             if (did) {
@@ -936,7 +657,8 @@ static struct selector parse_display_selector(FILE *rsp, char **message, uint32_
         } else {
             daemon_fail(rsp, "could not locate the selected display.\n");
         }
-    } else if (token_equals(result.token, ARGUMENT_COMMON_SEL_SOUTH)) {
+    } break;
+    case KEYWORD_COMMON_SEL_SOUTH: {
         if (acting_did) {
             uint32_t did = display_manager_find_closest_display_in_direction(acting_did, DIR_SOUTH);
             if (did) {
@@ -947,7 +669,8 @@ static struct selector parse_display_selector(FILE *rsp, char **message, uint32_
         } else {
             daemon_fail(rsp, "could not locate the selected display.\n");
         }
-    } else if (token_equals(result.token, ARGUMENT_COMMON_SEL_WEST)) {
+    } break;
+    case KEYWORD_COMMON_SEL_WEST: {
         if (acting_did) {
             uint32_t did = display_manager_find_closest_display_in_direction(acting_did, DIR_WEST);
             if (did) {
@@ -958,7 +681,8 @@ static struct selector parse_display_selector(FILE *rsp, char **message, uint32_
         } else {
             daemon_fail(rsp, "could not locate the selected display.\n");
         }
-    } else if (token_equals(result.token, ARGUMENT_COMMON_SEL_PREV)) {
+    } break;
+    case KEYWORD_COMMON_SEL_PREV: {
         if (acting_did) {
             uint32_t did = display_manager_prev_display_id(acting_did);
             if (did) {
@@ -969,7 +693,8 @@ static struct selector parse_display_selector(FILE *rsp, char **message, uint32_
         } else {
             daemon_fail(rsp, "could not locate the selected display.\n");
         }
-    } else if (token_equals(result.token, ARGUMENT_COMMON_SEL_NEXT)) {
+    } break;
+    case KEYWORD_COMMON_SEL_NEXT: {
         if (acting_did) {
             uint32_t did = display_manager_next_display_id(acting_did);
             if (did) {
@@ -980,62 +705,71 @@ static struct selector parse_display_selector(FILE *rsp, char **message, uint32_
         } else {
             daemon_fail(rsp, "could not locate the selected display.\n");
         }
-    } else if (token_equals(result.token, ARGUMENT_COMMON_SEL_FIRST)) {
+    } break;
+    case KEYWORD_COMMON_SEL_FIRST: {
         uint32_t did = display_manager_first_display_id();
         if (did) {
             result.did = did;
         } else {
             daemon_fail(rsp, "could not locate the first display.\n");
         }
-    } else if (token_equals(result.token, ARGUMENT_COMMON_SEL_LAST)) {
+    } break;
+    case KEYWORD_COMMON_SEL_LAST: {
         uint32_t did = display_manager_last_display_id();
         if (did) {
             result.did = did;
         } else {
             daemon_fail(rsp, "could not locate the last display.\n");
         }
-    } else if (token_equals(result.token, ARGUMENT_COMMON_SEL_RECENT)) {
+    } break;
+    case KEYWORD_COMMON_SEL_RECENT: {
         result.did = g_display_manager.last_display_id;
-    } else if (token_equals(result.token, ARGUMENT_COMMON_SEL_MOUSE)) {
+    } break;
+    case KEYWORD_COMMON_SEL_MOUSE: {
         uint32_t did = display_manager_cursor_display_id();
         if (did) {
             result.did = did;
         } else {
             daemon_fail(rsp, "could not locate display containing cursor.\n");
         }
-    } else if (token_is_valid(result.token)) {
-        int arrangement_index = 0;
-        if (token_to_int(result.token, &arrangement_index)) {
-            if (arrangement_index) {
-                uint32_t did = display_manager_arrangement_display_id(arrangement_index);
-                if (did) {
-                    result.did = did;
+    } break;
+    default: {
+        if (token_is_valid(result.token)) {
+            int arrangement_index = 0;
+            if (token_to_int(result.token, &arrangement_index)) {
+                if (arrangement_index) {
+                    uint32_t did = display_manager_arrangement_display_id(arrangement_index);
+                    if (did) {
+                        result.did = did;
+                    } else {
+                        daemon_fail(rsp, "could not locate display with arrangement index '%d'.\n", arrangement_index);
+                    }
                 } else {
-                    daemon_fail(rsp, "could not locate display with arrangement index '%d'.\n", arrangement_index);
+                    daemon_fail(rsp, "invalid arrangement-index specified '%d'.\n", arrangement_index);
                 }
             } else {
-                daemon_fail(rsp, "invalid arrangement-index specified '%d'.\n", arrangement_index);
+                result.did_parse = false;
+                daemon_fail(rsp, "value '%.*s' is not a valid option for DISPLAY_SEL\n", result.token.length, result.token.text);
             }
         } else {
             result.did_parse = false;
             daemon_fail(rsp, "value '%.*s' is not a valid option for DISPLAY_SEL\n", result.token.length, result.token.text);
         }
-    } else {
-        result.did_parse = false;
-        daemon_fail(rsp, "value '%.*s' is not a valid option for DISPLAY_SEL\n", result.token.length, result.token.text);
+    } break;
     }
 
     return result;
 }
 
-static struct selector parse_space_selector(FILE *rsp, char **message, uint64_t acting_sid)
+static struct selector parse_space_selector(FILE *rsp, struct token_index *message, uint64_t acting_sid)
 {
     struct selector result = {
         .token = get_token(message),
         .did_parse = true
     };
 
-    if (token_equals(result.token, ARGUMENT_COMMON_SEL_PREV)) {
+    switch (keyword_space_selector(result.token)) {
+    case KEYWORD_COMMON_SEL_PREV: {
         if (acting_sid) {
             uint64_t sid = space_manager_prev_space(acting_sid);
             if (sid) {
@@ -1046,7 +780,8 @@ static struct selector parse_space_selector(FILE *rsp, char **message, uint64_t
         } else {
             daemon_fail(rsp, "could not locate the selected space.\n");
         }
-    } else if (token_equals(result.token, ARGUMENT_COMMON_SEL_NEXT)) {
+    } break;
+    case KEYWORD_COMMON_SEL_NEXT: {
         if (acting_sid) {
             uint64_t sid = space_manager_next_space(acting_sid);
             if (sid) {
@@ -1057,68 +792,77 @@ static struct selector parse_space_selector(FILE *rsp, char **message, uint64_t
         } else {
             daemon_fail(rsp, "could not locate the selected space.\n");
         }
-    } else if (token_equals(result.token, ARGUMENT_COMMON_SEL_FIRST)) {
+    } break;
+    case KEYWORD_COMMON_SEL_FIRST: {
         uint64_t sid = space_manager_first_space();
         if (sid) {
             result.sid = sid;
         } else {
             daemon_fail(rsp, "could not locate the first space.\n");
         }
-    } else if (token_equals(result.token, ARGUMENT_COMMON_SEL_LAST)) {
+    } break;
+    case KEYWORD_COMMON_SEL_LAST: {
         uint64_t sid = space_manager_last_space();
         if (sid) {
             result.sid = sid;
         } else {
             daemon_fail(rsp, "could not locate the last space.\n");
         }
-    } else if (token_equals(result.token, ARGUMENT_COMMON_SEL_RECENT)) {
+    } break;
+    case KEYWORD_COMMON_SEL_RECENT: {
         result.sid = g_space_manager.last_space_id;
-    } else if (token_equals(result.token, ARGUMENT_COMMON_SEL_MOUSE)) {
+    } break;
+    case KEYWORD_COMMON_SEL_MOUSE: {
         uint64_t sid = space_manager_cursor_space();
         if (sid) {
             result.sid = sid;
         } else {
             daemon_fail(rsp, "could not locate space containing cursor.\n");
         }
-    } else if (token_is_valid(result.token)) {
-        int mci = 0;
-        if (token_to_int(result.token, &mci)) {
-            if (mci) {
-                uint64_t sid = space_manager_mission_control_space(mci);
-                if (sid) {
-                    result.sid = sid;
+    } break;
+    default: {
+        if (token_is_valid(result.token)) {
+            int mci = 0;
+            if (token_to_int(result.token, &mci)) {
+                if (mci) {
+                    uint64_t sid = space_manager_mission_control_space(mci);
+                    if (sid) {
+                        result.sid = sid;
+                    } else {
+                        daemon_fail(rsp, "could not locate space with mission-control index '%d'.\n", mci);
+                    }
                 } else {
-                    daemon_fail(rsp, "could not locate space with mission-control index '%d'.\n", mci);
+                    daemon_fail(rsp, "invalid mission-control index specified '%d'.\n", mci);
                 }
             } else {
-                daemon_fail(rsp, "invalid mission-control index specified '%d'.\n", mci);
+                struct space_label *space_label = space_manager_get_space_for_label(&g_space_manager, result.token);
+                if (space_label) {
+                    result.did_parse = true;
+                    result.sid = space_label->sid;
+                } else {
+                    result.did_parse = false;
+                    daemon_fail(rsp, "value '%.*s' is not a valid option for SPACE_SEL\n", result.token.length, result.token.text);
+                }
             }
         } else {
-            struct space_label *space_label = space_manager_get_space_for_label(&g_space_manager, result.token);
-            if (space_label) {
-                result.did_parse = true;
-                result.sid = space_label->sid;
-            } else {
-                result.did_parse = false;
-                daemon_fail(rsp, "value '%.*s' is not a valid option for SPACE_SEL\n", result.token.length, result.token.text);
-            }
+            result.did_parse = false;
+            daemon_fail(rsp, "value '%.*s' is not a valid option for SPACE_SEL\n", result.token.length, result.token.text);
         }
-    } else {
-        result.did_parse = false;
-        daemon_fail(rsp, "value '%.*s' is not a valid option for SPACE_SEL\n", result.token.length, result.token.text);
+    } break;
     }
 
     return result;
 }
 
-static struct selector parse_window_selector(FILE *rsp, char **message, struct window *acting_window)
+static struct selector parse_window_selector(FILE *rsp, struct token_index *message, struct window *acting_window)
 {
     struct selector result = {
         .token = get_token(message),
         .did_parse = true
     };
 
-    if (token_equals(result.token, ARGUMENT_COMMON_SEL_NORTH)) {
+    switch (keyword_window_selector(result.token)) {
+    case KEYWORD_COMMON_SEL_NORTH: {
         if (acting_window) {
             struct window *closest_window = window_manager_find_closest_managed_window_in_direction(&g_window_manager, acting_window, DIR_NORTH);
             if (closest_window) {
@@ -1129,7 +873,8 @@ static struct selector parse_window_selector(FILE *rsp, char **message, struct w
         } else {
             daemon_fail(rsp, "could not locate the selected window.\n");
         }
-    } else if (token_equals(result.token, ARGUMENT_COMMON_SEL_EAST)) {
+    } break;
+    case KEYWORD_COMMON_SEL_EAST: {
         if (acting_window) {
             struct window *closest_window = window_manager_find_closest_managed_window_in_direction(&g_window_manager, acting_window, DIR_EAST);
             if (closest_window) {
@@ -1140,7 +885,8 @@ static struct selector parse_window_selector(FILE *rsp, char **message, struct w
         } else {
             daemon_fail(rsp, "could not locate the selected window.\n");
         }
-    } else if (token_equals(result.token, ARGUMENT_COMMON_SEL_SOUTH)) {
+    } break;
+    case KEYWORD_COMMON_SEL_SOUTH: {
         if (acting_window) {
             struct window *closest_window = window_manager_find_closest_managed_window_in_direction(&g_window_manager, acting_window, DIR_SOUTH);
             if (closest_window) {
@@ -1151,7 +897,8 @@ static struct selector parse_window_selector(FILE *rsp, char **message, struct w
         } else {
             daemon_fail(rsp, "could not locate the selected window.\n");
         }
-    } else if (token_equals(result.token, ARGUMENT_COMMON_SEL_WEST)) {
+    } break;
+    case KEYWORD_COMMON_SEL_WEST: {
         if (acting_window) {
             struct window *closest_window = window_manager_find_closest_managed_window_in_direction(&g_window_manager, acting_window, DIR_WEST);
             if (closest_window) {
@@ -1162,28 +909,32 @@ static struct selector parse_window_selector(FILE *rsp, char **message, struct w
         } else {
             daemon_fail(rsp, "could not locate the selected window.\n");
         }
-    } else if (token_equals(result.token, ARGUMENT_COMMON_SEL_MOUSE)) {
+    } break;
+    case KEYWORD_COMMON_SEL_MOUSE: {
         struct window *mouse_window = window_manager_find_window_below_cursor(&g_window_manager);
         if (mouse_window) {
             result.window = mouse_window;
         } else {
             daemon_fail(rsp, "could not locate a window below the cursor.\n");
         }
-    } else if (token_equals(result.token, ARGUMENT_WINDOW_SEL_LARGEST)) {
+    } break;
+    case KEYWORD_WINDOW_SEL_LARGEST: {
         struct window *area_window = window_manager_find_largest_managed_window(&g_space_manager, &g_window_manager);
         if (area_window) {
             result.window = area_window;
         } else {
             daemon_fail(rsp, "could not locate window with the largest area.\n");
         }
-    } else if (token_equals(result.token, ARGUMENT_WINDOW_SEL_SMALLEST)) {
+    } break;
+    case KEYWORD_WINDOW_SEL_SMALLEST: {
         struct window *area_window = window_manager_find_smallest_managed_window(&g_space_manager, &g_window_manager);
         if (area_window) {
             result.window = area_window;
         } else {
             daemon_fail(rsp, "could not locate window with the smallest area.\n");
         }
-    } else if (token_equals(result.token, ARGUMENT_COMMON_SEL_PREV)) {
+    } break;
+    case KEYWORD_COMMON_SEL_PREV: {
         if (acting_window) {
             struct window *prev_window = window_manager_find_prev_managed_window(&g_space_manager, &g_window_manager, acting_window);
             if (prev_window) {
@@ -1194,7 +945,8 @@ static struct selector parse_window_selector(FILE *rsp, char **message, struct w
         } else {
             daemon_fail(rsp, "could not locate the selected window.\n");
         }
-    } else if (token_equals(result.token, ARGUMENT_COMMON_SEL_NEXT)) {
+    } break;
+    case KEYWORD_COMMON_SEL_NEXT: {
         if (acting_window) {
             struct window *next_window = window_manager_find_next_managed_window(&g_space_manager, &g_window_manager, acting_window);
             if (next_window) {
@@ -1205,28 +957,32 @@ static struct selector parse_window_selector(FILE *rsp, char **message, struct w
         } else {
             daemon_fail(rsp, "could not locate the selected window.\n");
         }
-    } else if (token_equals(result.token, ARGUMENT_COMMON_SEL_FIRST)) {
+    } break;
+    case KEYWORD_COMMON_SEL_FIRST: {
         struct window *first_window = window_manager_find_first_managed_window(&g_space_manager, &g_window_manager);
         if (first_window) {
             result.window = first_window;
         } else {
             daemon_fail(rsp, "could not locate the first managed window.\n");
         }
-    } else if (token_equals(result.token, ARGUMENT_COMMON_SEL_LAST)) {
+    } break;
+    case KEYWORD_COMMON_SEL_LAST: {
         struct window *last_window = window_manager_find_last_managed_window(&g_space_manager, &g_window_manager);
         if (last_window) {
             result.window = last_window;
         } else {
             daemon_fail(rsp, "could not locate the last managed window.\n");
         }
-    } else if (token_equals(result.token, ARGUMENT_COMMON_SEL_RECENT)) {
+    } break;
+    case KEYWORD_COMMON_SEL_RECENT: {
         struct window *recent_window = window_manager_find_recent_managed_window(&g_space_manager, &g_window_manager);
         if (recent_window) {
             result.window = recent_window;
         } else {
             daemon_fail(rsp, "could not locate the most recently focused window.\n");
         }
-    } else if (token_equals(result.token, ARGUMENT_COMMON_SEL_STACK_PREV)) {
+    } break;
+    case KEYWORD_COMMON_SEL_STACK_PREV: {
         if (acting_window) {
             struct window *prev_window = window_manager_find_prev_window_in_stack(&g_space_manager, &g_window_manager, acting_window);
             if (prev_window) {
@@ -1237,7 +993,8 @@ static struct selector parse_window_selector(FILE *rsp, char **message, struct w
         } else {
             daemon_fail(rsp, "could not locate the selected window.\n");
         }
-    } else if (token_equals(result.token, ARGUMENT_COMMON_SEL_STACK_NEXT)) {
+    } break;
+    case KEYWORD_COMMON_SEL_STACK_NEXT: {
         if (acting_window) {
             struct window *next_window = window_manager_find_next_window_in_stack(&g_space_manager, &g_window_manager, acting_window);
             if (next_window) {
@@ -1248,7 +1005,8 @@ static struct selector parse_window_selector(FILE *rsp, char **message, struct w
         } else {
             daemon_fail(rsp, "could not locate the selected window.\n");
         }
-    } else if (token_equals(result.token, ARGUMENT_COMMON_SEL_STACK_FIRST)) {
+    } break;
+    case KEYWORD_COMMON_SEL_STACK_FIRST: {
         if (acting_window) {
             struct window *first_window = window_manager_find_first_window_in_stack(&g_space_manager, &g_window_manager, acting_window);
             if (first_window) {
@@ -1259,7 +1017,8 @@ static struct selector parse_window_selector(FILE *rsp, char **message, struct w
         } else {
             daemon_fail(rsp, "could not locate the selected window.\n");
         }
-    } else if (token_equals(result.token, ARGUMENT_COMMON_SEL_STACK_LAST)) {
+    } break;
+    case KEYWORD_COMMON_SEL_STACK_LAST: {
         if (acting_window) {
             struct window *last_window = window_manager_find_last_window_in_stack(&g_space_manager, &g_window_manager, acting_window);
             if (last_window) {
@@ -1270,7 +1029,8 @@ static struct selector parse_window_selector(FILE *rsp, char **message, struct w
         } else {
             daemon_fail(rsp, "could not locate the selected window.\n");
         }
-    } else if (token_equals(result.token, ARGUMENT_COMMON_SEL_STACK_RECENT)) {
+    } break;
+    case KEYWORD_COMMON_SEL_STACK_RECENT: {
         if (acting_window) {
             struct window *recent_window = window_manager_find_recent_window_in_stack(&g_space_manager, &g_window_manager, acting_window);
             if (recent_window) {
@@ -1281,65 +1041,76 @@ static struct selector parse_window_selector(FILE *rsp, char **message, struct w
         } else {
             daemon_fail(rsp, "could not locate the selected window.\n");
         }
-    } else if (token_is_valid(result.token)) {
-        int wid = 0;
-        if (token_to_int(result.token, &wid)) {
-            if (wid) {
-                struct window *window = window_manager_find_window(&g_window_manager, wid);
-                if (window) {
-                    result.window = window;
+    } break;
+    default: {
+        if (token_is_valid(result.token)) {
+            int wid = 0;
+            if (token_to_int(result.token, &wid)) {
+                if (wid) {
+                    struct window *window = window_manager_find_window(&g_window_manager, wid);
+                    if (window) {
+                        result.window = window;
+                    } else {
+                        daemon_fail(rsp, "could not locate window with the specified id '%d'.\n", wid);
+                    }
                 } else {
-                    daemon_fail(rsp, "could not locate window with the specified id '%d'.\n", wid);
+                    daemon_fail(rsp, "invalid window id specified '%d'.\n", wid);
                 }
             } else {
-                daemon_fail(rsp, "invalid window id specified '%d'.\n", wid);
+                result.did_parse = false;
+                daemon_fail(rsp, "value '%.*s' is not a valid option for WINDOW_SEL\n", result.token.length, result.token.text);
             }
         } else {
             result.did_parse = false;
             daemon_fail(rsp, "value '%.*s' is not a valid option for WINDOW_SEL\n", result.token.length, result.token.text);
         }
-    } else {
-        result.did_parse = false;
-        daemon_fail(rsp, "value '%.*s' is not a valid option for WINDOW_SEL\n", result.token.length, result.token.text);
+    } break;
     }
 
     return result;
 }
 
-static struct selector parse_insert_selector(FILE *rsp, char **message)
+static struct selector parse_insert_selector(FILE *rsp, struct token_index *message)
 {
     struct selector result = {
         .token = get_token(message),
         .did_parse = true
     };
 
-    if (token_equals(result.token, ARGUMENT_COMMON_SEL_NORTH)) {
+    switch (keyword_insert_selector(result.token)) {
+    case KEYWORD_COMMON_SEL_NORTH: {
         result.dir = DIR_NORTH;
-    } else if (token_equals(result.token, ARGUMENT_COMMON_SEL_EAST)) {
+    } break;
+    case KEYWORD_COMMON_SEL_EAST: {
         result.dir = DIR_EAST;
-    } else if (token_equals(result.token, ARGUMENT_COMMON_SEL_SOUTH)) {
+    } break;
+    case KEYWORD_COMMON_SEL_SOUTH: {
         result.dir = DIR_SOUTH;
-    } else if (token_equals(result.token, ARGUMENT_COMMON_SEL_WEST)) {
+    } break;
+    case KEYWORD_COMMON_SEL_WEST: {
         result.dir = DIR_WEST;
-    } else if (token_equals(result.token, ARGUMENT_COMMON_SEL_STACK)) {
+    } break;
+    case KEYWORD_COMMON_SEL_STACK: {
         result.dir = STACK;
-    } else {
+    } break;
+    default: {
         result.did_parse = false;
         daemon_fail(rsp, "value '%.*s' is not a valid option for DIR_SEL\n", result.token.length, result.token.text);
+    } break;
     }
 
     return result;
 }
 
-static void handle_domain_display(FILE *rsp, struct token domain, char *message)
+static void handle_domain_display(FILE *rsp, struct token domain, struct token_index *message)
 {
     struct token command;
     uint32_t acting_did;
-    struct selector selector = parse_display_selector(NULL, &message, display_manager_active_display_id());
+    struct selector selector = parse_display_selector(NULL, message, display_manager_active_display_id());
 
     if (selector.did_parse) {
         acting_did = selector.did;
-        command = get_token(&message);
+        command = get_token(message);
     } else {
         acting_did = display_manager_active_display_id();
         command = selector.token;
@@ -1350,25 +1121,28 @@ static void handle_domain_display(FILE *rsp, struct token domain, char *message)
         return;
     }
 
-    if (token_equals(command, COMMAND_DISPLAY_FOCUS)) {
-        struct selector selector = parse_display_selector(rsp, &message, acting_did);
+    switch (keyword_display_command(command)) {
+    case KEYWORD_COMMAND_DISPLAY_FOCUS: {
+        struct selector selector = parse_display_selector(rsp, message, acting_did);
         if (selector.did_parse && selector.did) {
             display_manager_focus_display(selector.did);
         }
-    } else {
+    } break;
+    default: {
         daemon_fail(rsp, "unknown command '%.*s' for domain '%.*s'\n", command.length, command.text, domain.length, domain.text);
+    } break;
     }
 }
 
-static void handle_domain_space(FILE *rsp, struct token domain, char *message)
+static void handle_domain_space(FILE *rsp, struct token domain, struct token_index *message)
 {
     struct token command;
     uint64_t acting_sid;
-    struct selector selector = parse_space_selector(NULL, &message, space_manager_active_space());
+    struct selector selector = parse_space_selector(NULL, message, space_manager_active_space());
 
     if (selector.did_parse) {
         acting_sid = selector.sid;
-        command = get_token(&message);
+        command = get_token(message);
     } else {
         acting_sid = space_manager_active_space();
         command = selector.token;
@@ -1379,8 +1153,9 @@ static void handle_domain_space(FILE *rsp, struct token domain, char *message)
         return;
     }
 
-    if (token_equals(command, COMMAND_SPACE_FOCUS)) {
-        struct selector selector = parse_space_selector(rsp, &message, acting_sid);
+    switch (keyword_space_command(command)) {
+    case KEYWORD_COMMAND_SPACE_FOCUS: {
+        struct selector selector = parse_space_selector(rsp, message, acting_sid);
         if (selector.did_parse && selector.sid) {
             enum space_op_error result = space_manager_focus_space(selector.sid);
             if (result == SPACE_OP_ERROR_SAME_SPACE) {
@@ -1391,8 +1166,9 @@ static void handle_domain_space(FILE *rsp, struct token domain, char *message)
                 daemon_fail(rsp, "cannot focus space because mission-control is active.\n");
             }
         }
-    } else if (token_equals(command, COMMAND_SPACE_MOVE)) {
-        struct selector selector = parse_space_selector(rsp, &message, acting_sid);
+    } break;
+    case KEYWORD_COMMAND_SPACE_MOVE: {
+        struct selector selector = parse_space_selector(rsp, message, acting_sid);
         if (selector.did_parse && selector.sid) {
             enum space_op_error result = space_manager_move_space_to_space(acting_sid, selector.sid);
             if (result == SPACE_OP_ERROR_SAME_SPACE) {
@@ -1405,8 +1181,9 @@ static void handle_domain_space(FILE *rsp, struct token domain, char *message)
                 daemon_fail(rsp, "cannot move space because mission-control is active.\n");
             }
         }
-    } else if (token_equals(command, COMMAND_SPACE_SWAP)) {
-        struct selector selector = parse_space_selector(rsp, &message, acting_sid);
+    } break;
+    case KEYWORD_COMMAND_SPACE_SWAP: {
+        struct selector selector = parse_space_selector(rsp, message, acting_sid);
         if (selector.did_parse && selector.sid) {
             enum space_op_error result = space_manager_swap_space_with_space(acting_sid, selector.sid);
             if (result == SPACE_OP_ERROR_SAME_SPACE) {
@@ -1419,8 +1196,9 @@ static void handle_domain_space(FILE *rsp, struct token domain, char *message)
                 daemon_fail(rsp, "cannot swap space because mission-control is active.\n");
             }
         }
-    } else if (token_equals(command, COMMAND_SPACE_DISPLAY)) {
-        struct selector selector = parse_display_selector(rsp, &message, display_manager_active_display_id());
+    } break;
+    case KEYWORD_COMMAND_SPACE_DISPLAY: {
+        struct selector selector = parse_display_selector(rsp, message, display_manager_active_display_id());
         if (selector.did_parse && selector.did) {
             enum space_op_error result = space_manager_move_space_to_display(&g_space_manager, acting_sid, selector.did);
             if (result == SPACE_OP_ERROR_MISSING_SRC) {
@@ -1437,7 +1215,8 @@ static void handle_domain_space(FILE *rsp, struct token domain, char *message)
                 daemon_fail(rsp, "cannot send space to display because mission-control is active.\n");
             }
         }
-    } else if (token_equals(command, COMMAND_SPACE_CREATE)) {
+    } break;
+    case KEYWORD_COMMAND_SPACE_CREATE: {
         enum space_op_error result = space_manager_add_space(acting_sid);
         if (result == SPACE_OP_ERROR_MISSING_SRC) {
             daemon_fail(rsp, "could not locate the space to act on.\n");
@@ -1446,7 +1225,8 @@ static void handle_domain_space(FILE *rsp, struct token domain, char *message)
         } else if (result == SPACE_OP_ERROR_IN_MISSION_CONTROL) {
             daemon_fail(rsp, "cannot create space because mission-control is active.\n");
         }
-    } else if (token_equals(command, COMMAND_SPACE_DESTROY)) {
+    } break;
+    case KEYWORD_COMMAND_SPACE_DESTROY: {
         enum space_op_error result = space_manager_destroy_space(acting_sid);
         if (result == SPACE_OP_ERROR_MISSING_SRC) {
             daemon_fail(rsp, "could not locate the space to act on.\n");
@@ -1459,12 +1239,14 @@ static void handle_domain_space(FILE *rsp, struct token domain, char *message)
         } else if (result == SPACE_OP_ERROR_IN_MISSION_CONTROL) {
             daemon_fail(rsp, "cannot destroy space because mission-control is active.\n");
         }
-    } else if (token_equals(command, COMMAND_SPACE_BALANCE)) {
+    } break;
+    case KEYWORD_COMMAND_SPACE_BALANCE: {
         if (!space_manager_balance_space(&g_space_manager, acting_sid)) {
             daemon_fail(rsp, "cannot balance a non-managed space.\n");
         }
-    } else if (token_equals(command, COMMAND_SPACE_MIRROR)) {
-        struct token value = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_SPACE_MIRROR: {
+        struct token value = get_token(message);
         if (token_equals(value, ARGUMENT_SPACE_MIRROR_X)) {
             if (!space_manager_mirror_space(&g_space_manager, acting_sid, SPLIT_X)) {
                 daemon_fail(rsp, "cannot mirror a non-managed space.\n");
@@ -1476,8 +1258,9 @@ static void handle_domain_space(FILE *rsp, struct token domain, char *message)
         } else {
             daemon_fail(rsp, "unknown value '%.*s' given to command '%.*s' for domain '%.*s'\n", value.length, value.text, command.length, command.text, domain.length, domain.text);
         }
-    } else if (token_equals(command, COMMAND_SPACE_ROTATE)) {
-        struct token value = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_SPACE_ROTATE: {
+        struct token value = get_token(message);
         if (token_equals(value, ARGUMENT_SPACE_ROTATE_90)) {
             if (!space_manager_rotate_space(&g_space_manager, acting_sid, 90)) {
                 daemon_fail(rsp, "cannot rotate a non-managed space.\n");
@@ -1493,10 +1276,11 @@ static void handle_domain_space(FILE *rsp, struct token domain, char *message)
         } else {
             daemon_fail(rsp, "unknown value '%.*s' given to command '%.*s' for domain '%.*s'\n", value.length, value.text, command.length, command.text, domain.length, domain.text);
         }
-    } else if (token_equals(command, COMMAND_SPACE_PADDING)) {
+    } break;
+    case KEYWORD_COMMAND_SPACE_PADDING: {
         int t, b, l, r;
         char type[MAXLEN];
-        struct token value = get_token(&message);
+        struct token value = get_token(message);
         if ((sscanf(value.text, ARGUMENT_SPACE_PADDING, type, &t, &b, &l, &r) == 5)) {
             if (!space_manager_set_padding_for_space(&g_space_manager, acting_sid, parse_value_type(type), t, b, l, r)) {
                 daemon_fail(rsp, "cannot set padding for a non-managed space.\n");
@@ -1504,10 +1288,11 @@ static void handle_domain_space(FILE *rsp, struct token domain, char *message)
         } else {
             daemon_fail(rsp, "unknown value '%.*s' given to command '%.*s' for domain '%.*s'\n", value.length, value.text, command.length, command.text, domain.length, domain.text);
         }
-    } else if (token_equals(command, COMMAND_SPACE_GAP)) {
+    } break;
+    case KEYWORD_COMMAND_SPACE_GAP: {
         int gap;
         char type[MAXLEN];
-        struct token value = get_token(&message);
+        struct token value = get_token(message);
         if ((sscanf(value.text, ARGUMENT_SPACE_GAP, type, &gap) == 2)) {
             if (!space_manager_set_gap_for_space(&g_space_manager, acting_sid, parse_value_type(type), gap)) {
                 daemon_fail(rsp, "cannot set gap for a non-managed space.\n");
@@ -1515,8 +1300,9 @@ static void handle_domain_space(FILE *rsp, struct token domain, char *message)
         } else {
             daemon_fail(rsp, "unknown value '%.*s' given to command '%.*s' for domain '%.*s'\n", value.length, value.text, command.length, command.text, domain.length, domain.text);
         }
-    } else if (token_equals(command, COMMAND_SPACE_TOGGLE)) {
-        struct token value = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_SPACE_TOGGLE: {
+        struct token value = get_token(message);
         if (token_equals(value, ARGUMENT_SPACE_TGL_PADDING)) {
             if (!space_manager_toggle_padding_for_space(&g_space_manager, acting_sid)) {
                 daemon_fail(rsp, "cannot toggle padding for a non-managed space.\n");
@@ -1532,8 +1318,9 @@ static void handle_domain_space(FILE *rsp, struct token domain, char *message)
         } else {
             daemon_fail(rsp, "unknown value '%.*s' given to command '%.*s' for domain '%.*s'\n", value.length, value.text, command.length, command.text, domain.length, domain.text);
         }
-    } else if (token_equals(command, COMMAND_SPACE_LAYOUT)) {
-        struct token value = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_SPACE_LAYOUT: {
+        struct token value = get_token(message);
         if (token_equals(value, ARGUMENT_SPACE_LAYOUT_BSP)) {
             if (space_is_user(acting_sid)) {
                 space_manager_set_layout_for_space(&g_space_manager, acting_sid, VIEW_BSP);
@@ -1555,9 +1342,10 @@ static void handle_domain_space(FILE *rsp, struct token domain, char *message)
         } else {
             daemon_fail(rsp, "unknown value '%.*s' given to command '%.*s' for domain '%.*s'\n", value.length, value.text, command.length, command.text, domain.length, domain.text);
         }
-    } else if (token_equals(command, COMMAND_SPACE_LABEL)) {
+    } break;
+    case KEYWORD_COMMAND_SPACE_LABEL: {
         char *label;
-        if (parse_label(rsp, &message, LABEL_SPACE, &label)) {
+        if (parse_label(rsp, message, LABEL_SPACE, &label)) {
             if (label) {
                 space_manager_set_label_for_space(&g_space_manager, acting_sid, label);
             } else {
@@ -1566,20 +1354,22 @@ static void handle_domain_space(FILE *rsp, struct token domain, char *message)
                 }
             }
         }
-    } else {
+    } break;
+    default: {
         daemon_fail(rsp, "unknown command '%.*s' for domain '%.*s'\n", command.length, command.text, domain.length, domain.text);
+    } break;
     }
 }
 
-static void handle_domain_window(FILE *rsp, struct token domain, char *message)
+static void handle_domain_window(FILE *rsp, struct token domain, struct token_index *message)
 {
     struct token command;
     struct window *acting_window;
-    struct selector selector = parse_window_selector(NULL, &message, window_manager_focused_window(&g_window_manager));
+    struct selector selector = parse_window_selector(NULL, message, window_manager_focused_window(&g_window_manager));
 
     if (selector.did_parse) {
         acting_window = selector.window;
-        command = get_token(&message);
+        command = get_token(message);
     } else {
         acting_window = window_manager_focused_window(&g_window_manager);
         command = selector.token;
@@ -1590,13 +1380,15 @@ static void handle_domain_window(FILE *rsp, struct token domain, char *message)
         return;
     }
 
-    if (token_equals(command, COMMAND_WINDOW_FOCUS)) {
-        struct selector selector = parse_window_selector(rsp, &message, acting_window);
+    switch (keyword_window_command(command)) {
+    case KEYWORD_COMMAND_WINDOW_FOCUS: {
+        struct selector selector = parse_window_selector(rsp, message, acting_window);
         if (selector.did_parse && selector.window) {
             window_manager_focus_window_with_raise(&selector.window->application->psn, selector.window->id, selector.window->ref);
         }
-    } else if (token_equals(command, COMMAND_WINDOW_SWAP)) {
-        struct selector selector = parse_window_selector(rsp, &message, acting_window);
+    } break;
+    case KEYWORD_COMMAND_WINDOW_SWAP: {
+        struct selector selector = parse_window_selector(rsp, message, acting_window);
         if (selector.did_parse && selector.window) {
             enum window_op_error result = window_manager_swap_window(&g_space_manager, &g_window_manager, acting_window, selector.window);
             if (result == WINDOW_OP_ERROR_INVALID_SRC_VIEW) {
@@ -1613,8 +1405,9 @@ static void handle_domain_window(FILE *rsp, struct token domain, char *message)
                 daemon_fail(rsp, "cannot swap a window with itself.\n");
             }
         }
-    } else if (token_equals(command, COMMAND_WINDOW_WARP)) {
-        struct selector selector = parse_window_selector(rsp, &message, acting_window);
+    } break;
+    case KEYWORD_COMMAND_WINDOW_WARP: {
+        struct selector selector = parse_window_selector(rsp, message, acting_window);
         if (selector.did_parse && selector.window) {
             enum window_op_error result = window_manager_warp_window(&g_space_manager, &g_window_manager, acting_window, selector.window);
             if (result == WINDOW_OP_ERROR_INVALID_SRC_VIEW) {
@@ -1631,8 +1424,9 @@ static void handle_domain_window(FILE *rsp, struct token domain, char *message)
                 daemon_fail(rsp, "cannot warp a window onto itself.\n");
             }
         }
-    } else if (token_equals(command, COMMAND_WINDOW_STACK)) {
-        struct selector selector = parse_window_selector(rsp, &message, acting_window);
+    } break;
+    case KEYWORD_COMMAND_WINDOW_STACK: {
+        struct selector selector = parse_window_selector(rsp, message, acting_window);
         if (selector.did_parse && selector.window) {
             enum window_op_error result = window_manager_stack_window(&g_space_manager, &g_window_manager, acting_window, selector.window);
             if (result == WINDOW_OP_ERROR_INVALID_SRC_NODE) {
@@ -1643,8 +1437,9 @@ static void handle_domain_window(FILE *rsp, struct token domain, char *message)
                 daemon_fail(rsp, "cannot stack a window onto itself.\n");
             }
         }
-    } else if (token_equals(command, COMMAND_WINDOW_INSERT)) {
-        struct selector selector = parse_insert_selector(rsp, &message);
+    } break;
+    case KEYWORD_COMMAND_WINDOW_INSERT: {
+        struct selector selector = parse_insert_selector(rsp, message);
         if (selector.did_parse && selector.dir) {
             enum window_op_error result = window_manager_set_window_insertion(&g_space_manager, &g_window_manager, acting_window, selector.dir);
             if (result == WINDOW_OP_ERROR_INVALID_SRC_VIEW) {
@@ -1653,9 +1448,10 @@ static void handle_domain_window(FILE *rsp, struct token domain, char *message)
                 daemon_fail(rsp, "the acting window is not managed.\n");
             }
         }
-    } else if (token_equals(command, COMMAND_WINDOW_GRID)) {
+    } break;
+    case KEYWORD_COMMAND_WINDOW_GRID: {
         unsigned r, c, x, y, w, h;
-        struct token value = get_token(&message);
+        struct token value = get_token(message);
         if ((sscanf(value.text, ARGUMENT_WINDOW_GRID, &r, &c, &x, &y, &w, &h) == 6)) {
             enum window_op_error result = window_manager_apply_grid(&g_space_manager, &g_window_manager, acting_window, r, c, x, y, w, h);
             if (result == WINDOW_OP_ERROR_INVALID_SRC_VIEW) {
@@ -1664,10 +1460,11 @@ static void handle_domain_window(FILE *rsp, struct token domain, char *message)
         } else {
             daemon_fail(rsp, "unknown value '%.*s' given to command '%.*s' for domain '%.*s'\n", value.length, value.text, command.length, command.text, domain.length, domain.text);
         }
-    } else if (token_equals(command, COMMAND_WINDOW_MOVE)) {
+    } break;
+    case KEYWORD_COMMAND_WINDOW_MOVE: {
         float x, y;
         char type[MAXLEN];
-        struct token value = get_token(&message);
+        struct token value = get_token(message);
         if ((sscanf(value.text, ARGUMENT_WINDOW_MOVE, type, &x, &y) == 3)) {
             enum window_op_error result = window_manager_move_window_relative(&g_window_manager, acting_window, parse_value_type(type), x, y);
             if (result == WINDOW_OP_ERROR_INVALID_SRC_VIEW) {
@@ -1676,10 +1473,11 @@ static void handle_domain_window(FILE *rsp, struct token domain, char *message)
         } else {
             daemon_fail(rsp, "unknown value '%.*s' given to command '%.*s' for domain '%.*s'\n", value.length, value.text, command.length, command.text, domain.length, domain.text);
         }
-    } else if (token_equals(command, COMMAND_WINDOW_RESIZE)) {
+    } break;
+    case KEYWORD_COMMAND_WINDOW_RESIZE: {
         float w, h;
         char handle[MAXLEN];
-        struct token value = get_token(&message);
+        struct token value = get_token(message);
         if ((sscanf(value.text, ARGUMENT_WINDOW_RESIZE, handle, &w, &h) == 3)) {
             enum window_op_error result = window_manager_resize_window_relative(&g_window_manager, acting_window, parse_resize_handle(handle), w, h);
             if (result == WINDOW_OP_ERROR_INVALID_SRC_NODE) {
@@ -1690,10 +1488,11 @@ static void handle_domain_window(FILE *rsp, struct token domain, char *message)
         } else {
             daemon_fail(rsp, "unknown value '%.*s' given to command '%.*s' for domain '%.*s'\n", value.length, value.text, command.length, command.text, domain.length, domain.text);
         }
-    } else if (token_equals(command, COMMAND_WINDOW_RATIO)) {
+    } break;
+    case KEYWORD_COMMAND_WINDOW_RATIO: {
         float r;
         char type[MAXLEN];
-        struct token value = get_token(&message);
+        struct token value = get_token(message);
         if ((sscanf(value.text, ARGUMENT_WINDOW_RATIO, type, &r) == 2)) {
             enum window_op_error result = window_manager_adjust_window_ratio(&g_window_manager, acting_window, parse_value_type(type), r);
             if (result == WINDOW_OP_ERROR_INVALID_SRC_VIEW) {
@@ -1704,7 +1503,8 @@ static void handle_domain_window(FILE *rsp, struct token domain, char *message)
         } else {
             daemon_fail(rsp, "unknown value '%.*s' given to command '%.*s' for domain '%.*s'\n", value.length, value.text, command.length, command.text, domain.length, domain.text);
         }
-    } else if (token_equals(command, COMMAND_WINDOW_MIN)) {
+    } break;
+    case KEYWORD_COMMAND_WINDOW_MIN: {
         enum window_op_error result = window_manager_minimize_window(acting_window);
         if (result == WINDOW_OP_ERROR_CANT_MINIMIZE) {
             daemon_fail(rsp, "window with id '%d' does not support the minimize operation.\n", acting_window->id);
@@ -1713,19 +1513,22 @@ static void handle_domain_window(FILE *rsp, struct token domain, char *message)
         } else if (result == WINDOW_OP_ERROR_MINIMIZE_FAILED) {
             daemon_fail(rsp, "could not minimize window with id '%d'.\n", acting_window->id);
         }
-    } else if (token_equals(command, COMMAND_WINDOW_DEMIN)) {
+    } break;
+    case KEYWORD_COMMAND_WINDOW_DEMIN: {
         enum window_op_error result = window_manager_deminimize_window(acting_window);
         if (result == WINDOW_OP_ERROR_NOT_MINIMIZED) {
             daemon_fail(rsp, "window with id '%d' is not minimized.\n", acting_window->id);
         } else if (result == WINDOW_OP_ERROR_DEMINIMIZE_FAILED) {
             daemon_fail(rsp, "could not deminimize window with id '%d'.\n", acting_window->id);
         }
-    } else if (token_equals(command, COMMAND_WINDOW_CLOSE)) {
+    } break;
+    case KEYWORD_COMMAND_WINDOW_CLOSE: {
         if (!window_manager_close_window(acting_window)) {
             daemon_fail(rsp, "could not close window with id '%d'.\n", acting_window->id);
         }
-    } else if (token_equals(command, COMMAND_WINDOW_LAYER)) {
-        struct token value = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_WINDOW_LAYER: {
+        struct token value = get_token(message);
         if (token_equals(value, ARGUMENT_WINDOW_LAYER_BELOW)) {
             window_manager_set_window_layer(acting_window, LAYER_BELOW);
         } else if (token_equals(value, ARGUMENT_WINDOW_LAYER_NORMAL)) {
@@ -1735,17 +1538,19 @@ static void handle_domain_window(FILE *rsp, struct token domain, char *message)
         } else {
             daemon_fail(rsp, "unknown value '%.*s' given to command '%.*s' for domain '%.*s'\n", value.length, value.text, command.length, command.text, domain.length, domain.text);
         }
-    } else if (token_equals(command, COMMAND_WINDOW_OPACITY)) {
+    } break;
+    case KEYWORD_COMMAND_WINDOW_OPACITY: {
         float opacity;
-        struct token value = get_token(&message);
+        struct token value = get_token(message);
         if ((sscanf(value.text, "%f", &opacity) == 1) && in_range_ii(opacity, 0.0f, 1.0f)) {
             acting_window->opacity = opacity;
             window_manager_set_opacity(&g_window_manager, acting_window, opacity);
         } else {
             daemon_fail(rsp, "unknown value '%.*s' given to command '%.*s' for domain '%.*s'\n", value.length, value.text, command.length, command.text, domain.length, domain.text);
         }
-    } else if (token_equals(command, COMMAND_WINDOW_TOGGLE)) {
-        struct token value = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_WINDOW_TOGGLE: {
+        struct token value = get_token(message);
         if (token_equals(value, ARGUMENT_WINDOW_TOGGLE_FLOAT)) {
             window_manager_make_window_floating(&g_space_manager, &g_window_manager, acting_window, !acting_window->is_floating);
         } else if (token_equals(value, ARGUMENT_WINDOW_TOGGLE_ON_TOP)) {
@@ -1771,8 +1576,9 @@ static void handle_domain_window(FILE *rsp, struct token domain, char *message)
         } else {
             daemon_fail(rsp, "unknown value '%.*s' given to command '%.*s' for domain '%.*s'\n", value.length, value.text, command.length, command.text, domain.length, domain.text);
         }
-    } else if (token_equals(command, COMMAND_WINDOW_DISPLAY)) {
-        struct selector selector = parse_display_selector(rsp, &message, display_manager_active_display_id());
+    } break;
+    case KEYWORD_COMMAND_WINDOW_DISPLAY: {
+        struct selector selector = parse_display_selector(rsp, message, display_manager_active_display_id());
         if (selector.did_parse && selector.did) {
             uint64_t sid = display_space_id(selector.did);
             if (space_is_fullscreen(sid)) {
@@ -1781,8 +1587,9 @@ static void handle_domain_window(FILE *rsp, struct token domain, char *message)
                 window_manager_send_window_to_space(&g_space_manager, &g_window_manager, acting_window, sid, false);
             }
         }
-    } else if (token_equals(command, COMMAND_WINDOW_SPACE)) {
-        struct selector selector = parse_space_selector(rsp, &message, space_manager_active_space());
+    } break;
+    case KEYWORD_COMMAND_WINDOW_SPACE: {
+        struct selector selector = parse_space_selector(rsp, message, space_manager_active_space());
         if (selector.did_parse && selector.sid) {
             if (space_is_fullscreen(selector.sid)) {
                 daemon_fail(rsp, "can not move window to a macOS fullscreen space!\n");
@@ -1790,58 +1597,67 @@ static void handle_domain_window(FILE *rsp, struct token domain, char *message)
                 window_manager_send_window_to_space(&g_space_manager, &g_window_manager, acting_window, selector.sid, false);
             }
         }
-    } else {
+    } break;
+    default: {
         daemon_fail(rsp, "unknown command '%.*s' for domain '%.*s'\n", command.length, command.text, domain.length, domain.text);
+    } break;
     }
 }
 
-static void handle_domain_query(FILE *rsp, struct token domain, char *message)
+static void handle_domain_query(FILE *rsp, struct token domain, struct token_index *message)
 {
-    struct token command = get_token(&message);
-    if (token_equals(command, COMMAND_QUERY_DISPLAYS)) {
-        struct token option = get_token(&message);
+    struct token command = get_token(message);
+    switch (keyword_query_command(command)) {
+    case KEYWORD_COMMAND_QUERY_DISPLAYS: {
+        struct token option = get_token(message);
         if (token_equals(option, ARGUMENT_QUERY_DISPLAY)) {
             uint32_t acting_did = display_manager_active_display_id();
-            struct selector selector = parse_display_selector(NULL, &message, acting_did);
+            struct selector selector = parse_display_selector(NULL, message, acting_did);
             if (selector.did_parse || token_is_valid(selector.token)) {
                 if (selector.did) {
-                    display_serialize(rsp, selector.did);
-                    fprintf(rsp, "\n");
+                    struct json_writer *json = json_writer_begin(&g_json_writer);
+                    display_serialize(json, selector.did);
+                    json_writer_end(json, rsp);
                 } else {
                     daemon_fail(rsp, "could not locate the selected display.\n");
                 }
             } else {
-                display_serialize(rsp, acting_did);
-                fprintf(rsp, "\n");
+                struct json_writer *json = json_writer_begin(&g_json_writer);
+                display_serialize(json, acting_did);
+                json_writer_end(json, rsp);
             }
         } else if (token_equals(option, ARGUMENT_QUERY_SPACE)) {
             uint64_t acting_sid = space_manager_active_space();
-            struct selector selector = parse_space_selector(NULL, &message, acting_sid);
+            struct selector selector = parse_space_selector(NULL, message, acting_sid);
             if (selector.did_parse || token_is_valid(selector.token)) {
                 if (selector.sid) {
-                    display_serialize(rsp, space_display_id(selector.sid));
-                    fprintf(rsp, "\n");
+                    struct json_writer *json = json_writer_begin(&g_json_writer);
+                    display_serialize(json, space_display_id(selector.sid));
+                    json_writer_end(json, rsp);
                 } else {
                     daemon_fail(rsp, "could not locate the selected space.\n");
                 }
             } else {
-                display_serialize(rsp, space_display_id(acting_sid));
-                fprintf(rsp, "\n");
+                struct json_writer *json = json_writer_begin(&g_json_writer);
+                display_serialize(json, space_display_id(acting_sid));
+                json_writer_end(json, rsp);
             }
         } else if (token_equals(option, ARGUMENT_QUERY_WINDOW)) {
             struct window *acting_window = window_manager_focused_window(&g_window_manager);
-            struct selector selector = parse_window_selector(NULL, &message, acting_window);
+            struct selector selector = parse_window_selector(NULL, message, acting_window);
             if (selector.did_parse || token_is_valid(selector.token)) {
                 if (selector.window) {
-                    display_serialize(rsp, window_display_id(selector.window));
-                    fprintf(rsp, "\n");
+                    struct json_writer *json = json_writer_begin(&g_json_writer);
+                    display_serialize(json, window_display_id(selector.window));
+                    json_writer_end(json, rsp);
                 } else {
                     daemon_fail(rsp, "could not locate the selected window.\n");
                 }
             } else {
                 if (acting_window) {
-                    display_serialize(rsp, window_display_id(acting_window));
-                    fprintf(rsp, "\n");
+                    struct json_writer *json = json_writer_begin(&g_json_writer);
+                    display_serialize(json, window_display_id(acting_window));
+                    json_writer_end(json, rsp);
                 } else {
                     daemon_fail(rsp, "could not find window to retrieve display details.\n");
                 }
@@ -1851,11 +1667,12 @@ static void handle_domain_query(FILE *rsp, struct token domain, char *message)
         } else {
             display_manager_query_displays(rsp);
         }
-    } else if (token_equals(command, COMMAND_QUERY_SPACES)) {
-        struct token option = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_QUERY_SPACES: {
+        struct token option = get_token(message);
         if (token_equals(option, ARGUMENT_QUERY_DISPLAY)) {
             uint32_t acting_did = display_manager_active_display_id();
-            struct selector selector = parse_display_selector(NULL, &message, acting_did);
+            struct selector selector = parse_display_selector(NULL, message, acting_did);
             if (selector.did_parse || token_is_valid(selector.token)) {
                 if (selector.did) {
                     if (!space_manager_query_spaces_for_display(rsp, selector.did)) {
@@ -1871,13 +1688,14 @@ static void handle_domain_query(FILE *rsp, struct token domain, char *message)
             }
         } else if (token_equals(option, ARGUMENT_QUERY_SPACE)) {
             uint64_t acting_sid = space_manager_active_space();
-            struct selector selector = parse_space_selector(NULL, &message, acting_sid);
+            struct selector selector = parse_space_selector(NULL, message, acting_sid);
             if (selector.did_parse || token_is_valid(selector.token)) {
                 if (selector.sid) {
                     struct view *view = space_manager_query_view(&g_space_manager, selector.sid);
                     if (view) {
-                        view_serialize(rsp, view);
-                        fprintf(rsp, "\n");
+                        struct json_writer *json = json_writer_begin(&g_json_writer);
+                        view_serialize(json, view);
+                        json_writer_end(json, rsp);
                     } else {
                         daemon_fail(rsp, "could not locate space with id '%lld'.\n", selector.sid);
                     }
@@ -1891,7 +1709,7 @@ static void handle_domain_query(FILE *rsp, struct token domain, char *message)
             }
         } else if (token_equals(option, ARGUMENT_QUERY_WINDOW)) {
             struct window *acting_window = window_manager_focused_window(&g_window_manager);
-            struct selector selector = parse_window_selector(NULL, &message, acting_window);
+            struct selector selector = parse_window_selector(NULL, message, acting_window);
             if (selector.did_parse || token_is_valid(selector.token)) {
                 if (selector.window) {
                     space_manager_query_spaces_for_window(rsp, selector.window);
@@ -1912,11 +1730,17 @@ static void handle_domain_query(FILE *rsp, struct token domain, char *message)
                 daemon_fail(rsp, "could not retrieve spaces for displays.\n");
             }
         }
-    } else if (token_equals(command, COMMAND_QUERY_WINDOWS)) {
-        struct token option = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_QUERY_WINDOWS: {
+        if (take_flag(message, ARGUMENT_QUERY_FRESH)) {
+            window_manager_invalidate_window_attributes(&g_window_manager);
+        }
+
+        struct token option = get_token(message);
+
         if (token_equals(option, ARGUMENT_QUERY_DISPLAY)) {
             uint32_t acting_did = display_manager_active_display_id();
-            struct selector selector = parse_display_selector(NULL, &message, acting_did);
+            struct selector selector = parse_display_selector(NULL, message, acting_did);
             if (selector.did_parse || token_is_valid(selector.token)) {
                 if (selector.did) {
                     window_manager_query_windows_for_display(rsp, selector.did);
@@ -1928,7 +1752,7 @@ static void handle_domain_query(FILE *rsp, struct token domain, char *message)
             }
         } else if (token_equals(option, ARGUMENT_QUERY_SPACE)) {
             uint64_t acting_sid = space_manager_active_space();
-            struct selector selector = parse_space_selector(NULL, &message, acting_sid);
+            struct selector selector = parse_space_selector(NULL, message, acting_sid);
             if (selector.did_parse || token_is_valid(selector.token)) {
                 if (selector.sid) {
                     window_manager_query_windows_for_space(rsp, selector.sid);
@@ -1940,18 +1764,20 @@ static void handle_domain_query(FILE *rsp, struct token domain, char *message)
             }
         } else if (token_equals(option, ARGUMENT_QUERY_WINDOW)) {
             struct window *acting_window = window_manager_focused_window(&g_window_manager);
-            struct selector selector = parse_window_selector(NULL, &message, acting_window);
+            struct selector selector = parse_window_selector(NULL, message, acting_window);
             if (selector.did_parse || token_is_valid(selector.token)) {
                 if (selector.window) {
-                    window_serialize(rsp, selector.window);
-                    fprintf(rsp, "\n");
+                    struct json_writer *json = json_writer_begin(&g_json_writer);
+                    window_serialize(json, selector.window);
+                    json_writer_end(json, rsp);
                 } else {
                     daemon_fail(rsp, "could not locate the selected window.\n");
                 }
             } else {
                 if (acting_window) {
-                    window_serialize(rsp, acting_window);
-                    fprintf(rsp, "\n");
+                    struct json_writer *json = json_writer_begin(&g_json_writer);
+                    window_serialize(json, acting_window);
+                    json_writer_end(json, rsp);
                 } else {
                     daemon_fail(rsp, "could not retrieve window details.\n");
                 }
@@ -1961,21 +1787,24 @@ static void handle_domain_query(FILE *rsp, struct token domain, char *message)
         } else {
             window_manager_query_windows_for_displays(rsp);
         }
-    } else {
+    } break;
+    default: {
         daemon_fail(rsp, "unknown command '%.*s' for domain '%.*s'\n", command.length, command.text, domain.length, domain.text);
+    } break;
     }
 }
 
-static void handle_domain_rule(FILE *rsp, struct token domain, char *message)
+static void handle_domain_rule(FILE *rsp, struct token domain, struct token_index *message)
 {
-    struct token command = get_token(&message);
-    if (token_equals(command, COMMAND_RULE_ADD)) {
+    struct token command = get_token(message);
+    switch (keyword_rule_command(command)) {
+    case KEYWORD_COMMAND_RULE_ADD: {
         char *unsupported_exclusion = NULL;
         bool did_parse = true;
         bool has_filter = false;
         struct rule rule = {};
 
-        struct token token = get_token(&message);
+        struct token token = get_token(message);
         while (token.text && token.length > 0) {
             char *key = NULL;
             char *value = NULL;
@@ -2117,7 +1946,7 @@ static void handle_domain_rule(FILE *rsp, struct token domain, char *message)
             }
 
 rnext:
-            token = get_token(&message);
+            token = get_token(message);
         }
 
         if (!has_filter) {
@@ -2135,8 +1964,9 @@ rnext:
         } else {
             rule_destroy(&rule);
         }
-    } else if (token_equals(command, COMMAND_RULE_REM)) {
-        struct token token = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_RULE_REM: {
+        struct token token = get_token(message);
         if (token_is_valid(token)) {
             int index = -1;
             if (token_to_int(token, &index) && index != -1) {
@@ -2151,17 +1981,21 @@ rnext:
         } else {
             daemon_fail(rsp, "value '%.*s' is not a valid option for RULE_SEL\n", token.length, token.text);
         }
-    } else if (token_equals(command, COMMAND_RULE_LS)) {
+    } break;
+    case KEYWORD_COMMAND_RULE_LS: {
         window_manager_query_window_rules(rsp);
-    } else {
+    } break;
+    default: {
         daemon_fail(rsp, "unknown command '%.*s' for domain '%.*s'\n", command.length, command.text, domain.length, domain.text);
+    } break;
     }
 }
 
-static void handle_domain_signal(FILE *rsp, struct token domain, char *message)
+static void handle_domain_signal(FILE *rsp, struct token domain, struct token_index *message)
 {
-    struct token command = get_token(&message);
-    if (token_equals(command, COMMAND_SIGNAL_ADD)) {
+    struct token command = get_token(message);
+    switch (keyword_signal_command(command)) {
+    case KEYWORD_COMMAND_SIGNAL_ADD: {
         char *unsupported_exclusion = NULL;
         bool did_parse = true;
         bool has_command = false;
@@ -2169,7 +2003,7 @@ static void handle_domain_signal(FILE *rsp, struct token domain, char *message)
         enum event_type signal_type = EVENT_TYPE_UNKNOWN;
         struct signal signal = {};
 
-        struct token token = get_token(&message);
+        struct token token = get_token(message);
         while (token.text && token.length > 0) {
             char *key = NULL;
             char *value = NULL;
@@ -2221,7 +2055,7 @@ static void handle_domain_signal(FILE *rsp, struct token domain, char *message)
             }
 
 snext:
-            token = get_token(&message);
+            token = get_token(message);
         }
 
         if (!has_signal_type) {
@@ -2244,8 +2078,9 @@ snext:
         } else {
             event_signal_destroy(&signal);
         }
-    } else if (token_equals(command, COMMAND_SIGNAL_REM)) {
-        struct token token = get_token(&message);
+    } break;
+    case KEYWORD_COMMAND_SIGNAL_REM: {
+        struct token token = get_token(message);
         if (token_is_valid(token)) {
             int index = -1;
             if (token_to_int(token, &index) && index != -1) {
@@ -2260,36 +2095,262 @@ snext:
         } else {
             daemon_fail(rsp, "value '%.*s' is not a valid option for SIGNAL_SEL\n", token.length, token.text);
         }
-    } else if (token_equals(command, COMMAND_SIGNAL_LS)) {
+    } break;
+    case KEYWORD_COMMAND_SIGNAL_LS: {
         event_signal_list(rsp);
-    } else {
+    } break;
+    default: {
         daemon_fail(rsp, "unknown command '%.*s' for domain '%.*s'\n", command.length, command.text, domain.length, domain.text);
+    } break;
     }
 }
 
-void handle_message(FILE *rsp, char *message)
+//
+// NOTE(koekeishiya): A subscription keeps the connection of the client open, and the events it
+// asked for are streamed to it from then on. This requires a connection that carries a single
+// message, so that the socket is ours to keep, which is why sessions and batches are rejected.
+//
+
+static void handle_domain_subscribe(FILE *rsp, struct token domain, struct token_index *message)
 {
-    struct token domain = get_token(&message);
-    if (token_equals(domain, DOMAIN_CONFIG)) {
+    uint64_t event_mask = 0;
+
+    struct token token = get_token(message);
+    while (token_is_valid(token)) {
+        char *key = NULL;
+        char *value = NULL;
+        bool exclusion = false;
+        get_key_value_pair(token.text, &key, &value, &exclusion);
+
+        if (!key || !value) {
+            daemon_fail(rsp, "invalid key-value pair '%s'\n", token.text);
+            return;
+        }
+
+        if (exclusion) {
+            daemon_fail(rsp, "unsupported token '!' (exclusion) given for key '%s'\n", key);
+            return;
+        }
+
+        if (!string_equals(key, ARGUMENT_SUBSCRIBE_KEY_EVENTS)) {
+            daemon_fail(rsp, "unknown key '%s'\n", key);
+            return;
+        }
+
+        char *cursor = value;
+        for (;;) {
+            char *separator = strchr(cursor, ARGUMENT_SUBSCRIBE_EVENT_SEP);
+            if (separator) *separator = '\0';
+
+            enum event_type type = event_signal_type_from_string(cursor);
+            if (type == EVENT_TYPE_UNKNOWN) {
+                daemon_fail(rsp, "invalid value '%s' for key '%s'\n", cursor, key);
+                return;
+            }
+
+            event_mask |= 1ULL << type;
+
+            if (!separator) break;
+            cursor = separator + 1;
+        }
+
+        token = get_token(message);
+    }
+
+    if (!event_mask) {
+        daemon_fail(rsp, "missing required key-value pair '%s=..'\n", ARGUMENT_SUBSCRIBE_KEY_EVENTS);
+        return;
+    }
+
+    int sockfd = fileno(rsp);
+    if (sockfd == -1) {
+        daemon_fail(rsp, "domain '%.*s' can not be used in a session or batch\n", domain.length, domain.text);
+        return;
+    }
+
+    if (!event_signal_subscribe(sockfd, event_mask)) {
+        daemon_fail(rsp, "could not subscribe, too many subscribers\n");
+    }
+}
+
+struct batch_result
+{
+    char *command;
+    char *response;
+    size_t length;
+};
+
+static void batch_result_serialize(struct json_writer *json, struct batch_result *result)
+{
+    bool success = !(result->length > 0 && result->response[0] == FAILURE_MESSAGE[0]);
+
+    json_begin_object(json);
+    json_key(json, "command");  json_string(json, result->command);
+    json_key(json, "success");  json_int(json, success);
+    json_key(json, "response"); json_string(json, success ? result->response : result->response + 1);
+    json_end_object(json);
+}
+
+//
+// NOTE(koekeishiya): A batch contains multiple commands separated by ARGUMENT_BATCH_SEPARATOR.
+// The commands run in order within the same event, and all view flushes they cause are deferred
+// until the last command has completed, so that the windows are only moved once. Every command
+// runs even if a previous one failed. The response is an array containing the result of every
+// command; the batch is reported as failed if any of them failed.
+//
+// Commands observe the layout they have computed, but not the frames of windows that have yet
+// to be flushed; querying window frames inside a batch reports their position before the batch.
+//
+
+static char *batch_command_string(struct token_index *command)
+{
+    int length = 0;
+    for (int i = 0; i < command->count; ++i) {
+        length += command->tokens[i].length + 1;
+    }
+
+    char *result = malloc(length);
+    if (!result) return NULL;
+
+    char *cursor = result;
+    for (int i = 0; i < command->count; ++i) {
+        if (i > 0) *cursor++ = ' ';
+        memcpy(cursor, command->tokens[i].text, command->tokens[i].length);
+        cursor += command->tokens[i].length;
+    }
+
+    *cursor = '\0';
+    return result;
+}
+
+static void handle_domain_batch(FILE *rsp, struct token domain, struct token_index *message)
+{
+    struct batch_result *results = NULL;
+    bool did_fail = false;
+
+    view_defer_flush_begin();
+
+    while (message->cursor < message->count) {
+        struct token_index command = { .tokens = message->tokens + message->cursor };
+
+        for (struct token token = get_token(message); token_is_valid(token); token = get_token(message)) {
+            if (token_equals(token, ARGUMENT_BATCH_SEPARATOR)) break;
+            ++command.count;
+        }
+
+        if (!command.count) continue;
+
+        struct batch_result result = { .command = batch_command_string(&command) };
+        FILE *command_rsp = result.command ? open_memstream(&result.response, &result.length) : NULL;
+        if (!command_rsp) {
+            if (result.command) free(result.command);
+            did_fail = true;
+            break;
+        }
+
+        if (token_equals(command.tokens[0], DOMAIN_BATCH)) {
+            daemon_fail(command_rsp, "domain '%.*s' can not be nested\n", domain.length, domain.text);
+        } else {
+            handle_message_tokens(command_rsp, &command);
+        }
+
+        fclose(command_rsp);
+        buf_push(results, result);
+    }
+
+    view_defer_flush_end();
+
+    int count = buf_len(results);
+    if (!count && !did_fail) {
+        daemon_fail(rsp, "no commands given to domain '%.*s'\n", domain.length, domain.text);
+        return;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        if (results[i].length > 0 && results[i].response[0] == FAILURE_MESSAGE[0]) did_fail = true;
+    }
+
+    if (did_fail) fprintf(rsp, FAILURE_MESSAGE);
+
+    struct json_writer *json = json_writer_begin(&g_json_writer);
+    json_begin_array(json);
+
+    for (int i = 0; i < count; ++i) {
+        batch_result_serialize(json, &results[i]);
+        free(results[i].command);
+        free(results[i].response);
+    }
+
+    json_end_array(json);
+    json_writer_end(json, rsp);
+    buf_free(results);
+}
+
+static void handle_message_tokens(FILE *rsp, struct token_index *message)
+{
+    struct token domain = get_token(message);
+    switch (keyword_domain(domain)) {
+    case KEYWORD_DOMAIN_CONFIG: {
         handle_domain_config(rsp, domain, message);
-    } else if (token_equals(domain, DOMAIN_DISPLAY)) {
+    } break;
+    case KEYWORD_DOMAIN_DISPLAY: {
         handle_domain_display(rsp, domain, message);
-    } else if (token_equals(domain, DOMAIN_SPACE)) {
+    } break;
+    case KEYWORD_DOMAIN_SPACE: {
         handle_domain_space(rsp, domain, message);
-    } else if (token_equals(domain, DOMAIN_WINDOW)) {
+    } break;
+    case KEYWORD_DOMAIN_WINDOW: {
         handle_domain_window(rsp, domain, message);
-    } else if (token_equals(domain, DOMAIN_QUERY)) {
+    } break;
+    case KEYWORD_DOMAIN_QUERY: {
         handle_domain_query(rsp, domain, message);
-    } else if (token_equals(domain, DOMAIN_RULE)) {
+    } break;
+    case KEYWORD_DOMAIN_RULE: {
         handle_domain_rule(rsp, domain, message);
-    } else if (token_equals(domain, DOMAIN_SIGNAL)) {
+    } break;
+    case KEYWORD_DOMAIN_SIGNAL: {
         handle_domain_signal(rsp, domain, message);
-    } else {
+    } break;
+    case KEYWORD_DOMAIN_BATCH: {
+        handle_domain_batch(rsp, domain, message);
+    } break;
+    case KEYWORD_DOMAIN_SUBSCRIBE: {
+        handle_domain_subscribe(rsp, domain, message);
+    } break;
+    default: {
         daemon_fail(rsp, "unknown domain '%.*s'\n", domain.length, domain.text);
+    } break;
+    }
+}
+
+void handle_message(FILE *rsp, char *message)
+{
+    struct token_index index;
+
+    if (token_index_build(&index, message)) {
+        handle_message_tokens(rsp, &index);
+    } else {
+        daemon_fail(rsp, "failed to allocate memory for message\n");
     }
+
+    token_index_destroy(&index);
 }
 
 static SOCKET_DAEMON_HANDLER(message_handler)
 {
-    event_loop_post(&g_event_loop, DAEMON_MESSAGE, message, sockfd, NULL);
+    if (!is_session) {
+        event_loop_post(&g_event_loop, DAEMON_MESSAGE, message, sockfd, NULL);
+        return;
+    }
+
+    //
+    // NOTE(koekeishiya): Messages that belong to a session must be answered in the order they
+    // were sent, and the event that ends the session (NULL message) closes the socket. Dropping
+    // any of them would break that, so we block the session until the event is queued instead,
+    // which in turn applies back-pressure to the client.
+    //
+
+    while (!event_loop_post(&g_event_loop, DAEMON_SESSION_MESSAGE, message, sockfd, NULL)) {
+        usleep(EVENT_QUEUE_RETRY_DELAY);
+    }
 }
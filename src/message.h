@@ -7,7 +7,19 @@ struct token
     unsigned int length;
 };
 
+#define TOKEN_INDEX_INLINE_CAPACITY 16
+
+struct token_index
+{
+    struct token *tokens;
+    int count;
+    int capacity;
+    int cursor;
+    struct token storage[TOKEN_INDEX_INLINE_CAPACITY];
+};
+
 static SOCKET_DAEMON_HANDLER(message_handler);
+static void handle_message_tokens(FILE *rsp, struct token_index *message);
 void handle_message(FILE *rsp, char *message);
 
 #endif
@@ -0,0 +1,952 @@
+#include "message.h"
+
+#define DOMAIN_CONFIG    "config"
+#define DOMAIN_DISPLAY   "display"
+#define DOMAIN_SPACE     "space"
+#define DOMAIN_WINDOW    "window"
+#define DOMAIN_QUERY     "query"
+#define DOMAIN_RULE      "rule"
+#define DOMAIN_SIGNAL    "signal"
+#define DOMAIN_BATCH     "batch"
+#define DOMAIN_SUBSCRIBE "subscribe"
+
+/* --------------------------------DOMAIN CONFIG-------------------------------- */
+#define COMMAND_CONFIG_DEBUG_OUTPUT          "debug_output"
+#define COMMAND_CONFIG_MFF                   "mouse_follows_focus"
+#define COMMAND_CONFIG_FFM                   "focus_follows_mouse"
+#define COMMAND_CONFIG_WINDOW_PLACEMENT      "window_placement"
+#define COMMAND_CONFIG_TOPMOST               "window_topmost"
+#define COMMAND_CONFIG_OPACITY               "window_opacity"
+#define COMMAND_CONFIG_OPACITY_DURATION      "window_opacity_duration"
+#define COMMAND_CONFIG_BORDER                "window_border"
+#define COMMAND_CONFIG_BORDER_WIDTH          "window_border_width"
+#define COMMAND_CONFIG_BORDER_ACTIVE_COLOR   "active_window_border_color"
+#define COMMAND_CONFIG_BORDER_NORMAL_COLOR   "normal_window_border_color"
+#define COMMAND_CONFIG_SHADOW                "window_shadow"
+#define COMMAND_CONFIG_ACTIVE_WINDOW_OPACITY "active_window_opacity"
+#define COMMAND_CONFIG_NORMAL_WINDOW_OPACITY "normal_window_opacity"
+#define COMMAND_CONFIG_INSERT_FEEDBACK_COLOR "insert_feedback_color"
+#define COMMAND_CONFIG_TOP_PADDING           "top_padding"
+#define COMMAND_CONFIG_BOTTOM_PADDING        "bottom_padding"
+#define COMMAND_CONFIG_LEFT_PADDING          "left_padding"
+#define COMMAND_CONFIG_RIGHT_PADDING         "right_padding"
+#define COMMAND_CONFIG_LAYOUT                "layout"
+#define COMMAND_CONFIG_WINDOW_GAP            "window_gap"
+#define COMMAND_CONFIG_SPLIT_RATIO           "split_ratio"
+#define COMMAND_CONFIG_AUTO_BALANCE          "auto_balance"
+#define COMMAND_CONFIG_MOUSE_MOD             "mouse_modifier"
+#define COMMAND_CONFIG_MOUSE_ACTION1         "mouse_action1"
+#define COMMAND_CONFIG_MOUSE_ACTION2         "mouse_action2"
+#define COMMAND_CONFIG_MOUSE_DROP_ACTION     "mouse_drop_action"
+#define COMMAND_CONFIG_EXTERNAL_BAR          "external_bar"
+
+#define SELECTOR_CONFIG_SPACE                "--space"
+
+#define ARGUMENT_CONFIG_FFM_AUTOFOCUS        "autofocus"
+#define ARGUMENT_CONFIG_FFM_AUTORAISE        "autoraise"
+#define ARGUMENT_CONFIG_WINDOW_PLACEMENT_FST "first_child"
+#define ARGUMENT_CONFIG_WINDOW_PLACEMENT_SND "second_child"
+#define ARGUMENT_CONFIG_SHADOW_FLT           "float"
+#define ARGUMENT_CONFIG_LAYOUT_BSP           "bsp"
+#define ARGUMENT_CONFIG_LAYOUT_STACK         "stack"
+#define ARGUMENT_CONFIG_LAYOUT_FLOAT         "float"
+#define ARGUMENT_CONFIG_MOUSE_MOD_ALT        "alt"
+#define ARGUMENT_CONFIG_MOUSE_MOD_SHIFT      "shift"
+#define ARGUMENT_CONFIG_MOUSE_MOD_CMD        "cmd"
+#define ARGUMENT_CONFIG_MOUSE_MOD_CTRL       "ctrl"
+#define ARGUMENT_CONFIG_MOUSE_MOD_FN         "fn"
+#define ARGUMENT_CONFIG_MOUSE_ACTION_MOVE    "move"
+#define ARGUMENT_CONFIG_MOUSE_ACTION_RESIZE  "resize"
+#define ARGUMENT_CONFIG_MOUSE_ACTION_SWAP    "swap"
+#define ARGUMENT_CONFIG_MOUSE_ACTION_STACK   "stack"
+#define ARGUMENT_CONFIG_EXTERNAL_BAR_MAIN    "main"
+#define ARGUMENT_CONFIG_EXTERNAL_BAR_ALL     "all"
+#define ARGUMENT_CONFIG_EXTERNAL_BAR         "%5[^:]:%d:%d"
+/* ----------------------------------------------------------------------------- */
+
+/* --------------------------------DOMAIN DISPLAY------------------------------- */
+#define COMMAND_DISPLAY_FOCUS "--focus"
+/* ----------------------------------------------------------------------------- */
+
+/* --------------------------------DOMAIN SPACE--------------------------------- */
+#define COMMAND_SPACE_FOCUS   "--focus"
+#define COMMAND_SPACE_CREATE  "--create"
+#define COMMAND_SPACE_DESTROY "--destroy"
+#define COMMAND_SPACE_MOVE    "--move"
+#define COMMAND_SPACE_SWAP    "--swap"
+#define COMMAND_SPACE_DISPLAY "--display"
+#define COMMAND_SPACE_BALANCE "--balance"
+#define COMMAND_SPACE_MIRROR  "--mirror"
+#define COMMAND_SPACE_ROTATE  "--rotate"
+#define COMMAND_SPACE_PADDING "--padding"
+#define COMMAND_SPACE_GAP     "--gap"
+#define COMMAND_SPACE_TOGGLE  "--toggle"
+#define COMMAND_SPACE_LAYOUT  "--layout"
+#define COMMAND_SPACE_LABEL   "--label"
+
+#define ARGUMENT_SPACE_MIRROR_X     "x-axis"
+#define ARGUMENT_SPACE_MIRROR_Y     "y-axis"
+#define ARGUMENT_SPACE_ROTATE_90    "90"
+#define ARGUMENT_SPACE_ROTATE_180   "180"
+#define ARGUMENT_SPACE_ROTATE_270   "270"
+#define ARGUMENT_SPACE_PADDING      "%255[^:]:%d:%d:%d:%d"
+#define ARGUMENT_SPACE_GAP          "%255[^:]:%d"
+#define ARGUMENT_SPACE_TGL_PADDING  "padding"
+#define ARGUMENT_SPACE_TGL_GAP      "gap"
+#define ARGUMENT_SPACE_TGL_MC       "mission-control"
+#define ARGUMENT_SPACE_TGL_SD       "show-desktop"
+#define ARGUMENT_SPACE_LAYOUT_BSP   "bsp"
+#define ARGUMENT_SPACE_LAYOUT_STACK "stack"
+#define ARGUMENT_SPACE_LAYOUT_FLT   "float"
+/* ----------------------------------------------------------------------------- */
+
+/* --------------------------------DOMAIN WINDOW-------------------------------- */
+#define COMMAND_WINDOW_FOCUS   "--focus"
+#define COMMAND_WINDOW_SWAP    "--swap"
+#define COMMAND_WINDOW_WARP    "--warp"
+#define COMMAND_WINDOW_STACK   "--stack"
+#define COMMAND_WINDOW_INSERT  "--insert"
+#define COMMAND_WINDOW_GRID    "--grid"
+#define COMMAND_WINDOW_MOVE    "--move"
+#define COMMAND_WINDOW_RESIZE  "--resize"
+#define COMMAND_WINDOW_RATIO   "--ratio"
+#define COMMAND_WINDOW_MIN     "--minimize"
+#define COMMAND_WINDOW_DEMIN   "--deminimize"
+#define COMMAND_WINDOW_CLOSE   "--close"
+#define COMMAND_WINDOW_LAYER   "--layer"
+#define COMMAND_WINDOW_OPACITY "--opacity"
+#define COMMAND_WINDOW_TOGGLE  "--toggle"
+#define COMMAND_WINDOW_DISPLAY "--display"
+#define COMMAND_WINDOW_SPACE   "--space"
+
+#define ARGUMENT_WINDOW_SEL_LARGEST   "largest"
+#define ARGUMENT_WINDOW_SEL_SMALLEST  "smallest"
+#define ARGUMENT_WINDOW_GRID          "%d:%d:%d:%d:%d:%d"
+#define ARGUMENT_WINDOW_MOVE          "%255[^:]:%f:%f"
+#define ARGUMENT_WINDOW_RESIZE        "%255[^:]:%f:%f"
+#define ARGUMENT_WINDOW_RATIO         "%255[^:]:%f"
+#define ARGUMENT_WINDOW_LAYER_BELOW   "below"
+#define ARGUMENT_WINDOW_LAYER_NORMAL  "normal"
+#define ARGUMENT_WINDOW_LAYER_ABOVE   "above"
+#define ARGUMENT_WINDOW_TOGGLE_ON_TOP "topmost"
+#define ARGUMENT_WINDOW_TOGGLE_FLOAT  "float"
+#define ARGUMENT_WINDOW_TOGGLE_STICKY "sticky"
+#define ARGUMENT_WINDOW_TOGGLE_SHADOW "shadow"
+#define ARGUMENT_WINDOW_TOGGLE_SPLIT  "split"
+#define ARGUMENT_WINDOW_TOGGLE_PARENT "zoom-parent"
+#define ARGUMENT_WINDOW_TOGGLE_FULLSC "zoom-fullscreen"
+#define ARGUMENT_WINDOW_TOGGLE_NATIVE "native-fullscreen"
+#define ARGUMENT_WINDOW_TOGGLE_EXPOSE "expose"
+#define ARGUMENT_WINDOW_TOGGLE_PIP    "pip"
+#define ARGUMENT_WINDOW_TOGGLE_BORDER "border"
+/* ----------------------------------------------------------------------------- */
+
+/* --------------------------------DOMAIN QUERY--------------------------------- */
+#define COMMAND_QUERY_DISPLAYS "--displays"
+#define COMMAND_QUERY_SPACES   "--spaces"
+#define COMMAND_QUERY_WINDOWS  "--windows"
+
+#define ARGUMENT_QUERY_DISPLAY "--display"
+#define ARGUMENT_QUERY_SPACE   "--space"
+#define ARGUMENT_QUERY_WINDOW  "--window"
+#define ARGUMENT_QUERY_FRESH   "--fresh"
+/* ----------------------------------------------------------------------------- */
+
+/* --------------------------------DOMAIN RULE---------------------------------- */
+#define COMMAND_RULE_ADD "--add"
+#define COMMAND_RULE_REM "--remove"
+#define COMMAND_RULE_LS  "--list"
+
+#define ARGUMENT_RULE_KEY_APP     "app"
+#define ARGUMENT_RULE_KEY_TITLE   "title"
+#define ARGUMENT_RULE_KEY_DISPLAY "display"
+#define ARGUMENT_RULE_KEY_SPACE   "space"
+#define ARGUMENT_RULE_KEY_ALPHA   "opacity"
+#define ARGUMENT_RULE_KEY_MANAGE  "manage"
+#define ARGUMENT_RULE_KEY_STICKY  "sticky"
+#define ARGUMENT_RULE_KEY_LAYER   "layer"
+#define ARGUMENT_RULE_KEY_BORDER  "border"
+#define ARGUMENT_RULE_KEY_FULLSCR "native-fullscreen"
+#define ARGUMENT_RULE_KEY_GRID    "grid"
+#define ARGUMENT_RULE_KEY_LABEL   "label"
+
+#define ARGUMENT_RULE_VALUE_SPACE '^'
+#define ARGUMENT_RULE_VALUE_GRID  "%d:%d:%d:%d:%d:%d"
+/* ----------------------------------------------------------------------------- */
+
+/* --------------------------------DOMAIN SIGNAL-------------------------------- */
+#define COMMAND_SIGNAL_ADD "--add"
+#define COMMAND_SIGNAL_REM "--remove"
+#define COMMAND_SIGNAL_LS  "--list"
+
+#define ARGUMENT_SIGNAL_KEY_APP      "app"
+#define ARGUMENT_SIGNAL_KEY_TITLE    "title"
+#define ARGUMENT_SIGNAL_KEY_EVENT    "event"
+#define ARGUMENT_SIGNAL_KEY_ACTION   "action"
+#define ARGUMENT_SIGNAL_KEY_LABEL    "label"
+/* ----------------------------------------------------------------------------- */
+
+/* --------------------------------DOMAIN BATCH--------------------------------- */
+#define ARGUMENT_BATCH_SEPARATOR "--"
+/* ----------------------------------------------------------------------------- */
+
+/* --------------------------------DOMAIN SUBSCRIBE----------------------------- */
+#define ARGUMENT_SUBSCRIBE_KEY_EVENTS    "events"
+#define ARGUMENT_SUBSCRIBE_EVENT_SEP     ','
+/* ----------------------------------------------------------------------------- */
+
+/* --------------------------------COMMON ARGUMENTS----------------------------- */
+#define ARGUMENT_COMMON_VAL_ON           "on"
+#define ARGUMENT_COMMON_VAL_OFF          "off"
+#define ARGUMENT_COMMON_SEL_PREV         "prev"
+#define ARGUMENT_COMMON_SEL_NEXT         "next"
+#define ARGUMENT_COMMON_SEL_FIRST        "first"
+#define ARGUMENT_COMMON_SEL_LAST         "last"
+#define ARGUMENT_COMMON_SEL_RECENT       "recent"
+#define ARGUMENT_COMMON_SEL_NORTH        "north"
+#define ARGUMENT_COMMON_SEL_EAST         "east"
+#define ARGUMENT_COMMON_SEL_SOUTH        "south"
+#define ARGUMENT_COMMON_SEL_WEST         "west"
+#define ARGUMENT_COMMON_SEL_MOUSE        "mouse"
+#define ARGUMENT_COMMON_SEL_STACK        "stack"
+#define ARGUMENT_COMMON_SEL_STACK_PREV   "stack.prev"
+#define ARGUMENT_COMMON_SEL_STACK_NEXT   "stack.next"
+#define ARGUMENT_COMMON_SEL_STACK_FIRST  "stack.first"
+#define ARGUMENT_COMMON_SEL_STACK_LAST   "stack.last"
+#define ARGUMENT_COMMON_SEL_STACK_RECENT "stack.recent"
+/* ----------------------------------------------------------------------------- */
+
+static inline bool token_equals(struct token token, char *match)
+{
+    size_t length = strlen(match);
+    return token.length == length && memcmp(token.text, match, length) == 0;
+}
+
+//
+// NOTE(koekeishiya): Domains, commands and selectors are dispatched through the keyword tables
+// below. Each table switches on the length of the token, and then on a single byte that tells the
+// keywords of that length apart, so that a lookup costs two jumps and a comparison against the
+// one or two candidates that are left, regardless of how many keywords the table holds. The
+// handlers then switch on the returned keyword. The byte used for each length is picked from the
+// keywords in the table, so a table must be updated when a keyword is added or changed.
+//
+
+enum keyword
+{
+    KEYWORD_UNKNOWN,
+    KEYWORD_COMMAND_CONFIG_DEBUG_OUTPUT,
+    KEYWORD_COMMAND_CONFIG_MFF,
+    KEYWORD_COMMAND_CONFIG_FFM,
+    KEYWORD_COMMAND_CONFIG_WINDOW_PLACEMENT,
+    KEYWORD_COMMAND_CONFIG_TOPMOST,
+    KEYWORD_COMMAND_CONFIG_OPACITY,
+    KEYWORD_COMMAND_CONFIG_OPACITY_DURATION,
+    KEYWORD_COMMAND_CONFIG_BORDER,
+    KEYWORD_COMMAND_CONFIG_BORDER_WIDTH,
+    KEYWORD_COMMAND_CONFIG_BORDER_ACTIVE_COLOR,
+    KEYWORD_COMMAND_CONFIG_BORDER_NORMAL_COLOR,
+    KEYWORD_COMMAND_CONFIG_SHADOW,
+    KEYWORD_COMMAND_CONFIG_ACTIVE_WINDOW_OPACITY,
+    KEYWORD_COMMAND_CONFIG_NORMAL_WINDOW_OPACITY,
+    KEYWORD_COMMAND_CONFIG_INSERT_FEEDBACK_COLOR,
+    KEYWORD_COMMAND_CONFIG_TOP_PADDING,
+    KEYWORD_COMMAND_CONFIG_BOTTOM_PADDING,
+    KEYWORD_COMMAND_CONFIG_LEFT_PADDING,
+    KEYWORD_COMMAND_CONFIG_RIGHT_PADDING,
+    KEYWORD_COMMAND_CONFIG_WINDOW_GAP,
+    KEYWORD_COMMAND_CONFIG_LAYOUT,
+    KEYWORD_COMMAND_CONFIG_SPLIT_RATIO,
+    KEYWORD_COMMAND_CONFIG_AUTO_BALANCE,
+    KEYWORD_COMMAND_CONFIG_MOUSE_MOD,
+    KEYWORD_COMMAND_CONFIG_MOUSE_ACTION1,
+    KEYWORD_COMMAND_CONFIG_MOUSE_ACTION2,
+    KEYWORD_COMMAND_CONFIG_MOUSE_DROP_ACTION,
+    KEYWORD_COMMAND_CONFIG_EXTERNAL_BAR,
+    KEYWORD_COMMON_SEL_NORTH,
+    KEYWORD_COMMON_SEL_EAST,
+    KEYWORD_COMMON_SEL_SOUTH,
+    KEYWORD_COMMON_SEL_WEST,
+    KEYWORD_COMMON_SEL_PREV,
+    KEYWORD_COMMON_SEL_NEXT,
+    KEYWORD_COMMON_SEL_FIRST,
+    KEYWORD_COMMON_SEL_LAST,
+    KEYWORD_COMMON_SEL_RECENT,
+    KEYWORD_COMMON_SEL_MOUSE,
+    KEYWORD_WINDOW_SEL_LARGEST,
+    KEYWORD_WINDOW_SEL_SMALLEST,
+    KEYWORD_COMMON_SEL_STACK_PREV,
+    KEYWORD_COMMON_SEL_STACK_NEXT,
+    KEYWORD_COMMON_SEL_STACK_FIRST,
+    KEYWORD_COMMON_SEL_STACK_LAST,
+    KEYWORD_COMMON_SEL_STACK_RECENT,
+    KEYWORD_COMMON_SEL_STACK,
+    KEYWORD_COMMAND_DISPLAY_FOCUS,
+    KEYWORD_COMMAND_SPACE_FOCUS,
+    KEYWORD_COMMAND_SPACE_MOVE,
+    KEYWORD_COMMAND_SPACE_SWAP,
+    KEYWORD_COMMAND_SPACE_DISPLAY,
+    KEYWORD_COMMAND_SPACE_CREATE,
+    KEYWORD_COMMAND_SPACE_DESTROY,
+    KEYWORD_COMMAND_SPACE_BALANCE,
+    KEYWORD_COMMAND_SPACE_MIRROR,
+    KEYWORD_COMMAND_SPACE_ROTATE,
+    KEYWORD_COMMAND_SPACE_PADDING,
+    KEYWORD_COMMAND_SPACE_GAP,
+    KEYWORD_COMMAND_SPACE_TOGGLE,
+    KEYWORD_COMMAND_SPACE_LAYOUT,
+    KEYWORD_COMMAND_SPACE_LABEL,
+    KEYWORD_COMMAND_WINDOW_FOCUS,
+    KEYWORD_COMMAND_WINDOW_SWAP,
+    KEYWORD_COMMAND_WINDOW_WARP,
+    KEYWORD_COMMAND_WINDOW_STACK,
+    KEYWORD_COMMAND_WINDOW_INSERT,
+    KEYWORD_COMMAND_WINDOW_GRID,
+    KEYWORD_COMMAND_WINDOW_MOVE,
+    KEYWORD_COMMAND_WINDOW_RESIZE,
+    KEYWORD_COMMAND_WINDOW_RATIO,
+    KEYWORD_COMMAND_WINDOW_MIN,
+    KEYWORD_COMMAND_WINDOW_DEMIN,
+    KEYWORD_COMMAND_WINDOW_CLOSE,
+    KEYWORD_COMMAND_WINDOW_LAYER,
+    KEYWORD_COMMAND_WINDOW_OPACITY,
+    KEYWORD_COMMAND_WINDOW_TOGGLE,
+    KEYWORD_COMMAND_WINDOW_DISPLAY,
+    KEYWORD_COMMAND_WINDOW_SPACE,
+    KEYWORD_COMMAND_QUERY_DISPLAYS,
+    KEYWORD_COMMAND_QUERY_SPACES,
+    KEYWORD_COMMAND_QUERY_WINDOWS,
+    KEYWORD_COMMAND_RULE_ADD,
+    KEYWORD_COMMAND_RULE_REM,
+    KEYWORD_COMMAND_RULE_LS,
+    KEYWORD_COMMAND_SIGNAL_ADD,
+    KEYWORD_COMMAND_SIGNAL_REM,
+    KEYWORD_COMMAND_SIGNAL_LS,
+    KEYWORD_DOMAIN_CONFIG,
+    KEYWORD_DOMAIN_DISPLAY,
+    KEYWORD_DOMAIN_SPACE,
+    KEYWORD_DOMAIN_WINDOW,
+    KEYWORD_DOMAIN_QUERY,
+    KEYWORD_DOMAIN_RULE,
+    KEYWORD_DOMAIN_SIGNAL,
+    KEYWORD_DOMAIN_BATCH,
+    KEYWORD_DOMAIN_SUBSCRIBE
+};
+
+static enum keyword keyword_config_command(struct token token)
+{
+    switch (token.length) {
+    case 6: {
+        if (token_equals(token, COMMAND_CONFIG_LAYOUT)) return KEYWORD_COMMAND_CONFIG_LAYOUT;
+    } break;
+    case 10: {
+        if (token_equals(token, COMMAND_CONFIG_WINDOW_GAP)) return KEYWORD_COMMAND_CONFIG_WINDOW_GAP;
+    } break;
+    case 11: {
+        switch (token.text[0]) {
+        case 's': if (token_equals(token, COMMAND_CONFIG_SPLIT_RATIO)) return KEYWORD_COMMAND_CONFIG_SPLIT_RATIO; break;
+        case 't': if (token_equals(token, COMMAND_CONFIG_TOP_PADDING)) return KEYWORD_COMMAND_CONFIG_TOP_PADDING; break;
+        }
+    } break;
+    case 12: {
+        switch (token.text[0]) {
+        case 'a': if (token_equals(token, COMMAND_CONFIG_AUTO_BALANCE)) return KEYWORD_COMMAND_CONFIG_AUTO_BALANCE; break;
+        case 'd': if (token_equals(token, COMMAND_CONFIG_DEBUG_OUTPUT)) return KEYWORD_COMMAND_CONFIG_DEBUG_OUTPUT; break;
+        case 'e': if (token_equals(token, COMMAND_CONFIG_EXTERNAL_BAR)) return KEYWORD_COMMAND_CONFIG_EXTERNAL_BAR; break;
+        case 'l': if (token_equals(token, COMMAND_CONFIG_LEFT_PADDING)) return KEYWORD_COMMAND_CONFIG_LEFT_PADDING; break;
+        }
+    } break;
+    case 13: {
+        switch (token.text[12]) {
+        case '1': if (token_equals(token, COMMAND_CONFIG_MOUSE_ACTION1)) return KEYWORD_COMMAND_CONFIG_MOUSE_ACTION1; break;
+        case '2': if (token_equals(token, COMMAND_CONFIG_MOUSE_ACTION2)) return KEYWORD_COMMAND_CONFIG_MOUSE_ACTION2; break;
+        case 'g': if (token_equals(token, COMMAND_CONFIG_RIGHT_PADDING)) return KEYWORD_COMMAND_CONFIG_RIGHT_PADDING; break;
+        case 'r': if (token_equals(token, COMMAND_CONFIG_BORDER)) return KEYWORD_COMMAND_CONFIG_BORDER; break;
+        case 'w': if (token_equals(token, COMMAND_CONFIG_SHADOW)) return KEYWORD_COMMAND_CONFIG_SHADOW; break;
+        }
+    } break;
+    case 14: {
+        switch (token.text[8]) {
+        case 'a': if (token_equals(token, COMMAND_CONFIG_BOTTOM_PADDING)) return KEYWORD_COMMAND_CONFIG_BOTTOM_PADDING; break;
+        case 'd': if (token_equals(token, COMMAND_CONFIG_MOUSE_MOD)) return KEYWORD_COMMAND_CONFIG_MOUSE_MOD; break;
+        case 'o': if (token_equals(token, COMMAND_CONFIG_TOPMOST)) return KEYWORD_COMMAND_CONFIG_TOPMOST; break;
+        case 'p': if (token_equals(token, COMMAND_CONFIG_OPACITY)) return KEYWORD_COMMAND_CONFIG_OPACITY; break;
+        }
+    } break;
+    case 16: {
+        if (token_equals(token, COMMAND_CONFIG_WINDOW_PLACEMENT)) return KEYWORD_COMMAND_CONFIG_WINDOW_PLACEMENT;
+    } break;
+    case 17: {
+        if (token_equals(token, COMMAND_CONFIG_MOUSE_DROP_ACTION)) return KEYWORD_COMMAND_CONFIG_MOUSE_DROP_ACTION;
+    } break;
+    case 19: {
+        switch (token.text[0]) {
+        case 'f': if (token_equals(token, COMMAND_CONFIG_FFM)) return KEYWORD_COMMAND_CONFIG_FFM; break;
+        case 'm': if (token_equals(token, COMMAND_CONFIG_MFF)) return KEYWORD_COMMAND_CONFIG_MFF; break;
+        case 'w': if (token_equals(token, COMMAND_CONFIG_BORDER_WIDTH)) return KEYWORD_COMMAND_CONFIG_BORDER_WIDTH; break;
+        }
+    } break;
+    case 21: {
+        switch (token.text[0]) {
+        case 'a': if (token_equals(token, COMMAND_CONFIG_ACTIVE_WINDOW_OPACITY)) return KEYWORD_COMMAND_CONFIG_ACTIVE_WINDOW_OPACITY; break;
+        case 'i': if (token_equals(token, COMMAND_CONFIG_INSERT_FEEDBACK_COLOR)) return KEYWORD_COMMAND_CONFIG_INSERT_FEEDBACK_COLOR; break;
+        case 'n': if (token_equals(token, COMMAND_CONFIG_NORMAL_WINDOW_OPACITY)) return KEYWORD_COMMAND_CONFIG_NORMAL_WINDOW_OPACITY; break;
+        }
+    } break;
+    case 23: {
+        if (token_equals(token, COMMAND_CONFIG_OPACITY_DURATION)) return KEYWORD_COMMAND_CONFIG_OPACITY_DURATION;
+    } break;
+    case 26: {
+        switch (token.text[0]) {
+        case 'a': if (token_equals(token, COMMAND_CONFIG_BORDER_ACTIVE_COLOR)) return KEYWORD_COMMAND_CONFIG_BORDER_ACTIVE_COLOR; break;
+        case 'n': if (token_equals(token, COMMAND_CONFIG_BORDER_NORMAL_COLOR)) return KEYWORD_COMMAND_CONFIG_BORDER_NORMAL_COLOR; break;
+        }
+    } break;
+    }
+
+    return KEYWORD_UNKNOWN;
+}
+
+static enum keyword keyword_display_selector(struct token token)
+{
+    switch (token.length) {
+    case 4: {
+        switch (token.text[0]) {
+        case 'e': if (token_equals(token, ARGUMENT_COMMON_SEL_EAST)) return KEYWORD_COMMON_SEL_EAST; break;
+        case 'l': if (token_equals(token, ARGUMENT_COMMON_SEL_LAST)) return KEYWORD_COMMON_SEL_LAST; break;
+        case 'n': if (token_equals(token, ARGUMENT_COMMON_SEL_NEXT)) return KEYWORD_COMMON_SEL_NEXT; break;
+        case 'p': if (token_equals(token, ARGUMENT_COMMON_SEL_PREV)) return KEYWORD_COMMON_SEL_PREV; break;
+        case 'w': if (token_equals(token, ARGUMENT_COMMON_SEL_WEST)) return KEYWORD_COMMON_SEL_WEST; break;
+        }
+    } break;
+    case 5: {
+        switch (token.text[0]) {
+        case 'f': if (token_equals(token, ARGUMENT_COMMON_SEL_FIRST)) return KEYWORD_COMMON_SEL_FIRST; break;
+        case 'm': if (token_equals(token, ARGUMENT_COMMON_SEL_MOUSE)) return KEYWORD_COMMON_SEL_MOUSE; break;
+        case 'n': if (token_equals(token, ARGUMENT_COMMON_SEL_NORTH)) return KEYWORD_COMMON_SEL_NORTH; break;
+        case 's': if (token_equals(token, ARGUMENT_COMMON_SEL_SOUTH)) return KEYWORD_COMMON_SEL_SOUTH; break;
+        }
+    } break;
+    case 6: {
+        if (token_equals(token, ARGUMENT_COMMON_SEL_RECENT)) return KEYWORD_COMMON_SEL_RECENT;
+    } break;
+    }
+
+    return KEYWORD_UNKNOWN;
+}
+
+static enum keyword keyword_space_selector(struct token token)
+{
+    switch (token.length) {
+    case 4: {
+        switch (token.text[0]) {
+        case 'l': if (token_equals(token, ARGUMENT_COMMON_SEL_LAST)) return KEYWORD_COMMON_SEL_LAST; break;
+        case 'n': if (token_equals(token, ARGUMENT_COMMON_SEL_NEXT)) return KEYWORD_COMMON_SEL_NEXT; break;
+        case 'p': if (token_equals(token, ARGUMENT_COMMON_SEL_PREV)) return KEYWORD_COMMON_SEL_PREV; break;
+        }
+    } break;
+    case 5: {
+        switch (token.text[0]) {
+        case 'f': if (token_equals(token, ARGUMENT_COMMON_SEL_FIRST)) return KEYWORD_COMMON_SEL_FIRST; break;
+        case 'm': if (token_equals(token, ARGUMENT_COMMON_SEL_MOUSE)) return KEYWORD_COMMON_SEL_MOUSE; break;
+        }
+    } break;
+    case 6: {
+        if (token_equals(token, ARGUMENT_COMMON_SEL_RECENT)) return KEYWORD_COMMON_SEL_RECENT;
+    } break;
+    }
+
+    return KEYWORD_UNKNOWN;
+}
+
+static enum keyword keyword_window_selector(struct token token)
+{
+    switch (token.length) {
+    case 4: {
+        switch (token.text[0]) {
+        case 'e': if (token_equals(token, ARGUMENT_COMMON_SEL_EAST)) return KEYWORD_COMMON_SEL_EAST; break;
+        case 'l': if (token_equals(token, ARGUMENT_COMMON_SEL_LAST)) return KEYWORD_COMMON_SEL_LAST; break;
+        case 'n': if (token_equals(token, ARGUMENT_COMMON_SEL_NEXT)) return KEYWORD_COMMON_SEL_NEXT; break;
+        case 'p': if (token_equals(token, ARGUMENT_COMMON_SEL_PREV)) return KEYWORD_COMMON_SEL_PREV; break;
+        case 'w': if (token_equals(token, ARGUMENT_COMMON_SEL_WEST)) return KEYWORD_COMMON_SEL_WEST; break;
+        }
+    } break;
+    case 5: {
+        switch (token.text[0]) {
+        case 'f': if (token_equals(token, ARGUMENT_COMMON_SEL_FIRST)) return KEYWORD_COMMON_SEL_FIRST; break;
+        case 'm': if (token_equals(token, ARGUMENT_COMMON_SEL_MOUSE)) return KEYWORD_COMMON_SEL_MOUSE; break;
+        case 'n': if (token_equals(token, ARGUMENT_COMMON_SEL_NORTH)) return KEYWORD_COMMON_SEL_NORTH; break;
+        case 's': if (token_equals(token, ARGUMENT_COMMON_SEL_SOUTH)) return KEYWORD_COMMON_SEL_SOUTH; break;
+        }
+    } break;
+    case 6: {
+        if (token_equals(token, ARGUMENT_COMMON_SEL_RECENT)) return KEYWORD_COMMON_SEL_RECENT;
+    } break;
+    case 7: {
+        if (token_equals(token, ARGUMENT_WINDOW_SEL_LARGEST)) return KEYWORD_WINDOW_SEL_LARGEST;
+    } break;
+    case 8: {
+        if (token_equals(token, ARGUMENT_WINDOW_SEL_SMALLEST)) return KEYWORD_WINDOW_SEL_SMALLEST;
+    } break;
+    case 10: {
+        switch (token.text[6]) {
+        case 'l': if (token_equals(token, ARGUMENT_COMMON_SEL_STACK_LAST)) return KEYWORD_COMMON_SEL_STACK_LAST; break;
+        case 'n': if (token_equals(token, ARGUMENT_COMMON_SEL_STACK_NEXT)) return KEYWORD_COMMON_SEL_STACK_NEXT; break;
+        case 'p': if (token_equals(token, ARGUMENT_COMMON_SEL_STACK_PREV)) return KEYWORD_COMMON_SEL_STACK_PREV; break;
+        }
+    } break;
+    case 11: {
+        if (token_equals(token, ARGUMENT_COMMON_SEL_STACK_FIRST)) return KEYWORD_COMMON_SEL_STACK_FIRST;
+    } break;
+    case 12: {
+        if (token_equals(token, ARGUMENT_COMMON_SEL_STACK_RECENT)) return KEYWORD_COMMON_SEL_STACK_RECENT;
+    } break;
+    }
+
+    return KEYWORD_UNKNOWN;
+}
+
+static enum keyword keyword_insert_selector(struct token token)
+{
+    switch (token.length) {
+    case 4: {
+        switch (token.text[0]) {
+        case 'e': if (token_equals(token, ARGUMENT_COMMON_SEL_EAST)) return KEYWORD_COMMON_SEL_EAST; break;
+        case 'w': if (token_equals(token, ARGUMENT_COMMON_SEL_WEST)) return KEYWORD_COMMON_SEL_WEST; break;
+        }
+    } break;
+    case 5: {
+        switch (token.text[2]) {
+        case 'a': if (token_equals(token, ARGUMENT_COMMON_SEL_STACK)) return KEYWORD_COMMON_SEL_STACK; break;
+        case 'r': if (token_equals(token, ARGUMENT_COMMON_SEL_NORTH)) return KEYWORD_COMMON_SEL_NORTH; break;
+        case 'u': if (token_equals(token, ARGUMENT_COMMON_SEL_SOUTH)) return KEYWORD_COMMON_SEL_SOUTH; break;
+        }
+    } break;
+    }
+
+    return KEYWORD_UNKNOWN;
+}
+
+static enum keyword keyword_display_command(struct token token)
+{
+    switch (token.length) {
+    case 7: {
+        if (token_equals(token, COMMAND_DISPLAY_FOCUS)) return KEYWORD_COMMAND_DISPLAY_FOCUS;
+    } break;
+    }
+
+    return KEYWORD_UNKNOWN;
+}
+
+static enum keyword keyword_space_command(struct token token)
+{
+    switch (token.length) {
+    case 5: {
+        if (token_equals(token, COMMAND_SPACE_GAP)) return KEYWORD_COMMAND_SPACE_GAP;
+    } break;
+    case 6: {
+        switch (token.text[2]) {
+        case 'm': if (token_equals(token, COMMAND_SPACE_MOVE)) return KEYWORD_COMMAND_SPACE_MOVE; break;
+        case 's': if (token_equals(token, COMMAND_SPACE_SWAP)) return KEYWORD_COMMAND_SPACE_SWAP; break;
+        }
+    } break;
+    case 7: {
+        switch (token.text[2]) {
+        case 'f': if (token_equals(token, COMMAND_SPACE_FOCUS)) return KEYWORD_COMMAND_SPACE_FOCUS; break;
+        case 'l': if (token_equals(token, COMMAND_SPACE_LABEL)) return KEYWORD_COMMAND_SPACE_LABEL; break;
+        }
+    } break;
+    case 8: {
+        switch (token.text[2]) {
+        case 'c': if (token_equals(token, COMMAND_SPACE_CREATE)) return KEYWORD_COMMAND_SPACE_CREATE; break;
+        case 'l': if (token_equals(token, COMMAND_SPACE_LAYOUT)) return KEYWORD_COMMAND_SPACE_LAYOUT; break;
+        case 'm': if (token_equals(token, COMMAND_SPACE_MIRROR)) return KEYWORD_COMMAND_SPACE_MIRROR; break;
+        case 'r': if (token_equals(token, COMMAND_SPACE_ROTATE)) return KEYWORD_COMMAND_SPACE_ROTATE; break;
+        case 't': if (token_equals(token, COMMAND_SPACE_TOGGLE)) return KEYWORD_COMMAND_SPACE_TOGGLE; break;
+        }
+    } break;
+    case 9: {
+        switch (token.text[5]) {
+        case 'a': if (token_equals(token, COMMAND_SPACE_BALANCE)) return KEYWORD_COMMAND_SPACE_BALANCE; break;
+        case 'd': if (token_equals(token, COMMAND_SPACE_PADDING)) return KEYWORD_COMMAND_SPACE_PADDING; break;
+        case 'p': if (token_equals(token, COMMAND_SPACE_DISPLAY)) return KEYWORD_COMMAND_SPACE_DISPLAY; break;
+        case 't': if (token_equals(token, COMMAND_SPACE_DESTROY)) return KEYWORD_COMMAND_SPACE_DESTROY; break;
+        }
+    } break;
+    }
+
+    return KEYWORD_UNKNOWN;
+}
+
+static enum keyword keyword_window_command(struct token token)
+{
+    switch (token.length) {
+    case 6: {
+        switch (token.text[2]) {
+        case 'g': if (token_equals(token, COMMAND_WINDOW_GRID)) return KEYWORD_COMMAND_WINDOW_GRID; break;
+        case 'm': if (token_equals(token, COMMAND_WINDOW_MOVE)) return KEYWORD_COMMAND_WINDOW_MOVE; break;
+        case 's': if (token_equals(token, COMMAND_WINDOW_SWAP)) return KEYWORD_COMMAND_WINDOW_SWAP; break;
+        case 'w': if (token_equals(token, COMMAND_WINDOW_WARP)) return KEYWORD_COMMAND_WINDOW_WARP; break;
+        }
+    } break;
+    case 7: {
+        switch (token.text[2]) {
+        case 'c': if (token_equals(token, COMMAND_WINDOW_CLOSE)) return KEYWORD_COMMAND_WINDOW_CLOSE; break;
+        case 'f': if (token_equals(token, COMMAND_WINDOW_FOCUS)) return KEYWORD_COMMAND_WINDOW_FOCUS; break;
+        case 'l': if (token_equals(token, COMMAND_WINDOW_LAYER)) return KEYWORD_COMMAND_WINDOW_LAYER; break;
+        case 'r': if (token_equals(token, COMMAND_WINDOW_RATIO)) return KEYWORD_COMMAND_WINDOW_RATIO; break;
+        case 's': {
+            if (token_equals(token, COMMAND_WINDOW_STACK)) return KEYWORD_COMMAND_WINDOW_STACK;
+            if (token_equals(token, COMMAND_WINDOW_SPACE)) return KEYWORD_COMMAND_WINDOW_SPACE;
+        } break;
+        }
+    } break;
+    case 8: {
+        switch (token.text[2]) {
+        case 'i': if (token_equals(token, COMMAND_WINDOW_INSERT)) return KEYWORD_COMMAND_WINDOW_INSERT; break;
+        case 'r': if (token_equals(token, COMMAND_WINDOW_RESIZE)) return KEYWORD_COMMAND_WINDOW_RESIZE; break;
+        case 't': if (token_equals(token, COMMAND_WINDOW_TOGGLE)) return KEYWORD_COMMAND_WINDOW_TOGGLE; break;
+        }
+    } break;
+    case 9: {
+        switch (token.text[2]) {
+        case 'd': if (token_equals(token, COMMAND_WINDOW_DISPLAY)) return KEYWORD_COMMAND_WINDOW_DISPLAY; break;
+        case 'o': if (token_equals(token, COMMAND_WINDOW_OPACITY)) return KEYWORD_COMMAND_WINDOW_OPACITY; break;
+        }
+    } break;
+    case 10: {
+        if (token_equals(token, COMMAND_WINDOW_MIN)) return KEYWORD_COMMAND_WINDOW_MIN;
+    } break;
+    case 12: {
+        if (token_equals(token, COMMAND_WINDOW_DEMIN)) return KEYWORD_COMMAND_WINDOW_DEMIN;
+    } break;
+    }
+
+    return KEYWORD_UNKNOWN;
+}
+
+static enum keyword keyword_query_command(struct token token)
+{
+    switch (token.length) {
+    case 8: {
+        if (token_equals(token, COMMAND_QUERY_SPACES)) return KEYWORD_COMMAND_QUERY_SPACES;
+    } break;
+    case 9: {
+        if (token_equals(token, COMMAND_QUERY_WINDOWS)) return KEYWORD_COMMAND_QUERY_WINDOWS;
+    } break;
+    case 10: {
+        if (token_equals(token, COMMAND_QUERY_DISPLAYS)) return KEYWORD_COMMAND_QUERY_DISPLAYS;
+    } break;
+    }
+
+    return KEYWORD_UNKNOWN;
+}
+
+static enum keyword keyword_rule_command(struct token token)
+{
+    switch (token.length) {
+    case 5: {
+        if (token_equals(token, COMMAND_RULE_ADD)) return KEYWORD_COMMAND_RULE_ADD;
+    } break;
+    case 6: {
+        if (token_equals(token, COMMAND_RULE_LS)) return KEYWORD_COMMAND_RULE_LS;
+    } break;
+    case 8: {
+        if (token_equals(token, COMMAND_RULE_REM)) return KEYWORD_COMMAND_RULE_REM;
+    } break;
+    }
+
+    return KEYWORD_UNKNOWN;
+}
+
+static enum keyword keyword_signal_command(struct token token)
+{
+    switch (token.length) {
+    case 5: {
+        if (token_equals(token, COMMAND_SIGNAL_ADD)) return KEYWORD_COMMAND_SIGNAL_ADD;
+    } break;
+    case 6: {
+        if (token_equals(token, COMMAND_SIGNAL_LS)) return KEYWORD_COMMAND_SIGNAL_LS;
+    } break;
+    case 8: {
+        if (token_equals(token, COMMAND_SIGNAL_REM)) return KEYWORD_COMMAND_SIGNAL_REM;
+    } break;
+    }
+
+    return KEYWORD_UNKNOWN;
+}
+
+static enum keyword keyword_domain(struct token token)
+{
+    switch (token.length) {
+    case 4: {
+        if (token_equals(token, DOMAIN_RULE)) return KEYWORD_DOMAIN_RULE;
+    } break;
+    case 5: {
+        switch (token.text[0]) {
+        case 'b': if (token_equals(token, DOMAIN_BATCH)) return KEYWORD_DOMAIN_BATCH; break;
+        case 'q': if (token_equals(token, DOMAIN_QUERY)) return KEYWORD_DOMAIN_QUERY; break;
+        case 's': if (token_equals(token, DOMAIN_SPACE)) return KEYWORD_DOMAIN_SPACE; break;
+        }
+    } break;
+    case 6: {
+        switch (token.text[0]) {
+        case 'c': if (token_equals(token, DOMAIN_CONFIG)) return KEYWORD_DOMAIN_CONFIG; break;
+        case 's': if (token_equals(token, DOMAIN_SIGNAL)) return KEYWORD_DOMAIN_SIGNAL; break;
+        case 'w': if (token_equals(token, DOMAIN_WINDOW)) return KEYWORD_DOMAIN_WINDOW; break;
+        }
+    } break;
+    case 7: {
+        if (token_equals(token, DOMAIN_DISPLAY)) return KEYWORD_DOMAIN_DISPLAY;
+    } break;
+    case 9: {
+        if (token_equals(token, DOMAIN_SUBSCRIBE)) return KEYWORD_DOMAIN_SUBSCRIBE;
+    } break;
+    }
+
+    return KEYWORD_UNKNOWN;
+}
+
+static bool token_is_valid(struct token token)
+{
+    return token.text && token.length > 0;
+}
+
+static char *token_to_string(struct token token)
+{
+    char *result = malloc(token.length + 1);
+    if (!result) return NULL;
+
+    memcpy(result, token.text, token.length);
+    result[token.length] = '\0';
+    return result;
+}
+
+//
+// NOTE(koekeishiya): Numbers are parsed directly from the token, without copying it into a
+// temporary buffer. The accepted input matches what sscanf would read for the corresponding
+// conversion, except that floats are decimal only; parsing stops at the first character that
+// does not fit.
+//
+
+static inline bool char_is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static inline int char_hex_value(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static uint32_t token_to_uint32t(struct token token)
+{
+    uint32_t result = 0;
+    bool negative = false;
+    unsigned int i = 0;
+
+    if (i < token.length && (token.text[i] == '-' || token.text[i] == '+')) {
+        negative = token.text[i++] == '-';
+    }
+
+    if (i + 2 < token.length && token.text[i] == '0' && (token.text[i+1] == 'x' || token.text[i+1] == 'X') && char_hex_value(token.text[i+2]) != -1) {
+        i += 2;
+    }
+
+    for (int digit; i < token.length && (digit = char_hex_value(token.text[i])) != -1; ++i) {
+        result = (result << 4) | digit;
+    }
+
+    return negative ? -result : result;
+}
+
+static bool token_to_int(struct token token, int *value)
+{
+    int64_t result = 0;
+    bool negative = false;
+    unsigned int i = 0;
+
+    if (i < token.length && (token.text[i] == '-' || token.text[i] == '+')) {
+        negative = token.text[i++] == '-';
+    }
+
+    if (i == token.length || !char_is_digit(token.text[i])) {
+        *value = 0;
+        return false;
+    }
+
+    for (; i < token.length && char_is_digit(token.text[i]); ++i) {
+        if (result <= INT_MAX) result = result * 10 + (token.text[i] - '0');
+    }
+
+    if (negative) result = -result;
+    *value = result < INT_MIN ? INT_MIN : result > INT_MAX ? INT_MAX : (int) result;
+    return true;
+}
+
+static float token_to_float(struct token token)
+{
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    bool negative = false;
+    bool has_digits = false;
+    unsigned int i = 0;
+
+    if (i < token.length && (token.text[i] == '-' || token.text[i] == '+')) {
+        negative = token.text[i++] == '-';
+    }
+
+    for (; i < token.length && char_is_digit(token.text[i]); ++i) {
+        if (mantissa < UINT64_MAX / 10) {
+            mantissa = mantissa * 10 + (token.text[i] - '0');
+        } else {
+            ++exponent;
+        }
+        has_digits = true;
+    }
+
+    if (i < token.length && token.text[i] == '.') {
+        for (++i; i < token.length && char_is_digit(token.text[i]); ++i) {
+            if (mantissa < UINT64_MAX / 10) {
+                mantissa = mantissa * 10 + (token.text[i] - '0');
+                --exponent;
+            }
+            has_digits = true;
+        }
+    }
+
+    if (!has_digits) return 0.0f;
+    if (!mantissa)   return negative ? -0.0f : 0.0f;
+
+    if (i + 1 < token.length && (token.text[i] == 'e' || token.text[i] == 'E')) {
+        unsigned int j = i + 1;
+        bool negative_exponent = false;
+
+        if (token.text[j] == '-' || token.text[j] == '+') {
+            negative_exponent = token.text[j++] == '-';
+        }
+
+        if (j < token.length && char_is_digit(token.text[j])) {
+            int value = 0;
+            for (; j < token.length && char_is_digit(token.text[j]); ++j) {
+                if (value < 1000) value = value * 10 + (token.text[j] - '0');
+            }
+            exponent += negative_exponent ? -value : value;
+        }
+    }
+
+    double result = (double) mantissa;
+    if (exponent < 0) {
+        result /= pow(10.0, -exponent);
+    } else if (exponent > 0) {
+        result *= pow(10.0, exponent);
+    }
+
+    return (float)(negative ? -result : result);
+}
+
+//
+// NOTE(koekeishiya): A message is a list of null-terminated arguments, ending with an empty
+// argument. The boundaries of every argument are indexed once, when the message is received;
+// the handlers then consume the arguments in order. Once the index is exhausted, get_token
+// keeps returning an empty token. Messages with few arguments are indexed without allocating.
+//
+
+static bool token_index_build(struct token_index *index, char *message)
+{
+    index->tokens = index->storage;
+    index->capacity = array_count(index->storage);
+    index->count = 0;
+    index->cursor = 0;
+
+    while (*message) {
+        char *text = message;
+        message += strlen(message);
+
+        if (index->count == index->capacity) {
+            int capacity = index->capacity * 2;
+            struct token *tokens = malloc(sizeof(struct token) * capacity);
+            if (!tokens) return false;
+
+            memcpy(tokens, index->tokens, sizeof(struct token) * index->count);
+            if (index->tokens != index->storage) free(index->tokens);
+
+            index->tokens = tokens;
+            index->capacity = capacity;
+        }
+
+        index->tokens[index->count++] = (struct token) { text, message - text };
+        ++message;
+    }
+
+    return true;
+}
+
+static void token_index_destroy(struct token_index *index)
+{
+    if (index->tokens != index->storage) free(index->tokens);
+}
+
+static struct token get_token(struct token_index *message)
+{
+    if (message->cursor >= message->count) {
+        return (struct token) { "", 0 };
+    }
+
+    return message->tokens[message->cursor++];
+}
+
+//
+// NOTE(koekeishiya): Flags that may appear anywhere among the remaining arguments are taken out
+// of the index before the handler consumes the rest in order. Returns whether the flag was given;
+// every occurrence is removed.
+//
+
+static bool take_flag(struct token_index *message, char *flag)
+{
+    int count = message->cursor;
+
+    for (int i = message->cursor; i < message->count; ++i) {
+        if (!token_equals(message->tokens[i], flag)) {
+            message->tokens[count++] = message->tokens[i];
+        }
+    }
+
+    bool result = count != message->count;
+    message->count = count;
+    return result;
+}
+
+static void get_key_value_pair(char *token, char **key, char **value, bool *exclusion)
+{
+    *key = token;
+
+    while (*token) {
+        char fst = token[0];
+        char snd = token[1];
+
+        if (fst == '!' && snd == '=') {
+            break;
+        } else if (fst == '=') {
+            break;
+        }
+
+        ++token;
+    }
+
+    int index = (token[0] == '!' && token[1] == '=') ? 2 : 1;
+    char check = (index == 2) ? '!' : '=';
+
+    if (*token != check) {
+        *key = NULL;
+        *value = NULL;
+    } else if (token[index]) {
+        *token = '\0';
+        *value = token+index;
+        *exclusion = index == 2;
+    } else {
+        *value = NULL;
+    }
+}
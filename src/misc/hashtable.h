@@ -7,12 +7,24 @@ typedef TABLE_HASH_FUNC(table_hash_func);
 #define TABLE_COMPARE_FUNC(name) int name(void *key_a, void *key_b)
 typedef TABLE_COMPARE_FUNC(table_compare_func);
 
+//
+// NOTE(koekeishiya): Open-addressing table using Robin Hood hashing. Keys are at most
+// 8 bytes (window ids, pids, space ids and process serial numbers) and are stored inline
+// in the bucket, so neither insertion nor growth performs a per-entry allocation.
+// Deletion shifts the following run of buckets back by one slot instead of leaving
+// tombstones behind. A bucket is empty when its distance is 0 (and its value is NULL).
+//
+
+#define TABLE_KEY_SIZE sizeof(uint64_t)
+
 struct bucket
 {
-    void *key;
+    uint64_t key;
     void *value;
-    struct bucket *next;
+    uint32_t hash;
+    uint32_t distance;
 };
+
 struct table
 {
     int count;
@@ -20,7 +32,7 @@ struct table
     float max_load;
     table_hash_func *hash;
     table_compare_func *cmp;
-    struct bucket **buckets;
+    struct bucket *buckets;
 };
 
 void table_init(struct table *table, int capacity, table_hash_func hash, table_compare_func cmp);
@@ -31,74 +43,302 @@ void _table_add(struct table *table, void *key, int key_size, void *value);
 void table_remove(struct table *table, void *key);
 void *table_find(struct table *table, void *key);
 
+static inline uint32_t table_mix_hash(uint64_t hash)
+{
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return (uint32_t) hash;
+}
+
+static inline int table_capacity_for(int capacity)
+{
+    int size = 8;
+    while (size < capacity) size <<= 1;
+    return size;
+}
+
+//
+// NOTE(koekeishiya): TABLE_DEFINE instantiates a table for one concrete key type, so that
+// hashing and key comparison are inlined into the probe loop instead of being called through
+// the function pointers of the generic table. Every instantiation exposes count, capacity and
+// buckets[i].value, which is all that iteration sites are allowed to rely on.
+//
+// Building with -DHASHTABLE_GENERIC (make EXTRA_FLAGS=-DHASHTABLE_GENERIC) makes the same
+// names forward to the generic table instead, which is useful when comparing the two.
+//
+
+#ifdef HASHTABLE_GENERIC
+#define TABLE_DEFINE(name, key_type, hash_func, compare_func) \
+typedef struct table name##_table; \
+static TABLE_HASH_FUNC(name##_table_hash) { return hash_func(*(key_type *) key); } \
+static TABLE_COMPARE_FUNC(name##_table_compare) { return compare_func(*(key_type *) key_a, *(key_type *) key_b); } \
+static inline void name##_table_init(name##_table *table, int capacity) { table_init(table, capacity, name##_table_hash, name##_table_compare); } \
+static inline void name##_table_free(name##_table *table) { table_free(table); } \
+static inline void name##_table_add(name##_table *table, key_type key, void *value) { table_add(table, &key, value); } \
+static inline void name##_table_remove(name##_table *table, key_type key) { table_remove(table, &key); } \
+static inline void *name##_table_find(name##_table *table, key_type key) { return table_find(table, &key); }
+#else
+#define TABLE_DEFINE(name, key_type, hash_func, compare_func) \
+struct name##_bucket \
+{ \
+    key_type key; \
+    void *value; \
+    uint32_t hash; \
+    uint32_t distance; \
+}; \
+\
+typedef struct name##_table \
+{ \
+    int count; \
+    int capacity; \
+    float max_load; \
+    struct name##_bucket *buckets; \
+} name##_table; \
+\
+static inline void name##_table_init(name##_table *table, int capacity) \
+{ \
+    table->count = 0; \
+    table->capacity = table_capacity_for(capacity); \
+    table->max_load = 0.75f; \
+    table->buckets = calloc(table->capacity, sizeof(struct name##_bucket)); \
+} \
+\
+static inline void name##_table_free(name##_table *table) \
+{ \
+    if (table->buckets) { \
+        free(table->buckets); \
+        table->buckets = NULL; \
+    } \
+\
+    table->count = 0; \
+    table->capacity = 0; \
+} \
+\
+static inline void name##_table_insert(name##_table *table, struct name##_bucket entry) \
+{ \
+    uint32_t mask = table->capacity - 1; \
+    uint32_t index = entry.hash & mask; \
+\
+    for (entry.distance = 1;; ++entry.distance) { \
+        struct name##_bucket *bucket = &table->buckets[index]; \
+\
+        if (!bucket->distance) { \
+            *bucket = entry; \
+            return; \
+        } \
+\
+        if (bucket->distance < entry.distance) { \
+            struct name##_bucket swap = *bucket; \
+            *bucket = entry; \
+            entry = swap; \
+        } \
+\
+        index = (index + 1) & mask; \
+    } \
+} \
+\
+static inline struct name##_bucket *name##_table_get_bucket(name##_table *table, key_type key, uint32_t hash) \
+{ \
+    uint32_t mask = table->capacity - 1; \
+    uint32_t index = hash & mask; \
+\
+    for (uint32_t distance = 1;; ++distance) { \
+        struct name##_bucket *bucket = &table->buckets[index]; \
+        if (bucket->distance < distance) return NULL; \
+\
+        if (bucket->hash == hash && compare_func(bucket->key, key)) { \
+            return bucket; \
+        } \
+\
+        index = (index + 1) & mask; \
+    } \
+} \
+\
+static inline void name##_table_rehash(name##_table *table) \
+{ \
+    struct name##_bucket *old_buckets = table->buckets; \
+    int old_capacity = table->capacity; \
+\
+    table->capacity = 2 * table->capacity; \
+    table->buckets = calloc(table->capacity, sizeof(struct name##_bucket)); \
+\
+    for (int i = 0; i < old_capacity; ++i) { \
+        if (old_buckets[i].distance) { \
+            name##_table_insert(table, old_buckets[i]); \
+        } \
+    } \
+\
+    free(old_buckets); \
+} \
+\
+static inline void name##_table_add(name##_table *table, key_type key, void *value) \
+{ \
+    uint32_t hash = table_mix_hash(hash_func(key)); \
+    struct name##_bucket *bucket = name##_table_get_bucket(table, key, hash); \
+    if (bucket) { \
+        if (!bucket->value) { \
+            bucket->value = value; \
+        } \
+    } else { \
+        float load = (1.0f * (table->count + 1)) / table->capacity; \
+        if (load > table->max_load) { \
+            name##_table_rehash(table); \
+        } \
+\
+        struct name##_bucket entry = { .key = key, .value = value, .hash = hash }; \
+        name##_table_insert(table, entry); \
+        ++table->count; \
+    } \
+} \
+\
+static inline void name##_table_remove(name##_table *table, key_type key) \
+{ \
+    struct name##_bucket *bucket = name##_table_get_bucket(table, key, table_mix_hash(hash_func(key))); \
+    if (!bucket) return; \
+\
+    uint32_t mask = table->capacity - 1; \
+    uint32_t index = bucket - table->buckets; \
+\
+    for (;;) { \
+        uint32_t next_index = (index + 1) & mask; \
+        struct name##_bucket *next = &table->buckets[next_index]; \
+\
+        if (next->distance <= 1) { \
+            memset(&table->buckets[index], 0, sizeof(struct name##_bucket)); \
+            break; \
+        } \
+\
+        table->buckets[index] = *next; \
+        --table->buckets[index].distance; \
+        index = next_index; \
+    } \
+\
+    --table->count; \
+} \
+\
+static inline void *name##_table_find(name##_table *table, key_type key) \
+{ \
+    struct name##_bucket *bucket = name##_table_get_bucket(table, key, table_mix_hash(hash_func(key))); \
+    return bucket ? bucket->value : NULL; \
+}
+#endif
+
+static inline uint64_t table_hash_u32(uint32_t key) { return key; }
+static inline uint64_t table_hash_u64(uint64_t key) { return key; }
+static inline uint64_t table_hash_psn(ProcessSerialNumber key) { return ((uint64_t) key.highLongOfPSN << 32) | key.lowLongOfPSN; }
+
+static inline uint64_t table_hash_string(const char *str, int length)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    for (int i = 0; i < length; ++i) {
+        hash ^= (unsigned char) str[i];
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+static inline bool table_compare_u32(uint32_t a, uint32_t b) { return a == b; }
+static inline bool table_compare_u64(uint64_t a, uint64_t b) { return a == b; }
+static inline bool table_compare_psn(ProcessSerialNumber a, ProcessSerialNumber b) { return a.lowLongOfPSN == b.lowLongOfPSN && a.highLongOfPSN == b.highLongOfPSN; }
+
+TABLE_DEFINE(wid, uint32_t, table_hash_u32, table_compare_u32)
+TABLE_DEFINE(pid, pid_t, table_hash_u32, table_compare_u32)
+TABLE_DEFINE(sid, uint64_t, table_hash_u64, table_compare_u64)
+TABLE_DEFINE(psn, ProcessSerialNumber, table_hash_psn, table_compare_psn)
+
+//
+// NOTE(koekeishiya): Strings do not fit in a bucket, so literal tables are keyed by the 64-bit
+// hash of the string (table_hash_string). A hit is only a candidate; the caller compares the
+// actual strings, and chains entries whose hashes collide.
+//
+
+TABLE_DEFINE(literal, uint64_t, table_hash_u64, table_compare_u64)
+
 #endif
 
 #ifdef HASHTABLE_IMPLEMENTATION
+static inline uint32_t table_hash(struct table *table, void *key)
+{
+    return table_mix_hash(table->hash(key));
+}
+
+static void table_insert(struct table *table, struct bucket entry)
+{
+    uint32_t mask = table->capacity - 1;
+    uint32_t index = entry.hash & mask;
+
+    for (entry.distance = 1;; ++entry.distance) {
+        struct bucket *bucket = &table->buckets[index];
+
+        if (!bucket->distance) {
+            *bucket = entry;
+            return;
+        }
+
+        if (bucket->distance < entry.distance) {
+            struct bucket swap = *bucket;
+            *bucket = entry;
+            entry = swap;
+        }
+
+        index = (index + 1) & mask;
+    }
+}
+
 void table_init(struct table *table, int capacity, table_hash_func hash, table_compare_func cmp)
 {
     table->count = 0;
-    table->capacity = capacity;
+    table->capacity = table_capacity_for(capacity);
     table->max_load = 0.75f;
     table->hash = hash;
     table->cmp = cmp;
-    table->buckets = malloc(sizeof(struct bucket *) * capacity);
-    memset(table->buckets, 0, sizeof(struct bucket *) * capacity);
+    table->buckets = calloc(table->capacity, sizeof(struct bucket));
 }
 
 void table_free(struct table *table)
 {
-    for (int i = 0; i < table->capacity; ++i) {
-        struct bucket *next, *bucket = table->buckets[i];
-        while (bucket) {
-            next = bucket->next;
-            free(bucket->key);
-            free(bucket);
-            bucket = next;
-        }
-    }
-
     if (table->buckets) {
         free(table->buckets);
         table->buckets = NULL;
     }
+
+    table->count = 0;
+    table->capacity = 0;
 }
 
-static struct bucket **
-table_get_bucket(struct table *table, void *key)
+static struct bucket *
+table_get_bucket(struct table *table, void *key, uint32_t hash)
 {
-    struct bucket **bucket = table->buckets + (table->hash(key) % table->capacity);
-    while (*bucket) {
-        if (table->cmp((*bucket)->key, key)) {
-            break;
+    uint32_t mask = table->capacity - 1;
+    uint32_t index = hash & mask;
+
+    for (uint32_t distance = 1;; ++distance) {
+        struct bucket *bucket = &table->buckets[index];
+        if (bucket->distance < distance) return NULL;
+
+        if (bucket->hash == hash && table->cmp(&bucket->key, key)) {
+            return bucket;
         }
-        bucket = &(*bucket)->next;
+
+        index = (index + 1) & mask;
     }
-    return bucket;
 }
 
 static void
 table_rehash(struct table *table)
 {
-    struct bucket **old_buckets = table->buckets;
+    struct bucket *old_buckets = table->buckets;
     int old_capacity = table->capacity;
 
-    table->count = 0;
     table->capacity = 2 * table->capacity;
-    table->buckets = malloc(sizeof(struct bucket *) * table->capacity);
-    memset(table->buckets, 0, sizeof(struct bucket *) * table->capacity);
+    table->buckets = calloc(table->capacity, sizeof(struct bucket));
 
     for (int i = 0; i < old_capacity; ++i) {
-        struct bucket *next_bucket, *old_bucket = old_buckets[i];
-        while (old_bucket) {
-            struct bucket **new_bucket = table_get_bucket(table, old_bucket->key);
-            *new_bucket = malloc(sizeof(struct bucket));
-            (*new_bucket)->key = old_bucket->key;
-            (*new_bucket)->value = old_bucket->value;
-            (*new_bucket)->next = NULL;
-            ++table->count;
-            next_bucket = old_bucket->next;
-            free(old_bucket);
-            old_bucket = next_bucket;
+        if (old_buckets[i].distance) {
+            table_insert(table, old_buckets[i]);
         }
     }
 
@@ -107,41 +347,55 @@ table_rehash(struct table *table)
 
 void _table_add(struct table *table, void *key, int key_size, void *value)
 {
-    struct bucket **bucket = table_get_bucket(table, key);
-    if (*bucket) {
-        if (!(*bucket)->value) {
-            (*bucket)->value = value;
+    assert(key_size <= TABLE_KEY_SIZE);
+
+    uint32_t hash = table_hash(table, key);
+    struct bucket *bucket = table_get_bucket(table, key, hash);
+    if (bucket) {
+        if (!bucket->value) {
+            bucket->value = value;
         }
     } else {
-        *bucket = malloc(sizeof(struct bucket));
-        (*bucket)->key = malloc(key_size);
-        (*bucket)->value = value;
-        memcpy((*bucket)->key, key, key_size);
-        (*bucket)->next = NULL;
-        ++table->count;
-
-        float load = (1.0f * table->count) / table->capacity;
+        float load = (1.0f * (table->count + 1)) / table->capacity;
         if (load > table->max_load) {
             table_rehash(table);
         }
+
+        struct bucket entry = { .value = value, .hash = hash };
+        memcpy(&entry.key, key, key_size);
+        table_insert(table, entry);
+        ++table->count;
     }
 }
 
 void table_remove(struct table *table, void *key)
 {
-    struct bucket *next, **bucket = table_get_bucket(table, key);
-    if (*bucket) {
-        free((*bucket)->key);
-        next = (*bucket)->next;
-        free(*bucket);
-        *bucket = next;
-        --table->count;
+    struct bucket *bucket = table_get_bucket(table, key, table_hash(table, key));
+    if (!bucket) return;
+
+    uint32_t mask = table->capacity - 1;
+    uint32_t index = bucket - table->buckets;
+
+    for (;;) {
+        uint32_t next_index = (index + 1) & mask;
+        struct bucket *next = &table->buckets[next_index];
+
+        if (next->distance <= 1) {
+            memset(&table->buckets[index], 0, sizeof(struct bucket));
+            break;
+        }
+
+        table->buckets[index] = *next;
+        --table->buckets[index].distance;
+        index = next_index;
     }
+
+    --table->count;
 }
 
 void *table_find(struct table *table, void *key)
 {
-    struct bucket *bucket = *table_get_bucket(table, key);
+    struct bucket *bucket = table_get_bucket(table, key, table_hash(table, key));
     return bucket ? bucket->value : NULL;
 }
 #endif
@@ -51,63 +51,6 @@ static inline bool string_equals(const char *a, const char *b)
     return a && b && strcmp(a, b) == 0;
 }
 
-static inline char *string_escape(char *s)
-{
-    if (!s) return NULL;
-
-    char *cursor = s;
-    int num_replacements = 0;
-
-    while (*cursor) {
-        if ((*cursor == '"') ||
-            (*cursor == '\\') ||
-            (*cursor == '\b') ||
-            (*cursor == '\f') ||
-            (*cursor == '\n') ||
-            (*cursor == '\r') ||
-            (*cursor == '\t')) {
-            ++num_replacements;
-        }
-
-        ++cursor;
-    }
-
-    if (!num_replacements) return NULL;
-
-    int size_in_bytes = (int)(cursor - s) + num_replacements;
-    char *result = malloc(sizeof(char) * (size_in_bytes+1));
-    result[size_in_bytes] = '\0';
-
-    for (char *dst = result, *cursor = s; *cursor; ++cursor) {
-        if (*cursor == '"') {
-            *dst++ = '\\';
-            *dst++ = *cursor;
-        } else if (*cursor == '\\') {
-            *dst++ = '\\';
-            *dst++ = '\\';
-        } else if (*cursor == '\b') {
-            *dst++ = '\\';
-            *dst++ = 'b';
-        } else if (*cursor == '\f') {
-            *dst++ = '\\';
-            *dst++ = 'f';
-        } else if (*cursor == '\n') {
-            *dst++ = '\\';
-            *dst++ = 'n';
-        } else if (*cursor == '\r') {
-            *dst++ = '\\';
-            *dst++ = 'r';
-        } else if (*cursor == '\t') {
-            *dst++ = '\\';
-            *dst++ = 't';
-        } else {
-            *dst++ = *cursor;
-        }
-    }
-
-    return result;
-}
-
 static CFArrayRef cfarray_of_cfnumbers(void *values, size_t size, int count, CFNumberType type)
 {
     CFNumberRef temp[count];
@@ -257,6 +200,48 @@ static int regex_match(bool valid, regex_t *regex, const char *match)
     return result == 0 ? REGEX_MATCH_YES : REGEX_MATCH_NO;
 }
 
+//
+// NOTE(koekeishiya): Patterns that consist of nothing but literal characters are common in rules
+// and signals (e.g. app="^Safari$"), and do not need to go through regexec. If the pattern does not
+// use any regex operator, apart from a leading ^ and a trailing $, a copy of the literal is stored
+// in *literal and the returned kind tells how it must be compared.
+//
+
+#define REGEX_LITERAL_NONE      0
+#define REGEX_LITERAL_SUBSTRING 1
+#define REGEX_LITERAL_PREFIX    2
+#define REGEX_LITERAL_EXACT     3
+
+static int regex_literal(const char *pattern, char **literal)
+{
+    int length = strlen(pattern);
+    bool has_prefix = length >= 1 && pattern[0] == '^';
+    bool has_suffix = has_prefix && length >= 2 && pattern[length-1] == '$';
+    int begin = has_prefix ? 1 : 0;
+    int end = has_suffix ? length-1 : length;
+
+    for (int i = begin; i < end; ++i) {
+        if (strchr(".[]()*+?{}|^$\\", pattern[i])) return REGEX_LITERAL_NONE;
+    }
+
+    *literal = strndup(pattern + begin, end - begin);
+    return has_suffix ? REGEX_LITERAL_EXACT : has_prefix ? REGEX_LITERAL_PREFIX : REGEX_LITERAL_SUBSTRING;
+}
+
+static int regex_literal_match(int kind, const char *literal, const char *match)
+{
+    if (!match) return REGEX_MATCH_UD;
+
+    bool result = false;
+    switch (kind) {
+    case REGEX_LITERAL_SUBSTRING: result = strstr(match, literal) != NULL;                    break;
+    case REGEX_LITERAL_PREFIX:    result = strncmp(match, literal, strlen(literal)) == 0;    break;
+    case REGEX_LITERAL_EXACT:     result = strcmp(match, literal) == 0;                      break;
+    }
+
+    return result ? REGEX_MATCH_YES : REGEX_MATCH_NO;
+}
+
 static inline float clampf_range(float value, float min, float max)
 {
     if (value < min) return min;
@@ -0,0 +1,250 @@
+#ifndef JSON_H
+#define JSON_H
+
+#define JSON_WRITER_INITIAL_CAPACITY 4096
+#define JSON_WRITER_MAX_DEPTH 8
+
+//
+// NOTE(koekeishiya): Streaming writer for query responses. The output is built in a single
+// growable buffer that is kept alive between queries, so that serializing a large list of
+// windows does not go through a vfprintf call per field and an allocation per escaped string.
+// The layout matches the format we have always produced: object members go on their own line
+// indented by the number of enclosing objects, and arrays are written inline. A compact writer
+// puts everything on a single line instead, for streams of newline-delimited records.
+//
+
+struct json_writer
+{
+    char *data;
+    size_t length;
+    size_t capacity;
+    int depth;
+    int indent;
+    bool is_compact;
+    bool is_array[JSON_WRITER_MAX_DEPTH];
+    int count[JSON_WRITER_MAX_DEPTH];
+};
+
+static inline void json_reserve(struct json_writer *json, size_t size)
+{
+    if (json->length + size <= json->capacity) return;
+
+    size_t capacity = json->capacity ? json->capacity : JSON_WRITER_INITIAL_CAPACITY;
+    while (capacity < json->length + size) capacity *= 2;
+
+    json->data = realloc(json->data, capacity);
+    json->capacity = capacity;
+}
+
+static inline void json_write(struct json_writer *json, const char *data, size_t size)
+{
+    json_reserve(json, size);
+    memcpy(json->data + json->length, data, size);
+    json->length += size;
+}
+
+static inline void json_write_char(struct json_writer *json, char c)
+{
+    json_reserve(json, 1);
+    json->data[json->length++] = c;
+}
+
+static inline struct json_writer *json_writer_begin(struct json_writer *json)
+{
+    json->length = 0;
+    json->depth = 0;
+    json->indent = 0;
+    json->is_compact = false;
+    json->is_array[0] = false;
+    json->count[0] = 0;
+    return json;
+}
+
+static inline struct json_writer *json_writer_begin_compact(struct json_writer *json)
+{
+    json_writer_begin(json)->is_compact = true;
+    return json;
+}
+
+static inline void json_writer_end(struct json_writer *json, FILE *rsp)
+{
+    assert(json->depth == 0);
+    json_write_char(json, '\n');
+    fwrite(json->data, 1, json->length, rsp);
+    json->length = 0;
+}
+
+static inline void json_newline(struct json_writer *json)
+{
+    if (json->is_compact) return;
+
+    json_reserve(json, json->indent + 1);
+    json->data[json->length++] = '\n';
+    for (int i = 0; i < json->indent; ++i) {
+        json->data[json->length++] = '\t';
+    }
+}
+
+static inline void json_element(struct json_writer *json, bool is_container)
+{
+    if (!json->is_array[json->depth]) return;
+
+    if (json->count[json->depth]++ > 0) {
+        if (is_container) {
+            json_write_char(json, ',');
+        } else {
+            json_write(json, ", ", 2);
+        }
+    }
+}
+
+static inline void json_push(struct json_writer *json, bool is_array)
+{
+    assert(json->depth + 1 < JSON_WRITER_MAX_DEPTH);
+    ++json->depth;
+    json->is_array[json->depth] = is_array;
+    json->count[json->depth] = 0;
+}
+
+static inline void json_begin_object(struct json_writer *json)
+{
+    json_element(json, true);
+    json_write_char(json, '{');
+    json_push(json, false);
+    ++json->indent;
+}
+
+static inline void json_end_object(struct json_writer *json)
+{
+    --json->indent;
+    if (json->count[json->depth] > 0) json_newline(json);
+    json_write_char(json, '}');
+    --json->depth;
+}
+
+static inline void json_begin_array(struct json_writer *json)
+{
+    json_element(json, true);
+    json_write_char(json, '[');
+    json_push(json, true);
+}
+
+static inline void json_end_array(struct json_writer *json)
+{
+    json_write_char(json, ']');
+    --json->depth;
+}
+
+static inline void json_key(struct json_writer *json, const char *key)
+{
+    if (json->count[json->depth]++ > 0) json_write_char(json, ',');
+    json_newline(json);
+    json_write_char(json, '"');
+    json_write(json, key, strlen(key));
+    json_write(json, "\":", 2);
+}
+
+static inline void json_write_uint(struct json_writer *json, uint64_t value)
+{
+    char buffer[20];
+    char *cursor = buffer + sizeof(buffer);
+
+    do {
+        *--cursor = '0' + (value % 10);
+        value /= 10;
+    } while (value);
+
+    json_write(json, cursor, buffer + sizeof(buffer) - cursor);
+}
+
+static inline void json_int(struct json_writer *json, int64_t value)
+{
+    json_element(json, false);
+
+    if (value < 0) {
+        json_write_char(json, '-');
+        json_write_uint(json, -(uint64_t)value);
+    } else {
+        json_write_uint(json, value);
+    }
+}
+
+//
+// NOTE(koekeishiya): Equivalent of printf("%.4f"), rounded to the nearest ten-thousandth.
+// JSON has no representation for nan or inf, so those are written as zero.
+//
+
+static inline void json_float(struct json_writer *json, double value)
+{
+    json_element(json, false);
+
+    if (!isfinite(value) || fabs(value) >= 1e9) {
+        value = isfinite(value) ? value : 0.0;
+        int length = snprintf(NULL, 0, "%.4f", value);
+        json_reserve(json, length + 1);
+        snprintf(json->data + json->length, length + 1, "%.4f", value);
+        json->length += length;
+        return;
+    }
+
+    //
+    // NOTE(koekeishiya): The product may round up onto a half-way point that the exact value
+    // is below, in which case the residual from the fused multiply-add tells us to round down.
+    // Exact ties are rounded to even, like printf does.
+    //
+
+    double product = fabs(value) * 10000.0;
+    double residual = fma(fabs(value), 10000.0, -product);
+    double rounded = floor(product + 0.5);
+    if (rounded - product == 0.5 && (residual < 0 || (residual == 0 && fmod(rounded, 2.0) != 0))) rounded -= 1.0;
+
+    if (signbit(value)) json_write_char(json, '-');
+    uint64_t scaled = (uint64_t) rounded;
+    uint64_t fraction = scaled % 10000;
+
+    json_write_uint(json, scaled / 10000);
+    json_reserve(json, 5);
+    json->data[json->length++] = '.';
+    json->data[json->length++] = '0' + (fraction / 1000);
+    json->data[json->length++] = '0' + (fraction / 100) % 10;
+    json->data[json->length++] = '0' + (fraction / 10) % 10;
+    json->data[json->length++] = '0' + (fraction % 10);
+}
+
+static inline void json_string(struct json_writer *json, const char *value)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    json_element(json, false);
+    json_write_char(json, '"');
+
+    const char *cursor = value ? value : "";
+    const char *run = cursor;
+
+    for (; *cursor; ++cursor) {
+        unsigned char c = *cursor;
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+        json_write(json, run, cursor - run);
+        run = cursor + 1;
+
+        switch (c) {
+        case '"':  json_write(json, "\\\"", 2); break;
+        case '\\': json_write(json, "\\\\", 2); break;
+        case '\b': json_write(json, "\\b", 2);  break;
+        case '\f': json_write(json, "\\f", 2);  break;
+        case '\n': json_write(json, "\\n", 2);  break;
+        case '\r': json_write(json, "\\r", 2);  break;
+        case '\t': json_write(json, "\\t", 2);  break;
+        default: {
+            char escape[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf] };
+            json_write(json, escape, sizeof(escape));
+        } break;
+        }
+    }
+
+    json_write(json, run, cursor - run);
+    json_write_char(json, '"');
+}
+
+#endif
@@ -0,0 +1,542 @@
+#include "pattern.h"
+
+#define PATTERN_MAX_DEPTH   32
+#define PATTERN_CLOSURE_BOL (1 << 0)
+#define PATTERN_CLOSURE_EOL (1 << 1)
+
+struct pattern_fragment
+{
+    int start;
+    int end;
+};
+
+struct pattern_parser
+{
+    struct pattern_set *set;
+    const char *cursor;
+    int depth;
+    bool error;
+};
+
+static const struct pattern_fragment pattern_fragment_error = { -1, -1 };
+
+static inline void pattern_bytes_add(uint8_t *bytes, int c)
+{
+    bytes[c >> 3] |= 1 << (c & 7);
+}
+
+static inline bool pattern_bytes_has(uint8_t *bytes, int c)
+{
+    return (bytes[c >> 3] >> (c & 7)) & 1;
+}
+
+static int pattern_node_add(struct pattern_set *set, enum pattern_node_type type)
+{
+    struct pattern_node node = { .type = type, .out = -1, .out1 = -1, .id = -1 };
+    buf_push(set->node, node);
+    return buf_len(set->node) - 1;
+}
+
+static struct pattern_fragment pattern_fragment_create(struct pattern_set *set, enum pattern_node_type type)
+{
+    int start = pattern_node_add(set, type);
+    int end = pattern_node_add(set, PATTERN_NODE_EMPTY);
+    set->node[start].out = end;
+    return (struct pattern_fragment) { start, end };
+}
+
+static struct pattern_fragment pattern_parser_fail(struct pattern_parser *parser)
+{
+    parser->error = true;
+    return pattern_fragment_error;
+}
+
+static bool pattern_parse_bracket(struct pattern_parser *parser, uint8_t *bytes)
+{
+    const char *cursor = parser->cursor;
+    bool is_negated = *cursor == '^';
+    if (is_negated) ++cursor;
+
+    for (bool is_first = true;; is_first = false) {
+        if (!*cursor) return false;
+        if (*cursor == ']' && !is_first) break;
+
+        if (*cursor == '[' && (cursor[1] == ':' || cursor[1] == '.' || cursor[1] == '=')) return false;
+
+        int lo = (unsigned char) *cursor++;
+        int hi = lo;
+
+        if (*cursor == '-' && cursor[1] && cursor[1] != ']') {
+            if (cursor[1] == '[') return false;
+            hi = (unsigned char) cursor[1];
+            cursor += 2;
+            if (hi < lo) return false;
+        }
+
+        for (int c = lo; c <= hi; ++c) {
+            pattern_bytes_add(bytes, c);
+        }
+    }
+
+    if (is_negated) {
+        for (int i = 0; i < 32; ++i) bytes[i] = ~bytes[i];
+    }
+
+    bytes[0] &= ~1;
+    parser->cursor = cursor + 1;
+    return true;
+}
+
+static struct pattern_fragment pattern_parse_alternation(struct pattern_parser *parser);
+
+static struct pattern_fragment pattern_parse_atom(struct pattern_parser *parser)
+{
+    struct pattern_set *set = parser->set;
+    char c = *parser->cursor++;
+
+    switch (c) {
+    case '(': {
+        if (*parser->cursor == ')' || ++parser->depth > PATTERN_MAX_DEPTH) return pattern_parser_fail(parser);
+
+        struct pattern_fragment fragment = pattern_parse_alternation(parser);
+        if (parser->error || *parser->cursor != ')') return pattern_parser_fail(parser);
+
+        ++parser->cursor;
+        --parser->depth;
+        return fragment;
+    } break;
+    case '^': {
+        return pattern_fragment_create(set, PATTERN_NODE_BOL);
+    } break;
+    case '$': {
+        return pattern_fragment_create(set, PATTERN_NODE_EOL);
+    } break;
+    case '.': {
+        struct pattern_fragment fragment = pattern_fragment_create(set, PATTERN_NODE_BYTE);
+        memset(set->node[fragment.start].bytes, 0xff, 32);
+        set->node[fragment.start].bytes[0] &= ~1;
+        return fragment;
+    } break;
+    case '[': {
+        uint8_t bytes[32] = {};
+        if (!pattern_parse_bracket(parser, bytes)) return pattern_parser_fail(parser);
+
+        struct pattern_fragment fragment = pattern_fragment_create(set, PATTERN_NODE_BYTE);
+        memcpy(set->node[fragment.start].bytes, bytes, 32);
+        return fragment;
+    } break;
+    case '\\': {
+        c = *parser->cursor++;
+        if (!c || !strchr(".[]()*+?{}|^$\\", c)) return pattern_parser_fail(parser);
+    } break;
+    case '*': case '+': case '?':
+    case '{': case '}': {
+        return pattern_parser_fail(parser);
+    } break;
+    }
+
+    struct pattern_fragment fragment = pattern_fragment_create(set, PATTERN_NODE_BYTE);
+    pattern_bytes_add(set->node[fragment.start].bytes, (unsigned char) c);
+    return fragment;
+}
+
+static struct pattern_fragment pattern_parse_repetition(struct pattern_parser *parser)
+{
+    struct pattern_set *set = parser->set;
+    struct pattern_fragment fragment = pattern_parse_atom(parser);
+    if (parser->error) return fragment;
+
+    for (char c = *parser->cursor; c == '*' || c == '+' || c == '?'; c = *++parser->cursor) {
+        enum pattern_node_type type = set->node[fragment.start].type;
+        if (type == PATTERN_NODE_BOL || type == PATTERN_NODE_EOL) return pattern_parser_fail(parser);
+
+        int split = pattern_node_add(set, PATTERN_NODE_SPLIT);
+        int end = pattern_node_add(set, PATTERN_NODE_EMPTY);
+        set->node[split].out = fragment.start;
+        set->node[split].out1 = end;
+        set->node[fragment.end].out = c == '?' ? end : split;
+
+        fragment.start = c == '+' ? fragment.start : split;
+        fragment.end = end;
+    }
+
+    return fragment;
+}
+
+static struct pattern_fragment pattern_parse_concatenation(struct pattern_parser *parser)
+{
+    struct pattern_fragment result = pattern_fragment_error;
+
+    while (*parser->cursor && *parser->cursor != '|' && *parser->cursor != ')') {
+        struct pattern_fragment fragment = pattern_parse_repetition(parser);
+        if (parser->error) return fragment;
+
+        if (result.start == -1) {
+            result = fragment;
+        } else {
+            parser->set->node[result.end].out = fragment.start;
+            result.end = fragment.end;
+        }
+    }
+
+    if (result.start == -1) return pattern_parser_fail(parser);
+    return result;
+}
+
+static struct pattern_fragment pattern_parse_alternation(struct pattern_parser *parser)
+{
+    struct pattern_set *set = parser->set;
+    struct pattern_fragment result = pattern_parse_concatenation(parser);
+
+    while (!parser->error && *parser->cursor == '|') {
+        ++parser->cursor;
+
+        struct pattern_fragment fragment = pattern_parse_concatenation(parser);
+        if (parser->error) break;
+
+        int split = pattern_node_add(set, PATTERN_NODE_SPLIT);
+        int end = pattern_node_add(set, PATTERN_NODE_EMPTY);
+        set->node[split].out = result.start;
+        set->node[split].out1 = fragment.start;
+        set->node[result.end].out = end;
+        set->node[fragment.end].out = end;
+
+        result.start = split;
+        result.end = end;
+    }
+
+    return result;
+}
+
+int pattern_set_add(struct pattern_set *set, const char *pattern)
+{
+    for (int i = 0; i < buf_len(set->pattern); ++i) {
+        if (string_equals(set->pattern[i], pattern)) return i;
+    }
+
+    int node_count = buf_len(set->node);
+    struct pattern_parser parser = { .set = set, .cursor = pattern };
+    struct pattern_fragment fragment = pattern_parse_alternation(&parser);
+
+    if (parser.error || *parser.cursor) {
+        buf_truncate(set->node, node_count);
+        return -1;
+    }
+
+    int id = buf_len(set->pattern);
+    int match = pattern_node_add(set, PATTERN_NODE_MATCH);
+    set->node[match].id = id;
+    set->node[fragment.end].out = match;
+
+    buf_push(set->start, fragment.start);
+    buf_push(set->pattern, string_copy((char *) pattern));
+    set->is_compiled = false;
+
+    return id;
+}
+
+//
+// NOTE(koekeishiya): Collects the nodes that can be reached from the given node without consuming
+// a byte. Assertions are only followed when the corresponding flag is given; '^' is dropped when we
+// are not at the start of the string, but '$' is kept in the list, so that the nodes behind it can
+// be reached once we know that the string has ended.
+//
+
+static void pattern_closure(struct pattern_set *set, int node, int flags, int **list)
+{
+    int top = 0;
+    set->stack[top++] = node;
+
+    while (top) {
+        int index = set->stack[--top];
+        if (index == -1 || set->mark[index] == set->generation) continue;
+        set->mark[index] = set->generation;
+
+        struct pattern_node *n = &set->node[index];
+        switch (n->type) {
+        case PATTERN_NODE_EMPTY: {
+            set->stack[top++] = n->out;
+        } break;
+        case PATTERN_NODE_SPLIT: {
+            set->stack[top++] = n->out;
+            set->stack[top++] = n->out1;
+        } break;
+        case PATTERN_NODE_BOL: {
+            if (flags & PATTERN_CLOSURE_BOL) set->stack[top++] = n->out;
+        } break;
+        case PATTERN_NODE_EOL: {
+            if (flags & PATTERN_CLOSURE_EOL) {
+                set->stack[top++] = n->out;
+            } else {
+                buf_push(*list, index);
+            }
+        } break;
+        case PATTERN_NODE_BYTE:
+        case PATTERN_NODE_MATCH: {
+            buf_push(*list, index);
+        } break;
+        }
+    }
+}
+
+static int pattern_compare_node(const void *a, const void *b)
+{
+    return *(int *) a - *(int *) b;
+}
+
+static int pattern_state_find(struct pattern_set *set, int *nodes, int count, uint64_t hash)
+{
+    void *head = literal_table_find(&set->state_index, hash);
+
+    for (int i = head ? (intptr_t) head - 1 : -1; i != -1; i = set->state[i].next) {
+        struct pattern_state *state = &set->state[i];
+        if (state->node_count == count && memcmp(&set->state_node[state->node_offset], nodes, count * sizeof(int)) == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static int pattern_state_add(struct pattern_set *set, int *nodes, int count)
+{
+    qsort(nodes, count, sizeof(int), pattern_compare_node);
+
+    uint64_t hash = table_hash_string((char *) nodes, count * sizeof(int));
+    int index = pattern_state_find(set, nodes, count, hash);
+    if (index != -1) return index;
+
+    index = buf_len(set->state);
+    struct pattern_state state = { .node_offset = buf_len(set->state_node), .node_count = count, .hash = hash, .next = -1 };
+
+    void *head = literal_table_find(&set->state_index, hash);
+    if (head) {
+        struct pattern_state *collision = &set->state[(intptr_t) head - 1];
+        state.next = collision->next;
+        collision->next = index;
+    } else {
+        literal_table_add(&set->state_index, hash, (void *)(intptr_t)(index + 1));
+    }
+
+    buf_push(set->state, state);
+    for (int i = 0; i < count; ++i)                buf_push(set->state_node, nodes[i]);
+    for (int i = 0; i < set->class_count; ++i)     buf_push(set->transition, -1);
+    for (int i = 0; i < set->word_count; ++i)      buf_push(set->accept, 0);
+    for (int i = 0; i < set->word_count; ++i)      buf_push(set->end_accept, 0);
+
+    uint64_t *accept = &set->accept[index * set->word_count];
+    uint64_t *end_accept = &set->end_accept[index * set->word_count];
+    int *end_nodes = NULL;
+
+    ++set->generation;
+    for (int i = 0; i < count; ++i) {
+        struct pattern_node *node = &set->node[nodes[i]];
+        if (node->type == PATTERN_NODE_MATCH) {
+            accept[node->id >> 6] |= 1ULL << (node->id & 63);
+        } else if (node->type == PATTERN_NODE_EOL) {
+            pattern_closure(set, node->out, PATTERN_CLOSURE_EOL, &end_nodes);
+        }
+    }
+
+    for (int i = 0; i < buf_len(end_nodes); ++i) {
+        struct pattern_node *node = &set->node[end_nodes[i]];
+        if (node->type == PATTERN_NODE_MATCH) {
+            end_accept[node->id >> 6] |= 1ULL << (node->id & 63);
+        }
+    }
+
+    buf_free(end_nodes);
+    return index;
+}
+
+static int pattern_state_initial(struct pattern_set *set)
+{
+    buf_truncate(set->scratch, 0);
+    ++set->generation;
+
+    for (int i = 0; i < buf_len(set->start); ++i) {
+        pattern_closure(set, set->start[i], PATTERN_CLOSURE_BOL, &set->scratch);
+    }
+
+    return pattern_state_add(set, set->scratch, buf_len(set->scratch));
+}
+
+static void pattern_state_reset(struct pattern_set *set)
+{
+    buf_truncate(set->state, 0);
+    buf_truncate(set->state_node, 0);
+    buf_truncate(set->transition, 0);
+    buf_truncate(set->accept, 0);
+    buf_truncate(set->end_accept, 0);
+    literal_table_free(&set->state_index);
+    literal_table_init(&set->state_index, 64);
+}
+
+//
+// NOTE(koekeishiya): States are only created for the strings that we actually see, but a pattern
+// set could in theory require an exponential number of them. When the limit is reached we simply
+// start over with an empty cache, keeping the state that we are currently in.
+//
+
+static int pattern_state_flush(struct pattern_set *set, int index)
+{
+    struct pattern_state *state = &set->state[index];
+    int *nodes = NULL;
+
+    for (int i = 0; i < state->node_count; ++i) {
+        buf_push(nodes, set->state_node[state->node_offset + i]);
+    }
+
+    pattern_state_reset(set);
+    pattern_state_initial(set);
+    index = pattern_state_add(set, nodes, buf_len(nodes));
+
+    buf_free(nodes);
+    return index;
+}
+
+static int pattern_state_transition(struct pattern_set *set, int index, int class)
+{
+    if (buf_len(set->state) >= PATTERN_SET_MAX_STATES) {
+        index = pattern_state_flush(set, index);
+    }
+
+    int byte = 0;
+    while (set->byte_class[byte] != class) ++byte;
+
+    buf_truncate(set->scratch, 0);
+    ++set->generation;
+
+    struct pattern_state *state = &set->state[index];
+    for (int i = 0; i < state->node_count; ++i) {
+        struct pattern_node *node = &set->node[set->state_node[state->node_offset + i]];
+        if (node->type == PATTERN_NODE_BYTE && pattern_bytes_has(node->bytes, byte)) {
+            pattern_closure(set, node->out, 0, &set->scratch);
+        }
+    }
+
+    for (int i = 0; i < buf_len(set->restart); ++i) {
+        int node = set->restart[i];
+        if (set->mark[node] != set->generation) {
+            set->mark[node] = set->generation;
+            buf_push(set->scratch, node);
+        }
+    }
+
+    int next = pattern_state_add(set, set->scratch, buf_len(set->scratch));
+    set->transition[index * set->class_count + class] = next;
+
+    return next;
+}
+
+//
+// NOTE(koekeishiya): Bytes that are accepted by exactly the same set of nodes are interchangeable,
+// so every state only needs one transition per class of such bytes instead of one per byte.
+//
+
+static void pattern_set_compile(struct pattern_set *set)
+{
+    int node_count = buf_len(set->node);
+
+    memset(set->byte_class, 0, sizeof(set->byte_class));
+    set->class_count = 1;
+
+    for (int i = 0; i < node_count; ++i) {
+        struct pattern_node *node = &set->node[i];
+        if (node->type != PATTERN_NODE_BYTE) continue;
+
+        int class_map[512];
+        memset(class_map, -1, sizeof(class_map));
+        set->class_count = 0;
+
+        for (int c = 0; c < 256; ++c) {
+            int key = set->byte_class[c] * 2 + pattern_bytes_has(node->bytes, c);
+            if (class_map[key] == -1) class_map[key] = set->class_count++;
+            set->byte_class[c] = class_map[key];
+        }
+    }
+
+    set->word_count = (buf_len(set->pattern) + 63) / 64;
+    set->mark = realloc(set->mark, node_count * sizeof(int));
+    set->stack = realloc(set->stack, (2 * node_count + 1) * sizeof(int));
+    set->result = realloc(set->result, set->word_count * sizeof(uint64_t));
+    memset(set->mark, 0, node_count * sizeof(int));
+    set->generation = 0;
+
+    buf_truncate(set->restart, 0);
+    ++set->generation;
+    for (int i = 0; i < buf_len(set->start); ++i) {
+        pattern_closure(set, set->start[i], 0, &set->restart);
+    }
+
+    pattern_state_reset(set);
+    pattern_state_initial(set);
+    set->is_compiled = true;
+}
+
+uint64_t *pattern_set_match(struct pattern_set *set, const char *str)
+{
+    if (!buf_len(set->pattern)) return NULL;
+    if (!set->is_compiled) pattern_set_compile(set);
+
+    uint64_t *result = set->result;
+    memset(result, 0, set->word_count * sizeof(uint64_t));
+
+    const unsigned char *cursor = (const unsigned char *) str;
+    if (!*cursor) {
+        buf_truncate(set->scratch, 0);
+        ++set->generation;
+
+        for (int i = 0; i < buf_len(set->start); ++i) {
+            pattern_closure(set, set->start[i], PATTERN_CLOSURE_BOL | PATTERN_CLOSURE_EOL, &set->scratch);
+        }
+
+        for (int i = 0; i < buf_len(set->scratch); ++i) {
+            struct pattern_node *node = &set->node[set->scratch[i]];
+            if (node->type == PATTERN_NODE_MATCH) result[node->id >> 6] |= 1ULL << (node->id & 63);
+        }
+
+        return result;
+    }
+
+    int state = 0;
+    for (; *cursor; ++cursor) {
+        uint64_t *accept = &set->accept[state * set->word_count];
+        for (int i = 0; i < set->word_count; ++i) result[i] |= accept[i];
+
+        int class = set->byte_class[*cursor];
+        int next = set->transition[state * set->class_count + class];
+        state = next != -1 ? next : pattern_state_transition(set, state, class);
+    }
+
+    uint64_t *accept = &set->accept[state * set->word_count];
+    uint64_t *end_accept = &set->end_accept[state * set->word_count];
+    for (int i = 0; i < set->word_count; ++i) result[i] |= accept[i] | end_accept[i];
+
+    return result;
+}
+
+void pattern_set_free(struct pattern_set *set)
+{
+    for (int i = 0; i < buf_len(set->pattern); ++i) {
+        free(set->pattern[i]);
+    }
+
+    buf_free(set->node);
+    buf_free(set->pattern);
+    buf_free(set->start);
+    buf_free(set->restart);
+    buf_free(set->state);
+    buf_free(set->state_node);
+    buf_free(set->transition);
+    buf_free(set->accept);
+    buf_free(set->end_accept);
+    buf_free(set->scratch);
+    literal_table_free(&set->state_index);
+
+    if (set->stack)  free(set->stack);
+    if (set->mark)   free(set->mark);
+    if (set->result) free(set->result);
+
+    memset(set, 0, sizeof(struct pattern_set));
+}
@@ -0,0 +1,88 @@
+#ifndef PATTERN_H
+#define PATTERN_H
+
+#ifndef PATTERN_SET_MAX_STATES
+#define PATTERN_SET_MAX_STATES 4096
+#endif
+
+//
+// NOTE(koekeishiya): Multi-pattern matcher for the extended regular expressions used by rules and
+// signals. All patterns added to a set are compiled into a single NFA, which is turned into a DFA
+// lazily while matching, so that a string is scanned once to find every pattern that matches it,
+// instead of running regexec once per pattern. Only the match/no-match answer of regexec is
+// reproduced, which is all that rules and signals need.
+//
+// Supported are literals, escaped operators, '.', bracket expressions with ranges, grouping,
+// alternation, the '*', '+' and '?' operators, and the '^' and '$' anchors. Patterns using
+// anything else (bounds, character classes such as [:alpha:], unknown escapes) are rejected by
+// pattern_set_add, and the caller must keep using regexec for those.
+//
+
+enum pattern_node_type
+{
+    PATTERN_NODE_EMPTY,
+    PATTERN_NODE_SPLIT,
+    PATTERN_NODE_BYTE,
+    PATTERN_NODE_BOL,
+    PATTERN_NODE_EOL,
+    PATTERN_NODE_MATCH
+};
+
+struct pattern_node
+{
+    enum pattern_node_type type;
+    int out;
+    int out1;
+    int id;
+    uint8_t bytes[32];
+};
+
+struct pattern_state
+{
+    int node_offset;
+    int node_count;
+    uint64_t hash;
+    int next;
+};
+
+struct pattern_set
+{
+    struct pattern_node *node;
+    char **pattern;
+    int *start;
+
+    bool is_compiled;
+    int word_count;
+    int class_count;
+    uint8_t byte_class[256];
+    int *restart;
+
+    struct pattern_state *state;
+    int *state_node;
+    int *transition;
+    uint64_t *accept;
+    uint64_t *end_accept;
+    literal_table state_index;
+
+    int *stack;
+    int *mark;
+    int generation;
+    int *scratch;
+    uint64_t *result;
+};
+
+int pattern_set_add(struct pattern_set *set, const char *pattern);
+uint64_t *pattern_set_match(struct pattern_set *set, const char *str);
+void pattern_set_free(struct pattern_set *set);
+
+static inline int pattern_set_count(struct pattern_set *set)
+{
+    return buf_len(set->pattern);
+}
+
+static inline bool pattern_set_has(uint64_t *result, int id)
+{
+    return (result[id >> 6] >> (id & 63)) & 1;
+}
+
+#endif
@@ -20,6 +20,7 @@ struct buf_hdr
 #define buf_push(b, x) (buf__fit(b, 1), (b)[buf_len(b)] = (x), buf__hdr(b)->len++)
 #define buf_del(b, x) ((b) ? (b)[x] = (b)[buf_len(b)-1], buf__hdr(b)->len-- : 0)
 #define buf_free(b) ((b) ? free(buf__hdr(b)) : 0)
+#define buf_truncate(b, n) ((b) ? buf__hdr(b)->len = (n) : 0)
 
 static void *buf__grow_f(const void *buf, size_t new_len, size_t elem_size)
 {
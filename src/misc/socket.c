@@ -39,6 +39,82 @@ bool socket_write(int sockfd, char *message)
     return send(sockfd, message, strlen(message), 0) != -1;
 }
 
+static bool socket_read_exact(int sockfd, void *buffer, size_t len)
+{
+    char *cursor = buffer;
+
+    while (len > 0) {
+        ssize_t bytes_read = recv(sockfd, cursor, len, 0);
+        if (bytes_read <= 0) return false;
+
+        cursor += bytes_read;
+        len -= bytes_read;
+    }
+
+    return true;
+}
+
+//
+// NOTE(koekeishiya): A frame is a uint32_t length in host byte order followed by that many bytes.
+// Both ends of the connection live on the same machine, so there is no need for a fixed order.
+// socket_read_frame fails if the frame does not fit in the given buffer, as the connection
+// can not be resynchronized once a frame has been partially consumed.
+//
+
+bool socket_read_frame(int sockfd, char *buffer, uint32_t size, uint32_t *len)
+{
+    if (!socket_read_exact(sockfd, len, sizeof(uint32_t))) return false;
+    if (*len > size) return false;
+
+    return socket_read_exact(sockfd, buffer, *len);
+}
+
+bool socket_write_frame(int sockfd, char *message, uint32_t len)
+{
+    struct iovec iov[] = {
+        { &len,    sizeof(uint32_t) },
+        { message, len              }
+    };
+
+    struct iovec *cursor = iov;
+    int count = array_count(iov);
+
+    while (count > 0) {
+        ssize_t bytes_written = writev(sockfd, cursor, count);
+        if (bytes_written <= 0) return false;
+
+        while (count > 0 && (size_t) bytes_written >= cursor->iov_len) {
+            bytes_written -= cursor->iov_len;
+            ++cursor;
+            --count;
+        }
+
+        if (count > 0) {
+            cursor->iov_base = (char *) cursor->iov_base + bytes_written;
+            cursor->iov_len -= bytes_written;
+        }
+    }
+
+    return true;
+}
+
+char *socket_read_frame_alloc(int sockfd, uint32_t max_size, uint32_t *len)
+{
+    if (!socket_read_exact(sockfd, len, sizeof(uint32_t))) return NULL;
+    if (*len > max_size) return NULL;
+
+    char *result = malloc((size_t) *len + 1);
+    if (!result) return NULL;
+
+    if (!socket_read_exact(sockfd, result, *len)) {
+        free(result);
+        return NULL;
+    }
+
+    result[*len] = '\0';
+    return result;
+}
+
 bool socket_connect_in(int *sockfd, int port)
 {
     struct sockaddr_in socket_address;
@@ -90,26 +166,285 @@ void socket_close(int sockfd)
     close(sockfd);
 }
 
+//
+// NOTE(koekeishiya): The daemon serves every client from a single thread, polling the listening
+// socket and all connected clients at once. Reads never block; bytes are appended to a receive
+// buffer owned by the client, which doubles in size when full, up to the configured limit.
+// A client that does not complete its message within the timeout is disconnected, so a stalled
+// client can only ever hold on to its own slot.
+//
+// A client that wants to send more than one message opens the connection with
+// SOCKET_SESSION_MAGIC, followed by any number of frames. Every frame is passed to the handler
+// as its own message, and the handler is expected to answer each of them with exactly one
+// frame, in order. Any other client sends a single message and then shuts down its end of the
+// connection. In both cases the handler takes ownership of the socket; a session hands it over
+// by calling the handler with a NULL message once it ends.
+//
+
+static uint64_t socket_time_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void socket_daemon_init_limits(struct daemon *daemon)
+{
+    if (!daemon->limits.max_clients)      daemon->limits.max_clients      = SOCKET_DAEMON_MAX_CLIENTS;
+    if (!daemon->limits.max_message_size) daemon->limits.max_message_size = SOCKET_DAEMON_MAX_MESSAGE_SIZE;
+    if (!daemon->limits.client_timeout)   daemon->limits.client_timeout   = SOCKET_DAEMON_CLIENT_TIMEOUT;
+}
+
+static bool socket_daemon_client_grow(struct daemon *daemon, struct daemon_client *client)
+{
+    uint32_t max_size = daemon->limits.max_message_size + SOCKET_SESSION_MAGIC_LEN + sizeof(uint32_t) + 1;
+    if (client->capacity >= max_size) return false;
+
+    uint32_t capacity = client->capacity ? client->capacity * 2 : SOCKET_DAEMON_CLIENT_BUFFER_SIZE;
+    if (capacity > max_size) capacity = max_size;
+
+    char *buffer = realloc(client->buffer, capacity);
+    if (!buffer) return false;
+
+    client->buffer = buffer;
+    client->capacity = capacity;
+    return true;
+}
+
+static void socket_daemon_remove_client(struct daemon *daemon, int index)
+{
+    struct daemon_client *client = &daemon->clients[index];
+    if (client->buffer) free(client->buffer);
+    daemon->clients[index] = daemon->clients[--daemon->client_count];
+}
+
+static void socket_daemon_fail_client(struct daemon *daemon, struct daemon_client *client, char *message)
+{
+    if (client->type == DAEMON_CLIENT_SESSION) {
+        daemon->handler(NULL, 0, client->sockfd, true);
+    } else {
+        socket_write(client->sockfd, message);
+        socket_close(client->sockfd);
+    }
+}
+
+static bool socket_daemon_client_identify(struct daemon_client *client)
+{
+    if (client->length < SOCKET_SESSION_MAGIC_LEN) return false;
+
+    if (memcmp(client->buffer, SOCKET_SESSION_MAGIC, SOCKET_SESSION_MAGIC_LEN) == 0) {
+        client->type = DAEMON_CLIENT_SESSION;
+        client->length -= SOCKET_SESSION_MAGIC_LEN;
+        memmove(client->buffer, client->buffer + SOCKET_SESSION_MAGIC_LEN, client->length);
+    } else {
+        client->type = DAEMON_CLIENT_MESSAGE;
+    }
+
+    return true;
+}
+
+static bool socket_daemon_client_dispatch_frames(struct daemon *daemon, struct daemon_client *client, uint64_t now)
+{
+    uint32_t cursor = 0;
+
+    while (client->length - cursor >= sizeof(uint32_t)) {
+        uint32_t size;
+        memcpy(&size, client->buffer + cursor, sizeof(uint32_t));
+        if (size > daemon->limits.max_message_size) return false;
+        if (client->length - cursor - sizeof(uint32_t) < size) break;
+
+        char *message = malloc(size + 1);
+        if (!message) return false;
+
+        memcpy(message, client->buffer + cursor + sizeof(uint32_t), size);
+        message[size] = '\0';
+        cursor += sizeof(uint32_t) + size;
+
+        daemon->handler(message, size, client->sockfd, true);
+    }
+
+    if (cursor > 0) {
+        client->length -= cursor;
+        memmove(client->buffer, client->buffer + cursor, client->length);
+    }
+
+    //
+    // NOTE(koekeishiya): An idle session has no deadline; the timeout only starts once the
+    // client has sent part of a frame, and restarts for every frame that follows.
+    //
+
+    if (!client->length) {
+        client->deadline = 0;
+    } else if (cursor > 0 || !client->deadline) {
+        client->deadline = now + daemon->limits.client_timeout;
+    }
+
+    return true;
+}
+
+//
+// NOTE(koekeishiya): Returns false if the client is done, in which case its socket has either
+// been handed over to the handler or closed, and the client must be removed.
+//
+
+static bool socket_daemon_client_read(struct daemon *daemon, struct daemon_client *client, uint64_t now)
+{
+    for (;;) {
+        if (client->length + 1 >= client->capacity && !socket_daemon_client_grow(daemon, client)) {
+            socket_daemon_fail_client(daemon, client, FAILURE_MESSAGE"message is too large\n");
+            return false;
+        }
+
+        ssize_t bytes_read = recv(client->sockfd, client->buffer + client->length, client->capacity - client->length - 1, MSG_DONTWAIT);
+
+        if (bytes_read > 0) {
+            client->length += bytes_read;
+
+            if (client->type == DAEMON_CLIENT_UNKNOWN) {
+                socket_daemon_client_identify(client);
+            }
+
+            if (client->type == DAEMON_CLIENT_SESSION && !socket_daemon_client_dispatch_frames(daemon, client, now)) {
+                socket_daemon_fail_client(daemon, client, NULL);
+                return false;
+            }
+        } else if (bytes_read == 0) {
+            if (client->type == DAEMON_CLIENT_SESSION) {
+                daemon->handler(NULL, 0, client->sockfd, true);
+            } else if (client->length > 0) {
+                client->buffer[client->length] = '\0';
+                daemon->handler(client->buffer, client->length, client->sockfd, false);
+                client->buffer = NULL;
+            } else {
+                socket_close(client->sockfd);
+            }
+
+            return false;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return true;
+        } else if (errno != EINTR) {
+            socket_daemon_fail_client(daemon, client, FAILURE_MESSAGE"failed to read message\n");
+            return false;
+        }
+    }
+}
+
+static void socket_daemon_accept(struct daemon *daemon, uint64_t now)
+{
+    for (;;) {
+        int sockfd = accept(daemon->sockfd, NULL, 0);
+        if (sockfd == -1) break;
+
+        //
+        // NOTE(koekeishiya): The handler writes its response using regular blocking calls, so
+        // make sure the socket does not inherit O_NONBLOCK from the listening socket.
+        //
+
+        fcntl(sockfd, F_SETFL, fcntl(sockfd, F_GETFL) & ~O_NONBLOCK);
+
+        if (daemon->client_count == daemon->limits.max_clients) {
+            socket_write(sockfd, FAILURE_MESSAGE"too many clients, try again\n");
+            socket_close(sockfd);
+            continue;
+        }
+
+        daemon->clients[daemon->client_count++] = (struct daemon_client) {
+            .sockfd   = sockfd,
+            .type     = DAEMON_CLIENT_UNKNOWN,
+            .deadline = now + daemon->limits.client_timeout
+        };
+    }
+}
+
+static int socket_daemon_poll_timeout(struct daemon *daemon, uint64_t now)
+{
+    uint64_t deadline = 0;
+
+    for (int i = 0; i < daemon->client_count; ++i) {
+        uint64_t client_deadline = daemon->clients[i].deadline;
+        if (client_deadline && (!deadline || client_deadline < deadline)) deadline = client_deadline;
+    }
+
+    if (!deadline) return -1;
+    return deadline > now ? (int)(deadline - now) : 0;
+}
+
 static void *socket_connection_handler(void *context)
 {
     struct daemon *daemon = context;
+    struct pollfd *fds = malloc(sizeof(struct pollfd) * (daemon->limits.max_clients + 2));
 
     while (daemon->is_running) {
-        int sockfd = accept(daemon->sockfd, NULL, 0);
-        if (sockfd == -1) continue;
+        int client_count = daemon->client_count;
 
-        int length;
-        char *message = socket_read(sockfd, &length);
-        if (message) {
-            daemon->handler(message, length, sockfd);
-        } else {
-            socket_close(sockfd);
+        fds[0] = (struct pollfd) { daemon->wake[0], POLLIN, 0 };
+        fds[1] = (struct pollfd) { daemon->sockfd, POLLIN, 0 };
+
+        for (int i = 0; i < client_count; ++i) {
+            fds[i+2] = (struct pollfd) { daemon->clients[i].sockfd, POLLIN, 0 };
+        }
+
+        int timeout = socket_daemon_poll_timeout(daemon, socket_time_ms());
+        if (poll(fds, client_count + 2, timeout) == -1) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        uint64_t now = socket_time_ms();
+
+        //
+        // NOTE(koekeishiya): Clients are visited back to front, because removing a client moves
+        // the last one into its slot, and that one has then already been visited.
+        //
+
+        for (int i = client_count - 1; i >= 0; --i) {
+            struct daemon_client *client = &daemon->clients[i];
+            bool is_done = false;
+
+            if (fds[i+2].revents) {
+                is_done = !socket_daemon_client_read(daemon, client, now);
+            }
+
+            if (!is_done && client->deadline && client->deadline <= now) {
+                debug("%s: client %d timed out\n", __FUNCTION__, client->sockfd);
+                socket_daemon_fail_client(daemon, client, FAILURE_MESSAGE"timed out waiting for message\n");
+                is_done = true;
+            }
+
+            if (is_done) socket_daemon_remove_client(daemon, i);
+        }
+
+        if (fds[1].revents & POLLIN) {
+            socket_daemon_accept(daemon, now);
         }
     }
 
+    free(fds);
     return NULL;
 }
 
+static bool socket_daemon_begin(struct daemon *daemon, socket_daemon_handler *handler)
+{
+    if (listen(daemon->sockfd, SOMAXCONN) == -1) {
+        return false;
+    }
+
+    if (pipe(daemon->wake) == -1) {
+        return false;
+    }
+
+    fcntl(daemon->sockfd, F_SETFL, fcntl(daemon->sockfd, F_GETFL) | O_NONBLOCK);
+    socket_daemon_init_limits(daemon);
+
+    daemon->clients = malloc(sizeof(struct daemon_client) * daemon->limits.max_clients);
+    daemon->client_count = 0;
+    daemon->handler = handler;
+    daemon->is_running = true;
+    pthread_create(&daemon->thread, NULL, &socket_connection_handler, daemon);
+
+    return true;
+}
+
 bool socket_daemon_begin_in(struct daemon *daemon, int port, socket_daemon_handler *handler)
 {
     struct sockaddr_in socket_address;
@@ -126,15 +461,7 @@ bool socket_daemon_begin_in(struct daemon *daemon, int port, socket_daemon_handl
         return false;
     }
 
-    if (listen(daemon->sockfd, SOMAXCONN) == -1) {
-        return false;
-    }
-
-    daemon->handler = handler;
-    daemon->is_running = true;
-    pthread_create(&daemon->thread, NULL, &socket_connection_handler, daemon);
-
-    return true;
+    return socket_daemon_begin(daemon, handler);
 }
 
 bool socket_daemon_begin_un(struct daemon *daemon, char *socket_path, socket_daemon_handler *handler)
@@ -156,20 +483,25 @@ bool socket_daemon_begin_un(struct daemon *daemon, char *socket_path, socket_dae
         return false;
     }
 
-    if (listen(daemon->sockfd, SOMAXCONN) == -1) {
-        return false;
-    }
-
-    daemon->handler = handler;
-    daemon->is_running = true;
-    pthread_create(&daemon->thread, NULL, &socket_connection_handler, daemon);
-
-    return true;
+    return socket_daemon_begin(daemon, handler);
 }
 
 void socket_daemon_end(struct daemon *daemon)
 {
     daemon->is_running = false;
+    write(daemon->wake[1], "", 1);
     pthread_join(daemon->thread, NULL);
+
+    for (int i = 0; i < daemon->client_count; ++i) {
+        socket_close(daemon->clients[i].sockfd);
+        if (daemon->clients[i].buffer) free(daemon->clients[i].buffer);
+    }
+
+    free(daemon->clients);
+    daemon->clients = NULL;
+    daemon->client_count = 0;
+
+    close(daemon->wake[0]);
+    close(daemon->wake[1]);
     socket_close(daemon->sockfd);
 }
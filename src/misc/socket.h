@@ -1,33 +1,81 @@
 #ifndef SOCKET_H
 #define SOCKET_H
 
-#define SOCKET_DAEMON_HANDLER(name) void name(char *message, int length, int sockfd)
+#define SOCKET_DAEMON_HANDLER(name) void name(char *message, int length, int sockfd, bool is_session)
 typedef SOCKET_DAEMON_HANDLER(socket_daemon_handler);
 
 #define FAILURE_MESSAGE "\x07"
 
+#define SOCKET_SESSION_MAGIC            "\x1bYBS"
+#define SOCKET_SESSION_MAGIC_LEN        4
+
+#define SOCKET_DAEMON_MAX_CLIENTS        256
+#define SOCKET_DAEMON_MAX_MESSAGE_SIZE   (1 << 20)
+#define SOCKET_DAEMON_CLIENT_TIMEOUT     2000
+#define SOCKET_DAEMON_CLIENT_BUFFER_SIZE 512
+
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <sys/un.h>
+#include <sys/uio.h>
 #include <pthread.h>
 #include <unistd.h>
 #include <netdb.h>
 #include <poll.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+
+enum daemon_client_type
+{
+    DAEMON_CLIENT_UNKNOWN,
+    DAEMON_CLIENT_MESSAGE,
+    DAEMON_CLIENT_SESSION
+};
+
+struct daemon_client
+{
+    int sockfd;
+    enum daemon_client_type type;
+    char *buffer;
+    uint32_t length;
+    uint32_t capacity;
+    uint64_t deadline;
+};
+
+//
+// NOTE(koekeishiya): Limits that are zero when the daemon begins are set to their default.
+// client_timeout is the number of milliseconds a client has to complete a message.
+//
+
+struct daemon_limits
+{
+    int max_clients;
+    uint32_t max_message_size;
+    int client_timeout;
+};
 
 struct daemon
 {
     int sockfd;
+    int wake[2];
     bool is_running;
     pthread_t thread;
     socket_daemon_handler *handler;
+    struct daemon_limits limits;
+    struct daemon_client *clients;
+    int client_count;
 };
 
 char *socket_read(int sockfd, int *len);
 bool socket_write_bytes(int sockfd, char *message, int len);
 bool socket_write(int sockfd, char *message);
+bool socket_read_frame(int sockfd, char *buffer, uint32_t size, uint32_t *len);
+bool socket_write_frame(int sockfd, char *message, uint32_t len);
+char *socket_read_frame_alloc(int sockfd, uint32_t max_size, uint32_t *len);
 bool socket_connect_in(int *sockfd, int port);
 bool socket_connect_un(int *sockfd, char *socket_path);
 void socket_wait(int sockfd);
@@ -63,7 +63,7 @@ void mouse_drop_action_swap(struct window_manager *wm, struct view *src_view, st
         dst_view->insertion_point = src_window->id;
     }
 
-    window_node_swap_window_list(src_node, dst_node);
+    window_node_swap_window_list(src_view, src_node, dst_view, dst_node);
 
     if (src_view->sid != dst_view->sid) {
         for (int i = 0; i < src_node->window_count; ++i) {
@@ -110,6 +110,7 @@ void mouse_drop_no_target(struct space_manager *sm, struct window_manager *wm, s
 {
     if (src_view->sid == dst_view->sid) {
         node->zoom = NULL;
+        window->has_applied_frame = false;
         window_node_flush(node);
     } else {
         space_manager_untile_window(sm, src_view, window);
@@ -151,6 +152,9 @@ void mouse_drop_try_adjust_bsp_grid(struct window_manager *wm, struct view *view
 end:
     if (!success) {
         struct window_node *node = view_find_window_node(view, window->id);
-        if (node) window_node_flush(node);
+        if (node) {
+            window->has_applied_frame = false;
+            window_node_flush(node);
+        }
     }
 }
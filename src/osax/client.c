@@ -0,0 +1,252 @@
+#include "sa.h"
+
+extern char g_sa_socket_file[MAXLEN];
+
+//
+// NOTE(koekeishiya): The connection to the payload and the commands sent over it. Unlike the rest
+// of sa.m, none of this depends on Cocoa, so it can be built and measured on its own.
+//
+
+//
+// NOTE(koekeishiya): We keep a single connection to the payload open for the lifetime of yabai.
+// Commands are encoded using the binary protocol described in protocol.h and sent as
+// length-prefixed frames. The payload answers every frame in order, with an empty frame unless it
+// was a handshake. Commands that we do not need to observe the result of are pipelined; their
+// replies are collected before the next command that does wait, or when too many replies are
+// outstanding. If the connection is lost, e.g. because Dock.app was restarted, we reconnect and
+// retry the command once.
+//
+
+#define SA_MAX_PENDING 64
+
+static int sa_sockfd = -1;
+static int sa_pending;
+static uint16_t sa_protocol_version;
+
+static int sa_batch_depth;
+static struct sa_buffer sa_batch;
+
+static void scripting_addition_disconnect(void)
+{
+    if (sa_sockfd != -1) {
+        socket_close(sa_sockfd);
+        sa_sockfd = -1;
+    }
+
+    sa_pending = 0;
+}
+
+static bool scripting_addition_connect(void)
+{
+    if (sa_sockfd != -1) return true;
+
+    int sockfd;
+    if (!socket_connect_un(&sockfd, g_sa_socket_file)) {
+        if (sockfd != -1) close(sockfd);
+        return false;
+    }
+
+    sa_sockfd = sockfd;
+    sa_pending = 0;
+    return true;
+}
+
+static bool scripting_addition_drain(void)
+{
+    char rsp[MAXLEN];
+    uint32_t length;
+
+    while (sa_pending > 0) {
+        if (!socket_read_frame(sa_sockfd, rsp, sizeof(rsp), &length)) return false;
+        --sa_pending;
+    }
+
+    return true;
+}
+
+static bool scripting_addition_send(struct sa_buffer *buffer, bool wait)
+{
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        if (!scripting_addition_connect()) return false;
+
+        if (sa_pending >= SA_MAX_PENDING && !scripting_addition_drain()) goto reconnect;
+        if (!socket_write_frame(sa_sockfd, (char *) buffer->data, buffer->length)) goto reconnect;
+        ++sa_pending;
+
+        if (!wait || scripting_addition_drain()) return true;
+
+reconnect:
+        debug("yabai: scripting-addition connection lost, reconnecting..\n");
+        scripting_addition_disconnect();
+    }
+
+    return false;
+}
+
+static bool scripting_addition_flush_batch(bool wait)
+{
+    if (!sa_batch.length) return true;
+
+    bool result = scripting_addition_send(&sa_batch, wait);
+    sa_buffer_init(&sa_batch);
+
+    return result;
+}
+
+//
+// NOTE(koekeishiya): While a batch is open, commands are appended to a single frame instead of
+// being sent one by one. The payload applies the commands of a frame in order, and merges runs
+// of window moves and opacity changes into a single call for the whole list of windows.
+// A command that has to wait for completion sends the batch accumulated so far along with it.
+//
+
+void scripting_addition_begin_batch(void)
+{
+    ++sa_batch_depth;
+}
+
+void scripting_addition_end_batch(void)
+{
+    assert(sa_batch_depth > 0);
+    if (--sa_batch_depth == 0) scripting_addition_flush_batch(false);
+}
+
+static bool scripting_addition_send_command(struct sa_command *command, bool wait)
+{
+    if (sa_batch_depth) {
+        if (!sa_encode_command(&sa_batch, command)) {
+            scripting_addition_flush_batch(false);
+            if (!sa_encode_command(&sa_batch, command)) return false;
+        }
+
+        if (wait) return scripting_addition_flush_batch(true);
+        return scripting_addition_connect();
+    }
+
+    struct sa_buffer buffer;
+    sa_buffer_init(&buffer);
+
+    if (!sa_encode_command(&buffer, command)) return false;
+    return scripting_addition_send(&buffer, wait);
+}
+
+static bool scripting_addition_request_handshake(char *version, uint32_t *attrib)
+{
+    char rsp[MAXLEN];
+    uint32_t length;
+
+    scripting_addition_flush_batch(false);
+    scripting_addition_disconnect();
+    sa_protocol_version = 0;
+
+    //
+    // NOTE(koekeishiya): The reply is read directly below, so the handshake must be written to the
+    // socket right away. It can not go through scripting_addition_send_command, which only appends
+    // it to the open batch when we are called from an event handler (e.g. after Dock.app restarted).
+    // We also can not let scripting_addition_send wait for it, as that would consume the reply.
+    //
+
+    struct sa_buffer buffer;
+    sa_buffer_init(&buffer);
+
+    struct sa_command command = { .op = SA_OP_HANDSHAKE, .handshake.version = SA_PROTOCOL_VERSION };
+    if (!sa_encode_command(&buffer, &command)) return false;
+    if (!scripting_addition_send(&buffer, false)) return false;
+
+    if (!socket_read_frame(sa_sockfd, rsp, sizeof(rsp), &length)) {
+        scripting_addition_disconnect();
+        return false;
+    }
+
+    --sa_pending;
+
+    char *zero = memchr(rsp, '\0', length);
+    if (!zero || (rsp + length) - (zero + 1) < sizeof(uint32_t) + sizeof(uint16_t)) return false;
+
+    struct sa_reader reader;
+    sa_reader_init(&reader, zero + 1, (rsp + length) - (zero + 1));
+
+    memcpy(version, rsp, zero - rsp + 1);
+    *attrib = sa_get_u32(&reader);
+    sa_protocol_version = sa_get_u16(&reader);
+
+    return true;
+}
+
+bool scripting_addition_create_space(uint64_t sid)
+{
+    struct sa_command command = { .op = SA_OP_SPACE_CREATE, .space.sid = sid };
+    return scripting_addition_send_command(&command, true);
+}
+
+bool scripting_addition_destroy_space(uint64_t sid)
+{
+    struct sa_command command = { .op = SA_OP_SPACE_DESTROY, .space.sid = sid };
+    return scripting_addition_send_command(&command, true);
+}
+
+bool scripting_addition_focus_space(uint64_t sid)
+{
+    struct sa_command command = { .op = SA_OP_SPACE_FOCUS, .space.sid = sid };
+    return scripting_addition_send_command(&command, true);
+}
+
+bool scripting_addition_move_space_after_space(uint64_t src_sid, uint64_t dst_sid, bool focus)
+{
+    struct sa_command command = { .op = SA_OP_SPACE_MOVE, .space_move = { src_sid, dst_sid, focus } };
+    return scripting_addition_send_command(&command, true);
+}
+
+bool scripting_addition_add_to_window_group(uint32_t child_wid, uint32_t parent_wid)
+{
+    struct sa_command command = { .op = SA_OP_WINDOW_GROUP_ADD, .window_group = { parent_wid, child_wid } };
+    return scripting_addition_send_command(&command, true);
+}
+
+bool scripting_addition_remove_from_window_group(uint32_t child_wid, uint32_t parent_wid)
+{
+    struct sa_command command = { .op = SA_OP_WINDOW_GROUP_REMOVE, .window_group = { parent_wid, child_wid } };
+    return scripting_addition_send_command(&command, true);
+}
+
+bool scripting_addition_move_window(uint32_t wid, int x, int y)
+{
+    struct sa_command command = { .op = SA_OP_WINDOW_MOVE, .window_move = { wid, x, y } };
+    return scripting_addition_send_command(&command, false);
+}
+
+bool scripting_addition_set_opacity(uint32_t wid, float opacity, float duration)
+{
+    struct sa_command command = { .op = SA_OP_WINDOW_ALPHA_FADE, .window_alpha = { wid, opacity, duration } };
+    return scripting_addition_send_command(&command, false);
+}
+
+bool scripting_addition_set_layer(uint32_t wid, int layer)
+{
+    struct sa_command command = { .op = SA_OP_WINDOW_LEVEL, .window_level = { wid, layer } };
+    return scripting_addition_send_command(&command, false);
+}
+
+bool scripting_addition_set_sticky(uint32_t wid, bool sticky)
+{
+    struct sa_command command = { .op = SA_OP_WINDOW_STICKY, .window_flag = { wid, sticky } };
+    return scripting_addition_send_command(&command, false);
+}
+
+bool scripting_addition_set_shadow(uint32_t wid, bool shadow)
+{
+    struct sa_command command = { .op = SA_OP_WINDOW_SHADOW, .window_flag = { wid, shadow } };
+    return scripting_addition_send_command(&command, false);
+}
+
+bool scripting_addition_focus_window(uint32_t wid)
+{
+    struct sa_command command = { .op = SA_OP_WINDOW_FOCUS, .window.wid = wid };
+    return scripting_addition_send_command(&command, true);
+}
+
+bool scripting_addition_scale_window(uint32_t wid, float x, float y, float w, float h)
+{
+    struct sa_command command = { .op = SA_OP_WINDOW_SCALE, .window_scale = { wid, x, y, w, h } };
+    return scripting_addition_send_command(&command, true);
+}
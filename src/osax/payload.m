@@ -22,10 +22,10 @@
 #include <stdio.h>
 
 #include "common.h"
+#include "protocol.h"
 
 #define SOCKET_PATH_FMT "/tmp/yabai-sa_%s.socket"
 
-#define BUF_SIZE 256
 #define kCGSOnAllWorkspacesTagBit (1 << 11)
 #define kCGSNoShadowTagBit (1 << 3)
 
@@ -64,6 +64,7 @@ static uint64_t set_front_window_fp;
 static Class managed_space;
 
 static pthread_t daemon_thread;
+static pthread_mutex_t message_lock = PTHREAD_MUTEX_INITIALIZER;
 static int daemon_sockfd;
 
 static void dump_class_info(Class c)
@@ -464,82 +465,6 @@ static void init_instances()
     _connection = CGSMainConnectionID();
 }
 
-typedef struct
-{
-    const char *text;
-    unsigned int length;
-} Token;
-
-static bool token_equals(Token token, const char *match)
-{
-    const char *at = match;
-    for (int i = 0; i < token.length; ++i, ++at) {
-        if ((*at == 0) || (token.text[i] != *at)) {
-            return false;
-        }
-    }
-    return *at == 0;
-}
-
-static uint64_t token_to_uint64t(Token token)
-{
-    uint64_t result = 0;
-    char buffer[token.length + 1];
-    memcpy(buffer, token.text, token.length);
-    buffer[token.length] = '\0';
-    sscanf(buffer, "%lld", &result);
-    return result;
-}
-
-static uint32_t token_to_uint32t(Token token)
-{
-    uint32_t result = 0;
-    char buffer[token.length + 1];
-    memcpy(buffer, token.text, token.length);
-    buffer[token.length] = '\0';
-    sscanf(buffer, "%d", &result);
-    return result;
-}
-
-static int token_to_int(Token token)
-{
-    int result = 0;
-    char buffer[token.length + 1];
-    memcpy(buffer, token.text, token.length);
-    buffer[token.length] = '\0';
-    sscanf(buffer, "%d", &result);
-    return result;
-}
-
-static float token_to_float(Token token)
-{
-    float result = 0.0f;
-    char buffer[token.length + 1];
-    memcpy(buffer, token.text, token.length);
-    buffer[token.length] = '\0';
-    sscanf(buffer, "%f", &result);
-    return result;
-}
-
-static Token get_token(const char **message)
-{
-    Token token;
-
-    token.text = *message;
-    while (**message && !isspace(**message)) {
-        ++(*message);
-    }
-    token.length = *message - token.text;
-
-    if (isspace(**message)) {
-        ++(*message);
-    } else {
-        // NOTE(koekeishiya): don't go past the null-terminator
-    }
-
-    return token;
-}
-
 static inline id get_ivar_value(id instance, const char *name)
 {
     id result = nil;
@@ -606,17 +531,8 @@ static inline id display_space_for_space_with_id(uint64_t space_id)
 
 #define asm__call_move_space(v0,v1,v2,v3,func) \
         __asm__("movq %0, %%rdi;""movq %1, %%rsi;""movq %2, %%rdx;""movq %3, %%r13;""callq *%4;" : :"r"(v0), "r"(v1), "r"(v2), "r"(v3), "r"(func) :"%rdi", "%rsi", "%rdx", "%r13");
-static void do_space_move(const char *message)
+static void do_space_move(uint64_t source_space_id, uint64_t dest_space_id, bool focus_dest_space)
 {
-    Token source_token = get_token(&message);
-    uint64_t source_space_id = token_to_uint64t(source_token);
-
-    Token dest_token = get_token(&message);
-    uint64_t dest_space_id = token_to_uint64t(dest_token);
-
-    Token focus_token = get_token(&message);
-    bool focus_dest_space = token_to_int(focus_token);
-
     CFStringRef source_display_uuid = CGSCopyManagedDisplayForSpace(_connection, source_space_id);
     id source_space = space_for_display_with_id(source_display_uuid, source_space_id);
     id source_display_space = display_space_for_display_uuid(source_display_uuid);
@@ -649,10 +565,8 @@ static void do_space_move(const char *message)
 }
 
 typedef void (*remove_space_call)(id space, id display_space, id dock_spaces, uint64_t space_id1, uint64_t space_id2);
-static void do_space_destroy(const char *message)
+static void do_space_destroy(uint64_t space_id)
 {
-    Token space_id_token = get_token(&message);
-    uint64_t space_id = token_to_uint64t(space_id_token);
     CFStringRef display_uuid = CGSCopyManagedDisplayForSpace(_connection, space_id);
     uint64_t active_space_id = CGSManagedDisplayGetCurrentSpace(_connection, display_uuid);
 
@@ -674,10 +588,8 @@ static void do_space_destroy(const char *message)
 
 #define asm__call_add_space(v0,v1,func) \
         __asm__("movq %0, %%rdi;""movq %1, %%r13;""callq *%2;" : :"r"(v0), "r"(v1), "r"(func) :"%rdi", "%r13");
-static void do_space_create(const char *message)
+static void do_space_create(uint64_t space_id)
 {
-    Token space_id_token = get_token(&message);
-    uint64_t space_id = token_to_uint64t(space_id_token);
     CFStringRef __block display_uuid = CGSCopyManagedDisplayForSpace(_connection, space_id);
     dispatch_sync(dispatch_get_main_queue(), ^{
         id new_space = [[managed_space alloc] init];
@@ -687,10 +599,8 @@ static void do_space_create(const char *message)
     });
 }
 
-static void do_space_change(const char *message)
+static void do_space_change(uint64_t dest_space_id)
 {
-    Token token = get_token(&message);
-    uint64_t dest_space_id = token_to_uint64t(token);
     if (dest_space_id) {
         CFStringRef dest_display = CGSCopyManagedDisplayForSpace(_connection, dest_space_id);
         id source_space = objc_msgSend(dock_spaces, @selector(currentSpaceforDisplayUUID:), dest_display);
@@ -716,10 +626,8 @@ static void do_space_change(const char *message)
     }
 }
 
-static void do_window_scale(const char *message)
+static void do_window_scale(uint32_t wid, float dx, float dy, float dw, float dh)
 {
-    Token wid_token = get_token(&message);
-    uint32_t wid = token_to_uint32t(wid_token);
     if (!wid) return;
 
     CGRect frame = {};
@@ -730,15 +638,6 @@ static void do_window_scale(const char *message)
     CGSGetWindowTransform(_connection, wid, &current_transform);
 
     if (CGAffineTransformEqualToTransform(current_transform, original_transform)) {
-        Token dx_token = get_token(&message);
-        float dx = token_to_float(dx_token);
-        Token dy_token = get_token(&message);
-        float dy = token_to_float(dy_token);
-        Token dw_token = get_token(&message);
-        float dw = token_to_float(dw_token);
-        Token dh_token = get_token(&message);
-        float dh = token_to_float(dh_token);
-
         int target_width  = dw / 4;
         int target_height = target_width / (frame.size.width/frame.size.height);
 
@@ -756,69 +655,58 @@ static void do_window_scale(const char *message)
     }
 }
 
-static void do_window_move(const char *message)
+static void do_window_list_move(struct sa_command *commands, int count)
 {
-    Token wid_token = get_token(&message);
-    uint32_t wid = token_to_uint32t(wid_token);
-    if (!wid) return;
+    NSMutableArray *window_list = [[NSMutableArray alloc] initWithCapacity:count];
 
-    Token x_token = get_token(&message);
-    int x = token_to_int(x_token);
+    for (int i = 0; i < count; ++i) {
+        uint32_t wid = commands[i].window_move.wid;
+        if (!wid) continue;
 
-    Token y_token = get_token(&message);
-    int y = token_to_int(y_token);
+        CGPoint point = CGPointMake(commands[i].window_move.x, commands[i].window_move.y);
+        CGSMoveWindowWithGroup(_connection, wid, &point);
+        [window_list addObject:@(wid)];
+    }
 
-    CGPoint point = CGPointMake(x, y);
-    CGSMoveWindowWithGroup(_connection, wid, &point);
+    if ([window_list count]) {
+        CGSReassociateWindowsSpacesByGeometry(_connection, (__bridge CFArrayRef) window_list);
+    }
 
-    NSArray *window_list = @[ @(wid) ];
-    CGSReassociateWindowsSpacesByGeometry(_connection, (__bridge CFArrayRef) window_list);
     [window_list release];
 }
 
-static void do_window_alpha(const char *message)
+static void do_window_alpha(uint32_t wid, float alpha)
 {
-    Token wid_token = get_token(&message);
-    uint32_t wid = token_to_uint32t(wid_token);
     if (!wid) return;
-
-    Token alpha_token = get_token(&message);
-    float alpha = token_to_float(alpha_token);
     CGSSetWindowAlpha(_connection, wid, alpha);
 }
 
-static void do_window_alpha_fade(const char *message)
+static void do_window_list_alpha_fade(struct sa_command *commands, int count)
 {
-    Token wid_token = get_token(&message);
-    uint32_t wid = token_to_uint32t(wid_token);
-    if (!wid) return;
+    int window_count = 0;
+    uint32_t window_list[count];
+
+    for (int i = 0; i < count; ++i) {
+        if (commands[i].window_alpha.wid) {
+            window_list[window_count++] = commands[i].window_alpha.wid;
+        }
+    }
 
-    Token alpha_token = get_token(&message);
-    float alpha = token_to_float(alpha_token);
-    Token duration_token = get_token(&message);
-    float duration = token_to_float(duration_token);
-    CGSSetWindowListAlpha(_connection, &wid, 1, alpha, duration);
+    if (window_count) {
+        CGSSetWindowListAlpha(_connection, window_list, window_count, commands[0].window_alpha.alpha, commands[0].window_alpha.duration);
+    }
 }
 
-static void do_window_level(const char *message)
+static void do_window_level(uint32_t wid, int key)
 {
-    Token wid_token = get_token(&message);
-    uint32_t wid = token_to_uint32t(wid_token);
     if (!wid) return;
-
-    Token key_token = get_token(&message);
-    int key = token_to_int(key_token);
     CGSSetWindowLevel(_connection, wid, CGWindowLevelForKey(key));
 }
 
-static void do_window_sticky(const char *message)
+static void do_window_sticky(uint32_t wid, int value)
 {
-    Token wid_token = get_token(&message);
-    uint32_t wid = token_to_uint32t(wid_token);
     if (!wid) return;
 
-    Token value_token = get_token(&message);
-    int value = token_to_int(value_token);
     int tags[2] = { kCGSOnAllWorkspacesTagBit, 0 };
     if (value == 1) {
         CGSSetWindowTags(_connection, wid, tags, 32);
@@ -828,28 +716,21 @@ static void do_window_sticky(const char *message)
 }
 
 typedef void (*focus_window_call)(ProcessSerialNumber psn, uint32_t wid);
-static void do_window_focus(const char *message)
+static void do_window_focus(uint32_t window_id)
 {
     int window_connection;
     ProcessSerialNumber window_psn;
 
-    Token wid_token = get_token(&message);
-    uint32_t window_id = token_to_uint32t(wid_token);
-
     CGSGetWindowOwner(_connection, window_id, &window_connection);
     CGSGetConnectionPSN(window_connection, &window_psn);
 
     ((focus_window_call) set_front_window_fp)(window_psn, window_id);
 }
 
-static void do_window_shadow(const char *message)
+static void do_window_shadow(uint32_t wid, int value)
 {
-    Token wid_token = get_token(&message);
-    uint32_t wid = token_to_uint32t(wid_token);
     if (!wid) return;
 
-    Token value_token = get_token(&message);
-    int value = token_to_int(value_token);
     int tags[2] = { kCGSNoShadowTagBit,  0};
     if (value == 1) {
         CGSClearWindowTags(_connection, wid, tags, 32);
@@ -859,29 +740,17 @@ static void do_window_shadow(const char *message)
     CGSInvalidateWindowShadow(_connection, wid);
 }
 
-static void do_window_group_add(const char *message)
+static void do_window_group_add(uint32_t parent, uint32_t child)
 {
-    Token parent_token = get_token(&message);
-    uint32_t parent = token_to_uint32t(parent_token);
-    if (!parent) return;
-
-    Token child_token = get_token(&message);
-    uint32_t child = token_to_uint32t(child_token);
-    if (!child) return;
+    if (!parent || !child) return;
 
     CGSAddWindowToWindowMovementGroup(_connection, parent, child);
     CGSAddWindowToWindowOrderingGroup(_connection, parent, child, 1);
 }
 
-static void do_window_group_remove(const char *message)
+static void do_window_group_remove(uint32_t parent, uint32_t child)
 {
-    Token parent_token = get_token(&message);
-    uint32_t parent = token_to_uint32t(parent_token);
-    if (!parent) return;
-
-    Token child_token = get_token(&message);
-    uint32_t child = token_to_uint32t(child_token);
-    if (!child) return;
+    if (!parent || !child) return;
 
     CGSRemoveWindowFromWindowMovementGroup(_connection, parent, child);
     CGSRemoveFromOrderingGroup(_connection, child);
@@ -912,7 +781,42 @@ static inline bool can_focus_window()
     return set_front_window_fp != 0;
 }
 
-static void do_handshake(int sockfd)
+static bool recv_bytes(int sockfd, void *buffer, size_t size)
+{
+    char *cursor = buffer;
+
+    while (size > 0) {
+        ssize_t len = recv(sockfd, cursor, size, 0);
+        if (len <= 0) return false;
+
+        cursor += len;
+        size -= len;
+    }
+
+    return true;
+}
+
+static bool send_frame(int sockfd, const char *bytes, uint32_t length)
+{
+    char frame[sizeof(uint32_t) + length];
+    memcpy(frame, &length, sizeof(uint32_t));
+    memcpy(frame + sizeof(uint32_t), bytes, length);
+
+    char *cursor = frame;
+    size_t size = sizeof(frame);
+
+    while (size > 0) {
+        ssize_t len = send(sockfd, cursor, size, 0);
+        if (len <= 0) return false;
+
+        cursor += len;
+        size -= len;
+    }
+
+    return true;
+}
+
+static void do_handshake(int sockfd, uint16_t version)
 {
     uint32_t attrib = 0;
 
@@ -923,20 +827,18 @@ static void do_handshake(int sockfd)
     if (move_space_fp)                     attrib |= OSAX_ATTRIB_MOV_SPACE;
     if (set_front_window_fp)               attrib |= OSAX_ATTRIB_SET_WINDOW;
 
-    char bytes[BUFSIZ] = {};
-    int version_length = strlen(OSAX_VERSION);
-    int attrib_length = sizeof(uint32_t);
-    int bytes_length = version_length + 1 + attrib_length;
+    struct sa_buffer buffer;
+    sa_buffer_init(&buffer);
 
-    memcpy(bytes, OSAX_VERSION, version_length);
-    memcpy(bytes + version_length + 1, &attrib, attrib_length);
-    bytes[version_length] = '\0';
-    bytes[bytes_length] = '\n';
+    for (const char *at = OSAX_VERSION; *at; ++at) sa_put_u8(&buffer, *at);
+    sa_put_u8(&buffer, '\0');
+    sa_put_u32(&buffer, attrib);
+    sa_put_u16(&buffer, version < SA_PROTOCOL_VERSION ? version : SA_PROTOCOL_VERSION);
 
-    send(sockfd, bytes, bytes_length+1, 0);
+    send_frame(sockfd, (const char *) buffer.data, buffer.length);
 }
 
-static void handle_message(int sockfd, const char *message)
+static void handle_command(struct sa_command *command)
 {
     /*
      * NOTE(koekeishiya): interaction is supposed to happen through an
@@ -944,68 +846,146 @@ static void handle_message(int sockfd, const char *message)
      * validation, as the program in question should do this.
      */
 
-    Token token = get_token(&message);
-    if (token_equals(token, "handshake")) {
-        do_handshake(sockfd);
-    } else if (token_equals(token, "space")) {
-        if (!can_focus_space()) return;
-        do_space_change(message);
-    } else if (token_equals(token, "space_create")) {
-        if (!can_create_space()) return;
-        do_space_create(message);
-    } else if (token_equals(token, "space_destroy")) {
-        if (!can_destroy_space()) return;
-        do_space_destroy(message);
-    } else if (token_equals(token, "space_move")) {
-        if (!can_move_space()) return;
-        do_space_move(message);
-    } else if (token_equals(token, "window_scale")) {
-        do_window_scale(message);
-    } else if (token_equals(token, "window_move")) {
-        do_window_move(message);
-    } else if (token_equals(token, "window_alpha")) {
-        do_window_alpha(message);
-    } else if (token_equals(token, "window_alpha_fade")) {
-        do_window_alpha_fade(message);
-    } else if (token_equals(token, "window_level")) {
-        do_window_level(message);
-    } else if (token_equals(token, "window_sticky")) {
-        do_window_sticky(message);
-    } else if (token_equals(token, "window_focus")) {
-        if (!can_focus_window()) return;
-        do_window_focus(message);
-    } else if (token_equals(token, "window_shadow")) {
-        do_window_shadow(message);
-    } else if (token_equals(token, "window_group_add")) {
-        do_window_group_add(message);
-    } else if (token_equals(token, "window_group_remove")) {
-        do_window_group_remove(message);
+    switch (command->op) {
+    case SA_OP_SPACE_FOCUS: {
+        if (can_focus_space()) do_space_change(command->space.sid);
+    } break;
+    case SA_OP_SPACE_CREATE: {
+        if (can_create_space()) do_space_create(command->space.sid);
+    } break;
+    case SA_OP_SPACE_DESTROY: {
+        if (can_destroy_space()) do_space_destroy(command->space.sid);
+    } break;
+    case SA_OP_SPACE_MOVE: {
+        if (can_move_space()) do_space_move(command->space_move.src_sid, command->space_move.dst_sid, command->space_move.focus);
+    } break;
+    case SA_OP_WINDOW_SCALE: {
+        do_window_scale(command->window_scale.wid, command->window_scale.x, command->window_scale.y, command->window_scale.w, command->window_scale.h);
+    } break;
+    case SA_OP_WINDOW_ALPHA: {
+        do_window_alpha(command->window_alpha.wid, command->window_alpha.alpha);
+    } break;
+    case SA_OP_WINDOW_LEVEL: {
+        do_window_level(command->window_level.wid, command->window_level.key);
+    } break;
+    case SA_OP_WINDOW_STICKY: {
+        do_window_sticky(command->window_flag.wid, command->window_flag.value);
+    } break;
+    case SA_OP_WINDOW_FOCUS: {
+        if (can_focus_window()) do_window_focus(command->window.wid);
+    } break;
+    case SA_OP_WINDOW_SHADOW: {
+        do_window_shadow(command->window_flag.wid, command->window_flag.value);
+    } break;
+    case SA_OP_WINDOW_GROUP_ADD: {
+        do_window_group_add(command->window_group.parent_wid, command->window_group.child_wid);
+    } break;
+    case SA_OP_WINDOW_GROUP_REMOVE: {
+        do_window_group_remove(command->window_group.parent_wid, command->window_group.child_wid);
+    } break;
     }
 }
 
-static bool recv_socket(int sockfd, char *message, size_t message_size)
+static inline bool can_merge_command(struct sa_command *a, struct sa_command *b)
 {
-    int len = recv(sockfd, message, message_size, 0);
-    if (len > 0) {
-        message[len] = '\0';
-        return true;
+    if (a->op != b->op) return false;
+
+    switch (a->op) {
+    case SA_OP_WINDOW_MOVE:       return true;
+    case SA_OP_WINDOW_ALPHA_FADE: return a->window_alpha.alpha == b->window_alpha.alpha &&
+                                         a->window_alpha.duration == b->window_alpha.duration;
     }
+
     return false;
 }
 
-static void *handle_connection(void *unused)
+//
+// NOTE(koekeishiya): Commands are applied in the order they were sent, but a run of window moves,
+// or of opacity changes to the same value, is applied using a single call for the list of windows.
+//
+
+static void handle_message(int sockfd, const uint8_t *bytes, uint32_t length)
+{
+    int count = 0;
+    struct sa_reader reader;
+    struct sa_command commands[SA_MAX_COMMAND_COUNT];
+
+    sa_reader_init(&reader, bytes, length);
+
+    while (count < SA_MAX_COMMAND_COUNT && sa_decode_command(&reader, &commands[count])) {
+        if (commands[count].op == SA_OP_HANDSHAKE) {
+            do_handshake(sockfd, commands[count].handshake.version);
+            return;
+        }
+
+        ++count;
+    }
+
+    for (int i = 0, j = 0; i < count; i = j) {
+        for (j = i + 1; j < count && can_merge_command(&commands[i], &commands[j]); ++j);
+
+        switch (commands[i].op) {
+        case SA_OP_WINDOW_MOVE: {
+            do_window_list_move(commands + i, j - i);
+        } break;
+        case SA_OP_WINDOW_ALPHA_FADE: {
+            do_window_list_alpha_fade(commands + i, j - i);
+        } break;
+        default: {
+            for (int k = i; k < j; ++k) handle_command(&commands[k]);
+        } break;
+        }
+    }
+
+    send_frame(sockfd, NULL, 0);
+}
+
+//
+// NOTE(koekeishiya): yabai keeps its connection open and sends length-prefixed frames, each
+// holding one or more commands. Every frame is answered by exactly one response frame, in the
+// order the frames were received. Each connection is served by its own thread, so that a
+// short-lived client (yabai --load-sa) is not blocked by the running instance, while commands
+// from different connections are still applied one at a time.
+//
+
+static void *handle_connection(void *context)
+{
+    int sockfd = (int)(intptr_t) context;
+
+    uint32_t length;
+    uint8_t message[SA_MAX_FRAME_SIZE];
+
+    while (recv_bytes(sockfd, &length, sizeof(uint32_t))) {
+        if (length > sizeof(message)) break;
+        if (!recv_bytes(sockfd, message, length)) break;
+
+        pthread_mutex_lock(&message_lock);
+        handle_message(sockfd, message, length);
+        pthread_mutex_unlock(&message_lock);
+    }
+
+    shutdown(sockfd, SHUT_RDWR);
+    close(sockfd);
+
+    return NULL;
+}
+
+static void *handle_daemon(void *unused)
 {
     while (1) {
         int sockfd = accept(daemon_sockfd, NULL, 0);
         if (sockfd == -1) continue;
 
-        char message[BUF_SIZE];
-        if (recv_socket(sockfd, message, sizeof(message))) {
-            handle_message(sockfd, message);
-        }
+        int set = 1;
+        setsockopt(sockfd, SOL_SOCKET, SO_NOSIGPIPE, (void *) &set, sizeof(int));
 
-        shutdown(sockfd, SHUT_RDWR);
-        close(sockfd);
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, &handle_connection, (void *)(intptr_t) sockfd) == 0) {
+            pthread_detach(thread);
+        } else {
+            shutdown(sockfd, SHUT_RDWR);
+            close(sockfd);
+        }
     }
 
     return NULL;
@@ -1034,7 +1014,7 @@ static bool start_daemon(char *socket_path)
         return false;
     }
 
-    pthread_create(&daemon_thread, NULL, &handle_connection, NULL);
+    pthread_create(&daemon_thread, NULL, &handle_daemon, NULL);
     return true;
 }
 
@@ -0,0 +1,303 @@
+#ifndef SA_PROTOCOL_H
+#define SA_PROTOCOL_H
+
+//
+// NOTE(koekeishiya): Binary protocol spoken between yabai and the scripting-addition payload.
+// Every frame (see socket_write_frame) carries one or more commands, each made up of a one byte
+// opcode followed by its arguments, packed without padding in little-endian byte order. The size
+// of every command is determined by its opcode, so a frame is simply decoded until it is empty.
+// The payload answers every frame with exactly one frame; empty unless the frame was a handshake.
+//
+// The first frame sent on a connection is a handshake carrying the protocol version of yabai.
+// The payload replies with its version string, the attributes it supports and the protocol
+// version that both sides are going to use, which is the lowest of the two.
+//
+
+#define SA_PROTOCOL_VERSION  1
+#define SA_MAX_FRAME_SIZE    4096
+#define SA_MIN_COMMAND_SIZE  5
+#define SA_MAX_COMMAND_COUNT (SA_MAX_FRAME_SIZE / SA_MIN_COMMAND_SIZE)
+
+enum sa_opcode
+{
+    SA_OP_INVALID,
+
+    SA_OP_HANDSHAKE,
+    SA_OP_SPACE_FOCUS,
+    SA_OP_SPACE_CREATE,
+    SA_OP_SPACE_DESTROY,
+    SA_OP_SPACE_MOVE,
+    SA_OP_WINDOW_SCALE,
+    SA_OP_WINDOW_MOVE,
+    SA_OP_WINDOW_ALPHA,
+    SA_OP_WINDOW_ALPHA_FADE,
+    SA_OP_WINDOW_LEVEL,
+    SA_OP_WINDOW_STICKY,
+    SA_OP_WINDOW_FOCUS,
+    SA_OP_WINDOW_SHADOW,
+    SA_OP_WINDOW_GROUP_ADD,
+    SA_OP_WINDOW_GROUP_REMOVE,
+
+    SA_OP_COUNT
+};
+
+struct sa_command
+{
+    uint8_t op;
+    union {
+        struct { uint16_t version; } handshake;
+        struct { uint64_t sid; } space;
+        struct { uint64_t src_sid; uint64_t dst_sid; uint8_t focus; } space_move;
+        struct { uint32_t wid; float x; float y; float w; float h; } window_scale;
+        struct { uint32_t wid; int32_t x; int32_t y; } window_move;
+        struct { uint32_t wid; float alpha; float duration; } window_alpha;
+        struct { uint32_t wid; int32_t key; } window_level;
+        struct { uint32_t wid; uint8_t value; } window_flag;
+        struct { uint32_t wid; } window;
+        struct { uint32_t parent_wid; uint32_t child_wid; } window_group;
+    };
+};
+
+struct sa_buffer
+{
+    uint32_t length;
+    uint8_t data[SA_MAX_FRAME_SIZE];
+};
+
+struct sa_reader
+{
+    const uint8_t *cursor;
+    const uint8_t *end;
+};
+
+static inline void sa_buffer_init(struct sa_buffer *buffer)
+{
+    buffer->length = 0;
+}
+
+static inline bool sa_put_bytes(struct sa_buffer *buffer, uint64_t value, int size)
+{
+    if (buffer->length + size > SA_MAX_FRAME_SIZE) return false;
+
+    for (int i = 0; i < size; ++i) {
+        buffer->data[buffer->length++] = (uint8_t)(value >> (8 * i));
+    }
+
+    return true;
+}
+
+static inline bool sa_put_u8(struct sa_buffer *buffer, uint8_t value)   { return sa_put_bytes(buffer, value, sizeof(uint8_t)); }
+static inline bool sa_put_u16(struct sa_buffer *buffer, uint16_t value) { return sa_put_bytes(buffer, value, sizeof(uint16_t)); }
+static inline bool sa_put_u32(struct sa_buffer *buffer, uint32_t value) { return sa_put_bytes(buffer, value, sizeof(uint32_t)); }
+static inline bool sa_put_u64(struct sa_buffer *buffer, uint64_t value) { return sa_put_bytes(buffer, value, sizeof(uint64_t)); }
+static inline bool sa_put_i32(struct sa_buffer *buffer, int32_t value)  { return sa_put_bytes(buffer, (uint32_t) value, sizeof(uint32_t)); }
+
+static inline bool sa_put_f32(struct sa_buffer *buffer, float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(uint32_t));
+    return sa_put_bytes(buffer, bits, sizeof(uint32_t));
+}
+
+static inline int sa_command_size(uint8_t op)
+{
+    switch (op) {
+    case SA_OP_HANDSHAKE:           return 1 + 2;
+    case SA_OP_SPACE_FOCUS:         return 1 + 8;
+    case SA_OP_SPACE_CREATE:        return 1 + 8;
+    case SA_OP_SPACE_DESTROY:       return 1 + 8;
+    case SA_OP_SPACE_MOVE:          return 1 + 8 + 8 + 1;
+    case SA_OP_WINDOW_SCALE:        return 1 + 4 + 4 + 4 + 4 + 4;
+    case SA_OP_WINDOW_MOVE:         return 1 + 4 + 4 + 4;
+    case SA_OP_WINDOW_ALPHA:        return 1 + 4 + 4;
+    case SA_OP_WINDOW_ALPHA_FADE:   return 1 + 4 + 4 + 4;
+    case SA_OP_WINDOW_LEVEL:        return 1 + 4 + 4;
+    case SA_OP_WINDOW_STICKY:       return 1 + 4 + 1;
+    case SA_OP_WINDOW_FOCUS:        return 1 + 4;
+    case SA_OP_WINDOW_SHADOW:       return 1 + 4 + 1;
+    case SA_OP_WINDOW_GROUP_ADD:    return 1 + 4 + 4;
+    case SA_OP_WINDOW_GROUP_REMOVE: return 1 + 4 + 4;
+    }
+
+    return 0;
+}
+
+//
+// NOTE(koekeishiya): Encoding a command either appends all of it to the buffer, or nothing at all
+// if it would not fit, in which case the caller is expected to send the buffer and start over.
+//
+
+static inline bool sa_encode_command(struct sa_buffer *buffer, struct sa_command *command)
+{
+    int size = sa_command_size(command->op);
+    if (!size || buffer->length + size > SA_MAX_FRAME_SIZE) return false;
+
+    sa_put_u8(buffer, command->op);
+
+    switch (command->op) {
+    case SA_OP_HANDSHAKE: {
+        sa_put_u16(buffer, command->handshake.version);
+    } break;
+    case SA_OP_SPACE_FOCUS:
+    case SA_OP_SPACE_CREATE:
+    case SA_OP_SPACE_DESTROY: {
+        sa_put_u64(buffer, command->space.sid);
+    } break;
+    case SA_OP_SPACE_MOVE: {
+        sa_put_u64(buffer, command->space_move.src_sid);
+        sa_put_u64(buffer, command->space_move.dst_sid);
+        sa_put_u8(buffer, command->space_move.focus);
+    } break;
+    case SA_OP_WINDOW_SCALE: {
+        sa_put_u32(buffer, command->window_scale.wid);
+        sa_put_f32(buffer, command->window_scale.x);
+        sa_put_f32(buffer, command->window_scale.y);
+        sa_put_f32(buffer, command->window_scale.w);
+        sa_put_f32(buffer, command->window_scale.h);
+    } break;
+    case SA_OP_WINDOW_MOVE: {
+        sa_put_u32(buffer, command->window_move.wid);
+        sa_put_i32(buffer, command->window_move.x);
+        sa_put_i32(buffer, command->window_move.y);
+    } break;
+    case SA_OP_WINDOW_ALPHA: {
+        sa_put_u32(buffer, command->window_alpha.wid);
+        sa_put_f32(buffer, command->window_alpha.alpha);
+    } break;
+    case SA_OP_WINDOW_ALPHA_FADE: {
+        sa_put_u32(buffer, command->window_alpha.wid);
+        sa_put_f32(buffer, command->window_alpha.alpha);
+        sa_put_f32(buffer, command->window_alpha.duration);
+    } break;
+    case SA_OP_WINDOW_LEVEL: {
+        sa_put_u32(buffer, command->window_level.wid);
+        sa_put_i32(buffer, command->window_level.key);
+    } break;
+    case SA_OP_WINDOW_STICKY:
+    case SA_OP_WINDOW_SHADOW: {
+        sa_put_u32(buffer, command->window_flag.wid);
+        sa_put_u8(buffer, command->window_flag.value);
+    } break;
+    case SA_OP_WINDOW_FOCUS: {
+        sa_put_u32(buffer, command->window.wid);
+    } break;
+    case SA_OP_WINDOW_GROUP_ADD:
+    case SA_OP_WINDOW_GROUP_REMOVE: {
+        sa_put_u32(buffer, command->window_group.parent_wid);
+        sa_put_u32(buffer, command->window_group.child_wid);
+    } break;
+    }
+
+    return true;
+}
+
+static inline void sa_reader_init(struct sa_reader *reader, const void *bytes, uint32_t length)
+{
+    reader->cursor = bytes;
+    reader->end = reader->cursor + length;
+}
+
+static inline bool sa_reader_is_empty(struct sa_reader *reader)
+{
+    return reader->cursor >= reader->end;
+}
+
+static inline uint64_t sa_get_bytes(struct sa_reader *reader, int size)
+{
+    uint64_t value = 0;
+
+    for (int i = 0; i < size; ++i) {
+        value |= (uint64_t) reader->cursor[i] << (8 * i);
+    }
+
+    reader->cursor += size;
+    return value;
+}
+
+static inline uint8_t sa_get_u8(struct sa_reader *reader)   { return (uint8_t) sa_get_bytes(reader, sizeof(uint8_t)); }
+static inline uint16_t sa_get_u16(struct sa_reader *reader) { return (uint16_t) sa_get_bytes(reader, sizeof(uint16_t)); }
+static inline uint32_t sa_get_u32(struct sa_reader *reader) { return (uint32_t) sa_get_bytes(reader, sizeof(uint32_t)); }
+static inline uint64_t sa_get_u64(struct sa_reader *reader) { return sa_get_bytes(reader, sizeof(uint64_t)); }
+static inline int32_t sa_get_i32(struct sa_reader *reader)  { return (int32_t) sa_get_u32(reader); }
+
+static inline float sa_get_f32(struct sa_reader *reader)
+{
+    float value;
+    uint32_t bits = sa_get_u32(reader);
+    memcpy(&value, &bits, sizeof(float));
+    return value;
+}
+
+//
+// NOTE(koekeishiya): Decoding fails on an unknown opcode or a truncated command. Because the
+// size of a command is implied by its opcode, the rest of the frame can not be trusted anymore.
+//
+
+static inline bool sa_decode_command(struct sa_reader *reader, struct sa_command *command)
+{
+    if (sa_reader_is_empty(reader)) return false;
+
+    int size = sa_command_size(reader->cursor[0]);
+    if (!size || reader->end - reader->cursor < size) return false;
+
+    memset(command, 0, sizeof(struct sa_command));
+    command->op = sa_get_u8(reader);
+
+    switch (command->op) {
+    case SA_OP_HANDSHAKE: {
+        command->handshake.version = sa_get_u16(reader);
+    } break;
+    case SA_OP_SPACE_FOCUS:
+    case SA_OP_SPACE_CREATE:
+    case SA_OP_SPACE_DESTROY: {
+        command->space.sid = sa_get_u64(reader);
+    } break;
+    case SA_OP_SPACE_MOVE: {
+        command->space_move.src_sid = sa_get_u64(reader);
+        command->space_move.dst_sid = sa_get_u64(reader);
+        command->space_move.focus = sa_get_u8(reader);
+    } break;
+    case SA_OP_WINDOW_SCALE: {
+        command->window_scale.wid = sa_get_u32(reader);
+        command->window_scale.x = sa_get_f32(reader);
+        command->window_scale.y = sa_get_f32(reader);
+        command->window_scale.w = sa_get_f32(reader);
+        command->window_scale.h = sa_get_f32(reader);
+    } break;
+    case SA_OP_WINDOW_MOVE: {
+        command->window_move.wid = sa_get_u32(reader);
+        command->window_move.x = sa_get_i32(reader);
+        command->window_move.y = sa_get_i32(reader);
+    } break;
+    case SA_OP_WINDOW_ALPHA: {
+        command->window_alpha.wid = sa_get_u32(reader);
+        command->window_alpha.alpha = sa_get_f32(reader);
+    } break;
+    case SA_OP_WINDOW_ALPHA_FADE: {
+        command->window_alpha.wid = sa_get_u32(reader);
+        command->window_alpha.alpha = sa_get_f32(reader);
+        command->window_alpha.duration = sa_get_f32(reader);
+    } break;
+    case SA_OP_WINDOW_LEVEL: {
+        command->window_level.wid = sa_get_u32(reader);
+        command->window_level.key = sa_get_i32(reader);
+    } break;
+    case SA_OP_WINDOW_STICKY:
+    case SA_OP_WINDOW_SHADOW: {
+        command->window_flag.wid = sa_get_u32(reader);
+        command->window_flag.value = sa_get_u8(reader);
+    } break;
+    case SA_OP_WINDOW_FOCUS: {
+        command->window.wid = sa_get_u32(reader);
+    } break;
+    case SA_OP_WINDOW_GROUP_ADD:
+    case SA_OP_WINDOW_GROUP_REMOVE: {
+        command->window_group.parent_wid = sa_get_u32(reader);
+        command->window_group.child_wid = sa_get_u32(reader);
+    } break;
+    }
+
+    return true;
+}
+
+#endif
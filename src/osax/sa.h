@@ -3,6 +3,7 @@
 
 #include <pwd.h>
 #include "common.h"
+#include "protocol.h"
 
 #define PAYLOAD_STATUS_SUCCESS   0
 #define PAYLOAD_STATUS_OUTDATED  1
@@ -15,6 +16,9 @@ bool scripting_addition_is_installed(void);
 int scripting_addition_uninstall(void);
 int scripting_addition_install(void);
 
+void scripting_addition_begin_batch(void);
+void scripting_addition_end_batch(void);
+
 bool scripting_addition_create_space(uint64_t sid);
 bool scripting_addition_destroy_space(uint64_t sid);
 bool scripting_addition_focus_space(uint64_t sid);
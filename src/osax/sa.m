@@ -178,38 +178,6 @@ static void scripting_addition_prepare_binaries(void)
     system(cmd);
 }
 
-static bool scripting_addition_request_handshake(char *version, uint32_t *attrib)
-{
-    bool result = false;
-
-    int sockfd;
-    char message[MAXLEN];
-
-    if (socket_connect_un(&sockfd, g_sa_socket_file)) {
-        snprintf(message, sizeof(message), "handshake");
-        if (socket_write(sockfd, message)) {
-            result = true;
-
-            int length;
-            char *rsp = socket_read(sockfd, &length);
-            if (!rsp) goto out;
-
-            char *zero = rsp;
-            while (*zero != '\0') ++zero;
-
-            assert(*zero == '\0');
-            memcpy(version, rsp, zero - rsp + 1);
-            memcpy(attrib, zero+1, sizeof(uint32_t));
-
-            free(rsp);
-        }
-    }
-
-out:
-    socket_close(sockfd);
-    return result;
-}
-
 static int scripting_addition_perform_validation(bool loaded)
 {
     uint32_t attrib = 0;
@@ -220,10 +188,10 @@ static int scripting_addition_perform_validation(bool loaded)
         return PAYLOAD_STATUS_CON_ERROR;
     }
 
-    debug("yabai: osax version = %s, osax attrib = 0x%X\n", version, attrib);
+    debug("yabai: osax version = %s, osax attrib = 0x%X, protocol version = %d\n", version, attrib, sa_protocol_version);
     bool is_latest_version_installed = scripting_addition_check() == 0;
 
-    if (!string_equals(version, OSAX_VERSION)) {
+    if (!string_equals(version, OSAX_VERSION) || sa_protocol_version != SA_PROTOCOL_VERSION) {
         if (loaded && is_latest_version_installed) {
             notify("scripting-addition", "payload is outdated, restart Dock.app!");
         } else {
@@ -489,211 +457,3 @@ int scripting_addition_load(void)
     }
     }
 }
-
-bool scripting_addition_create_space(uint64_t sid)
-{
-    int sockfd;
-    char message[MAXLEN];
-
-    bool result = socket_connect_un(&sockfd, g_sa_socket_file);
-    if (result) {
-        snprintf(message, sizeof(message), "space_create %lld", sid);
-        socket_write(sockfd, message);
-        socket_wait(sockfd);
-    }
-
-    socket_close(sockfd);
-    return result;
-}
-
-bool scripting_addition_destroy_space(uint64_t sid)
-{
-    int sockfd;
-    char message[MAXLEN];
-
-    bool result = socket_connect_un(&sockfd, g_sa_socket_file);
-    if (result) {
-        snprintf(message, sizeof(message), "space_destroy %lld", sid);
-        socket_write(sockfd, message);
-        socket_wait(sockfd);
-    }
-
-    socket_close(sockfd);
-    return result;
-}
-
-bool scripting_addition_focus_space(uint64_t sid)
-{
-    int sockfd;
-    char message[MAXLEN];
-
-    bool result = socket_connect_un(&sockfd, g_sa_socket_file);
-    if (result) {
-        snprintf(message, sizeof(message), "space %lld", sid);
-        socket_write(sockfd, message);
-        socket_wait(sockfd);
-    }
-
-    socket_close(sockfd);
-    return result;
-}
-
-bool scripting_addition_move_space_after_space(uint64_t src_sid, uint64_t dst_sid, bool focus)
-{
-    int sockfd;
-    char message[MAXLEN];
-
-    bool result = socket_connect_un(&sockfd, g_sa_socket_file);
-    if (result) {
-        snprintf(message, sizeof(message), "space_move %lld %lld %d", src_sid, dst_sid, focus);
-        socket_write(sockfd, message);
-        socket_wait(sockfd);
-    }
-
-    socket_close(sockfd);
-    return result;
-}
-
-bool scripting_addition_add_to_window_group(uint32_t child_wid, uint32_t parent_wid)
-{
-    int sockfd;
-    char message[MAXLEN];
-
-    bool result = socket_connect_un(&sockfd, g_sa_socket_file);
-    if (result) {
-        snprintf(message, sizeof(message), "window_group_add %d %d", parent_wid, child_wid);
-        socket_write(sockfd, message);
-        socket_wait(sockfd);
-    }
-
-    socket_close(sockfd);
-    return result;
-}
-
-bool scripting_addition_remove_from_window_group(uint32_t child_wid, uint32_t parent_wid)
-{
-    int sockfd;
-    char message[MAXLEN];
-
-    bool result = socket_connect_un(&sockfd, g_sa_socket_file);
-    if (result) {
-        snprintf(message, sizeof(message), "window_group_remove %d %d", parent_wid, child_wid);
-        socket_write(sockfd, message);
-        socket_wait(sockfd);
-    }
-
-    socket_close(sockfd);
-    return result;
-}
-
-bool scripting_addition_move_window(uint32_t wid, int x, int y)
-{
-    int sockfd;
-    char message[MAXLEN];
-
-    bool result = socket_connect_un(&sockfd, g_sa_socket_file);
-    if (result) {
-        snprintf(message, sizeof(message), "window_move %d %d %d", wid, x, y);
-        socket_write(sockfd, message);
-        socket_wait(sockfd);
-    }
-
-    socket_close(sockfd);
-    return result;
-}
-
-bool scripting_addition_set_opacity(uint32_t wid, float opacity, float duration)
-{
-    int sockfd;
-    char message[MAXLEN];
-
-    bool result = socket_connect_un(&sockfd, g_sa_socket_file);
-    if (result) {
-        snprintf(message, sizeof(message), "window_alpha_fade %d %f %f", wid, opacity, duration);
-        socket_write(sockfd, message);
-        socket_wait(sockfd);
-    }
-
-    socket_close(sockfd);
-    return result;
-}
-
-bool scripting_addition_set_layer(uint32_t wid, int layer)
-{
-    int sockfd;
-    char message[MAXLEN];
-
-    bool result = socket_connect_un(&sockfd, g_sa_socket_file);
-    if (result) {
-        snprintf(message, sizeof(message), "window_level %d %d", wid, layer);
-        socket_write(sockfd, message);
-        socket_wait(sockfd);
-    }
-
-    socket_close(sockfd);
-    return result;
-}
-
-bool scripting_addition_set_sticky(uint32_t wid, bool sticky)
-{
-    int sockfd;
-    char message[MAXLEN];
-
-    bool result = socket_connect_un(&sockfd, g_sa_socket_file);
-    if (result) {
-        snprintf(message, sizeof(message), "window_sticky %d %d", wid, sticky);
-        socket_write(sockfd, message);
-        socket_wait(sockfd);
-    }
-
-    socket_close(sockfd);
-    return result;
-}
-
-bool scripting_addition_set_shadow(uint32_t wid, bool shadow)
-{
-    int sockfd;
-    char message[MAXLEN];
-
-    bool result = socket_connect_un(&sockfd, g_sa_socket_file);
-    if (result) {
-        snprintf(message, sizeof(message), "window_shadow %d %d", wid, shadow);
-        socket_write(sockfd, message);
-        socket_wait(sockfd);
-    }
-
-    socket_close(sockfd);
-    return result;
-}
-
-bool scripting_addition_focus_window(uint32_t wid)
-{
-    int sockfd;
-    char message[MAXLEN];
-
-    bool result = socket_connect_un(&sockfd, g_sa_socket_file);
-    if (result) {
-        snprintf(message, sizeof(message), "window_focus %d", wid);
-        socket_write(sockfd, message);
-        socket_wait(sockfd);
-    }
-
-    socket_close(sockfd);
-    return result;
-}
-
-bool scripting_addition_scale_window(uint32_t wid, float x, float y, float w, float h)
-{
-    int sockfd;
-    char message[MAXLEN];
-
-    bool result = socket_connect_un(&sockfd, g_sa_socket_file);
-    if (result) {
-        snprintf(message, sizeof(message), "window_scale %d %f %f %f %f", wid, x, y, w, h);
-        socket_write(sockfd, message);
-        socket_wait(sockfd);
-    }
-
-    socket_close(sockfd);
-    return result;
-}
@@ -3,16 +3,6 @@
 extern struct event_loop g_event_loop;
 extern void *g_workspace_context;
 
-static TABLE_HASH_FUNC(hash_psn)
-{
-    return ((ProcessSerialNumber *) key)->lowLongOfPSN;
-}
-
-static TABLE_COMPARE_FUNC(compare_psn)
-{
-    return psn_equals(key_a, key_b);
-}
-
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wdeprecated-declarations"
 struct process *process_create(ProcessSerialNumber psn)
@@ -147,17 +137,17 @@ process_manager_add_running_processes(struct process_manager *pm)
 
 struct process *process_manager_find_process(struct process_manager *pm, ProcessSerialNumber *psn)
 {
-    return table_find(&pm->process, psn);
+    return psn_table_find(&pm->process, *psn);
 }
 
 void process_manager_remove_process(struct process_manager *pm, ProcessSerialNumber *psn)
 {
-    table_remove(&pm->process, psn);
+    psn_table_remove(&pm->process, *psn);
 }
 
 void process_manager_add_process(struct process_manager *pm, struct process *process)
 {
-    table_add(&pm->process, &process->psn, process);
+    psn_table_add(&pm->process, process->psn, process);
 }
 
 #if 0
@@ -193,7 +183,7 @@ void process_manager_init(struct process_manager *pm)
     pm->type[1].eventKind  = kEventAppTerminated;
     pm->type[2].eventClass = kEventClassApplication;
     pm->type[2].eventKind  = kEventAppFrontSwitched;
-    table_init(&pm->process, 125, hash_psn, compare_psn);
+    psn_table_init(&pm->process, 125);
     process_manager_add_running_processes(pm);
 }
 
@@ -22,7 +22,7 @@ struct process
 
 struct process_manager
 {
-    struct table process;
+    psn_table process;
     EventTargetRef target;
     EventHandlerUPP handler;
     EventTypeSpec type[3];
@@ -3,55 +3,192 @@
 extern struct space_manager g_space_manager;
 extern struct window_manager g_window_manager;
 
-void rule_serialize(FILE *rsp, struct rule *rule, int index)
+void rule_serialize(struct json_writer *json, struct rule *rule, int index)
 {
-    fprintf(rsp,
-            "{\n"
-            "\t\"index\":%d,\n"
-            "\t\"label\":\"%s\",\n"
-            "\t\"app\":\"%s\",\n"
-            "\t\"title\":\"%s\",\n"
-            "\t\"display_id\":%d,\n"
-            "\t\"space_id\":%lld,\n"
-            "\t\"follow_space\":%d,\n"
-            "\t\"opacity\":%.4f,\n"
-            "\t\"manage\":%d,\n"
-            "\t\"sticky\":%d,\n"
-            "\t\"layer\":\"%s\",\n"
-            "\t\"border\":%d,\n"
-            "\t\"native-fullscreen\":%d,\n"
-            "\t\"grid\":\"%d:%d:%d:%d:%d:%d\"\n"
-            "}",
-            index,
-            rule->label ? rule->label : "",
-            rule->app ? rule->app : "",
-            rule->title ? rule->title : "",
-            rule->did,
-            rule->sid,
-            rule->follow_space,
-            rule->alpha,
-            rule_prop[rule->manage],
-            rule_prop[rule->sticky],
-            layer_str[rule->layer],
-            rule_prop[rule->border],
-            rule_prop[rule->fullscreen],
-            rule->grid[0], rule->grid[1],
-            rule->grid[2], rule->grid[3],
-            rule->grid[4], rule->grid[5]);
+    char grid[MAXLEN];
+    snprintf(grid, sizeof(grid), "%d:%d:%d:%d:%d:%d",
+             rule->grid[0], rule->grid[1],
+             rule->grid[2], rule->grid[3],
+             rule->grid[4], rule->grid[5]);
+
+    json_begin_object(json);
+    json_key(json, "index");             json_int(json, index);
+    json_key(json, "label");             json_string(json, rule->label);
+    json_key(json, "app");               json_string(json, rule->app);
+    json_key(json, "title");             json_string(json, rule->title);
+    json_key(json, "display_id");        json_int(json, rule->did);
+    json_key(json, "space_id");          json_int(json, rule->sid);
+    json_key(json, "follow_space");      json_int(json, rule->follow_space);
+    json_key(json, "opacity");           json_float(json, rule->alpha);
+    json_key(json, "manage");            json_int(json, rule_prop[rule->manage]);
+    json_key(json, "sticky");            json_int(json, rule_prop[rule->sticky]);
+    json_key(json, "layer");             json_string(json, layer_str[rule->layer]);
+    json_key(json, "border");            json_int(json, rule_prop[rule->border]);
+    json_key(json, "native-fullscreen"); json_int(json, rule_prop[rule->fullscreen]);
+    json_key(json, "grid");              json_string(json, grid);
+    json_key(json, "hits");              json_int(json, rule->hit_count);
+    json_key(json, "match_time");        json_int(json, rule->match_time / 1000);
+    json_end_object(json);
 }
 
-void rule_apply(struct rule *rule)
+//
+// NOTE(koekeishiya): Rules are tested against every window that is created, so the rule set is
+// compiled into an index that is rebuilt lazily after rules are added or removed. Rules that
+// require the app name to equal a literal (app="^Safari$") or to start with one (app="^Safari")
+// are stored in hash tables keyed by that literal, and only become candidates for a window if
+// the name of its application is found there. Every other rule is always a candidate. Candidates
+// are still matched in the order that the rules were added, and the window title is fetched at
+// most once, and only when a candidate with a title filter is reached. App and title patterns that
+// are not plain literals are combined into one automaton each (see pattern.h), which is run at most
+// once per window.
+//
+
+static struct rule_index rule_index;
+
+static inline uint64_t rule_time_ns(void)
 {
-    for (int window_index = 0; window_index < g_window_manager.window.capacity; ++window_index) {
-        struct bucket *bucket = g_window_manager.window.buckets[window_index];
-        while (bucket) {
-            if (bucket->value) {
-                struct window *window = bucket->value;
-                window_manager_apply_rule_to_window(&g_space_manager, &g_window_manager, window, rule);
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static inline bool rule_is_indexed(struct rule *rule)
+{
+    return rule->app_regex_valid && !rule->app_regex_exclude && (rule->app_literal_kind == REGEX_LITERAL_EXACT || rule->app_literal_kind == REGEX_LITERAL_PREFIX);
+}
+
+static void rule_index_add(literal_table *table, int index, uint64_t hash)
+{
+    void *head = literal_table_find(table, hash);
+
+    if (head) {
+        struct rule *collision = &g_window_manager.rules[(intptr_t) head - 1];
+        g_window_manager.rules[index].next = collision->next;
+        collision->next = index;
+    } else {
+        literal_table_add(table, hash, (void *)(intptr_t)(index + 1));
+    }
+}
+
+static void rule_index_build(void)
+{
+    int rule_count = buf_len(g_window_manager.rules);
+
+    literal_table_free(&rule_index.exact);
+    literal_table_free(&rule_index.prefix);
+    literal_table_init(&rule_index.exact, 16);
+    literal_table_init(&rule_index.prefix, 16);
+    buf_free(rule_index.prefix_length);
+    rule_index.prefix_length = NULL;
+    rule_index.is_candidate = realloc(rule_index.is_candidate, (rule_count + 1) * sizeof(bool));
+    pattern_set_free(&rule_index.app_patterns);
+    pattern_set_free(&rule_index.title_patterns);
+
+    for (int i = 0; i < rule_count; ++i) {
+        struct rule *rule = &g_window_manager.rules[i];
+        rule->next = -1;
+        rule->app_pattern   = rule->app_regex_valid   && rule->app_literal_kind   == REGEX_LITERAL_NONE ? pattern_set_add(&rule_index.app_patterns,   rule->app)   : -1;
+        rule->title_pattern = rule->title_regex_valid && rule->title_literal_kind == REGEX_LITERAL_NONE ? pattern_set_add(&rule_index.title_patterns, rule->title) : -1;
+
+        if (!rule_is_indexed(rule)) continue;
+
+        int length = strlen(rule->app_literal);
+        uint64_t hash = table_hash_string(rule->app_literal, length);
+
+        if (rule->app_literal_kind == REGEX_LITERAL_EXACT) {
+            rule_index_add(&rule_index.exact, i, hash);
+        } else {
+            bool has_length = false;
+            for (int j = 0; j < buf_len(rule_index.prefix_length); ++j) {
+                if (rule_index.prefix_length[j] == length) has_length = true;
+            }
+
+            if (!has_length) buf_push(rule_index.prefix_length, length);
+            rule_index_add(&rule_index.prefix, i, hash);
+        }
+    }
+
+    rule_index.is_built = true;
+}
+
+static void rule_index_mark(literal_table *table, char *app, int length)
+{
+    void *head = literal_table_find(table, table_hash_string(app, length));
+    for (int i = head ? (intptr_t) head - 1 : -1; i != -1; i = g_window_manager.rules[i].next) {
+        rule_index.is_candidate[i] = true;
+    }
+}
+
+bool *rule_find_candidates(struct rule_subject *subject)
+{
+    char *app = subject->app;
+    subject->is_indexed = true;
+
+    if (!rule_index.is_built) rule_index_build();
+
+    for (int i = 0; i < buf_len(g_window_manager.rules); ++i) {
+        rule_index.is_candidate[i] = !app || !rule_is_indexed(&g_window_manager.rules[i]);
+    }
+
+    if (app) {
+        int length = strlen(app);
+        rule_index_mark(&rule_index.exact, app, length);
+
+        for (int i = 0; i < buf_len(rule_index.prefix_length); ++i) {
+            if (rule_index.prefix_length[i] <= length) {
+                rule_index_mark(&rule_index.prefix, app, rule_index.prefix_length[i]);
             }
+        }
+    }
+
+    return rule_index.is_candidate;
+}
+
+static int rule_match_pattern(bool valid, regex_t *regex, int kind, char *literal, struct pattern_set *patterns, int pattern, uint64_t **matches, char *match)
+{
+    if (!valid) return REGEX_MATCH_UD;
+    if (kind != REGEX_LITERAL_NONE) return regex_literal_match(kind, literal, match);
+
+    if (patterns && pattern != -1 && match) {
+        if (!*matches) *matches = pattern_set_match(patterns, match);
+        return pattern_set_has(*matches, pattern) ? REGEX_MATCH_YES : REGEX_MATCH_NO;
+    }
 
-            bucket = bucket->next;
+    return regex_match(valid, regex, match);
+}
+
+bool rule_match(struct rule *rule, struct rule_subject *subject)
+{
+    uint64_t begin = rule_time_ns();
+    bool result = false;
+
+    struct pattern_set *app_patterns   = subject->is_indexed ? &rule_index.app_patterns   : NULL;
+    struct pattern_set *title_patterns = subject->is_indexed ? &rule_index.title_patterns : NULL;
+
+    int regex_match_app = rule->app_regex_exclude ? REGEX_MATCH_YES : REGEX_MATCH_NO;
+    if (rule_match_pattern(rule->app_regex_valid, &rule->app_regex, rule->app_literal_kind, rule->app_literal, app_patterns, rule->app_pattern, &subject->app_matches, subject->app) != regex_match_app) {
+        if (rule->title_regex_valid && !subject->has_title) {
+            subject->title = window_title(subject->window);
+            subject->has_title = true;
         }
+
+        int regex_match_title = rule->title_regex_exclude ? REGEX_MATCH_YES : REGEX_MATCH_NO;
+        result = rule_match_pattern(rule->title_regex_valid, &rule->title_regex, rule->title_literal_kind, rule->title_literal, title_patterns, rule->title_pattern, &subject->title_matches, subject->title) != regex_match_title;
+    }
+
+    rule->match_time += rule_time_ns() - begin;
+    if (result) ++rule->hit_count;
+
+    return result;
+}
+
+void rule_apply(struct rule *rule)
+{
+    for (int window_index = 0; window_index < g_window_manager.window.capacity; ++window_index) {
+        struct window *window = g_window_manager.window.buckets[window_index].value;
+        if (!window) continue;
+
+        window_manager_apply_rule_to_window(&g_space_manager, &g_window_manager, window, rule);
     }
 }
 
@@ -61,6 +198,7 @@ bool rule_remove_by_index(int index)
         if (i == index) {
             rule_destroy(&g_window_manager.rules[i]);
             buf_del(g_window_manager.rules, i);
+            rule_index.is_built = false;
             return true;
         }
     }
@@ -74,6 +212,7 @@ bool rule_remove(char *label)
         if (string_equals(g_window_manager.rules[i].label, label)) {
             rule_destroy(&g_window_manager.rules[i]);
             buf_del(g_window_manager.rules, i);
+            rule_index.is_built = false;
             return true;
         }
     }
@@ -84,14 +223,19 @@ bool rule_remove(char *label)
 void rule_add(struct rule *rule)
 {
     if (rule->label) rule_remove(rule->label);
+    if (rule->app_regex_valid)   rule->app_literal_kind   = regex_literal(rule->app, &rule->app_literal);
+    if (rule->title_regex_valid) rule->title_literal_kind = regex_literal(rule->title, &rule->title_literal);
     buf_push(g_window_manager.rules, *rule);
-    rule_apply(rule);
+    rule_index.is_built = false;
+    rule_apply(&g_window_manager.rules[buf_len(g_window_manager.rules)-1]);
 }
 
 void rule_destroy(struct rule *rule)
 {
     if (rule->app_regex_valid)   regfree(&rule->app_regex);
     if (rule->title_regex_valid) regfree(&rule->title_regex);
+    if (rule->app_literal)   free(rule->app_literal);
+    if (rule->title_literal) free(rule->title_literal);
     if (rule->label) free(rule->label);
     if (rule->app)   free(rule->app);
     if (rule->title) free(rule->title);
@@ -33,9 +33,42 @@ struct rule
     int border;
     int fullscreen;
     unsigned grid[6];
+    int app_literal_kind;
+    int title_literal_kind;
+    char *app_literal;
+    char *title_literal;
+    int app_pattern;
+    int title_pattern;
+    int next;
+    uint64_t hit_count;
+    uint64_t match_time;
 };
 
-void rule_serialize(FILE *rsp, struct rule *rule, int index);
+struct rule_index
+{
+    bool is_built;
+    literal_table exact;
+    literal_table prefix;
+    int *prefix_length;
+    bool *is_candidate;
+    struct pattern_set app_patterns;
+    struct pattern_set title_patterns;
+};
+
+struct rule_subject
+{
+    struct window *window;
+    char *app;
+    char *title;
+    bool has_title;
+    bool is_indexed;
+    uint64_t *app_matches;
+    uint64_t *title_matches;
+};
+
+void rule_serialize(struct json_writer *json, struct rule *rule, int index);
+bool *rule_find_candidates(struct rule_subject *subject);
+bool rule_match(struct rule *rule, struct rule_subject *subject);
 bool rule_remove_by_index(int index);
 bool rule_remove(char *label);
 void rule_add(struct rule *rule);
@@ -3,16 +3,7 @@
 extern struct window_manager g_window_manager;
 extern bool g_mission_control_active;
 extern int g_connection;
-
-static TABLE_HASH_FUNC(hash_view)
-{
-    return *(uint64_t *) key;
-}
-
-static TABLE_COMPARE_FUNC(compare_view)
-{
-    return *(uint64_t *) key_a == *(uint64_t *) key_b;
-}
+extern struct json_writer g_json_writer;
 
 bool space_manager_has_separate_spaces(void)
 {
@@ -24,8 +15,9 @@ bool space_manager_query_active_space(FILE *rsp)
     struct view *view = space_manager_query_view(&g_space_manager, space_manager_active_space());
     if (!view) return false;
 
-    view_serialize(rsp, view);
-    fprintf(rsp, "\n");
+    struct json_writer *json = json_writer_begin(&g_json_writer);
+    view_serialize(json, view);
+    json_writer_end(json, rsp);
     return true;
 }
 
@@ -35,15 +27,14 @@ bool space_manager_query_spaces_for_window(FILE *rsp, struct window *window)
     uint64_t *space_list = window_space_list(window, &space_count);
     if (!space_list) return false;
 
-    fprintf(rsp, "[");
+    struct json_writer *json = json_writer_begin(&g_json_writer);
+    json_begin_array(json);
     for (int i = 0; i < space_count; ++i) {
         struct view *view = space_manager_query_view(&g_space_manager, space_list[i]);
-        if (!view) continue;
-
-        view_serialize(rsp, view);
-        fprintf(rsp, "%c", i < space_count - 1 ? ',' : ']');
+        if (view) view_serialize(json, view);
     }
-    fprintf(rsp, "\n");
+    json_end_array(json);
+    json_writer_end(json, rsp);
 
     free(space_list);
     return true;
@@ -55,15 +46,14 @@ bool space_manager_query_spaces_for_display(FILE *rsp, uint32_t did)
     uint64_t *space_list = display_space_list(did, &space_count);
     if (!space_list) return false;
 
-    fprintf(rsp, "[");
+    struct json_writer *json = json_writer_begin(&g_json_writer);
+    json_begin_array(json);
     for (int i = 0; i < space_count; ++i) {
         struct view *view = space_manager_query_view(&g_space_manager, space_list[i]);
-        if (!view) continue;
-
-        view_serialize(rsp, view);
-        fprintf(rsp, "%c", i < space_count - 1 ? ',' : ']');
+        if (view) view_serialize(json, view);
     }
-    fprintf(rsp, "\n");
+    json_end_array(json);
+    json_writer_end(json, rsp);
 
     free(space_list);
     return true;
@@ -75,7 +65,8 @@ bool space_manager_query_spaces_for_displays(FILE *rsp)
     uint32_t *display_list = display_manager_active_display_list(&display_count);
     if (!display_list) return false;
 
-    fprintf(rsp, "[");
+    struct json_writer *json = json_writer_begin(&g_json_writer);
+    json_begin_array(json);
     for (int i = 0; i < display_count; ++i) {
         int space_count;
         uint64_t *space_list = display_space_list(display_list[i], &space_count);
@@ -83,16 +74,13 @@ bool space_manager_query_spaces_for_displays(FILE *rsp)
 
         for (int j = 0; j < space_count; ++j) {
             struct view *view = space_manager_query_view(&g_space_manager, space_list[j]);
-            if (!view) continue;
-
-            view_serialize(rsp, view);
-            if (j < space_count - 1) fprintf(rsp, ",");
+            if (view) view_serialize(json, view);
         }
 
         free(space_list);
-        fprintf(rsp, "%c", i < display_count - 1 ? ',' : ']');
     }
-    fprintf(rsp, "\n");
+    json_end_array(json);
+    json_writer_end(json, rsp);
 
     free(display_list);
     return true;
@@ -101,15 +89,15 @@ bool space_manager_query_spaces_for_displays(FILE *rsp)
 struct view *space_manager_query_view(struct space_manager *sm, uint64_t sid)
 {
     if (sm->did_begin) return space_manager_find_view(sm, sid);
-    return table_find(&sm->view, &sid);
+    return sid_table_find(&sm->view, sid);
 }
 
 struct view *space_manager_find_view(struct space_manager *sm, uint64_t sid)
 {
-    struct view *view = table_find(&sm->view, &sid);
+    struct view *view = sid_table_find(&sm->view, sid);
     if (!view) {
         view = view_create(sid);
-        table_add(&sm->view, &sid, view);
+        sid_table_add(&sm->view, sid, view);
     }
     return view;
 }
@@ -119,6 +107,7 @@ void space_manager_refresh_view(struct space_manager *sm, uint64_t sid)
     struct view *view = space_manager_find_view(sm, sid);
     if (view->layout == VIEW_FLOAT) return;
 
+    view_set_dirty(view);
     view_update(view);
     view_flush(view);
 }
@@ -129,6 +118,7 @@ void space_manager_mark_view_invalid(struct space_manager *sm,  uint64_t sid)
     if (view->layout == VIEW_FLOAT) return;
 
     view->is_valid = false;
+    view_set_dirty(view);
 }
 
 void space_manager_mark_view_dirty(struct space_manager *sm,  uint64_t sid)
@@ -136,7 +126,7 @@ void space_manager_mark_view_dirty(struct space_manager *sm,  uint64_t sid)
     struct view *view = space_manager_find_view(sm, sid);
     if (view->layout == VIEW_FLOAT) return;
 
-    view->is_dirty = true;
+    view_set_dirty(view);
 }
 
 void space_manager_untile_window(struct space_manager *sm, struct view *view, struct window *window)
@@ -147,7 +137,7 @@ void space_manager_untile_window(struct space_manager *sm, struct view *view, st
     view_flush(view);
 
     if (!space_is_visible(view->sid)) {
-        view->is_dirty = true;
+        view_set_dirty(view);
     }
 }
 
@@ -264,22 +254,18 @@ void space_manager_set_layout_for_all_spaces(struct space_manager *sm, enum view
 {
     sm->layout = layout;
     for (int i = 0; i < sm->view.capacity; ++i) {
-        struct bucket *bucket = sm->view.buckets[i];
-        while (bucket) {
-            if (bucket->value) {
-                struct view *view = bucket->value;
-                if (!view->custom_layout) {
-                    if (space_is_user(view->sid)) {
-                        view->layout = layout;
-                        view_clear(view);
-
-                        if (view->layout != VIEW_FLOAT) {
-                            window_manager_validate_and_check_for_windows_on_space(sm, &g_window_manager, view->sid);
-                        }
-                    }
+        struct view *view = sm->view.buckets[i].value;
+        if (!view) continue;
+
+        if (!view->custom_layout) {
+            if (space_is_user(view->sid)) {
+                view->layout = layout;
+                view_clear(view);
+
+                if (view->layout != VIEW_FLOAT) {
+                    window_manager_validate_and_check_for_windows_on_space(sm, &g_window_manager, view->sid);
                 }
             }
-            bucket = bucket->next;
         }
     }
 }
@@ -287,16 +273,12 @@ void space_manager_set_layout_for_all_spaces(struct space_manager *sm, enum view
 #define VIEW_SET_PROPERTY(p) \
     sm->p = p; \
     for (int i = 0; i < sm->view.capacity; ++i) { \
-        struct bucket *bucket = sm->view.buckets[i]; \
-        while (bucket) { \
-            if (bucket->value) { \
-                struct view *view = bucket->value; \
-                if (!view->custom_##p) view->p = p; \
-                view_update(view); \
-                view_flush(view); \
-            } \
-            bucket = bucket->next; \
-        } \
+        struct view *view = sm->view.buckets[i].value; \
+        if (!view) continue; \
+        \
+        if (!view->custom_##p) view->p = p; \
+        view_update(view); \
+        view_flush(view); \
     }
 
 void space_manager_set_window_gap_for_all_spaces(struct space_manager *sm, int window_gap)
@@ -413,7 +395,7 @@ struct view *space_manager_tile_window_on_space_with_insertion_point(struct spac
     view_flush(view);
 
     if (!space_is_visible(view->sid)) {
-        view->is_dirty = true;
+        view_set_dirty(view);
     }
 
     if (view->layout == VIEW_BSP && insertion_point) {
@@ -620,6 +602,7 @@ void space_manager_move_window_to_space(uint64_t sid, struct window *window)
     CFArrayRef window_list_ref = cfarray_of_cfnumbers(&window->id, sizeof(uint32_t), 1, kCFNumberSInt32Type);
     SLSMoveWindowsToManagedSpace(g_connection, window_list_ref, sid);
     CFRelease(window_list_ref);
+    window_invalidate_attributes(window, WINDOW_ATTRIBUTE_SPACE);
 }
 
 enum space_op_error space_manager_focus_space(uint64_t sid)
@@ -883,14 +866,10 @@ bool space_manager_refresh_application_windows(struct space_manager *sm)
 {
     int window_count = g_window_manager.window.count;
     for (int i = 0; i < g_window_manager.application.capacity; ++i) {
-        struct bucket *bucket = g_window_manager.application.buckets[i];
-        while (bucket) {
-            if (bucket->value) {
-                struct application *application = bucket->value;
-                window_manager_add_application_windows(sm, &g_window_manager, application);
-            }
-            bucket = bucket->next;
-        }
+        struct application *application = g_window_manager.application.buckets[i].value;
+        if (!application) continue;
+
+        window_manager_add_application_windows(sm, &g_window_manager, application);
     }
 
     return window_count != g_window_manager.window.count;
@@ -907,16 +886,12 @@ void space_manager_handle_display_add(struct space_manager *sm, uint32_t did)
     CFStringRef uuid_list[sm->view.count];
 
     for (int i = 0; i < sm->view.capacity; ++i) {
-        struct bucket *bucket = sm->view.buckets[i];
-        while (bucket) {
-            if (bucket->value) {
-                struct view *view = bucket->value;
-                view_list[list_count] = view;
-                uuid_list[list_count] = view->suuid;
-                ++list_count;
-            }
-            bucket = bucket->next;
-        }
+        struct view *view = sm->view.buckets[i].value;
+        if (!view) continue;
+
+        view_list[list_count] = view;
+        uuid_list[list_count] = view->suuid;
+        ++list_count;
     }
 
     for (int i = 0; i < space_count; ++i) {
@@ -934,7 +909,7 @@ void space_manager_handle_display_add(struct space_manager *sm, uint32_t did)
                 uuid_list[j] = NULL;
                 view_list[j] = NULL;
 
-                table_remove(&sm->view, &view->sid);
+                sid_table_remove(&sm->view, view->sid);
                 CFRelease(view->suuid);
 
                 struct space_label *label = space_manager_get_label_for_space(sm, view->sid);
@@ -943,7 +918,7 @@ void space_manager_handle_display_add(struct space_manager *sm, uint32_t did)
                 view->sid = sid;
                 view->suuid = CFRetain(uuid);
 
-                table_add(&sm->view, &sid, view);
+                sid_table_add(&sm->view, sid, view);
                 break;
             }
         }
@@ -965,7 +940,7 @@ void space_manager_init(struct space_manager *sm)
     sm->window_placement = CHILD_SECOND;
     sm->labels = NULL;
 
-    table_init(&sm->view, 23, hash_view, compare_view);
+    sid_table_init(&sm->view, 23);
 
     uint32_t display_count;
     uint32_t *display_list = display_manager_active_display_list(&display_count);
@@ -978,7 +953,7 @@ void space_manager_init(struct space_manager *sm)
 
         for (int j = 0; j < space_count; ++j) {
             struct view *view = view_create(space_list[j]);
-            table_add(&sm->view, &space_list[j], view);
+            sid_table_add(&sm->view, space_list[j], view);
         }
 
         free(space_list);
@@ -16,7 +16,7 @@ struct space_label
 
 struct space_manager
 {
-    struct table view;
+    sid_table view;
     uint64_t current_space_id;
     uint64_t last_space_id;
     bool did_begin;
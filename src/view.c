@@ -6,33 +6,36 @@ extern struct display_manager g_display_manager;
 extern struct space_manager g_space_manager;
 extern struct window_manager g_window_manager;
 
+static struct view_stats view_stats;
+static struct view_deferred_flush view_deferred_flush;
+
 void insert_feedback_show(struct window_node *node)
 {
     CFTypeRef frame_region;
     CGRect frame = {{(int)node->area.x, (int)node->area.y},{(int)(node->area.w+0.5f), (int)(node->area.h+0.5f)}};
     CGSNewRegionWithRect(&frame, &frame_region);
 
-    if (!node->feedback_window.id) {
+    if (!node->feedback_window->id) {
         uint64_t tags = kCGSIgnoreForExposeTagBit | kCGSIgnoreForEventsTagBit | kCGSDisableShadowTagBit;
-        SLSNewWindow(g_connection, 2, 0, 0, frame_region, &node->feedback_window.id);
-        SLSSetWindowTags(g_connection, node->feedback_window.id, &tags, 64);
-        SLSSetWindowResolution(g_connection, node->feedback_window.id, 1.0f);
-        SLSSetWindowOpacity(g_connection, node->feedback_window.id, 0);
-        SLSSetWindowLevel(g_connection, node->feedback_window.id, g_floating_window_level);
-        node->feedback_window.context = SLWindowContextCreate(g_connection, node->feedback_window.id, 0);
+        SLSNewWindow(g_connection, 2, 0, 0, frame_region, &node->feedback_window->id);
+        SLSSetWindowTags(g_connection, node->feedback_window->id, &tags, 64);
+        SLSSetWindowResolution(g_connection, node->feedback_window->id, 1.0f);
+        SLSSetWindowOpacity(g_connection, node->feedback_window->id, 0);
+        SLSSetWindowLevel(g_connection, node->feedback_window->id, g_floating_window_level);
+        node->feedback_window->context = SLWindowContextCreate(g_connection, node->feedback_window->id, 0);
         int width = g_window_manager.enable_window_border ? g_window_manager.border_width : 2;
-        CGContextSetLineWidth(node->feedback_window.context, width);
-        CGContextSetRGBFillColor(node->feedback_window.context,
+        CGContextSetLineWidth(node->feedback_window->context, width);
+        CGContextSetRGBFillColor(node->feedback_window->context,
                                    g_window_manager.insert_feedback_color.r,
                                    g_window_manager.insert_feedback_color.g,
                                    g_window_manager.insert_feedback_color.b,
                                    g_window_manager.insert_feedback_color.a*0.25f);
-        CGContextSetRGBStrokeColor(node->feedback_window.context,
+        CGContextSetRGBStrokeColor(node->feedback_window->context,
                                    g_window_manager.insert_feedback_color.r,
                                    g_window_manager.insert_feedback_color.g,
                                    g_window_manager.insert_feedback_color.b,
                                    g_window_manager.insert_feedback_color.a);
-        buf_push(g_window_manager.insert_feedback_windows, node->feedback_window.id);
+        buf_push(g_window_manager.insert_feedback_windows, node->feedback_window->id);
     }
 
     frame.origin.x = 0; frame.origin.y = 0;
@@ -81,14 +84,14 @@ void insert_feedback_show(struct window_node *node)
     CGPathAddLineToPoint(outline, NULL, x4, y4);
 
     SLSDisableUpdate(g_connection);
-    SLSOrderWindow(g_connection, node->feedback_window.id, 0, node->window_order[0]);
-    SLSSetWindowShape(g_connection, node->feedback_window.id, 0.0f, 0.0f, frame_region);
-    CGContextClearRect(node->feedback_window.context, frame);
-    CGContextFillRect(node->feedback_window.context, fill);
-    CGContextAddPath(node->feedback_window.context, outline);
-    CGContextStrokePath(node->feedback_window.context);
-    CGContextFlush(node->feedback_window.context);
-    SLSOrderWindow(g_connection, node->feedback_window.id, 1, node->window_order[0]);
+    SLSOrderWindow(g_connection, node->feedback_window->id, 0, node->window_order[0]);
+    SLSSetWindowShape(g_connection, node->feedback_window->id, 0.0f, 0.0f, frame_region);
+    CGContextClearRect(node->feedback_window->context, frame);
+    CGContextFillRect(node->feedback_window->context, fill);
+    CGContextAddPath(node->feedback_window->context, outline);
+    CGContextStrokePath(node->feedback_window->context);
+    CGContextFlush(node->feedback_window->context);
+    SLSOrderWindow(g_connection, node->feedback_window->id, 1, node->window_order[0]);
     SLSReenableUpdate(g_connection);
     CGPathRelease(outline);
     CFRelease(frame_region);
@@ -96,28 +99,36 @@ void insert_feedback_show(struct window_node *node)
 
 void insert_feedback_destroy(struct window_node *node)
 {
-    if (node->feedback_window.id) {
+    if (node->feedback_window->id) {
         for (int i = 0; i < buf_len(g_window_manager.insert_feedback_windows); ++i) {
-            if (g_window_manager.insert_feedback_windows[i] == node->feedback_window.id) {
+            if (g_window_manager.insert_feedback_windows[i] == node->feedback_window->id) {
                 buf_del(g_window_manager.insert_feedback_windows, i);
                 break;
             }
         }
 
-        CGContextRelease(node->feedback_window.context);
-        SLSReleaseWindow(g_connection, node->feedback_window.id);
-        memset(&node->feedback_window, 0, sizeof(struct feedback_window));
+        CGContextRelease(node->feedback_window->context);
+        SLSReleaseWindow(g_connection, node->feedback_window->id);
+        memset(node->feedback_window, 0, sizeof(struct feedback_window));
     }
 }
 
-static inline CGPoint area_center(struct area a)
+static inline struct area area_from_cgrect(CGRect rect)
 {
-    return (CGPoint) { a.x + a.w*0.5f, a.y + a.h*0.5f };
+    return (struct area) { rect.origin.x, rect.origin.y, rect.size.width, rect.size.height };
 }
 
-static inline struct area area_from_cgrect(CGRect rect)
+static inline bool area_equals(struct area a, struct area b)
 {
-    return (struct area) { rect.origin.x, rect.origin.y, rect.size.width, rect.size.height };
+    return a.x == b.x && a.y == b.y && a.w == b.w && a.h == b.h;
+}
+
+static inline void window_node_set_area(struct window_node *node, struct area area)
+{
+    if (!area_equals(node->area, area)) {
+        node->area = area;
+        node->is_dirty = true;
+    }
 }
 
 static inline enum window_node_child window_node_get_child(struct window_node *node)
@@ -146,55 +157,34 @@ static void area_make_pair(struct view *view, struct window_node *node)
     float ratio = window_node_get_ratio(node);
     float gap   = window_node_get_gap(view);
 
+    struct area left_area  = node->area;
+    struct area right_area = node->area;
+
     if (split == SPLIT_Y) {
-        node->left->area = node->area;
-        node->left->area.w *= ratio;
-        node->left->area.w -= gap;
-
-        node->right->area = node->area;
-        node->right->area.x += (node->area.w * ratio);
-        node->right->area.w *= (1 - ratio);
-        node->right->area.x += gap;
-        node->right->area.w -= gap;
+        left_area.w *= ratio;
+        left_area.w -= gap;
+
+        right_area.x += (node->area.w * ratio);
+        right_area.w *= (1 - ratio);
+        right_area.x += gap;
+        right_area.w -= gap;
     } else {
-        node->left->area = node->area;
-        node->left->area.h *= ratio;
-        node->left->area.h -= gap;
+        left_area.h *= ratio;
+        left_area.h -= gap;
 
-        node->right->area = node->area;
-        node->right->area.y += (node->area.h * ratio);
-        node->right->area.h *= (1 - ratio);
-        node->right->area.y += gap;
-        node->right->area.h -= gap;
+        right_area.y += (node->area.h * ratio);
+        right_area.h *= (1 - ratio);
+        right_area.y += gap;
+        right_area.h -= gap;
     }
 
+    window_node_set_area(node->left, left_area);
+    window_node_set_area(node->right, right_area);
+
     node->split = split;
     node->ratio = ratio;
-}
-
-static inline bool window_node_is_occupied(struct window_node *node)
-{
-    return node->window_count != 0;
-}
-
-static inline bool window_node_is_intermediate(struct window_node *node)
-{
-    return node->parent != NULL;
-}
-
-static inline bool window_node_is_leaf(struct window_node *node)
-{
-    return node->left == NULL && node->right == NULL;
-}
-
-static inline bool window_node_is_left_child(struct window_node *node)
-{
-    return node->parent && node->parent->left == node;
-}
-
-static inline bool window_node_is_right_child(struct window_node *node)
-{
-    return node->parent && node->parent->right == node;
+    view->edge_index.is_dirty = true;
+    ++view_stats.nodes_updated;
 }
 
 static inline struct equalize_node equalize_node_add(struct equalize_node a, struct equalize_node b)
@@ -231,13 +221,25 @@ static struct equalize_node window_node_equalize(struct window_node *node)
     return total_leafs;
 }
 
-static void window_node_split(struct view *view, struct window_node *node, struct window *window)
+static void view_index_window_node(struct view *view, struct window_node *node)
 {
-    struct window_node *left = malloc(sizeof(struct window_node));
-    memset(left, 0, sizeof(struct window_node));
+    for (int i = 0; i < node->window_count; ++i) {
+        wid_table_remove(&view->node_index, node->window_list[i]);
+        wid_table_add(&view->node_index, node->window_list[i], node);
+    }
+}
 
-    struct window_node *right = malloc(sizeof(struct window_node));
-    memset(right, 0, sizeof(struct window_node));
+static void view_unindex_window_node(struct view *view, struct window_node *node)
+{
+    for (int i = 0; i < node->window_count; ++i) {
+        wid_table_remove(&view->node_index, node->window_list[i]);
+    }
+}
+
+static void window_node_split(struct view *view, struct window_node *node, struct window *window)
+{
+    struct window_node *left = window_node_create(view);
+    struct window_node *right = window_node_create(view);
 
     if (window_node_get_child(node) == CHILD_SECOND) {
         memcpy(left->window_list, node->window_list, sizeof(uint32_t) * node->window_count);
@@ -263,38 +265,60 @@ static void window_node_split(struct view *view, struct window_node *node, struc
     node->right = right;
     node->zoom  = NULL;
 
+    view_index_window_node(view, left);
+    view_index_window_node(view, right);
+
     area_make_pair(view, node);
 }
 
+//
+// NOTE(koekeishiya): Nodes are marked dirty when their area changes, and only dirty subtrees
+// have to be laid out again. A full update is required when split ratios may have changed
+// anywhere in the tree (equalize, rotate, resize through a fence, padding and gap changes).
+// Otherwise the given node is recomputed and we descend only into children whose area changed.
+//
+
+static void window_node_update_subtree(struct view *view, struct window_node *node, bool full)
+{
+    if (window_node_is_leaf(node)) {
+        if (node->insert_dir && (full || node->is_dirty)) insert_feedback_show(node);
+        return;
+    }
+
+    area_make_pair(view, node);
+
+    if (full || node->left->is_dirty)  window_node_update_subtree(view, node->left, full);
+    if (full || node->right->is_dirty) window_node_update_subtree(view, node->right, full);
+}
+
 void window_node_update(struct view *view, struct window_node *node)
 {
+    view_stats.nodes_updated = 0;
+
     if (window_node_is_intermediate(node)) {
         area_make_pair(view, node->parent);
     }
 
-    if (window_node_is_leaf(node)) {
-        if (node->insert_dir) insert_feedback_show(node);
-    } else {
-        window_node_update(view, node->left);
-        window_node_update(view, node->right);
-    }
+    window_node_update_subtree(view, node, false);
+    debug("%s: recomputed %d nodes\n", __FUNCTION__, view_stats.nodes_updated);
 }
 
-static void window_node_destroy(struct window_node *node)
+static void window_node_destroy(struct view *view, struct window_node *node)
 {
-    if (node->left)  window_node_destroy(node->left);
-    if (node->right) window_node_destroy(node->right);
+    if (node->left)  window_node_destroy(view, node->left);
+    if (node->right) window_node_destroy(view, node->right);
 
     for (int i = 0; i < node->window_count; ++i) {
         window_manager_remove_managed_window(&g_window_manager, node->window_list[i]);
     }
 
     insert_feedback_destroy(node);
-    free(node);
+    window_node_release(view, node);
 }
 
 static void window_node_clear_zoom(struct window_node *node)
 {
+    if (node->zoom) node->is_dirty = true;
     node->zoom = NULL;
 
     if (!window_node_is_leaf(node)) {
@@ -303,27 +327,82 @@ static void window_node_clear_zoom(struct window_node *node)
     }
 }
 
-void window_node_flush(struct window_node *node)
+static void window_node_flush_subtree(struct window_node *node, bool only_dirty, struct frame_batch *batch)
 {
-    if (window_node_is_occupied(node)) {
+    if (window_node_is_occupied(node) && (!only_dirty || node->is_dirty)) {
         for (int i = 0; i < node->window_count; ++i) {
             struct window *window = window_manager_find_window(&g_window_manager, node->window_list[i]);
             if (window) {
                 if (node->zoom) {
-                    window_manager_set_window_frame(window, node->zoom->area.x, node->zoom->area.y, node->zoom->area.w, node->zoom->area.h);
+                    frame_batch_add(batch, window, node->zoom->area.x, node->zoom->area.y, node->zoom->area.w, node->zoom->area.h);
                 } else {
-                    window_manager_set_window_frame(window, node->area.x, node->area.y, node->area.w, node->area.h);
+                    frame_batch_add(batch, window, node->area.x, node->area.y, node->area.w, node->area.h);
                 }
+
+                ++view_stats.windows_flushed;
             }
         }
     }
 
+    node->is_dirty = false;
+
+    if (!window_node_is_leaf(node)) {
+        window_node_flush_subtree(node->left, only_dirty, batch);
+        window_node_flush_subtree(node->right, only_dirty, batch);
+    }
+}
+
+static void window_node_mark_dirty(struct window_node *node)
+{
+    node->is_dirty = true;
+
     if (!window_node_is_leaf(node)) {
-        window_node_flush(node->left);
-        window_node_flush(node->right);
+        window_node_mark_dirty(node->left);
+        window_node_mark_dirty(node->right);
     }
 }
 
+static struct view *view_find_for_window_node(struct window_node *node)
+{
+    while (node->parent) node = node->parent;
+
+    for (int i = 0; i < g_space_manager.view.capacity; ++i) {
+        struct view *view = g_space_manager.view.buckets[i].value;
+        if (view && view->root == node) return view;
+    }
+
+    return NULL;
+}
+
+static void view_defer_flush(struct view *view)
+{
+    for (int i = 0; i < buf_len(view_deferred_flush.views); ++i) {
+        if (view_deferred_flush.views[i] == view) return;
+    }
+
+    buf_push(view_deferred_flush.views, view);
+}
+
+void window_node_flush(struct window_node *node)
+{
+    if (view_deferred_flush.depth > 0) {
+        struct view *view = view_find_for_window_node(node);
+        if (view) {
+            window_node_mark_dirty(node);
+            view_defer_flush(view);
+            return;
+        }
+    }
+
+    struct frame_batch batch;
+    frame_batch_begin(&batch);
+
+    view_stats.windows_flushed = 0;
+    window_node_flush_subtree(node, false, &batch);
+    frame_batch_commit(&batch);
+    debug("%s: flushed %d windows\n", __FUNCTION__, view_stats.windows_flushed);
+}
+
 bool window_node_contains_window(struct window_node *node, uint32_t window_id)
 {
     for (int i = 0; i < node->window_count; ++i) {
@@ -342,12 +421,15 @@ int window_node_index_of_window(struct window_node *node, uint32_t window_id)
     return 0;
 }
 
-void window_node_swap_window_list(struct window_node *a_node, struct window_node *b_node)
+void window_node_swap_window_list(struct view *a_view, struct window_node *a_node, struct view *b_view, struct window_node *b_node)
 {
     uint32_t tmp_window_list[NODE_MAX_WINDOW_COUNT];
     uint32_t tmp_window_order[NODE_MAX_WINDOW_COUNT];
     uint32_t tmp_window_count;
 
+    view_unindex_window_node(a_view, a_node);
+    view_unindex_window_node(b_view, b_node);
+
     memcpy(tmp_window_list, a_node->window_list, sizeof(uint32_t) * a_node->window_count);
     memcpy(tmp_window_order, a_node->window_order, sizeof(uint32_t) * a_node->window_count);
     tmp_window_count = a_node->window_count;
@@ -362,54 +444,12 @@ void window_node_swap_window_list(struct window_node *a_node, struct window_node
 
     a_node->zoom = NULL;
     b_node->zoom = NULL;
-}
-
-struct window_node *window_node_find_first_leaf(struct window_node *root)
-{
-    struct window_node *node = root;
-    while (!window_node_is_leaf(node)) {
-        node = node->left;
-    }
-    return node;
-}
-
-struct window_node *window_node_find_last_leaf(struct window_node *root)
-{
-    struct window_node *node = root;
-    while (!window_node_is_leaf(node)) {
-        node = node->right;
-    }
-    return node;
-}
-
-struct window_node *window_node_find_prev_leaf(struct window_node *node)
-{
-    if (!node->parent) return NULL;
-
-    if (window_node_is_left_child(node)) {
-        return window_node_find_prev_leaf(node->parent);
-    }
-
-    if (window_node_is_leaf(node->parent->left)) {
-        return node->parent->left;
-    }
-
-    return window_node_find_first_leaf(node->parent->left->right);
-}
-
-struct window_node *window_node_find_next_leaf(struct window_node *node)
-{
-    if (!node->parent) return NULL;
 
-    if (window_node_is_right_child(node)) {
-        return window_node_find_next_leaf(node->parent);
-    }
-
-    if (window_node_is_leaf(node->parent->right)) {
-        return node->parent->right;
-    }
+    a_node->is_dirty = true;
+    b_node->is_dirty = true;
 
-    return window_node_find_first_leaf(node->parent->right->left);
+    view_index_window_node(a_view, a_node);
+    view_index_window_node(b_view, b_node);
 }
 
 void window_node_rotate(struct window_node *node, int degrees)
@@ -487,61 +527,41 @@ struct window_node *view_find_min_depth_leaf_node(struct window_node *node)
     return NULL;
 }
 
-struct window_node *view_find_window_node_in_direction(struct view *view, struct window_node *source, int direction)
+struct window_node *view_find_window_node(struct view *view, uint32_t window_id)
 {
-    int best_distance = INT_MAX;
-    struct window_node *best_node = NULL;
-    CGPoint source_point = area_center(source->area);
+    return wid_table_find(&view->node_index, window_id);
+}
 
-    struct window_node *target = window_node_find_first_leaf(view->root);
-    while (target) {
-        CGPoint target_point = area_center(target->area);
-        int distance = euclidean_distance(source_point, target_point);
-        if (distance >= best_distance) goto next;
+//
+// NOTE(koekeishiya): Verify that the window id -> node index agrees with the tree;
+// every window stored in a leaf must map to that leaf, and nothing else may be indexed.
+// This walks the whole tree, so view_flush only runs it when built with
+// -DVIEW_CHECK_NODE_INDEX.
+//
 
-        switch (direction) {
-        case DIR_EAST: {
-            if (target->area.x >= source->area.x + source->area.w) {
-                best_node = target;
-                best_distance = distance;
-            }
-        } break;
-        case DIR_SOUTH: {
-            if (target->area.y >= source->area.y + source->area.h) {
-                best_node = target;
-                best_distance = distance;
-            }
-        } break;
-        case DIR_WEST: {
-            if (target->area.x + target->area.w <= source->area.x) {
-                best_node = target;
-                best_distance = distance;
-            }
-        } break;
-        case DIR_NORTH: {
-            if (target->area.y + target->area.h <= source->area.y) {
-                best_node = target;
-                best_distance = distance;
+bool view_check_window_node_index(struct view *view)
+{
+    int window_count = 0;
+
+    struct window_node *node = window_node_find_first_leaf(view->root);
+    while (node) {
+        for (int i = 0; i < node->window_count; ++i) {
+            if (wid_table_find(&view->node_index, node->window_list[i]) != node) {
+                warn("%s: window %d is not indexed to its node on space %lld\n", __FUNCTION__, node->window_list[i], view->sid);
+                return false;
             }
-        } break;
         }
 
-next:
-        target = window_node_find_next_leaf(target);
+        window_count += node->window_count;
+        node = window_node_find_next_leaf(node);
     }
 
-    return best_node;
-}
-
-struct window_node *view_find_window_node(struct view *view, uint32_t window_id)
-{
-    struct window_node *node = window_node_find_first_leaf(view->root);
-    while (node) {
-        if (window_node_contains_window(node, window_id)) return node;
-        node = window_node_find_next_leaf(node);
+    if (window_count != view->node_index.count) {
+        warn("%s: %d windows in tree, but %d indexed on space %lld\n", __FUNCTION__, window_count, view->node_index.count, view->sid);
+        return false;
     }
 
-    return NULL;
+    return true;
 }
 
 void view_remove_window_node(struct view *view, struct window *window)
@@ -549,6 +569,8 @@ void view_remove_window_node(struct view *view, struct window *window)
     struct window_node *node = view_find_window_node(view, window->id);
     if (!node) return;
 
+    wid_table_remove(&view->node_index, window->id);
+
     if (node->window_count > 1) {
         bool removed_entry = false;
         bool removed_order = false;
@@ -587,17 +609,19 @@ void view_remove_window_node(struct view *view, struct window *window)
                                ? parent->left
                                : parent->right;
 
-
     memcpy(parent->window_list, child->window_list, sizeof(uint32_t) * child->window_count);
     memcpy(parent->window_order, child->window_order, sizeof(uint32_t) * child->window_count);
     parent->window_count = child->window_count;
+    view_index_window_node(view, parent);
+    view->edge_index.is_dirty = true;
 
     parent->left      = NULL;
     parent->right     = NULL;
     parent->zoom      = NULL;
+    parent->is_dirty  = true;
 
     if (child->insert_dir) {
-        parent->feedback_window = child->feedback_window;
+        *parent->feedback_window = *child->feedback_window;
         parent->insert_dir      = child->insert_dir;
         parent->split           = child->split;
         parent->child           = child->child;
@@ -619,8 +643,8 @@ void view_remove_window_node(struct view *view, struct window *window)
 
     insert_feedback_destroy(node);
 
-    free(child);
-    free(node);
+    window_node_release(view, child);
+    window_node_release(view, node);
 
     if (g_space_manager.auto_balance) {
         window_node_equalize(view->root);
@@ -639,6 +663,8 @@ void view_stack_window_node(struct view *view, struct window_node *node, struct
     node->window_list[node->window_count] = window->id;
     node->window_order[node->window_count] = window->id;
     ++node->window_count;
+
+    wid_table_add(&view->node_index, window->id, node);
 }
 
 void view_add_window_node(struct view *view, struct window *window)
@@ -648,6 +674,8 @@ void view_add_window_node(struct view *view, struct window *window)
         view->root->window_list[0] = window->id;
         view->root->window_order[0] = window->id;
         view->root->window_count = 1;
+        view->root->is_dirty = true;
+        wid_table_add(&view->node_index, window->id, view->root);
     } else if (view->layout == VIEW_BSP) {
         struct window_node *leaf = NULL;
 
@@ -707,90 +735,138 @@ bool view_is_dirty(struct view *view)
     return view->is_dirty;
 }
 
+void view_set_dirty(struct view *view)
+{
+    window_node_mark_dirty(view->root);
+    view->is_dirty = true;
+}
+
+//
+// NOTE(koekeishiya): view_flush writes the frame of every window in the view, not only the
+// windows in dirty leaves; a window that was moved or resized outside of yabai must snap back
+// to its tile the next time the view is flushed, even if its own node did not change. Frames
+// that are still where we put them are dropped by the frame batch, so this costs a tree walk
+// rather than an accessibility write per window. Dirty leaves are only used to decide which
+// windows to write when flushing the nodes that were changed by a relayout (window_node_flush
+// inside a deferred flush).
+//
+
 void view_flush(struct view *view)
 {
-    window_node_flush(view->root);
+#ifdef VIEW_CHECK_NODE_INDEX
+    assert(view_check_window_node_index(view));
+#endif
+
+    if (view_deferred_flush.depth > 0) {
+        window_node_mark_dirty(view->root);
+        view_defer_flush(view);
+        view->is_dirty = false;
+        return;
+    }
+
+    struct frame_batch batch;
+    frame_batch_begin(&batch);
+
+    view_stats.windows_flushed = 0;
+    window_node_flush_subtree(view->root, false, &batch);
+    frame_batch_commit(&batch);
     view->is_dirty = false;
+    debug("%s: flushed %d windows\n", __FUNCTION__, view_stats.windows_flushed);
+}
+
+//
+// NOTE(koekeishiya): While a flush is deferred, view_flush and window_node_flush only mark the
+// nodes they would have written (every node of the view for view_flush) and remember which views
+// were touched. When the outermost deferral ends, the dirty nodes of every touched view are
+// committed together as a single frame batch.
+// A view that was marked dirty again after its deferred flush (e.g. because the space is not
+// visible) stays dirty, exactly as it would have been without the deferral.
+//
+
+void view_defer_flush_begin(void)
+{
+    ++view_deferred_flush.depth;
 }
 
-void view_serialize(FILE *rsp, struct view *view)
+void view_defer_flush_end(void)
 {
-    int buffer_size = MAXLEN;
-    size_t bytes_written = 0;
-    char buffer[MAXLEN] = {};
-    char *cursor = buffer;
+    assert(view_deferred_flush.depth > 0);
+    if (--view_deferred_flush.depth > 0) return;
 
-    int count = 0;
-    uint32_t windows[MAXLEN] = {};
+    struct frame_batch batch;
+    frame_batch_begin(&batch);
+    view_stats.windows_flushed = 0;
+
+    int view_count = buf_len(view_deferred_flush.views);
+    for (int i = 0; i < view_count; ++i) {
+        struct view *view = view_deferred_flush.views[i];
+        bool is_dirty = view->is_dirty;
+
+        window_node_flush_subtree(view->root, true, &batch);
+        if (is_dirty) view_set_dirty(view);
+    }
+
+    frame_batch_commit(&batch);
+    debug("%s: flushed %d windows in %d views\n", __FUNCTION__, view_stats.windows_flushed, view_count);
+
+    buf_free(view_deferred_flush.views);
+    view_deferred_flush.views = NULL;
+}
+
+void view_serialize(struct json_writer *json, struct view *view)
+{
+    struct space_label *space_label = space_manager_get_label_for_space(&g_space_manager, view->sid);
+    struct window_node *first_leaf = window_node_find_first_leaf(view->root);
+    struct window_node *last_leaf = window_node_find_last_leaf(view->root);
+
+    json_begin_object(json);
+    json_key(json, "id");                json_int(json, view->sid);
+    json_key(json, "label");             json_string(json, space_label ? space_label->label : "");
+    json_key(json, "index");             json_int(json, space_manager_mission_control_index(view->sid));
+    json_key(json, "display");           json_int(json, display_arrangement(space_display_id(view->sid)));
+    json_key(json, "windows");
+    json_begin_array(json);
 
     int window_count = 0;
     uint32_t *window_list = space_window_list(view->sid, &window_count, true);
     if (window_list) {
         for (int i = 0; i < window_count; ++i) {
             if (window_manager_find_window(&g_window_manager, window_list[i])) {
-                windows[count++] = window_list[i];
+                json_int(json, window_list[i]);
             }
         }
         free(window_list);
     }
 
-    for (int i = 0; i < count; ++i) {
-        if (i < count - 1) {
-            bytes_written = snprintf(cursor, buffer_size, "%d, ", windows[i]);
-        } else {
-            bytes_written = snprintf(cursor, buffer_size, "%d", windows[i]);
-        }
-
-        cursor += bytes_written;
-        buffer_size -= bytes_written;
-        if (buffer_size <= 0) break;
-    }
-
-    struct space_label *space_label = space_manager_get_label_for_space(&g_space_manager, view->sid);
-    struct window_node *first_leaf = window_node_find_first_leaf(view->root);
-    struct window_node *last_leaf = window_node_find_last_leaf(view->root);
-
-    fprintf(rsp,
-            "{\n"
-            "\t\"id\":%lld,\n"
-            "\t\"label\":\"%s\",\n"
-            "\t\"index\":%d,\n"
-            "\t\"display\":%d,\n"
-            "\t\"windows\":[%s],\n"
-            "\t\"type\":\"%s\",\n"
-            "\t\"visible\":%d,\n"
-            "\t\"focused\":%d,\n"
-            "\t\"native-fullscreen\":%d,\n"
-            "\t\"first-window\":%d,\n"
-            "\t\"last-window\":%d\n"
-            "}",
-            view->sid,
-            space_label ? space_label->label : "",
-            space_manager_mission_control_index(view->sid),
-            display_arrangement(space_display_id(view->sid)),
-            buffer,
-            view_type_str[view->layout],
-            space_is_visible(view->sid),
-            view->sid == g_space_manager.current_space_id,
-            space_is_fullscreen(view->sid),
-            first_leaf ? first_leaf->window_order[0] : 0,
-            last_leaf ? last_leaf->window_order[0] : 0);
+    json_end_array(json);
+    json_key(json, "type");              json_string(json, view_type_str[view->layout]);
+    json_key(json, "visible");           json_int(json, space_is_visible(view->sid));
+    json_key(json, "focused");           json_int(json, view->sid == g_space_manager.current_space_id);
+    json_key(json, "native-fullscreen"); json_int(json, space_is_fullscreen(view->sid));
+    json_key(json, "first-window");      json_int(json, first_leaf ? first_leaf->window_order[0] : 0);
+    json_key(json, "last-window");       json_int(json, last_leaf ? last_leaf->window_order[0] : 0);
+    json_end_object(json);
 }
 
 void view_update(struct view *view)
 {
     uint32_t did = space_display_id(view->sid);
     CGRect frame = display_bounds_constrained(did);
-    view->root->area = area_from_cgrect(frame);
+    struct area area = area_from_cgrect(frame);
 
     if (view->enable_padding) {
-        view->root->area.x += view->left_padding;
-        view->root->area.w -= (view->left_padding + view->right_padding);
-        view->root->area.y += view->top_padding;
-        view->root->area.h -= (view->top_padding + view->bottom_padding);
+        area.x += view->left_padding;
+        area.w -= (view->left_padding + view->right_padding);
+        area.y += view->top_padding;
+        area.h -= (view->top_padding + view->bottom_padding);
     }
 
-    window_node_update(view, view->root);
+    view_stats.nodes_updated = 0;
+    view->edge_index.is_dirty = true;
+    window_node_set_area(view->root, area);
+    window_node_update_subtree(view, view->root, true);
+    debug("%s: recomputed %d nodes\n", __FUNCTION__, view_stats.nodes_updated);
+
     view->is_valid = true;
     view->is_dirty = true;
 }
@@ -800,8 +876,8 @@ struct view *view_create(uint64_t sid)
     struct view *view = malloc(sizeof(struct view));
     memset(view, 0, sizeof(struct view));
 
-    view->root = malloc(sizeof(struct window_node));
-    memset(view->root, 0, sizeof(struct window_node));
+    view->root = window_node_create(view);
+    wid_table_init(&view->node_index, 32);
 
     view->enable_padding = true;
     view->enable_gap = true;
@@ -826,15 +902,18 @@ struct view *view_create(uint64_t sid)
 void view_clear(struct view *view)
 {
     if (view->root) {
-        if (view->root->left)  window_node_destroy(view->root->left);
-        if (view->root->right) window_node_destroy(view->root->right);
+        if (view->root->left)  window_node_destroy(view, view->root->left);
+        if (view->root->right) window_node_destroy(view, view->root->right);
 
         for (int i = 0; i < view->root->window_count; ++i) {
             window_manager_remove_managed_window(&g_window_manager, view->root->window_list[i]);
         }
 
         insert_feedback_destroy(view->root);
-        memset(view->root, 0, sizeof(struct window_node));
+        window_node_reset(view->root);
+
+        wid_table_free(&view->node_index);
+        wid_table_init(&view->node_index, 32);
         view_update(view);
     }
 }
@@ -52,6 +52,13 @@ struct feedback_window
 };
 
 #define NODE_MAX_WINDOW_COUNT 32
+struct window_node_data
+{
+    uint32_t window_list[NODE_MAX_WINDOW_COUNT];
+    uint32_t window_order[NODE_MAX_WINDOW_COUNT];
+    struct feedback_window feedback_window;
+};
+
 struct window_node
 {
     struct area area;
@@ -59,14 +66,66 @@ struct window_node
     struct window_node *left;
     struct window_node *right;
     struct window_node *zoom;
-    uint32_t window_list[NODE_MAX_WINDOW_COUNT];
-    uint32_t window_order[NODE_MAX_WINDOW_COUNT];
-    uint32_t window_count;
     float ratio;
     enum window_node_split split;
     enum window_node_child child;
     int insert_dir;
-    struct feedback_window feedback_window;
+    uint32_t window_count;
+    bool is_dirty;
+    uint32_t *window_list;
+    uint32_t *window_order;
+    struct feedback_window *feedback_window;
+};
+
+#define NODE_POOL_CHUNK_SIZE 32
+struct window_node_chunk
+{
+    struct window_node_chunk *next;
+    struct window_node node[NODE_POOL_CHUNK_SIZE];
+    struct window_node_data data[NODE_POOL_CHUNK_SIZE];
+};
+
+struct window_node_pool
+{
+    struct window_node_chunk *chunks;
+    struct window_node *free_list;
+};
+
+enum window_node_edge_dir
+{
+    EDGE_EAST,
+    EDGE_SOUTH,
+    EDGE_WEST,
+    EDGE_NORTH,
+
+    EDGE_DIR_COUNT
+};
+
+struct window_node_edge
+{
+    float key;
+    int order;
+    struct window_node *node;
+};
+
+struct window_node_edge_index
+{
+    struct window_node_edge *edges[EDGE_DIR_COUNT];
+    int count;
+    int capacity;
+    bool is_dirty;
+};
+
+struct view_stats
+{
+    uint32_t nodes_updated;
+    uint32_t windows_flushed;
+};
+
+struct view_deferred_flush
+{
+    int depth;
+    struct view **views;
 };
 
 enum view_type
@@ -90,6 +149,9 @@ struct view
     CFStringRef suuid;
     uint64_t sid;
     struct window_node *root;
+    struct window_node_pool pool;
+    wid_table node_index;
+    struct window_node_edge_index edge_index;
     enum view_type layout;
     uint32_t insertion_point;
     int top_padding;
@@ -116,7 +178,7 @@ void window_node_flush(struct window_node *node);
 void window_node_update(struct view *view, struct window_node *node);
 bool window_node_contains_window(struct window_node *node, uint32_t window_id);
 int window_node_index_of_window(struct window_node *node, uint32_t window_id);
-void window_node_swap_window_list(struct window_node *a_node, struct window_node *b_node);
+void window_node_swap_window_list(struct view *a_view, struct window_node *a_node, struct view *b_view, struct window_node *b_node);
 struct window_node *window_node_find_first_leaf(struct window_node *root);
 struct window_node *window_node_find_last_leaf(struct window_node *root);
 struct window_node *window_node_find_prev_leaf(struct window_node *node);
@@ -124,15 +186,19 @@ struct window_node *window_node_find_next_leaf(struct window_node *node);
 
 struct window_node *view_find_window_node_in_direction(struct view *view, struct window_node *source, int direction);
 struct window_node *view_find_window_node(struct view *view, uint32_t window_id);
+bool view_check_window_node_index(struct view *view);
 void view_stack_window_node(struct view *view, struct window_node *node, struct window *window);
 void view_add_window_node(struct view *view, struct window *window);
 void view_remove_window_node(struct view *view, struct window *window);
 uint32_t *view_find_window_list(struct view *view);
 
-void view_serialize(FILE *rsp, struct view *view);
+void view_serialize(struct json_writer *json, struct view *view);
 bool view_is_invalid(struct view *view);
 bool view_is_dirty(struct view *view);
+void view_set_dirty(struct view *view);
 void view_flush(struct view *view);
+void view_defer_flush_begin(void);
+void view_defer_flush_end(void);
 void view_update(struct view *view);
 struct view *view_create(uint64_t sid);
 void view_clear(struct view *view);
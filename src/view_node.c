@@ -0,0 +1,296 @@
+#include "view.h"
+
+//
+// NOTE(koekeishiya): The parts of the window tree that do not talk to the window server or the
+// accessibility API: the node pool, the leaf walks and the directional edge index. They are kept
+// apart from view.c so that they can be built and measured on their own (see tests/ and bench/).
+//
+
+static inline CGPoint area_center(struct area a)
+{
+    return (CGPoint) { a.x + a.w*0.5f, a.y + a.h*0.5f };
+}
+
+static inline bool window_node_is_occupied(struct window_node *node)
+{
+    return node->window_count != 0;
+}
+
+static inline bool window_node_is_intermediate(struct window_node *node)
+{
+    return node->parent != NULL;
+}
+
+static inline bool window_node_is_leaf(struct window_node *node)
+{
+    return node->left == NULL && node->right == NULL;
+}
+
+static inline bool window_node_is_left_child(struct window_node *node)
+{
+    return node->parent && node->parent->left == node;
+}
+
+static inline bool window_node_is_right_child(struct window_node *node)
+{
+    return node->parent && node->parent->right == node;
+}
+
+//
+// NOTE(koekeishiya): Nodes are handed out from a per-view pool. The fields used while walking
+// and laying out the tree are kept in struct window_node, which are packed together in each
+// chunk, whereas the window stacks and the insert feedback window live in a separate array
+// of struct window_node_data that is only touched when a leaf is actually inspected.
+//
+
+static void window_node_pool_grow(struct window_node_pool *pool)
+{
+    struct window_node_chunk *chunk = malloc(sizeof(struct window_node_chunk));
+    chunk->next = pool->chunks;
+    pool->chunks = chunk;
+
+    for (int i = NODE_POOL_CHUNK_SIZE - 1; i >= 0; --i) {
+        struct window_node *node = &chunk->node[i];
+        node->window_list     = chunk->data[i].window_list;
+        node->window_order    = chunk->data[i].window_order;
+        node->feedback_window = &chunk->data[i].feedback_window;
+        node->parent          = pool->free_list;
+        pool->free_list       = node;
+    }
+}
+
+static void window_node_reset(struct window_node *node)
+{
+    uint32_t *window_list = node->window_list;
+    uint32_t *window_order = node->window_order;
+    struct feedback_window *feedback_window = node->feedback_window;
+
+    memset(node, 0, sizeof(struct window_node));
+    memset(feedback_window, 0, sizeof(struct feedback_window));
+
+    node->window_list = window_list;
+    node->window_order = window_order;
+    node->feedback_window = feedback_window;
+}
+
+static struct window_node *window_node_create(struct view *view)
+{
+    if (!view->pool.free_list) window_node_pool_grow(&view->pool);
+
+    struct window_node *node = view->pool.free_list;
+    view->pool.free_list = node->parent;
+    window_node_reset(node);
+
+    return node;
+}
+
+static void window_node_release(struct view *view, struct window_node *node)
+{
+    node->parent = view->pool.free_list;
+    view->pool.free_list = node;
+}
+
+struct window_node *window_node_find_first_leaf(struct window_node *root)
+{
+    struct window_node *node = root;
+    while (!window_node_is_leaf(node)) {
+        node = node->left;
+    }
+    return node;
+}
+
+struct window_node *window_node_find_last_leaf(struct window_node *root)
+{
+    struct window_node *node = root;
+    while (!window_node_is_leaf(node)) {
+        node = node->right;
+    }
+    return node;
+}
+
+struct window_node *window_node_find_prev_leaf(struct window_node *node)
+{
+    if (!node->parent) return NULL;
+
+    if (window_node_is_left_child(node)) {
+        return window_node_find_prev_leaf(node->parent);
+    }
+
+    if (window_node_is_leaf(node->parent->left)) {
+        return node->parent->left;
+    }
+
+    return window_node_find_first_leaf(node->parent->left->right);
+}
+
+struct window_node *window_node_find_next_leaf(struct window_node *node)
+{
+    if (!node->parent) return NULL;
+
+    if (window_node_is_right_child(node)) {
+        return window_node_find_next_leaf(node->parent);
+    }
+
+    if (window_node_is_leaf(node->parent->right)) {
+        return node->parent->right;
+    }
+
+    return window_node_find_first_leaf(node->parent->right->left);
+}
+
+//
+// NOTE(koekeishiya): For every direction we keep the leaves sorted by the edge that faces the
+// source window, stored as a key where a target lies in that direction iff key >= threshold.
+// West and north negate the far edge, so that all four lists are sorted in ascending order.
+// The list is rebuilt lazily when the layout has changed since the last directional query.
+//
+
+static inline float window_node_edge_key(struct area area, int dir)
+{
+    switch (dir) {
+    case EDGE_EAST:  return area.x;
+    case EDGE_SOUTH: return area.y;
+    case EDGE_WEST:  return -(area.x + area.w);
+    case EDGE_NORTH: return -(area.y + area.h);
+    }
+
+    return 0.0f;
+}
+
+static inline float window_node_edge_threshold(struct area area, int dir)
+{
+    switch (dir) {
+    case EDGE_EAST:  return area.x + area.w;
+    case EDGE_SOUTH: return area.y + area.h;
+    case EDGE_WEST:  return -area.x;
+    case EDGE_NORTH: return -area.y;
+    }
+
+    return 0.0f;
+}
+
+static inline float window_node_edge_center(CGPoint center, int dir)
+{
+    switch (dir) {
+    case EDGE_EAST:  return center.x;
+    case EDGE_SOUTH: return center.y;
+    case EDGE_WEST:  return -center.x;
+    case EDGE_NORTH: return -center.y;
+    }
+
+    return 0.0f;
+}
+
+static inline int window_node_edge_dir(int direction)
+{
+    switch (direction) {
+    case DIR_EAST:  return EDGE_EAST;
+    case DIR_SOUTH: return EDGE_SOUTH;
+    case DIR_WEST:  return EDGE_WEST;
+    case DIR_NORTH: return EDGE_NORTH;
+    }
+
+    return -1;
+}
+
+static int window_node_edge_compare(const void *a, const void *b)
+{
+    const struct window_node_edge *edge_a = a;
+    const struct window_node_edge *edge_b = b;
+
+    if (edge_a->key < edge_b->key) return -1;
+    if (edge_a->key > edge_b->key) return  1;
+
+    return edge_a->order - edge_b->order;
+}
+
+static void view_build_edge_index(struct view *view)
+{
+    struct window_node_edge_index *index = &view->edge_index;
+    index->count = 0;
+
+    struct window_node *node = window_node_find_first_leaf(view->root);
+    while (node) {
+        if (index->count == index->capacity) {
+            index->capacity = index->capacity ? 2 * index->capacity : 16;
+            for (int dir = 0; dir < EDGE_DIR_COUNT; ++dir) {
+                index->edges[dir] = realloc(index->edges[dir], sizeof(struct window_node_edge) * index->capacity);
+            }
+        }
+
+        for (int dir = 0; dir < EDGE_DIR_COUNT; ++dir) {
+            index->edges[dir][index->count] = (struct window_node_edge) {
+                .key   = window_node_edge_key(node->area, dir),
+                .order = index->count,
+                .node  = node
+            };
+        }
+
+        ++index->count;
+        node = window_node_find_next_leaf(node);
+    }
+
+    for (int dir = 0; dir < EDGE_DIR_COUNT; ++dir) {
+        qsort(index->edges[dir], index->count, sizeof(struct window_node_edge), window_node_edge_compare);
+    }
+
+    index->is_dirty = false;
+}
+
+static int window_node_edge_lower_bound(struct window_node_edge *edges, int count, float threshold)
+{
+    int first = 0;
+
+    while (count > 0) {
+        int step = count / 2;
+        if (edges[first + step].key < threshold) {
+            first += step + 1;
+            count -= step + 1;
+        } else {
+            count = step;
+        }
+    }
+
+    return first;
+}
+
+//
+// NOTE(koekeishiya): Candidates are visited in order of their facing edge. The center of a
+// candidate is never closer to the source center (along the query axis) than its facing edge,
+// so once that edge alone is further away than the best match, no later candidate can win.
+// Ties are resolved in favour of the earliest leaf, the same as a walk over all leaves.
+//
+
+struct window_node *view_find_window_node_in_direction(struct view *view, struct window_node *source, int direction)
+{
+    int dir = window_node_edge_dir(direction);
+    if (dir == -1) return NULL;
+
+    if (view->edge_index.is_dirty || !view->edge_index.capacity) {
+        view_build_edge_index(view);
+    }
+
+    int best_order = INT_MAX;
+    int best_distance = INT_MAX;
+    struct window_node *best_node = NULL;
+    CGPoint source_point = area_center(source->area);
+    float source_center = window_node_edge_center(source_point, dir);
+
+    struct window_node_edge *edges = view->edge_index.edges[dir];
+    int count = view->edge_index.count;
+    int first = window_node_edge_lower_bound(edges, count, window_node_edge_threshold(source->area, dir));
+
+    for (int i = first; i < count; ++i) {
+        int bound = edges[i].key - source_center;
+        if (bound * bound > best_distance) break;
+
+        int distance = euclidean_distance(source_point, area_center(edges[i].node->area));
+        if (distance < best_distance || (distance == best_distance && edges[i].order < best_order)) {
+            best_node = edges[i].node;
+            best_order = edges[i].order;
+            best_distance = distance;
+        }
+    }
+
+    return best_node;
+}
@@ -106,104 +106,139 @@ err:
     return space_list;
 }
 
-void window_serialize(FILE *rsp, struct window *window)
+//
+// NOTE(koekeishiya): Most of the properties we report for a window are read through the
+// accessibility API, which is a synchronous round trip to the owning process. Queries are
+// polled frequently by status bars, so we keep the last known values and only refresh the
+// ones that were invalidated by an event since the previous query. Opacity is not cached,
+// because the scripting-addition fades it asynchronously after we request a change.
+//
+
+void window_invalidate_attributes(struct window *window, uint32_t mask)
 {
-    char *role = NULL;
-    char *subrole = NULL;
-    char *title = window_title(window);
-    char *escaped_title = string_escape(title);
-    CGRect frame = window_frame(window);
-    uint64_t sid = window_space(window);
+    window->attributes.valid &= ~mask;
+}
+
+static struct window_attributes *window_attributes(struct window *window)
+{
+    struct window_attributes *attributes = &window->attributes;
+
+    if (attributes->generation != g_window_manager.attribute_generation) {
+        attributes->generation = g_window_manager.attribute_generation;
+        attributes->valid = 0;
+    }
+
+    uint32_t missing = ~attributes->valid & WINDOW_ATTRIBUTE_ALL;
+    if (!missing) return attributes;
+
+    if (missing & WINDOW_ATTRIBUTE_TITLE) {
+        if (attributes->title) free(attributes->title);
+        attributes->title = window_title(window);
+    }
+
+    if (missing & WINDOW_ATTRIBUTE_FRAME) {
+        attributes->frame = window_frame(window);
+    }
+
+    if (missing & WINDOW_ATTRIBUTE_SPACE) {
+        attributes->sid = window_space(window);
+    }
+
+    if (missing & WINDOW_ATTRIBUTE_LEVEL) {
+        attributes->level = window_level(window);
+    }
+
+    if (missing & WINDOW_ATTRIBUTE_ROLE) {
+        if (attributes->role) free(attributes->role);
+        if (attributes->subrole) free(attributes->subrole);
+        attributes->role = NULL;
+        attributes->subrole = NULL;
+
+        CFStringRef cfrole = window_role(window);
+        if (cfrole) {
+            attributes->role = cfstring_copy(cfrole);
+            CFRelease(cfrole);
+        }
+
+        CFStringRef cfsubrole = window_subrole(window);
+        if (cfsubrole) {
+            attributes->subrole = cfstring_copy(cfsubrole);
+            CFRelease(cfsubrole);
+        }
+    }
+
+    if (missing & WINDOW_ATTRIBUTE_CAPABILITY) {
+        attributes->can_move = window_can_move(window);
+        attributes->can_resize = window_can_resize(window);
+    }
+
+    if (missing & WINDOW_ATTRIBUTE_MINIMIZED) {
+        attributes->is_minimized = window_is_minimized(window);
+    }
+
+    if (missing & WINDOW_ATTRIBUTE_FULLSCREEN) {
+        attributes->is_fullscreen = window_is_fullscreen(window);
+    }
+
+    attributes->valid = WINDOW_ATTRIBUTE_ALL;
+    return attributes;
+}
+
+void window_serialize(struct json_writer *json, struct window *window)
+{
+    struct window_attributes *attributes = window_attributes(window);
+    CGRect frame = attributes->frame;
+    uint64_t sid = attributes->sid;
     int space = space_manager_mission_control_index(sid);
     int display = display_arrangement(space_display_id(sid));
-    bool is_topmost = window_is_topmost(window);
-    bool is_minimized = window_is_minimized(window);
+    bool is_topmost = attributes->level == CGWindowLevelForKey(LAYER_ABOVE);
+    bool is_minimized = attributes->is_minimized || window->is_minimized;
     bool visible = !is_minimized && (window->is_sticky || space_is_visible(sid));
     bool border = window->border.id ? 1 : 0;
     float opacity = window_opacity(window);
 
-    CFStringRef cfrole = window_role(window);
-    if (cfrole) {
-        role = cfstring_copy(cfrole);
-        CFRelease(cfrole);
-    }
-
-    CFStringRef cfsubrole = window_subrole(window);
-    if (cfsubrole) {
-        subrole = cfstring_copy(cfsubrole);
-        CFRelease(cfsubrole);
-    }
-
     struct view *view = window_manager_find_managed_window(&g_window_manager, window);
     struct window_node *node = view ? view_find_window_node(view, window->id) : NULL;
 
-    char split[MAXLEN];
-    snprintf(split, sizeof(split), "%s", window_node_split_str[node && node->parent ? node->parent->split : 0]);
+    const char *split = window_node_split_str[node && node->parent ? node->parent->split : 0];
     bool zoom_parent = node && node->zoom && node->zoom == node->parent;
     bool zoom_fullscreen = node && node->zoom && node->zoom == view->root;
     int stack_index = node && node->window_count > 1 ? window_node_index_of_window(node, window->id)+1 : 0;
 
-    fprintf(rsp,
-            "{\n"
-            "\t\"id\":%d,\n"
-            "\t\"pid\":%d,\n"
-            "\t\"app\":\"%s\",\n"
-            "\t\"title\":\"%s\",\n"
-            "\t\"frame\":{\n\t\t\"x\":%.4f,\n\t\t\"y\":%.4f,\n\t\t\"w\":%.4f,\n\t\t\"h\":%.4f\n\t},\n"
-            "\t\"level\":%d,\n"
-            "\t\"role\":\"%s\",\n"
-            "\t\"subrole\":\"%s\",\n"
-            "\t\"movable\":%d,\n"
-            "\t\"resizable\":%d,\n"
-            "\t\"display\":%d,\n"
-            "\t\"space\":%d,\n"
-            "\t\"visible\":%d,\n"
-            "\t\"focused\":%d,\n"
-            "\t\"split\":\"%s\",\n"
-            "\t\"floating\":%d,\n"
-            "\t\"sticky\":%d,\n"
-            "\t\"minimized\":%d,\n"
-            "\t\"topmost\":%d,\n"
-            "\t\"opacity\":%.4f,\n"
-            "\t\"shadow\":%d,\n"
-            "\t\"border\":%d,\n"
-            "\t\"stack-index\":%d,\n"
-            "\t\"zoom-parent\":%d,\n"
-            "\t\"zoom-fullscreen\":%d,\n"
-            "\t\"native-fullscreen\":%d\n"
-            "}",
-            window->id,
-            window->application->pid,
-            window->application->name,
-            escaped_title ? escaped_title : title ? title : "",
-            frame.origin.x, frame.origin.y,
-            frame.size.width, frame.size.height,
-            window_level(window),
-            role ? role : "",
-            subrole ? subrole : "",
-            window_can_move(window),
-            window_can_resize(window),
-            display,
-            space,
-            visible,
-            window->id == g_window_manager.focused_window_id,
-            split,
-            window->is_floating,
-            window->is_sticky,
-            is_minimized,
-            is_topmost,
-            opacity,
-            window->has_shadow,
-            border,
-            stack_index,
-            zoom_parent,
-            zoom_fullscreen,
-            window_is_fullscreen(window));
-
-    if (subrole) free(subrole);
-    if (role) free(role);
-    if (title) free(title);
-    if (escaped_title) free(escaped_title);
+    json_begin_object(json);
+    json_key(json, "id");                json_int(json, window->id);
+    json_key(json, "pid");               json_int(json, window->application->pid);
+    json_key(json, "app");               json_string(json, window->application->name);
+    json_key(json, "title");             json_string(json, attributes->title);
+    json_key(json, "frame");
+    json_begin_object(json);
+    json_key(json, "x");                 json_float(json, frame.origin.x);
+    json_key(json, "y");                 json_float(json, frame.origin.y);
+    json_key(json, "w");                 json_float(json, frame.size.width);
+    json_key(json, "h");                 json_float(json, frame.size.height);
+    json_end_object(json);
+    json_key(json, "level");             json_int(json, attributes->level);
+    json_key(json, "role");              json_string(json, attributes->role);
+    json_key(json, "subrole");           json_string(json, attributes->subrole);
+    json_key(json, "movable");           json_int(json, attributes->can_move);
+    json_key(json, "resizable");         json_int(json, attributes->can_resize);
+    json_key(json, "display");           json_int(json, display);
+    json_key(json, "space");             json_int(json, space);
+    json_key(json, "visible");           json_int(json, visible);
+    json_key(json, "focused");           json_int(json, window->id == g_window_manager.focused_window_id);
+    json_key(json, "split");             json_string(json, split);
+    json_key(json, "floating");          json_int(json, window->is_floating);
+    json_key(json, "sticky");            json_int(json, window->is_sticky);
+    json_key(json, "minimized");         json_int(json, is_minimized);
+    json_key(json, "topmost");           json_int(json, is_topmost);
+    json_key(json, "opacity");           json_float(json, opacity);
+    json_key(json, "shadow");            json_int(json, window->has_shadow);
+    json_key(json, "border");            json_int(json, border);
+    json_key(json, "stack-index");       json_int(json, stack_index);
+    json_key(json, "zoom-parent");       json_int(json, zoom_parent);
+    json_key(json, "zoom-fullscreen");   json_int(json, zoom_fullscreen);
+    json_key(json, "native-fullscreen"); json_int(json, attributes->is_fullscreen);
+    json_end_object(json);
 }
 
 char *window_title(struct window *window)
@@ -468,6 +503,9 @@ struct window *window_create(struct application *application, AXUIElementRef win
 
 void window_destroy(struct window *window)
 {
+    if (window->attributes.title) free(window->attributes.title);
+    if (window->attributes.role) free(window->attributes.role);
+    if (window->attributes.subrole) free(window->attributes.subrole);
     border_destroy(window);
     CFRelease(window->ref);
     free(window->id_ptr);
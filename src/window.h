@@ -38,6 +38,39 @@ static CFStringRef ax_window_notification[] =
     [AX_WINDOW_DEMINIMIZED_INDEX]    = kAXWindowDeminiaturizedNotification
 };
 
+#define WINDOW_ATTRIBUTE_TITLE       (1 << 0)
+#define WINDOW_ATTRIBUTE_FRAME       (1 << 1)
+#define WINDOW_ATTRIBUTE_SPACE       (1 << 2)
+#define WINDOW_ATTRIBUTE_LEVEL       (1 << 3)
+#define WINDOW_ATTRIBUTE_ROLE        (1 << 4)
+#define WINDOW_ATTRIBUTE_CAPABILITY  (1 << 5)
+#define WINDOW_ATTRIBUTE_MINIMIZED   (1 << 6)
+#define WINDOW_ATTRIBUTE_FULLSCREEN  (1 << 7)
+#define WINDOW_ATTRIBUTE_ALL         (WINDOW_ATTRIBUTE_TITLE |\
+                                      WINDOW_ATTRIBUTE_FRAME |\
+                                      WINDOW_ATTRIBUTE_SPACE |\
+                                      WINDOW_ATTRIBUTE_LEVEL |\
+                                      WINDOW_ATTRIBUTE_ROLE |\
+                                      WINDOW_ATTRIBUTE_CAPABILITY |\
+                                      WINDOW_ATTRIBUTE_MINIMIZED |\
+                                      WINDOW_ATTRIBUTE_FULLSCREEN)
+
+struct window_attributes
+{
+    uint64_t generation;
+    uint32_t valid;
+    char *title;
+    char *role;
+    char *subrole;
+    CGRect frame;
+    uint64_t sid;
+    int level;
+    bool can_move;
+    bool can_resize;
+    bool is_minimized;
+    bool is_fullscreen;
+};
+
 struct window
 {
     struct application *application;
@@ -54,14 +87,18 @@ struct window
     float opacity;
     bool rule_manage;
     bool rule_fullscreen;
+    bool has_applied_frame;
+    CGRect applied_frame;
     struct border border;
+    struct window_attributes attributes;
 };
 
 CFStringRef window_display_uuid(struct window *window);
 int window_display_id(struct window *window);
 uint64_t window_space(struct window *window);
 uint64_t *window_space_list(struct window *window, int *count);
-void window_serialize(FILE *rsp, struct window *window);
+void window_invalidate_attributes(struct window *window, uint32_t mask);
+void window_serialize(struct json_writer *json, struct window *window);
 char *window_title(struct window *window);
 CGRect window_ax_frame(struct window *window);
 CGRect window_frame(struct window *window);
@@ -3,26 +3,17 @@
 extern struct event_loop g_event_loop;
 extern struct process_manager g_process_manager;
 extern struct mouse_state g_mouse_state;
-
-static TABLE_HASH_FUNC(hash_wm)
-{
-    return *(uint32_t *) key;
-}
-
-static TABLE_COMPARE_FUNC(compare_wm)
-{
-    return *(uint32_t *) key_a == *(uint32_t *) key_b;
-}
+extern struct json_writer g_json_writer;
 
 void window_manager_query_window_rules(FILE *rsp)
 {
-    fprintf(rsp, "[");
+    struct json_writer *json = json_writer_begin(&g_json_writer);
+    json_begin_array(json);
     for (int i = 0; i < buf_len(g_window_manager.rules); ++i) {
-        struct rule *rule = &g_window_manager.rules[i];
-        rule_serialize(rsp, rule, i);
-        if (i < buf_len(g_window_manager.rules) - 1) fprintf(rsp, ",");
+        rule_serialize(json, &g_window_manager.rules[i], i);
     }
-    fprintf(rsp, "]\n");
+    json_end_array(json);
+    json_writer_end(json, rsp);
 }
 
 void window_manager_query_windows_for_space(FILE *rsp, uint64_t sid)
@@ -37,13 +28,13 @@ void window_manager_query_windows_for_space(FILE *rsp, uint64_t sid)
         if (window) buf_push(window_aggregate_list, window);
     }
 
-    fprintf(rsp, "[");
+    struct json_writer *json = json_writer_begin(&g_json_writer);
+    json_begin_array(json);
     for (int i = 0; i < buf_len(window_aggregate_list); ++i) {
-        struct window *window = window_aggregate_list[i];
-        window_serialize(rsp, window);
-        if (i < buf_len(window_aggregate_list) - 1) fprintf(rsp, ",");
+        window_serialize(json, window_aggregate_list[i]);
     }
-    fprintf(rsp, "]\n");
+    json_end_array(json);
+    json_writer_end(json, rsp);
 
     buf_free(window_aggregate_list);
     free(window_list);
@@ -69,13 +60,13 @@ void window_manager_query_windows_for_display(FILE *rsp, uint32_t did)
         free(window_list);
     }
 
-    fprintf(rsp, "[");
+    struct json_writer *json = json_writer_begin(&g_json_writer);
+    json_begin_array(json);
     for (int i = 0; i < buf_len(window_aggregate_list); ++i) {
-        struct window *window = window_aggregate_list[i];
-        window_serialize(rsp, window);
-        if (i < buf_len(window_aggregate_list) - 1) fprintf(rsp, ",");
+        window_serialize(json, window_aggregate_list[i]);
     }
-    fprintf(rsp, "]\n");
+    json_end_array(json);
+    json_writer_end(json, rsp);
 
     buf_free(window_aggregate_list);
     free(space_list);
@@ -109,26 +100,25 @@ void window_manager_query_windows_for_displays(FILE *rsp)
         free(space_list);
     }
 
-    fprintf(rsp, "[");
+    struct json_writer *json = json_writer_begin(&g_json_writer);
+    json_begin_array(json);
     for (int i = 0; i < buf_len(window_aggregate_list); ++i) {
-        struct window *window = window_aggregate_list[i];
-        window_serialize(rsp, window);
-        if (i < buf_len(window_aggregate_list) - 1) fprintf(rsp, ",");
+        window_serialize(json, window_aggregate_list[i]);
     }
-    fprintf(rsp, "]\n");
+    json_end_array(json);
+    json_writer_end(json, rsp);
 
     buf_free(window_aggregate_list);
     free(display_list);
 }
 
-void window_manager_apply_rule_to_window(struct space_manager *sm, struct window_manager *wm, struct window *window, struct rule *rule)
+void window_manager_invalidate_window_attributes(struct window_manager *wm)
 {
-    int regex_match_app = rule->app_regex_exclude ? REGEX_MATCH_YES : REGEX_MATCH_NO;
-    if (regex_match(rule->app_regex_valid,   &rule->app_regex,   window->application->name) == regex_match_app)   return;
-
-    int regex_match_title = rule->title_regex_exclude ? REGEX_MATCH_YES : REGEX_MATCH_NO;
-    if (regex_match(rule->title_regex_valid, &rule->title_regex, window_title(window))      == regex_match_title) return;
+    ++wm->attribute_generation;
+}
 
+static void window_manager_apply_rule_effects(struct space_manager *sm, struct window_manager *wm, struct window *window, struct rule *rule)
+{
     if (rule->sid || rule->did) {
         if (!window_is_fullscreen(window) && !space_is_fullscreen(window_space(window))) {
             uint64_t sid = rule->did ? display_space_id(rule->did) : rule->sid;
@@ -178,11 +168,28 @@ void window_manager_apply_rule_to_window(struct space_manager *sm, struct window
     }
 }
 
+void window_manager_apply_rule_to_window(struct space_manager *sm, struct window_manager *wm, struct window *window, struct rule *rule)
+{
+    struct rule_subject subject = { .window = window, .app = window->application->name };
+    if (rule_match(rule, &subject)) window_manager_apply_rule_effects(sm, wm, window, rule);
+    if (subject.title) free(subject.title);
+}
+
 void window_manager_apply_rules_to_window(struct space_manager *sm, struct window_manager *wm, struct window *window)
 {
-    for (int i = 0; i < buf_len(wm->rules); ++i) {
-        window_manager_apply_rule_to_window(sm, wm, window, &wm->rules[i]);
+    int rule_count = buf_len(wm->rules);
+    if (!rule_count) return;
+
+    struct rule_subject subject = { .window = window, .app = window->application->name };
+    bool *is_candidate = rule_find_candidates(&subject);
+
+    for (int i = 0; i < rule_count; ++i) {
+        if (is_candidate[i] && rule_match(&wm->rules[i], &subject)) {
+            window_manager_apply_rule_effects(sm, wm, window, &wm->rules[i]);
+        }
     }
+
+    if (subject.title) free(subject.title);
 }
 
 void window_manager_set_window_border_enabled(struct window_manager *wm, bool enabled)
@@ -190,18 +197,13 @@ void window_manager_set_window_border_enabled(struct window_manager *wm, bool en
     wm->enable_window_border = enabled;
 
     for (int window_index = 0; window_index < wm->window.capacity; ++window_index) {
-        struct bucket *bucket = wm->window.buckets[window_index];
-        while (bucket) {
-            if (bucket->value) {
-                struct window *window = bucket->value;
-                if (enabled) {
-                    border_create(window);
-                } else {
-                    border_destroy(window);
-                }
-            }
+        struct window *window = wm->window.buckets[window_index].value;
+        if (!window) continue;
 
-            bucket = bucket->next;
+        if (enabled) {
+            border_create(window);
+        } else {
+            border_destroy(window);
         }
     }
 
@@ -213,17 +215,12 @@ void window_manager_set_window_border_width(struct window_manager *wm, int width
 {
     wm->border_width = width;
     for (int window_index = 0; window_index < wm->window.capacity; ++window_index) {
-        struct bucket *bucket = wm->window.buckets[window_index];
-        while (bucket) {
-            if (bucket->value) {
-                struct window *window = bucket->value;
-                if (window->border.id) {
-                    CGContextSetLineWidth(window->border.context, width);
-                    border_redraw(window);
-                }
-            }
+        struct window *window = wm->window.buckets[window_index].value;
+        if (!window) continue;
 
-            bucket = bucket->next;
+        if (window->border.id) {
+            CGContextSetLineWidth(window->border.context, width);
+            border_redraw(window);
         }
     }
 }
@@ -239,16 +236,11 @@ void window_manager_set_normal_window_border_color(struct window_manager *wm, ui
 {
     wm->normal_border_color = rgba_color_from_hex(color);
     for (int window_index = 0; window_index < wm->window.capacity; ++window_index) {
-        struct bucket *bucket = wm->window.buckets[window_index];
-        while (bucket) {
-            if (bucket->value) {
-                struct window *window = bucket->value;
-                if (window->id != wm->focused_window_id) {
-                    border_deactivate(window);
-                }
-            }
+        struct window *window = wm->window.buckets[window_index].value;
+        if (!window) continue;
 
-            bucket = bucket->next;
+        if (window->id != wm->focused_window_id) {
+            border_deactivate(window);
         }
     }
 }
@@ -257,15 +249,10 @@ void window_manager_set_window_opacity_enabled(struct window_manager *wm, bool e
 {
     wm->enable_window_opacity = enabled;
     for (int window_index = 0; window_index < wm->window.capacity; ++window_index) {
-        struct bucket *bucket = wm->window.buckets[window_index];
-        while (bucket) {
-            if (bucket->value) {
-                struct window *window = bucket->value;
-                window_manager_set_opacity(wm, window, enabled ? window->opacity : 1.0f);
-            }
+        struct window *window = wm->window.buckets[window_index].value;
+        if (!window) continue;
 
-            bucket = bucket->next;
-        }
+        window_manager_set_opacity(wm, window, enabled ? window->opacity : 1.0f);
     }
 }
 
@@ -306,18 +293,18 @@ bool window_manager_should_manage_window(struct window *window)
 
 struct view *window_manager_find_managed_window(struct window_manager *wm, struct window *window)
 {
-    return table_find(&wm->managed_window, &window->id);
+    return wid_table_find(&wm->managed_window, window->id);
 }
 
 void window_manager_remove_managed_window(struct window_manager *wm, uint32_t wid)
 {
-    table_remove(&wm->managed_window, &wid);
+    wid_table_remove(&wm->managed_window, wid);
 }
 
 void window_manager_add_managed_window(struct window_manager *wm, struct window *window, struct view *view)
 {
     if (view->layout == VIEW_FLOAT) return;
-    table_add(&wm->managed_window, &window->id, view);
+    wid_table_add(&wm->managed_window, window->id, view);
     window_manager_purify_window(wm, window);
 }
 
@@ -419,6 +406,8 @@ void window_manager_move_window(struct window *window, float x, float y)
         if (window->border.id) SLSMoveWindow(g_connection, window->border.id, &position);
     }
 
+    window->has_applied_frame = false;
+    window_invalidate_attributes(window, WINDOW_ATTRIBUTE_FRAME);
     CFRelease(position_ref);
 }
 
@@ -429,29 +418,68 @@ void window_manager_resize_window(struct window *window, float width, float heig
     if (!size_ref) return;
 
     AXUIElementSetAttributeValue(window->ref, kAXSizeAttribute, size_ref);
+    window->has_applied_frame = false;
+    window_invalidate_attributes(window, WINDOW_ATTRIBUTE_FRAME);
     CFRelease(size_ref);
 }
 
 void window_manager_set_window_frame(struct window *window, float x, float y, float width, float height)
 {
-    window_manager_resize_window(window, width, height);
-    window_manager_move_window(window, x, y);
-    window_manager_resize_window(window, width, height);
+    struct frame_batch batch;
+    frame_batch_begin(&batch);
+    frame_batch_add(&batch, window, x, y, width, height);
+    frame_batch_commit(&batch);
+}
+
+static inline bool window_manager_frame_equals(CGRect a, CGRect b)
+{
+    return fabsf(a.origin.x - b.origin.x) < 1.0f &&
+           fabsf(a.origin.y - b.origin.y) < 1.0f &&
+           fabsf(a.size.width - b.size.width) < 1.0f &&
+           fabsf(a.size.height - b.size.height) < 1.0f;
+}
+
+//
+// NOTE(koekeishiya): Called when the system reports that a window was moved or resized. Our own
+// writes also end up here, so the cached frame is only discarded if the window is no longer where
+// we put it; either the user or the application itself changed it, or the write was clamped.
+//
+
+void window_manager_check_applied_frame(struct window *window)
+{
+    if (!window->has_applied_frame) return;
+
+    if (!window_manager_frame_equals(window->applied_frame, window_frame(window))) {
+        window->has_applied_frame = false;
+    }
+}
+
+static bool frame_batch_apply(struct window *window, CGRect frame)
+{
+    bool result = false;
+
+    CFTypeRef position_ref = AXValueCreate(kAXValueTypeCGPoint, (void *) &frame.origin);
+    CFTypeRef size_ref = AXValueCreate(kAXValueTypeCGSize, (void *) &frame.size);
+    if (!position_ref || !size_ref) goto out;
+
+    AXUIElementSetAttributeValue(window->ref, kAXSizeAttribute, size_ref);
+    result = AXUIElementSetAttributeValue(window->ref, kAXPositionAttribute, position_ref) == kAXErrorSuccess;
+    AXUIElementSetAttributeValue(window->ref, kAXSizeAttribute, size_ref);
+
+out:
+    if (position_ref) CFRelease(position_ref);
+    if (size_ref) CFRelease(size_ref);
+    return result;
 }
 
 void window_manager_set_purify_mode(struct window_manager *wm, enum purify_mode mode)
 {
     wm->purify_mode = mode;
     for (int window_index = 0; window_index < wm->window.capacity; ++window_index) {
-        struct bucket *bucket = wm->window.buckets[window_index];
-        while (bucket) {
-            if (bucket->value) {
-                struct window *window = bucket->value;
-                window_manager_purify_window(wm, window);
-            }
+        struct window *window = wm->window.buckets[window_index].value;
+        if (!window) continue;
 
-            bucket = bucket->next;
-        }
+        window_manager_purify_window(wm, window);
     }
 }
 
@@ -488,23 +516,18 @@ void window_manager_set_normal_window_opacity(struct window_manager *wm, float o
 {
     wm->normal_window_opacity = opacity;
     for (int window_index = 0; window_index < wm->window.capacity; ++window_index) {
-        struct bucket *bucket = wm->window.buckets[window_index];
-        while (bucket) {
-            if (bucket->value) {
-                struct window *window = bucket->value;
-                if (window->id == wm->focused_window_id) goto next;
-                window_manager_set_window_opacity(wm, window, wm->normal_window_opacity);
-            }
+        struct window *window = wm->window.buckets[window_index].value;
+        if (!window) continue;
 
-next:
-            bucket = bucket->next;
-        }
+        if (window->id == wm->focused_window_id) continue;
+        window_manager_set_window_opacity(wm, window, wm->normal_window_opacity);
     }
 }
 
 void window_manager_set_window_layer(struct window *window, int layer)
 {
     scripting_addition_set_layer(window->id, layer);
+    window_invalidate_attributes(window, WINDOW_ATTRIBUTE_LEVEL);
 
     CFArrayRef window_list = SLSCopyAssociatedWindows(g_connection, window->id);
     if (!window_list) return;
@@ -867,62 +890,62 @@ struct window *window_manager_focused_window(struct window_manager *wm)
 
 bool window_manager_find_lost_front_switched_event(struct window_manager *wm, pid_t pid)
 {
-    return table_find(&wm->application_lost_front_switched_event, &pid) != NULL;
+    return pid_table_find(&wm->application_lost_front_switched_event, pid) != NULL;
 }
 
 void window_manager_remove_lost_front_switched_event(struct window_manager *wm, pid_t pid)
 {
-    table_remove(&wm->application_lost_front_switched_event, &pid);
+    pid_table_remove(&wm->application_lost_front_switched_event, pid);
 }
 
 void window_manager_add_lost_front_switched_event(struct window_manager *wm, pid_t pid)
 {
-    table_add(&wm->application_lost_front_switched_event, &pid, (void *)(intptr_t) 1);
+    pid_table_add(&wm->application_lost_front_switched_event, pid, (void *)(intptr_t) 1);
 }
 
 bool window_manager_find_lost_focused_event(struct window_manager *wm, uint32_t window_id)
 {
-    return table_find(&wm->window_lost_focused_event, &window_id) != NULL;
+    return wid_table_find(&wm->window_lost_focused_event, window_id) != NULL;
 }
 
 void window_manager_remove_lost_focused_event(struct window_manager *wm, uint32_t window_id)
 {
-    table_remove(&wm->window_lost_focused_event, &window_id);
+    wid_table_remove(&wm->window_lost_focused_event, window_id);
 }
 
 void window_manager_add_lost_focused_event(struct window_manager *wm, uint32_t window_id)
 {
-    table_add(&wm->window_lost_focused_event, &window_id, (void *)(intptr_t) 1);
+    wid_table_add(&wm->window_lost_focused_event, window_id, (void *)(intptr_t) 1);
 }
 
 struct window *window_manager_find_window(struct window_manager *wm, uint32_t window_id)
 {
-    return table_find(&wm->window, &window_id);
+    return wid_table_find(&wm->window, window_id);
 }
 
 void window_manager_remove_window(struct window_manager *wm, uint32_t window_id)
 {
-    table_remove(&wm->window, &window_id);
+    wid_table_remove(&wm->window, window_id);
 }
 
 void window_manager_add_window(struct window_manager *wm, struct window *window)
 {
-    table_add(&wm->window, &window->id, window);
+    wid_table_add(&wm->window, window->id, window);
 }
 
 struct application *window_manager_find_application(struct window_manager *wm, pid_t pid)
 {
-    return table_find(&wm->application, &pid);
+    return pid_table_find(&wm->application, pid);
 }
 
 void window_manager_remove_application(struct window_manager *wm, pid_t pid)
 {
-    table_remove(&wm->application, &pid);
+    pid_table_remove(&wm->application, pid);
 }
 
 void window_manager_add_application(struct window_manager *wm, struct application *application)
 {
-    table_add(&wm->application, &application->pid, application);
+    pid_table_add(&wm->application, application->pid, application);
 }
 
 struct window **window_manager_find_application_windows(struct window_manager *wm, struct application *application)
@@ -930,16 +953,11 @@ struct window **window_manager_find_application_windows(struct window_manager *w
     struct window **window_list = NULL;
 
     for (int window_index = 0; window_index < wm->window.capacity; ++window_index) {
-        struct bucket *bucket = wm->window.buckets[window_index];
-        while (bucket) {
-            if (bucket->value) {
-                struct window *window = bucket->value;
-                if (window->application == application) {
-                    buf_push(window_list, window);
-                }
-            }
+        struct window *window = wm->window.buckets[window_index].value;
+        if (!window) continue;
 
-            bucket = bucket->next;
+        if (window->application == application) {
+            buf_push(window_list, window);
         }
     }
 
@@ -1126,7 +1144,7 @@ enum window_op_error window_manager_warp_window(struct space_manager *sm, struct
                 a_view->insertion_point = b->id;
             }
 
-            window_node_swap_window_list(a_node, b_node);
+            window_node_swap_window_list(a_view, a_node, b_view, b_node);
 
             window_node_flush(a_node);
             window_node_flush(b_node);
@@ -1182,7 +1200,7 @@ enum window_op_error window_manager_swap_window(struct space_manager *sm, struct
         b_view->insertion_point = a->id;
     }
 
-    window_node_swap_window_list(a_node, b_node);
+    window_node_swap_window_list(a_view, a_node, b_view, b_node);
 
     if (a_view->sid != b_view->sid) {
         for (int i = 0; i < a_node->window_count; ++i) {
@@ -1345,6 +1363,8 @@ void window_manager_make_window_sticky(struct space_manager *sm, struct window_m
     } else {
         if (scripting_addition_set_sticky(window->id, false)) window->is_sticky = false;
     }
+
+    window_invalidate_attributes(window, WINDOW_ATTRIBUTE_SPACE);
 }
 
 void window_manager_toggle_window_shadow(struct space_manager *sm, struct window_manager *wm, struct window *window)
@@ -1431,6 +1451,7 @@ void window_manager_toggle_window_pip(struct space_manager *sm, struct window_ma
     }
 
     scripting_addition_scale_window(window->id, bounds.origin.x, bounds.origin.y, bounds.size.width, bounds.size.height);
+    window->has_applied_frame = false;
 }
 
 void window_manager_toggle_window_border(struct window_manager *wm, struct window *window)
@@ -1553,32 +1574,27 @@ void window_manager_init(struct window_manager *wm)
     wm->normal_border_color = rgba_color_from_hex(0xff555555);
     wm->border_width = 6;
 
-    table_init(&wm->application, 150, hash_wm, compare_wm);
-    table_init(&wm->window, 150, hash_wm, compare_wm);
-    table_init(&wm->managed_window, 150, hash_wm, compare_wm);
-    table_init(&wm->window_lost_focused_event, 150, hash_wm, compare_wm);
-    table_init(&wm->application_lost_front_switched_event, 150, hash_wm, compare_wm);
+    pid_table_init(&wm->application, 150);
+    wid_table_init(&wm->window, 150);
+    wid_table_init(&wm->managed_window, 150);
+    wid_table_init(&wm->window_lost_focused_event, 150);
+    pid_table_init(&wm->application_lost_front_switched_event, 150);
 }
 
 void window_manager_begin(struct space_manager *sm, struct window_manager *wm)
 {
     for (int process_index = 0; process_index < g_process_manager.process.capacity; ++process_index) {
-        struct bucket *bucket = g_process_manager.process.buckets[process_index];
-        while (bucket) {
-            if (bucket->value) {
-                struct process *process = bucket->value;
-                struct application *application = application_create(process);
-
-                if (application_observe(application)) {
-                    window_manager_add_application(wm, application);
-                    window_manager_add_application_windows(sm, wm, application);
-                } else {
-                    application_unobserve(application);
-                    application_destroy(application);
-                }
-            }
+        struct process *process = g_process_manager.process.buckets[process_index].value;
+        if (!process) continue;
 
-            bucket = bucket->next;
+        struct application *application = application_create(process);
+
+        if (application_observe(application)) {
+            window_manager_add_application(wm, application);
+            window_manager_add_application_windows(sm, wm, application);
+        } else {
+            application_unobserve(application);
+            application_destroy(application);
         }
     }
 
@@ -70,11 +70,11 @@ static const char *ffm_mode_str[] =
 struct window_manager
 {
     AXUIElementRef system_element;
-    struct table application;
-    struct table window;
-    struct table managed_window;
-    struct table window_lost_focused_event;
-    struct table application_lost_front_switched_event;
+    pid_table application;
+    wid_table window;
+    wid_table managed_window;
+    wid_table window_lost_focused_event;
+    pid_table application_lost_front_switched_event;
     struct rule *rules;
     uint32_t focused_window_id;
     ProcessSerialNumber focused_window_psn;
@@ -93,12 +93,14 @@ struct window_manager
     struct rgba_color insert_feedback_color;
     struct rgba_color active_border_color;
     struct rgba_color normal_border_color;
+    uint64_t attribute_generation;
 };
 
 void window_manager_query_window_rules(FILE *rsp);
 void window_manager_query_windows_for_space(FILE *rsp, uint64_t sid);
 void window_manager_query_windows_for_display(FILE *rsp, uint32_t did);
 void window_manager_query_windows_for_displays(FILE *rsp);
+void window_manager_invalidate_window_attributes(struct window_manager *wm);
 void window_manager_apply_rule_to_window(struct space_manager *sm, struct window_manager *wm, struct window *window, struct rule *rule);
 void window_manager_apply_rules_to_window(struct space_manager *sm, struct window_manager *wm, struct window *window);
 void window_manager_center_mouse(struct window_manager *wm, struct window *window);
@@ -108,6 +110,7 @@ void window_manager_move_window(struct window *window, float x, float y);
 void window_manager_resize_window(struct window *window, float width, float height);
 enum window_op_error window_manager_adjust_window_ratio(struct window_manager *wm, struct window *window, int action, float ratio);
 void window_manager_set_window_frame(struct window *window, float x, float y, float width, float height);
+void window_manager_check_applied_frame(struct window *window);
 struct window *window_manager_find_window_on_space_by_rank(struct window_manager *wm, uint64_t sid, int rank);
 struct window *window_manager_find_window_at_point_filtering_window(struct window_manager *wm, CGPoint point, uint32_t filter_wid);
 struct window *window_manager_find_window_at_point(struct window_manager *wm, CGPoint point);
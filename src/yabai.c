@@ -5,6 +5,8 @@
 
 #define CLIENT_OPT_LONG         "--message"
 #define CLIENT_OPT_SHRT         "-m"
+#define CLIENT_BATCH_OPT        "--batch"
+#define CLIENT_BATCH_MAX_PENDING 32
 
 #define DEBUG_VERBOSE_OPT_LONG  "--verbose"
 #define DEBUG_VERBOSE_OPT_SHRT  "-V"
@@ -35,6 +37,7 @@ struct window_manager g_window_manager;
 struct mouse_state g_mouse_state;
 struct event_tap g_event_tap;
 struct daemon g_daemon;
+struct json_writer g_json_writer;
 int g_normal_window_level;
 int g_floating_window_level;
 int g_connection;
@@ -47,6 +50,137 @@ char g_config_file[4096];
 char g_lock_file[MAXLEN];
 bool g_verbose;
 
+//
+// NOTE(koekeishiya): Split a line into arguments the same way a shell would for the kind of
+// commands we accept; whitespace separates arguments, quotes group them and a backslash escapes
+// the next character. The arguments are written back into the line separated by NUL, which is
+// the format the daemon expects. Returns the length of the message, or -1 on a missing quote.
+//
+
+static int client_parse_batch_line(char *line)
+{
+    char *cursor = line;
+    char *message = line;
+    bool in_argument = false;
+    char quote = 0;
+
+    while (isspace((unsigned char) *cursor)) ++cursor;
+    if (*cursor == '#') return 0;
+
+    for (; *cursor; ++cursor) {
+        char c = *cursor;
+
+        if (quote) {
+            if (c == quote) {
+                quote = 0;
+                continue;
+            }
+
+            if (c == '\\' && quote == '"' && (cursor[1] == '"' || cursor[1] == '\\')) {
+                c = *++cursor;
+            }
+
+            *message++ = c;
+        } else if (isspace((unsigned char) c)) {
+            if (in_argument) *message++ = '\0';
+            in_argument = false;
+        } else if (c == '\'' || c == '"') {
+            quote = c;
+            in_argument = true;
+        } else {
+            if (c == '\\' && cursor[1]) c = *++cursor;
+            *message++ = c;
+            in_argument = true;
+        }
+    }
+
+    if (quote) return -1;
+    if (in_argument) *message++ = '\0';
+
+    return message - line;
+}
+
+static bool client_read_batch_response(int sockfd, int *result)
+{
+    uint32_t length;
+    char *rsp = socket_read_frame_alloc(sockfd, UINT32_MAX, &length);
+    if (!rsp) return false;
+
+    if (length > 0 && rsp[0] == FAILURE_MESSAGE[0]) {
+        *result = EXIT_FAILURE;
+        fwrite(rsp + 1, 1, length - 1, stderr);
+        fflush(stderr);
+    } else {
+        fwrite(rsp, 1, length, stdout);
+        fflush(stdout);
+    }
+
+    free(rsp);
+    return true;
+}
+
+//
+// NOTE(koekeishiya): Read one command per line from stdin and send them all over the same
+// connection. Commands are pipelined; we only wait for a response once CLIENT_BATCH_MAX_PENDING
+// commands are in flight, which keeps the daemon from blocking on a client that is not reading.
+// The exit code is non-zero if any of the commands failed.
+//
+
+static int client_send_batch(int sockfd)
+{
+    signal(SIGPIPE, SIG_IGN);
+
+    if (!socket_write_bytes(sockfd, SOCKET_SESSION_MAGIC, SOCKET_SESSION_MAGIC_LEN)) {
+        error("yabai-msg: failed to send data..\n");
+    }
+
+    int result = EXIT_SUCCESS;
+    int pending = 0;
+    int line_number = 0;
+
+    char *line = NULL;
+    size_t line_size = 0;
+
+    while (getline(&line, &line_size, stdin) != -1) {
+        ++line_number;
+
+        int message_length = client_parse_batch_line(line);
+        if (message_length == 0) continue;
+
+        if (message_length < 0) {
+            result = EXIT_FAILURE;
+            fprintf(stderr, "yabai-msg: unterminated quote on line %d\n", line_number);
+            fflush(stderr);
+            continue;
+        }
+
+        if (!socket_write_frame(sockfd, line, message_length)) {
+            error("yabai-msg: failed to send data..\n");
+        }
+
+        if (++pending == CLIENT_BATCH_MAX_PENDING) {
+            if (!client_read_batch_response(sockfd, &result)) {
+                error("yabai-msg: failed to read response..\n");
+            }
+
+            --pending;
+        }
+    }
+
+    shutdown(sockfd, SHUT_WR);
+
+    for (; pending > 0; --pending) {
+        if (!client_read_batch_response(sockfd, &result)) {
+            error("yabai-msg: failed to read response..\n");
+        }
+    }
+
+    free(line);
+    socket_close(sockfd);
+
+    return result;
+}
+
 static int client_send_message(int argc, char **argv)
 {
     if (argc <= 1) {
@@ -66,6 +200,10 @@ static int client_send_message(int argc, char **argv)
         error("yabai-msg: failed to connect to socket..\n");
     }
 
+    if (argc == 2 && string_equals(argv[1], CLIENT_BATCH_OPT)) {
+        return client_send_batch(sockfd);
+    }
+
     int message_length = argc - 1;
     int argl[argc];
 
@@ -273,6 +411,10 @@ int main(int argc, char **argv)
     init_misc_settings();
     acquire_lockfile();
 
+    if (!event_signal_executor_begin()) {
+        warn("yabai: could not start signal executor, signals will be executed by forking the daemon..\n");
+    }
+
     if (!space_manager_has_separate_spaces()) {
         error("yabai: 'display has separate spaces' is disabled! abort..\n");
     }
@@ -0,0 +1,41 @@
+#ifndef TEST_COMPAT_H
+#define TEST_COMPAT_H
+
+//
+// NOTE(koekeishiya): Stand-ins for the few CoreFoundation, CoreGraphics and Carbon types that
+// the portable parts of the daemon refer to, so that those parts can be built off macOS. Only
+// layout-compatible plain structs belong here; nothing in this file may call into a framework.
+//
+
+#include <sys/types.h>
+
+typedef double CGFloat;
+typedef const void *CFTypeRef;
+typedef const struct __CFString *CFStringRef;
+typedef struct CGContext *CGContextRef;
+
+typedef struct
+{
+    CGFloat x;
+    CGFloat y;
+} CGPoint;
+
+typedef struct
+{
+    CGFloat width;
+    CGFloat height;
+} CGSize;
+
+typedef struct
+{
+    CGPoint origin;
+    CGSize size;
+} CGRect;
+
+typedef struct
+{
+    uint32_t highLongOfPSN;
+    uint32_t lowLongOfPSN;
+} ProcessSerialNumber;
+
+#endif
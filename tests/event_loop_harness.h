@@ -0,0 +1,88 @@
+#ifndef EVENT_LOOP_HARNESS_H
+#define EVENT_LOOP_HARNESS_H
+
+#include "misc/socket.h"
+#include "misc/socket.c"
+
+#include "event.h"
+#include "event_loop.h"
+
+//
+// NOTE(koekeishiya): event_loop.c is compiled as-is; the handlers and the few daemon functions
+// that it calls are replaced by the definitions below. Every handler forwards to
+// harness_handler, which a test points at its own function.
+//
+
+typedef uint32_t harness_handler_fn(enum event_type type, void *context, int param1);
+static harness_handler_fn *harness_handler;
+
+static volatile uint64_t harness_released;
+static volatile uint64_t harness_destroyed;
+static volatile uint64_t harness_signals;
+
+struct process;
+
+static void process_destroy(struct process *process) { __atomic_add_fetch(&harness_destroyed, 1, __ATOMIC_RELAXED); }
+static void CFRelease(void *ref) { __atomic_add_fetch(&harness_released, 1, __ATOMIC_RELAXED); }
+void scripting_addition_begin_batch(void) {}
+void scripting_addition_end_batch(void) {}
+void event_signal_transmit(void *context, enum event_type type) { __atomic_add_fetch(&harness_signals, 1, __ATOMIC_RELAXED); }
+
+#define HARNESS_HANDLER(type) \
+    static EVENT_CALLBACK(EVENT_HANDLER_##type) \
+    { \
+        return harness_handler ? harness_handler(type, context, param1) : EVENT_SUCCESS; \
+    }
+
+HARNESS_HANDLER(APPLICATION_LAUNCHED)
+HARNESS_HANDLER(APPLICATION_TERMINATED)
+HARNESS_HANDLER(APPLICATION_FRONT_SWITCHED)
+HARNESS_HANDLER(APPLICATION_ACTIVATED)
+HARNESS_HANDLER(APPLICATION_DEACTIVATED)
+HARNESS_HANDLER(APPLICATION_VISIBLE)
+HARNESS_HANDLER(APPLICATION_HIDDEN)
+HARNESS_HANDLER(WINDOW_CREATED)
+HARNESS_HANDLER(WINDOW_DESTROYED)
+HARNESS_HANDLER(WINDOW_FOCUSED)
+HARNESS_HANDLER(WINDOW_MOVED)
+HARNESS_HANDLER(WINDOW_RESIZED)
+HARNESS_HANDLER(WINDOW_MINIMIZED)
+HARNESS_HANDLER(WINDOW_DEMINIMIZED)
+HARNESS_HANDLER(WINDOW_TITLE_CHANGED)
+HARNESS_HANDLER(SPACE_CHANGED)
+HARNESS_HANDLER(DISPLAY_ADDED)
+HARNESS_HANDLER(DISPLAY_REMOVED)
+HARNESS_HANDLER(DISPLAY_MOVED)
+HARNESS_HANDLER(DISPLAY_RESIZED)
+HARNESS_HANDLER(DISPLAY_CHANGED)
+HARNESS_HANDLER(MOUSE_DOWN)
+HARNESS_HANDLER(MOUSE_UP)
+HARNESS_HANDLER(MOUSE_DRAGGED)
+HARNESS_HANDLER(MOUSE_MOVED)
+HARNESS_HANDLER(MISSION_CONTROL_ENTER)
+HARNESS_HANDLER(MISSION_CONTROL_CHECK_FOR_EXIT)
+HARNESS_HANDLER(MISSION_CONTROL_EXIT)
+HARNESS_HANDLER(DOCK_DID_RESTART)
+HARNESS_HANDLER(MENU_OPENED)
+HARNESS_HANDLER(MENU_BAR_HIDDEN_CHANGED)
+HARNESS_HANDLER(DOCK_DID_CHANGE_PREF)
+HARNESS_HANDLER(SYSTEM_WOKE)
+HARNESS_HANDLER(DAEMON_MESSAGE)
+HARNESS_HANDLER(DAEMON_SESSION_MESSAGE)
+
+#include "event_loop.c"
+
+//
+// NOTE(koekeishiya): The loop allocates its ring and opens a semaphore; both are released here
+// so that a test can run several loops back to back.
+//
+
+static void harness_event_loop_destroy(struct event_loop *event_loop)
+{
+    free(event_loop->queue.slots);
+    buf_free(event_loop->overflow.events);
+    pthread_mutex_destroy(&event_loop->overflow.lock);
+    sem_close(event_loop->semaphore);
+}
+
+#endif
@@ -0,0 +1,306 @@
+#include "test.h"
+#include "event_loop_harness.h"
+
+#define GATE       -1
+#define PRODUCERS   8
+#define PER_THREAD  100000
+
+static struct event_loop g_event_loop;
+
+static volatile int gate_open;
+static volatile int gate_entered;
+static volatile uint64_t handled;
+static volatile uint64_t out_of_order;
+static volatile uint64_t handled_type[EVENT_TYPE_COUNT];
+static int *order;
+static int self_post_count;
+static uint64_t self_post_elapsed;
+
+static void wait_for(volatile uint64_t *counter, uint64_t target)
+{
+    uint64_t deadline = test_now_ns() + 30ULL * 1000000000ULL;
+    while (__atomic_load_n(counter, __ATOMIC_ACQUIRE) < target && test_now_ns() < deadline) usleep(100);
+}
+
+static void wait_for_gate(void)
+{
+    while (!__atomic_load_n(&gate_entered, __ATOMIC_ACQUIRE)) usleep(100);
+}
+
+static void reset(void)
+{
+    gate_open = 0;
+    gate_entered = 0;
+    handled = 0;
+    out_of_order = 0;
+    self_post_count = 0;
+    self_post_elapsed = 0;
+    memset((void *) handled_type, 0, sizeof(handled_type));
+    harness_released = 0;
+    harness_destroyed = 0;
+    buf_free(order);
+    order = NULL;
+}
+
+static void begin(harness_handler_fn *handler)
+{
+    reset();
+    harness_handler = handler;
+    expect(event_loop_init(&g_event_loop));
+    expect(event_loop_begin(&g_event_loop));
+}
+
+static void end(void)
+{
+    event_loop_end(&g_event_loop);
+    harness_event_loop_destroy(&g_event_loop);
+    harness_handler = NULL;
+}
+
+static uint32_t record_handler(enum event_type type, void *context, int param1)
+{
+    if (param1 == GATE) {
+        __atomic_store_n(&gate_entered, 1, __ATOMIC_RELEASE);
+        while (!__atomic_load_n(&gate_open, __ATOMIC_ACQUIRE)) usleep(100);
+
+        for (int i = 0; i < self_post_count; ++i) {
+            uint64_t start = test_now_ns();
+            event_loop_post(&g_event_loop, WINDOW_FOCUSED, NULL, i, NULL);
+            self_post_elapsed += test_now_ns() - start;
+        }
+
+        return EVENT_SUCCESS;
+    }
+
+    buf_push(order, param1);
+    __atomic_add_fetch(&handled_type[type], 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&handled, 1, __ATOMIC_RELEASE);
+    return EVENT_SUCCESS;
+}
+
+TEST(queue_is_bounded_and_fifo)
+{
+    struct queue queue;
+    struct event event = {0};
+    expect(queue_init(&queue));
+
+    for (int lap = 0; lap < 3; ++lap) {
+        expect(queue_is_empty(&queue));
+
+        for (int i = 0; i < EVENT_QUEUE_SIZE; ++i) {
+            event.param1 = lap * EVENT_QUEUE_SIZE + i;
+            expect(queue_push(&queue, &event));
+        }
+
+        event.param1 = -1;
+        expect(!queue_push(&queue, &event));
+        expect(!queue_is_empty(&queue));
+
+        int in_order = 0;
+        for (int i = 0; i < EVENT_QUEUE_SIZE; ++i) {
+            in_order += queue_pop(&queue, &event) && event.param1 == lap * EVENT_QUEUE_SIZE + i;
+        }
+
+        expect_eq(in_order, EVENT_QUEUE_SIZE);
+        expect(!queue_pop(&queue, &event));
+    }
+
+    free(queue.slots);
+}
+
+TEST(overflow_preserves_order)
+{
+    int count = 2 * EVENT_QUEUE_SIZE;
+    begin(record_handler);
+
+    event_loop_post(&g_event_loop, WINDOW_FOCUSED, NULL, GATE, NULL);
+    wait_for_gate();
+
+    for (int i = 0; i < count; ++i) {
+        expect(event_loop_post(&g_event_loop, WINDOW_FOCUSED, NULL, i, NULL));
+    }
+
+    expect_eq(g_event_loop.stats.overflowed, count - EVENT_QUEUE_SIZE);
+    expect_eq(g_event_loop.stats.stalled, 1);
+
+    __atomic_store_n(&gate_open, 1, __ATOMIC_RELEASE);
+    wait_for(&handled, count);
+
+    expect_eq(handled, count);
+    expect_eq(buf_len(order), count);
+
+    int in_order = 0;
+    for (int i = 0; i < buf_len(order); ++i) in_order += order[i] == i;
+    expect_eq(in_order, count);
+    expect_eq(g_event_loop.stats.dropped, 0);
+
+    end();
+}
+
+TEST(consumer_post_never_waits)
+{
+    begin(record_handler);
+    self_post_count = 3 * EVENT_QUEUE_SIZE;
+    gate_open = 1;
+
+    event_loop_post(&g_event_loop, WINDOW_FOCUSED, NULL, GATE, NULL);
+    wait_for(&handled, self_post_count);
+
+    expect_eq(handled, self_post_count);
+    expect_eq(g_event_loop.stats.stalled, 0);
+    expect_eq(g_event_loop.stats.dropped, 0);
+    expect(g_event_loop.stats.overflowed >= (uint64_t)(self_post_count - EVENT_QUEUE_SIZE));
+
+    //
+    // NOTE(koekeishiya): A single retry would already cost EVENT_QUEUE_RETRY_DELAY; the bound
+    // is loose enough for a sanitizer build but far below one delay per overflowed event.
+    //
+
+    expect(self_post_elapsed < 500ULL * 1000000ULL);
+
+    int in_order = 0;
+    for (int i = 0; i < buf_len(order); ++i) in_order += order[i] == i;
+    expect_eq(in_order, self_post_count);
+
+    end();
+}
+
+TEST(only_mouse_motion_and_messages_are_dropped)
+{
+    int fds[2];
+    char reply[64] = {0};
+    volatile uint32_t info = 0;
+
+    begin(record_handler);
+    expect(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+    event_loop_post(&g_event_loop, WINDOW_FOCUSED, NULL, GATE, NULL);
+    wait_for_gate();
+
+    for (int i = 0; i < EVENT_QUEUE_SIZE; ++i) {
+        event_loop_post(&g_event_loop, WINDOW_FOCUSED, NULL, i, NULL);
+    }
+
+    expect(!event_loop_post(&g_event_loop, MOUSE_MOVED, (void *) 0x1, 0, &info));
+    expect_eq(event_status(info), EVENT_PROCESSED);
+    expect_eq(event_result(info), EVENT_FAILURE);
+    expect(!event_loop_post(&g_event_loop, MOUSE_DRAGGED, (void *) 0x1, 0, NULL));
+    expect_eq(harness_released, 2);
+
+    expect(!event_loop_post(&g_event_loop, DAEMON_MESSAGE, strdup("query --windows"), fds[0], NULL));
+    expect(read(fds[1], reply, sizeof(reply) - 1) > 0);
+    expect(reply[0] == FAILURE_MESSAGE[0]);
+
+    expect(!event_loop_post(&g_event_loop, DAEMON_SESSION_MESSAGE, NULL, 0, NULL));
+    expect_eq(g_event_loop.stats.dropped, 4);
+
+    expect(event_loop_post(&g_event_loop, WINDOW_CREATED, (void *) 0x1, EVENT_QUEUE_SIZE, NULL));
+    expect(event_loop_post(&g_event_loop, APPLICATION_TERMINATED, (void *) 0x1, EVENT_QUEUE_SIZE + 1, NULL));
+    expect(event_loop_post(&g_event_loop, SPACE_CHANGED, NULL, EVENT_QUEUE_SIZE + 2, NULL));
+    expect_eq(g_event_loop.stats.overflowed, 3);
+
+    __atomic_store_n(&gate_open, 1, __ATOMIC_RELEASE);
+    wait_for(&handled, EVENT_QUEUE_SIZE + 3);
+
+    expect_eq(handled, EVENT_QUEUE_SIZE + 3);
+    expect_eq(handled_type[WINDOW_CREATED], 1);
+    expect_eq(handled_type[APPLICATION_TERMINATED], 1);
+    expect_eq(handled_type[SPACE_CHANGED], 1);
+    expect_eq(handled_type[MOUSE_MOVED], 0);
+    expect_eq(handled_type[DAEMON_MESSAGE], 0);
+    expect_eq(harness_released, 3);
+    expect_eq(harness_destroyed, 1);
+    expect_eq(g_event_loop.stats.dropped, 4);
+
+    close(fds[1]);
+    end();
+}
+
+TEST(window_moved_is_coalesced_while_pending)
+{
+    begin(record_handler);
+
+    event_loop_post(&g_event_loop, WINDOW_FOCUSED, NULL, GATE, NULL);
+    wait_for_gate();
+
+    for (int i = 0; i < 100; ++i) {
+        expect(event_loop_post(&g_event_loop, WINDOW_MOVED, (void *)(uintptr_t) 7, 0, NULL));
+        expect(event_loop_post(&g_event_loop, WINDOW_RESIZED, (void *)(uintptr_t) 7, 0, NULL));
+    }
+
+    expect_eq(g_event_loop.stats.coalesced, 198);
+
+    __atomic_store_n(&gate_open, 1, __ATOMIC_RELEASE);
+    wait_for(&handled, 2);
+    expect_eq(handled_type[WINDOW_MOVED], 1);
+    expect_eq(handled_type[WINDOW_RESIZED], 1);
+
+    expect(event_loop_post(&g_event_loop, WINDOW_MOVED, (void *)(uintptr_t) 7, 0, NULL));
+    wait_for(&handled, 3);
+    expect_eq(handled_type[WINDOW_MOVED], 2);
+
+    end();
+}
+
+static volatile int last_seen[PRODUCERS];
+
+static uint32_t sequence_handler(enum event_type type, void *context, int param1)
+{
+    int producer = param1 >> 24;
+    int sequence = param1 & 0xffffff;
+
+    if (sequence != last_seen[producer] + 1) __atomic_add_fetch(&out_of_order, 1, __ATOMIC_RELAXED);
+    last_seen[producer] = sequence;
+
+    __atomic_add_fetch(&handled, 1, __ATOMIC_RELEASE);
+    return EVENT_SUCCESS;
+}
+
+static void *producer_main(void *context)
+{
+    int producer = (int)(intptr_t) context;
+
+    for (int i = 0; i < PER_THREAD; ++i) {
+        event_loop_post(&g_event_loop, WINDOW_FOCUSED, NULL, (producer << 24) | i, NULL);
+    }
+
+    return NULL;
+}
+
+TEST(multiple_producers_lose_nothing)
+{
+    pthread_t threads[PRODUCERS];
+
+    begin(sequence_handler);
+    for (int i = 0; i < PRODUCERS; ++i) last_seen[i] = -1;
+
+    for (int i = 0; i < PRODUCERS; ++i) {
+        pthread_create(&threads[i], NULL, producer_main, (void *)(intptr_t) i);
+    }
+
+    for (int i = 0; i < PRODUCERS; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+
+    wait_for(&handled, PRODUCERS * PER_THREAD);
+
+    expect_eq(handled, PRODUCERS * PER_THREAD);
+    expect_eq(out_of_order, 0);
+    expect_eq(g_event_loop.stats.dropped, 0);
+    for (int i = 0; i < PRODUCERS; ++i) expect_eq(last_seen[i], PER_THREAD - 1);
+
+    end();
+}
+
+int main(int argc, char **argv)
+{
+    run_test(queue_is_bounded_and_fifo);
+    run_test(overflow_preserves_order);
+    run_test(consumer_post_never_waits);
+    run_test(only_mouse_motion_and_messages_are_dropped);
+    run_test(window_moved_is_coalesced_while_pending);
+    run_test(multiple_producers_lose_nothing);
+
+    reset();
+    return test_report("event_loop");
+}
@@ -0,0 +1,321 @@
+#include "test.h"
+#include "compat.h"
+
+//
+// NOTE(koekeishiya): frame_batch.c only touches a handful of window fields, so the window below
+// is a stand-in that carries just those. The backend records every write instead of talking to
+// the accessibility API, and dispatch_apply_f runs each group on its own thread, so that the
+// concurrent path is exercised the same way it is on macOS.
+//
+
+#define WINDOW_ATTRIBUTE_FRAME (1 << 1)
+#define QOS_CLASS_USER_INTERACTIVE 0x21
+#define MAX_WRITES 1024
+
+typedef void *dispatch_queue_t;
+
+struct application
+{
+    int pid;
+};
+
+struct border
+{
+    uint32_t id;
+};
+
+struct window
+{
+    struct application *application;
+    uint32_t id;
+    bool has_applied_frame;
+    CGRect applied_frame;
+    struct border border;
+    uint32_t invalidated;
+};
+
+struct write
+{
+    struct window *window;
+    CGRect frame;
+    pthread_t thread;
+};
+
+int g_connection;
+
+static pthread_mutex_t write_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct write writes[MAX_WRITES];
+static int write_count;
+static uint32_t rejected_wid;
+static int border_moves;
+static int dispatch_calls;
+
+static bool CGRectEqualToRect(CGRect a, CGRect b)
+{
+    return a.origin.x == b.origin.x && a.origin.y == b.origin.y && a.size.width == b.size.width && a.size.height == b.size.height;
+}
+
+static void window_invalidate_attributes(struct window *window, uint32_t mask)
+{
+    window->invalidated |= mask;
+}
+
+static int SLSMoveWindow(int cid, uint32_t wid, CGPoint *point)
+{
+    ++border_moves;
+    return 0;
+}
+
+static dispatch_queue_t dispatch_get_global_queue(long identifier, unsigned long flags)
+{
+    return NULL;
+}
+
+struct dispatch_work
+{
+    pthread_t thread;
+    void *context;
+    void (*work)(void *, size_t);
+    size_t index;
+};
+
+static void *dispatch_work_main(void *context)
+{
+    struct dispatch_work *work = context;
+    work->work(work->context, work->index);
+    return NULL;
+}
+
+static void dispatch_apply_f(size_t iterations, dispatch_queue_t queue, void *context, void (*work)(void *, size_t))
+{
+    struct dispatch_work *threads = malloc(sizeof(struct dispatch_work) * iterations);
+    ++dispatch_calls;
+
+    for (size_t i = 0; i < iterations; ++i) {
+        threads[i] = (struct dispatch_work) { .context = context, .work = work, .index = i };
+        pthread_create(&threads[i].thread, NULL, dispatch_work_main, &threads[i]);
+    }
+
+    for (size_t i = 0; i < iterations; ++i) {
+        pthread_join(threads[i].thread, NULL);
+    }
+
+    free(threads);
+}
+
+#include "frame_batch.h"
+
+static bool frame_batch_apply(struct window *window, CGRect frame)
+{
+    pthread_mutex_lock(&write_lock);
+    assert(write_count < MAX_WRITES);
+    writes[write_count++] = (struct write) { window, frame, pthread_self() };
+    pthread_mutex_unlock(&write_lock);
+
+    return window->id != rejected_wid;
+}
+
+#include "frame_batch.c"
+
+static void reset(void)
+{
+    write_count = 0;
+    rejected_wid = 0;
+    border_moves = 0;
+    dispatch_calls = 0;
+}
+
+static int writes_for(struct window *window)
+{
+    int result = 0;
+    for (int i = 0; i < write_count; ++i) result += writes[i].window == window;
+    return result;
+}
+
+TEST(unchanged_frames_are_dropped)
+{
+    struct application app = { 1 };
+    struct window windows[4];
+    struct frame_batch batch;
+
+    reset();
+    memset(windows, 0, sizeof(windows));
+    for (int i = 0; i < array_count(windows); ++i) {
+        windows[i] = (struct window) { .application = &app, .id = i + 1 };
+    }
+
+    frame_batch_begin(&batch);
+    for (int i = 0; i < array_count(windows); ++i) {
+        frame_batch_add(&batch, &windows[i], i * 100, 0, 100, 200);
+    }
+    expect_eq(batch.skipped, 0);
+    frame_batch_commit(&batch);
+
+    expect_eq(write_count, 4);
+    expect(batch.entries == NULL);
+    for (int i = 0; i < array_count(windows); ++i) {
+        expect(windows[i].has_applied_frame);
+        expect(windows[i].applied_frame.origin.x == i * 100);
+        expect(windows[i].invalidated & WINDOW_ATTRIBUTE_FRAME);
+    }
+
+    //
+    // NOTE(koekeishiya): Only the second window changes; the others are already in place and
+    // must not reach the backend at all.
+    //
+
+    reset();
+    frame_batch_begin(&batch);
+    for (int i = 0; i < array_count(windows); ++i) {
+        frame_batch_add(&batch, &windows[i], i * 100, 0, i == 1 ? 150 : 100, 200);
+    }
+    expect_eq(batch.skipped, 3);
+    frame_batch_commit(&batch);
+
+    expect_eq(write_count, 1);
+    expect(writes[0].window == &windows[1]);
+    expect(writes[0].frame.size.width == 150);
+    expect(windows[1].applied_frame.size.width == 150);
+}
+
+TEST(writes_are_grouped_per_application)
+{
+    struct application apps[3] = { {1}, {2}, {3} };
+    struct window windows[30];
+    struct frame_batch batch;
+    uint64_t seed = 0x2d358dccaa6c78a5ULL;
+    int order[array_count(windows)];
+
+    reset();
+    for (int i = 0; i < array_count(windows); ++i) {
+        windows[i] = (struct window) { .application = &apps[i % 3], .id = 100 + i, .border.id = i & 1 ? 500 + i : 0 };
+        order[i] = i;
+    }
+
+    for (int i = array_count(order) - 1; i > 0; --i) {
+        int j = test_rand(&seed) % (i + 1);
+        int t = order[i]; order[i] = order[j]; order[j] = t;
+    }
+
+    frame_batch_begin(&batch);
+    for (int i = 0; i < array_count(order); ++i) {
+        struct window *window = &windows[order[i]];
+        frame_batch_add(&batch, window, window->id, 0, 10, 10);
+    }
+    frame_batch_commit(&batch);
+
+    expect_eq(dispatch_calls, 1);
+    expect_eq(write_count, array_count(windows));
+    expect_eq(border_moves, array_count(windows) / 2);
+
+    int written_once = 0;
+    for (int i = 0; i < array_count(windows); ++i) written_once += writes_for(&windows[i]) == 1;
+    expect_eq(written_once, array_count(windows));
+
+    //
+    // NOTE(koekeishiya): Groups run concurrently, so writes of different applications may
+    // interleave; within one application they come from a single thread, in window id order.
+    //
+
+    for (int a = 0; a < array_count(apps); ++a) {
+        pthread_t thread = 0;
+        uint32_t last_wid = 0;
+        int in_order = 0, same_thread = 0, seen = 0;
+
+        for (int i = 0; i < write_count; ++i) {
+            if (writes[i].window->application != &apps[a]) continue;
+            if (seen++ == 0) thread = writes[i].thread;
+
+            same_thread += pthread_equal(thread, writes[i].thread) != 0;
+            in_order += writes[i].window->id > last_wid;
+            last_wid = writes[i].window->id;
+        }
+
+        expect_eq(seen, 10);
+        expect_eq(same_thread, 10);
+        expect_eq(in_order, 10);
+    }
+}
+
+TEST(single_application_is_written_inline)
+{
+    struct application app = { 1 };
+    struct window windows[3];
+    struct frame_batch batch;
+
+    reset();
+    for (int i = 0; i < array_count(windows); ++i) {
+        windows[i] = (struct window) { .application = &app, .id = 3 - i };
+    }
+
+    frame_batch_begin(&batch);
+    for (int i = 0; i < array_count(windows); ++i) {
+        frame_batch_add(&batch, &windows[i], 0, 0, 10 + i, 10);
+    }
+    frame_batch_commit(&batch);
+
+    expect_eq(dispatch_calls, 0);
+    expect_eq(write_count, 3);
+    expect_eq(writes[0].window->id, 1);
+    expect_eq(writes[2].window->id, 3);
+    for (int i = 0; i < write_count; ++i) expect(pthread_equal(writes[i].thread, pthread_self()));
+}
+
+TEST(failed_write_clears_applied_frame)
+{
+    struct application app = { 1 };
+    struct window window = { .application = &app, .id = 7, .border.id = 9 };
+    struct frame_batch batch;
+
+    reset();
+    frame_batch_begin(&batch);
+    frame_batch_add(&batch, &window, 10, 10, 300, 300);
+    frame_batch_commit(&batch);
+    expect(window.has_applied_frame);
+    expect_eq(border_moves, 1);
+
+    reset();
+    rejected_wid = window.id;
+    frame_batch_begin(&batch);
+    frame_batch_add(&batch, &window, 20, 10, 300, 300);
+    frame_batch_commit(&batch);
+    expect(!window.has_applied_frame);
+    expect_eq(border_moves, 0);
+
+    //
+    // NOTE(koekeishiya): The window is in an unknown state after a failed write, so the next
+    // batch must write it even though it asks for the frame that was applied before.
+    //
+
+    reset();
+    frame_batch_begin(&batch);
+    frame_batch_add(&batch, &window, 10, 10, 300, 300);
+    expect_eq(batch.skipped, 0);
+    frame_batch_commit(&batch);
+    expect_eq(write_count, 1);
+    expect(window.has_applied_frame);
+}
+
+TEST(empty_batch_is_a_no_op)
+{
+    struct frame_batch batch;
+
+    reset();
+    frame_batch_begin(&batch);
+    frame_batch_commit(&batch);
+
+    expect_eq(write_count, 0);
+    expect_eq(dispatch_calls, 0);
+    expect(batch.entries == NULL);
+}
+
+int main(int argc, char **argv)
+{
+    run_test(unchanged_frames_are_dropped);
+    run_test(writes_are_grouped_per_application);
+    run_test(single_application_is_written_inline);
+    run_test(failed_write_clears_applied_frame);
+    run_test(empty_batch_is_a_no_op);
+
+    return test_report("frame_batch");
+}
@@ -0,0 +1,202 @@
+#include "test.h"
+#include "compat.h"
+
+#define HASHTABLE_IMPLEMENTATION
+#include "misc/hashtable.h"
+#undef HASHTABLE_IMPLEMENTATION
+
+#define KEYS 4096
+#define OPS  200000
+
+//
+// NOTE(koekeishiya): The generic table is wrapped in the same interface that TABLE_DEFINE
+// generates, so that every table runs through the same model test. Built with
+// -DHASHTABLE_GENERIC (hashtable_generic_test) the wid/pid/sid/psn tables forward to the
+// generic table as well.
+//
+
+static TABLE_HASH_FUNC(generic_hash) { return *(uint32_t *) key; }
+static TABLE_COMPARE_FUNC(generic_compare) { return *(uint32_t *) key_a == *(uint32_t *) key_b; }
+
+typedef struct table generic_table;
+static inline void generic_table_init(generic_table *table, int capacity) { table_init(table, capacity, generic_hash, generic_compare); }
+static inline void generic_table_free(generic_table *table) { table_free(table); }
+static inline void generic_table_add(generic_table *table, uint32_t key, void *value) { table_add(table, &key, value); }
+static inline void generic_table_remove(generic_table *table, uint32_t key) { table_remove(table, &key); }
+static inline void *generic_table_find(generic_table *table, uint32_t key) { return table_find(table, &key); }
+
+static inline uint32_t wid_key(int index) { return 100 + index; }
+static inline pid_t pid_key(int index) { return (pid_t)(index * 2654435761u) & 0x7fffffff; }
+static inline uint64_t sid_key(int index) { return (uint64_t) index * 0x9e3779b97f4a7c15ULL; }
+static inline ProcessSerialNumber psn_key(int index) { return (ProcessSerialNumber) { .highLongOfPSN = index >> 3, .lowLongOfPSN = index * 7 }; }
+static inline uint64_t literal_key(int index) { return table_hash_string((char *) &index, sizeof(index)); }
+static inline uint32_t generic_key(int index) { return index * 31; }
+
+//
+// NOTE(koekeishiya): Every occupied bucket must sit exactly distance - 1 slots after its home
+// bucket, and count must match the number of occupied buckets; a wrong backward shift in
+// remove breaks the first, a wrong rehash the second.
+//
+
+#define expect_table_invariants(table) \
+    do { \
+        int used = 0, misplaced = 0; \
+        uint32_t mask = (table)->capacity - 1; \
+        for (uint32_t i = 0; i < (uint32_t)(table)->capacity; ++i) { \
+            if (!(table)->buckets[i].distance) continue; \
+            ++used; \
+            misplaced += (table)->buckets[i].distance != (((i - ((table)->buckets[i].hash & mask)) & mask) + 1); \
+        } \
+        expect_eq(misplaced, 0); \
+        expect_eq(used, (table)->count); \
+    } while (0)
+
+#define MODEL_TEST(name) \
+TEST(name##_table_matches_reference) \
+{ \
+    name##_table table; \
+    void *reference[KEYS] = {0}; \
+    int reference_count = 0, mismatches = 0; \
+    uint64_t seed = 0x2545f4914f6cdd1dULL; \
+\
+    name##_table_init(&table, 8); \
+\
+    for (int op = 0; op < OPS; ++op) { \
+        int index = test_rand(&seed) % (op < OPS / 2 ? KEYS : KEYS / 4); \
+        void *value = (void *)(uintptr_t)(op + 1); \
+\
+        switch (test_rand(&seed) % 4) { \
+        case 0: \
+        case 1: { \
+            name##_table_add(&table, name##_key(index), value); \
+            if (!reference[index]) { \
+                reference[index] = value; \
+                ++reference_count; \
+            } \
+        } break; \
+        case 2: { \
+            name##_table_remove(&table, name##_key(index)); \
+            if (reference[index]) { \
+                reference[index] = NULL; \
+                --reference_count; \
+            } \
+        } break; \
+        case 3: { \
+            mismatches += name##_table_find(&table, name##_key(index)) != reference[index]; \
+        } break; \
+        } \
+\
+        if (table.count != reference_count) ++mismatches; \
+        if ((op & 0x3fff) == 0) expect_table_invariants(&table); \
+    } \
+\
+    for (int i = 0; i < KEYS; ++i) { \
+        mismatches += name##_table_find(&table, name##_key(i)) != reference[i]; \
+    } \
+\
+    expect_eq(mismatches, 0); \
+    expect_table_invariants(&table); \
+\
+    for (int i = 0; i < KEYS; ++i) { \
+        name##_table_remove(&table, name##_key(i)); \
+    } \
+\
+    expect_eq(table.count, 0); \
+    expect_table_invariants(&table); \
+    name##_table_free(&table); \
+}
+
+MODEL_TEST(wid)
+MODEL_TEST(pid)
+MODEL_TEST(sid)
+MODEL_TEST(psn)
+MODEL_TEST(literal)
+MODEL_TEST(generic)
+
+TEST(add_does_not_replace_existing_value)
+{
+    wid_table table;
+    wid_table_init(&table, 8);
+
+    wid_table_add(&table, 42, (void *) 0x1);
+    wid_table_add(&table, 42, (void *) 0x2);
+    expect(wid_table_find(&table, 42) == (void *) 0x1);
+    expect_eq(table.count, 1);
+
+    wid_table_remove(&table, 42);
+    wid_table_remove(&table, 42);
+    expect(wid_table_find(&table, 42) == NULL);
+    expect_eq(table.count, 0);
+
+    wid_table_free(&table);
+}
+
+TEST(remove_shifts_cluster_across_wrap_around)
+{
+    wid_table table;
+    uint32_t keys[3];
+    int found = 0;
+
+    //
+    // NOTE(koekeishiya): Three keys whose home is the last bucket of an 8 bucket table form
+    // a cluster that wraps around to the start of the array.
+    //
+
+    for (uint32_t key = 1; found < 3; ++key) {
+        if ((table_mix_hash(table_hash_u32(key)) & 7) == 7) keys[found++] = key;
+    }
+
+    wid_table_init(&table, 8);
+    for (int i = 0; i < 3; ++i) wid_table_add(&table, keys[i], (void *)(uintptr_t)(i + 1));
+
+    expect_eq(table.capacity, 8);
+    expect_table_invariants(&table);
+
+    wid_table_remove(&table, keys[0]);
+    expect_table_invariants(&table);
+    expect(wid_table_find(&table, keys[0]) == NULL);
+    expect(wid_table_find(&table, keys[1]) == (void *) 2);
+    expect(wid_table_find(&table, keys[2]) == (void *) 3);
+
+    wid_table_remove(&table, keys[2]);
+    expect_table_invariants(&table);
+    expect(wid_table_find(&table, keys[1]) == (void *) 2);
+    expect_eq(table.count, 1);
+
+    wid_table_free(&table);
+}
+
+TEST(table_grows_past_max_load)
+{
+    sid_table table;
+    sid_table_init(&table, 8);
+
+    for (int i = 0; i < 6; ++i) sid_table_add(&table, sid_key(i), (void *) 0x1);
+    expect_eq(table.capacity, 8);
+
+    sid_table_add(&table, sid_key(6), (void *) 0x1);
+    expect_eq(table.capacity, 16);
+    expect_eq(table.count, 7);
+    expect_table_invariants(&table);
+
+    sid_table_free(&table);
+}
+
+int main(int argc, char **argv)
+{
+    run_test(wid_table_matches_reference);
+    run_test(pid_table_matches_reference);
+    run_test(sid_table_matches_reference);
+    run_test(psn_table_matches_reference);
+    run_test(literal_table_matches_reference);
+    run_test(generic_table_matches_reference);
+    run_test(add_does_not_replace_existing_value);
+    run_test(remove_shifts_cluster_across_wrap_around);
+    run_test(table_grows_past_max_load);
+
+#ifdef HASHTABLE_GENERIC
+    return test_report("hashtable (HASHTABLE_GENERIC)");
+#else
+    return test_report("hashtable");
+#endif
+}
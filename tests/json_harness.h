@@ -0,0 +1,259 @@
+#ifndef JSON_HARNESS_H
+#define JSON_HARNESS_H
+
+#include "misc/json.h"
+
+//
+// NOTE(koekeishiya): Windows with the fields that window_serialize writes, filled with values of
+// the kind that a real query returns: fractional frames, titles that need escaping now and then,
+// and a handful of applications. window_serialize itself needs the window server, so the harness
+// writes the same fields in the same order; legacy_window_serialize is the fprintf format string
+// that it replaced.
+//
+
+struct synthetic_window
+{
+    uint32_t id;
+    int pid;
+    char *app;
+    char *title;
+    double x, y, w, h;
+    int level;
+    char *role;
+    char *subrole;
+    bool movable;
+    bool resizable;
+    int display;
+    int space;
+    bool visible;
+    bool focused;
+    char *split;
+    bool floating;
+    bool sticky;
+    bool minimized;
+    bool topmost;
+    float opacity;
+    bool shadow;
+    bool border;
+    int stack_index;
+    bool zoom_parent;
+    bool zoom_fullscreen;
+    bool native_fullscreen;
+};
+
+static char *synthetic_apps[] = { "Safari", "Terminal", "Mail", "Finder", "Xcode", "Slack", "Spotify", "Preview" };
+static char *synthetic_titles[] =
+{
+    "Inbox (1,204 messages)",
+    "~/src/yabai \xe2\x80\x94 -zsh \xe2\x80\x94 120\xc3\x97" "40",
+    "README.md \xe2\x80\x94 Edited",
+    "\"quoted\" title with a \\ backslash",
+    "tab\tseparated\ttitle",
+    "Downloads",
+    "",
+    "multi\nline\ntitle\r",
+};
+static char *synthetic_splits[] = { "none", "horizontal", "vertical" };
+
+static void synthetic_window_init(struct synthetic_window *window, uint32_t index, uint64_t *seed)
+{
+    uint64_t r = test_rand(seed);
+
+    window->id = 1000 + index;
+    window->pid = 400 + (r % array_count(synthetic_apps));
+    window->app = synthetic_apps[r % array_count(synthetic_apps)];
+    window->title = synthetic_titles[(r >> 8) % array_count(synthetic_titles)];
+    window->x = (double)(test_rand(seed) % 2560000) / 1000.0;
+    window->y = (double)(test_rand(seed) % 1440000) / 1000.0 + 0.5;
+    window->w = (float)((test_rand(seed) % 1280000) / 1000.0 + 200.0);
+    window->h = (float)((test_rand(seed) % 720000) / 1000.0 + 100.0);
+    window->level = (r >> 16) & 1 ? 3 : 0;
+    window->role = "AXWindow";
+    window->subrole = (r >> 17) & 1 ? "AXStandardWindow" : "AXDialog";
+    window->movable = (r >> 18) & 1;
+    window->resizable = (r >> 19) & 1;
+    window->display = 1 + ((r >> 20) & 1);
+    window->space = 1 + ((r >> 21) % 9);
+    window->visible = (r >> 25) & 1;
+    window->focused = index == 0;
+    window->split = synthetic_splits[(r >> 26) % array_count(synthetic_splits)];
+    window->floating = (r >> 28) & 1;
+    window->sticky = (r >> 29) & 1;
+    window->minimized = (r >> 30) & 1;
+    window->topmost = window->level == 3;
+    window->opacity = (float)((r >> 32) % 101) / 100.0f;
+    window->shadow = (r >> 40) & 1;
+    window->border = (r >> 41) & 1;
+    window->stack_index = (r >> 42) % 4;
+    window->zoom_parent = (r >> 44) & 1;
+    window->zoom_fullscreen = (r >> 45) & 1;
+    window->native_fullscreen = (r >> 46) & 1;
+}
+
+static void synthetic_window_serialize(struct json_writer *json, struct synthetic_window *window)
+{
+    json_begin_object(json);
+    json_key(json, "id");                json_int(json, window->id);
+    json_key(json, "pid");               json_int(json, window->pid);
+    json_key(json, "app");               json_string(json, window->app);
+    json_key(json, "title");             json_string(json, window->title);
+    json_key(json, "frame");
+    json_begin_object(json);
+    json_key(json, "x");                 json_float(json, window->x);
+    json_key(json, "y");                 json_float(json, window->y);
+    json_key(json, "w");                 json_float(json, window->w);
+    json_key(json, "h");                 json_float(json, window->h);
+    json_end_object(json);
+    json_key(json, "level");             json_int(json, window->level);
+    json_key(json, "role");              json_string(json, window->role);
+    json_key(json, "subrole");           json_string(json, window->subrole);
+    json_key(json, "movable");           json_int(json, window->movable);
+    json_key(json, "resizable");         json_int(json, window->resizable);
+    json_key(json, "display");           json_int(json, window->display);
+    json_key(json, "space");             json_int(json, window->space);
+    json_key(json, "visible");           json_int(json, window->visible);
+    json_key(json, "focused");           json_int(json, window->focused);
+    json_key(json, "split");             json_string(json, window->split);
+    json_key(json, "floating");          json_int(json, window->floating);
+    json_key(json, "sticky");            json_int(json, window->sticky);
+    json_key(json, "minimized");         json_int(json, window->minimized);
+    json_key(json, "topmost");           json_int(json, window->topmost);
+    json_key(json, "opacity");           json_float(json, window->opacity);
+    json_key(json, "shadow");            json_int(json, window->shadow);
+    json_key(json, "border");            json_int(json, window->border);
+    json_key(json, "stack-index");       json_int(json, window->stack_index);
+    json_key(json, "zoom-parent");       json_int(json, window->zoom_parent);
+    json_key(json, "zoom-fullscreen");   json_int(json, window->zoom_fullscreen);
+    json_key(json, "native-fullscreen"); json_int(json, window->native_fullscreen);
+    json_end_object(json);
+}
+
+static void synthetic_windows_serialize(struct json_writer *json, struct synthetic_window *windows, int count, FILE *rsp)
+{
+    json_writer_begin(json);
+    json_begin_array(json);
+    for (int i = 0; i < count; ++i) {
+        synthetic_window_serialize(json, &windows[i]);
+    }
+    json_end_array(json);
+    json_writer_end(json, rsp);
+}
+
+static char *legacy_string_escape(char *s)
+{
+    if (!s) return NULL;
+
+    char *cursor = s;
+    int num_replacements = 0;
+
+    while (*cursor) {
+        if ((*cursor == '"') ||
+            (*cursor == '\\') ||
+            (*cursor == '\b') ||
+            (*cursor == '\f') ||
+            (*cursor == '\n') ||
+            (*cursor == '\r') ||
+            (*cursor == '\t')) {
+            ++num_replacements;
+        }
+
+        ++cursor;
+    }
+
+    if (!num_replacements) return NULL;
+
+    int size_in_bytes = (int)(cursor - s) + num_replacements;
+    char *result = malloc(sizeof(char) * (size_in_bytes+1));
+    result[size_in_bytes] = '\0';
+
+    for (char *dst = result, *cursor = s; *cursor; ++cursor) {
+        switch (*cursor) {
+        case '"':  *dst++ = '\\'; *dst++ = '"';  break;
+        case '\\': *dst++ = '\\'; *dst++ = '\\'; break;
+        case '\b': *dst++ = '\\'; *dst++ = 'b';  break;
+        case '\f': *dst++ = '\\'; *dst++ = 'f';  break;
+        case '\n': *dst++ = '\\'; *dst++ = 'n';  break;
+        case '\r': *dst++ = '\\'; *dst++ = 'r';  break;
+        case '\t': *dst++ = '\\'; *dst++ = 't';  break;
+        default:   *dst++ = *cursor;             break;
+        }
+    }
+
+    return result;
+}
+
+static void legacy_window_serialize(FILE *rsp, struct synthetic_window *window)
+{
+    char *escaped_title = legacy_string_escape(window->title);
+
+    fprintf(rsp,
+            "{\n"
+            "\t\"id\":%d,\n"
+            "\t\"pid\":%d,\n"
+            "\t\"app\":\"%s\",\n"
+            "\t\"title\":\"%s\",\n"
+            "\t\"frame\":{\n\t\t\"x\":%.4f,\n\t\t\"y\":%.4f,\n\t\t\"w\":%.4f,\n\t\t\"h\":%.4f\n\t},\n"
+            "\t\"level\":%d,\n"
+            "\t\"role\":\"%s\",\n"
+            "\t\"subrole\":\"%s\",\n"
+            "\t\"movable\":%d,\n"
+            "\t\"resizable\":%d,\n"
+            "\t\"display\":%d,\n"
+            "\t\"space\":%d,\n"
+            "\t\"visible\":%d,\n"
+            "\t\"focused\":%d,\n"
+            "\t\"split\":\"%s\",\n"
+            "\t\"floating\":%d,\n"
+            "\t\"sticky\":%d,\n"
+            "\t\"minimized\":%d,\n"
+            "\t\"topmost\":%d,\n"
+            "\t\"opacity\":%.4f,\n"
+            "\t\"shadow\":%d,\n"
+            "\t\"border\":%d,\n"
+            "\t\"stack-index\":%d,\n"
+            "\t\"zoom-parent\":%d,\n"
+            "\t\"zoom-fullscreen\":%d,\n"
+            "\t\"native-fullscreen\":%d\n"
+            "}",
+            window->id,
+            window->pid,
+            window->app,
+            escaped_title ? escaped_title : window->title ? window->title : "",
+            window->x, window->y,
+            window->w, window->h,
+            window->level,
+            window->role ? window->role : "",
+            window->subrole ? window->subrole : "",
+            window->movable,
+            window->resizable,
+            window->display,
+            window->space,
+            window->visible,
+            window->focused,
+            window->split,
+            window->floating,
+            window->sticky,
+            window->minimized,
+            window->topmost,
+            window->opacity,
+            window->shadow,
+            window->border,
+            window->stack_index,
+            window->zoom_parent,
+            window->zoom_fullscreen,
+            window->native_fullscreen);
+
+    free(escaped_title);
+}
+
+static void legacy_windows_serialize(struct synthetic_window *windows, int count, FILE *rsp)
+{
+    fprintf(rsp, "[");
+    for (int i = 0; i < count; ++i) {
+        legacy_window_serialize(rsp, &windows[i]);
+        if (i < count - 1) fprintf(rsp, ",");
+    }
+    fprintf(rsp, "]\n");
+}
+
+#endif
@@ -0,0 +1,377 @@
+#include "test.h"
+#include "json_harness.h"
+
+#include <float.h>
+
+#define FUZZ_VALUES 200000
+
+static struct json_writer json;
+
+//
+// NOTE(koekeishiya): Every value is written as the only element of an array, so that the writer
+// output is exactly the formatted value between the brackets.
+//
+
+static char *write_float(double value, char *buffer, size_t size)
+{
+    json_writer_begin(&json);
+    json_begin_array(&json);
+    json_float(&json, value);
+    json_end_array(&json);
+
+    snprintf(buffer, size, "%.*s", (int) json.length - 2, json.data + 1);
+    return buffer;
+}
+
+static char *write_int(int64_t value, char *buffer, size_t size)
+{
+    json_writer_begin(&json);
+    json_begin_array(&json);
+    json_int(&json, value);
+    json_end_array(&json);
+
+    snprintf(buffer, size, "%.*s", (int) json.length - 2, json.data + 1);
+    return buffer;
+}
+
+static char *write_string(const char *value)
+{
+    json_writer_begin(&json);
+    json_string(&json, value);
+
+    char *result = malloc(json.length + 1);
+    memcpy(result, json.data, json.length);
+    result[json.length] = '\0';
+    return result;
+}
+
+static bool float_matches_printf(double value, bool verbose)
+{
+    char actual[512], expected[512];
+
+    write_float(value, actual, sizeof(actual));
+    snprintf(expected, sizeof(expected), "%.4f", isfinite(value) ? value : 0.0);
+
+    if (strcmp(actual, expected) != 0) {
+        if (verbose) fprintf(stderr, "json_float(%.17g) = %s, printf = %s\n", value, actual, expected);
+        return false;
+    }
+
+    return true;
+}
+
+TEST(float_matches_printf_for_edge_cases)
+{
+    double cases[] = {
+        0.0, -0.0, 1.0, -1.0, 0.5, 0.00005, -0.00005, 0.00004999, 0.00015, 0.00025,
+        1.00005, 2.5e-5, 7.5e-5, 0.03125, 0.09375, 1.4375e-4, 0.333333333, 2.0 / 3.0,
+        -0.00001, 1439.99995, 2559.5, 999999999.99994, 999999999.99996, 1e9, -1e9, 1e12, 1e300,
+        4294967296.123, DBL_MIN, 1e-300, (float) 0.1, (float) 0.95, (float) 1439.9,
+        NAN, INFINITY, -INFINITY,
+    };
+
+    for (int i = 0; i < array_count(cases); ++i) {
+        expect(float_matches_printf(cases[i], true));
+    }
+}
+
+//
+// NOTE(koekeishiya): Exact ties at the fourth decimal are values with few binary digits after
+// the point, such as n/32; those are rounded to even. Values that only look like ties in decimal
+// are not exactly representable, and must round the same way as their exact binary value.
+//
+
+TEST(float_matches_printf_for_ties)
+{
+    int mismatches = 0;
+
+    for (int denominator = 2; denominator <= 1 << 16; denominator <<= 1) {
+        for (int numerator = -2 * denominator; numerator <= 2 * denominator; numerator += 1 + denominator / 64) {
+            mismatches += !float_matches_printf((double) numerator / denominator, mismatches < 8);
+        }
+    }
+
+    for (int i = 0; i < 100000; ++i) {
+        mismatches += !float_matches_printf(i / 10000.0 + 0.00005, mismatches < 8);
+        mismatches += !float_matches_printf(-(i / 10000.0 + 0.00005), mismatches < 8);
+    }
+
+    expect_eq(mismatches, 0);
+}
+
+TEST(float_matches_printf_for_random_values)
+{
+    uint64_t seed = 0x6a09e667bb67ae85ULL;
+    int mismatches = 0;
+
+    for (int i = 0; i < FUZZ_VALUES; ++i) {
+        uint64_t r = test_rand(&seed);
+        double mantissa = (double)(r >> 11) / (double)(1ULL << 53);
+        double value = mantissa * pow(10.0, (int)(test_rand(&seed) % 16) - 6);
+        if (r & 1) value = -value;
+
+        //
+        // NOTE(koekeishiya): Frames and opacity are stored as float and widened when written.
+        //
+
+        if (r & 2) value = (float) value;
+        mismatches += !float_matches_printf(value, mismatches < 8);
+    }
+
+    for (int i = 0; i < FUZZ_VALUES; ++i) {
+        uint64_t bits = test_rand(&seed);
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        mismatches += !float_matches_printf(value, mismatches < 8);
+    }
+
+    expect_eq(mismatches, 0);
+}
+
+TEST(int_matches_printf)
+{
+    int64_t cases[] = { 0, 1, -1, 9, 10, -10, 99, 100, INT32_MAX, INT32_MIN, UINT32_MAX, INT64_MAX, INT64_MIN, INT64_MIN + 1 };
+    char actual[64], expected[64];
+    uint64_t seed = 0x3c6ef372a54ff53aULL;
+    int mismatches = 0;
+
+    for (int i = 0; i < array_count(cases); ++i) {
+        snprintf(expected, sizeof(expected), "%lld", (long long) cases[i]);
+        expect_str(write_int(cases[i], actual, sizeof(actual)), expected);
+    }
+
+    for (int i = 0; i < FUZZ_VALUES; ++i) {
+        int64_t value = (int64_t) test_rand(&seed) >> (test_rand(&seed) % 64);
+        snprintf(expected, sizeof(expected), "%lld", (long long) value);
+        mismatches += strcmp(write_int(value, actual, sizeof(actual)), expected) != 0;
+    }
+
+    expect_eq(mismatches, 0);
+}
+
+//
+// NOTE(koekeishiya): The reference escapes one byte at a time: quote, backslash and the control
+// characters that have a short form get it, other control characters are written as \u00XX, and
+// everything else, including UTF-8 sequences, is copied as is.
+//
+
+static char *reference_escape(const char *value)
+{
+    char *result = NULL;
+    buf_push(result, '"');
+
+    for (const unsigned char *at = (const unsigned char *) value; *at; ++at) {
+        char escape[8];
+        int length = 0;
+
+        switch (*at) {
+        case '"':  length = snprintf(escape, sizeof(escape), "\\\""); break;
+        case '\\': length = snprintf(escape, sizeof(escape), "\\\\"); break;
+        case '\b': length = snprintf(escape, sizeof(escape), "\\b");  break;
+        case '\f': length = snprintf(escape, sizeof(escape), "\\f");  break;
+        case '\n': length = snprintf(escape, sizeof(escape), "\\n");  break;
+        case '\r': length = snprintf(escape, sizeof(escape), "\\r");  break;
+        case '\t': length = snprintf(escape, sizeof(escape), "\\t");  break;
+        default: {
+            if (*at < 0x20) {
+                length = snprintf(escape, sizeof(escape), "\\u%04x", *at);
+            } else {
+                escape[length++] = *at;
+            }
+        } break;
+        }
+
+        for (int i = 0; i < length; ++i) buf_push(result, escape[i]);
+    }
+
+    buf_push(result, '"');
+    buf_push(result, '\0');
+    return result;
+}
+
+TEST(string_escapes_every_byte)
+{
+    char value[256];
+
+    for (int c = 1; c < 256; ++c) {
+        snprintf(value, sizeof(value), "a%cb%c", c, c);
+
+        char *actual = write_string(value);
+        char *expected = reference_escape(value);
+        expect_str(actual, expected);
+
+        free(actual);
+        buf_free(expected);
+    }
+
+    char *empty = write_string(NULL);
+    expect_str(empty, "\"\"");
+    free(empty);
+}
+
+TEST(string_escapes_random_strings)
+{
+    uint64_t seed = 0x510e527f9b05688cULL;
+    int mismatches = 0;
+
+    for (int i = 0; i < 20000; ++i) {
+        char value[128];
+        int length = test_rand(&seed) % (sizeof(value) - 1);
+
+        for (int j = 0; j < length; ++j) {
+            uint64_t r = test_rand(&seed);
+            value[j] = r & 3 ? 'a' + (r >> 8) % 26 : 1 + (r >> 8) % 255;
+        }
+        value[length] = '\0';
+
+        char *actual = write_string(value);
+        char *expected = reference_escape(value);
+        mismatches += strcmp(actual, expected) != 0;
+
+        free(actual);
+        buf_free(expected);
+    }
+
+    expect_eq(mismatches, 0);
+}
+
+static char *read_stream(void (*write)(FILE *rsp, void *context), void *context)
+{
+    char *data = NULL;
+    size_t size = 0;
+
+    FILE *rsp = open_memstream(&data, &size);
+    write(rsp, context);
+    fclose(rsp);
+
+    return data;
+}
+
+struct windows
+{
+    struct synthetic_window *windows;
+    int count;
+};
+
+static void write_windows(FILE *rsp, void *context)
+{
+    struct windows *windows = context;
+    synthetic_windows_serialize(&json, windows->windows, windows->count, rsp);
+}
+
+static void write_legacy_windows(FILE *rsp, void *context)
+{
+    struct windows *windows = context;
+    legacy_windows_serialize(windows->windows, windows->count, rsp);
+}
+
+//
+// NOTE(koekeishiya): The writer must produce the exact layout that the fprintf format strings
+// did. The legacy format did not escape control characters other than the ones with a short
+// form, which is why the synthetic titles only contain those; the others are covered above.
+//
+
+TEST(windows_match_legacy_layout)
+{
+    uint64_t seed = 0xbb67ae853c6ef372ULL;
+    struct synthetic_window windows[64];
+
+    for (int i = 0; i < array_count(windows); ++i) {
+        synthetic_window_init(&windows[i], i, &seed);
+    }
+
+    for (int count = 0; count <= array_count(windows); count = count ? count * 4 : 1) {
+        struct windows context = { windows, count };
+        char *actual = read_stream(write_windows, &context);
+        char *expected = read_stream(write_legacy_windows, &context);
+
+        expect_str(actual, expected);
+
+        free(actual);
+        free(expected);
+    }
+}
+
+TEST(compact_writer_stays_on_one_line)
+{
+    uint64_t seed = 0x1f83d9ab5be0cd19ULL;
+    struct synthetic_window window;
+    synthetic_window_init(&window, 1, &seed);
+    window.title = "two\nlines";
+
+    json_writer_begin_compact(&json);
+    synthetic_window_serialize(&json, &window);
+
+    expect(json.length > 0);
+    expect(memchr(json.data, '\n', json.length) == NULL);
+    expect(memchr(json.data, '\t', json.length) == NULL);
+    expect(json.data[0] == '{' && json.data[json.length - 1] == '}');
+}
+
+TEST(nested_containers_are_laid_out)
+{
+    char *expected = "{\n\t\"a\":1,\n\t\"b\":[1, 2, \"x\"],\n\t\"c\":{\n\t\t\"d\":0.5000\n\t},\n\t\"e\":[{\n\t\t\"f\":1\n\t},{}],\n\t\"g\":{}\n}";
+
+    json_writer_begin(&json);
+    json_begin_object(&json);
+    json_key(&json, "a"); json_int(&json, 1);
+    json_key(&json, "b");
+    json_begin_array(&json); json_int(&json, 1); json_int(&json, 2); json_string(&json, "x"); json_end_array(&json);
+    json_key(&json, "c");
+    json_begin_object(&json); json_key(&json, "d"); json_float(&json, 0.5); json_end_object(&json);
+    json_key(&json, "e");
+    json_begin_array(&json);
+    json_begin_object(&json); json_key(&json, "f"); json_int(&json, 1); json_end_object(&json);
+    json_begin_object(&json); json_end_object(&json);
+    json_end_array(&json);
+    json_key(&json, "g");
+    json_begin_object(&json); json_end_object(&json);
+    json_end_object(&json);
+
+    expect_eq(json.depth, 0);
+    expect_eq(json.length, strlen(expected));
+    expect(json.length == strlen(expected) && memcmp(json.data, expected, json.length) == 0);
+}
+
+//
+// NOTE(koekeishiya): The buffer is kept between responses and only ever grows; a response that
+// is much larger than the initial capacity is written in one piece.
+//
+
+TEST(buffer_is_reused_and_grows)
+{
+    char title[JSON_WRITER_INITIAL_CAPACITY * 3];
+    memset(title, 'x', sizeof(title) - 1);
+    title[sizeof(title) - 1] = '\0';
+
+    char *escaped = write_string(title);
+    expect_eq(strlen(escaped), sizeof(title) + 1);
+    expect(json.capacity >= sizeof(title) + 1);
+    free(escaped);
+
+    char *data = json.data;
+    size_t capacity = json.capacity;
+
+    escaped = write_string("short");
+    expect_str(escaped, "\"short\"");
+    expect(json.data == data);
+    expect_eq(json.capacity, capacity);
+    free(escaped);
+}
+
+int main(int argc, char **argv)
+{
+    run_test(float_matches_printf_for_edge_cases);
+    run_test(float_matches_printf_for_ties);
+    run_test(float_matches_printf_for_random_values);
+    run_test(int_matches_printf);
+    run_test(string_escapes_every_byte);
+    run_test(string_escapes_random_strings);
+    run_test(windows_match_legacy_layout);
+    run_test(compact_writer_stays_on_one_line);
+    run_test(nested_containers_are_laid_out);
+    run_test(buffer_is_reused_and_grows);
+
+    free(json.data);
+    return test_report("json");
+}
@@ -0,0 +1,734 @@
+#include "test.h"
+#include "misc/socket.h"
+#include "message.h"
+#include "message_token.c"
+
+#define FUZZ_TOKENS 20000
+
+//
+// NOTE(koekeishiya): Lays out the arguments the way the client sends them: every argument is
+// null-terminated, and the message ends with an empty argument.
+//
+
+static char *make_message(char **argv, int argc)
+{
+    char *message = NULL;
+
+    for (int i = 0; i < argc; ++i) {
+        for (char *at = argv[i]; *at; ++at) buf_push(message, *at);
+        buf_push(message, '\0');
+    }
+
+    buf_push(message, '\0');
+    return message;
+}
+
+static struct token make_token(char *text)
+{
+    return (struct token) { text, strlen(text) };
+}
+
+//
+// NOTE(koekeishiya): Random tokens over the given alphabet. The token is not null-terminated
+// where it ends, so that a parser which reads past its length is caught by the address sanitizer.
+//
+
+static char *random_token(uint64_t *seed, const char *alphabet, int max_length, struct token *token)
+{
+    int alphabet_length = strlen(alphabet);
+    int length = test_rand(seed) % (max_length + 1);
+    char *text = malloc(length ? length : 1);
+
+    for (int i = 0; i < length; ++i) {
+        text[i] = alphabet[test_rand(seed) % alphabet_length];
+    }
+
+    *token = (struct token) { text, length };
+    return text;
+}
+
+static char *terminated_copy(struct token token, char *buffer)
+{
+    memcpy(buffer, token.text, token.length);
+    buffer[token.length] = '\0';
+    return buffer;
+}
+
+TEST(token_index_points_into_message)
+{
+    char *argv[] = { "window", "--focus", "next" };
+    char *message = make_message(argv, array_count(argv));
+    struct token_index index;
+
+    expect(token_index_build(&index, message));
+    expect_eq(index.count, array_count(argv));
+    expect(index.tokens == index.storage);
+
+    char *at = message;
+    for (int i = 0; i < array_count(argv); ++i) {
+        struct token token = get_token(&index);
+        expect(token.text == at);
+        expect_eq(token.length, strlen(argv[i]));
+        expect(token_equals(token, argv[i]));
+        at += token.length + 1;
+    }
+
+    token_index_destroy(&index);
+    buf_free(message);
+}
+
+TEST(token_index_grows_past_inline_capacity)
+{
+    char *argv[TOKEN_INDEX_INLINE_CAPACITY * 6];
+    char text[array_count(argv)][16];
+
+    for (int i = 0; i < array_count(argv); ++i) {
+        snprintf(text[i], sizeof(text[i]), "argument%d", i);
+        argv[i] = text[i];
+    }
+
+    for (int count = TOKEN_INDEX_INLINE_CAPACITY - 1; count <= array_count(argv); count += 7) {
+        char *message = make_message(argv, count);
+        struct token_index index;
+
+        expect(token_index_build(&index, message));
+        expect_eq(index.count, count);
+        expect(index.capacity >= count);
+        expect((index.tokens == index.storage) == (count <= TOKEN_INDEX_INLINE_CAPACITY));
+
+        int matched = 0;
+        for (int i = 0; i < count; ++i) {
+            matched += token_equals(get_token(&index), argv[i]);
+        }
+
+        expect_eq(matched, count);
+        expect(!token_is_valid(get_token(&index)));
+
+        token_index_destroy(&index);
+        buf_free(message);
+    }
+}
+
+TEST(exhausted_index_returns_empty_token)
+{
+    char empty[] = { '\0' };
+    struct token_index index;
+
+    expect(token_index_build(&index, empty));
+    expect_eq(index.count, 0);
+
+    for (int i = 0; i < 3; ++i) {
+        struct token token = get_token(&index);
+        expect(!token_is_valid(token));
+        expect_eq(token.length, 0);
+        expect(token.text && *token.text == '\0');
+    }
+
+    char *argv[] = { "query" };
+    char *message = make_message(argv, array_count(argv));
+
+    expect(token_index_build(&index, message));
+    expect(token_equals(get_token(&index), "query"));
+    expect(!token_is_valid(get_token(&index)));
+    expect(!token_is_valid(get_token(&index)));
+    expect_eq(index.cursor, 1);
+
+    token_index_destroy(&index);
+    buf_free(message);
+}
+
+//
+// NOTE(koekeishiya): An empty argument ends the message, so whatever the client sends after it
+// is never indexed.
+//
+
+TEST(empty_argument_ends_message)
+{
+    char message[] = "space\0\0--focus\0\0";
+    struct token_index index;
+
+    expect(token_index_build(&index, message));
+    expect_eq(index.count, 1);
+    expect(token_equals(get_token(&index), "space"));
+
+    token_index_destroy(&index);
+}
+
+TEST(token_to_string_copies_token)
+{
+    char message[] = "--label\0main\0";
+    struct token token = { message + 8, 4 };
+
+    char *string = token_to_string(token);
+    expect_str(string, "main");
+    expect(string != token.text);
+    free(string);
+
+    string = token_to_string((struct token) { message, 0 });
+    expect_str(string, "");
+    free(string);
+}
+
+//
+// NOTE(koekeishiya): The numbers are checked against sscanf, which is what the handlers used
+// before the numbers were parsed in place. Integers are kept short enough that sscanf does not
+// overflow, which is undefined; clamping is checked separately.
+//
+
+TEST(token_to_int_matches_sscanf)
+{
+    char *cases[] = { "0", "7", "-7", "+7", "007", "-0", "12px", "1.5", "-", "+", "", "x1", "--1", "+-1", "2147483647", "-2147483648" };
+    char buffer[64];
+
+    for (int i = 0; i < array_count(cases); ++i) {
+        int value = -1, expected = 0;
+        bool success = sscanf(cases[i], "%d", &expected) == 1;
+
+        expect_eq(token_to_int(make_token(cases[i]), &value), success);
+        expect_eq(value, success ? expected : 0);
+    }
+
+    uint64_t seed = 0x243f6a8885a308d3ULL;
+    int mismatches = 0;
+
+    for (int i = 0; i < FUZZ_TOKENS; ++i) {
+        struct token token;
+        char *text = random_token(&seed, "0123456789012345678901234+-.x", 9, &token);
+
+        int value = -1, expected = 0;
+        bool success = sscanf(terminated_copy(token, buffer), "%d", &expected) == 1;
+
+        if (token_to_int(token, &value) != success || value != (success ? expected : 0)) {
+            if (mismatches++ < 8) fprintf(stderr, "token_to_int(\"%s\") = %d, sscanf = %d\n", buffer, value, expected);
+        }
+
+        free(text);
+    }
+
+    expect_eq(mismatches, 0);
+}
+
+TEST(token_to_int_clamps_on_overflow)
+{
+    int value;
+
+    expect(token_to_int(make_token("2147483648"), &value));
+    expect_eq(value, INT_MAX);
+    expect(token_to_int(make_token("-2147483649"), &value));
+    expect_eq(value, INT_MIN);
+    expect(token_to_int(make_token("99999999999999999999999"), &value));
+    expect_eq(value, INT_MAX);
+    expect(token_to_int(make_token("-99999999999999999999999"), &value));
+    expect_eq(value, INT_MIN);
+}
+
+TEST(token_to_uint32t_matches_sscanf)
+{
+    char *cases[] = { "0", "ff", "FF", "0xff", "0XfF", "0xff00ff00", "-1", "+1a", "0x", "0xg", "g", "", "12345678" };
+    char buffer[64];
+
+    for (int i = 0; i < array_count(cases); ++i) {
+        uint32_t expected = 0;
+        sscanf(cases[i], "%x", &expected);
+        expect_eq(token_to_uint32t(make_token(cases[i])), expected);
+    }
+
+    uint64_t seed = 0x13198a2e03707344ULL;
+    int mismatches = 0;
+
+    for (int i = 0; i < FUZZ_TOKENS; ++i) {
+        struct token token;
+        char *text;
+
+        //
+        // NOTE(koekeishiya): Colors are written as 0xAARRGGBB, so half of the tokens get the prefix.
+        //
+
+        if (test_rand(&seed) & 1) {
+            char digits[16];
+            struct token suffix;
+            char *suffix_text = random_token(&seed, "0123456789abcdefABCDEF", 8, &suffix);
+
+            memcpy(digits, "0x", 2);
+            memcpy(digits + 2, suffix_text, suffix.length);
+            free(suffix_text);
+
+            text = malloc(suffix.length + 2);
+            memcpy(text, digits, suffix.length + 2);
+            token = (struct token) { text, suffix.length + 2 };
+        } else {
+            text = random_token(&seed, "0123456789abcdefABCDEFxX+-g", 8, &token);
+        }
+
+        uint32_t expected = 0;
+        sscanf(terminated_copy(token, buffer), "%x", &expected);
+
+        uint32_t value = token_to_uint32t(token);
+        if (value != expected) {
+            if (mismatches++ < 8) fprintf(stderr, "token_to_uint32t(\"%s\") = %x, sscanf = %x\n", buffer, value, expected);
+        }
+
+        free(text);
+    }
+
+    expect_eq(mismatches, 0);
+}
+
+static bool float_matches(float value, float expected)
+{
+    if (value == expected) return true;
+    return fabsf(value - expected) <= fabsf(expected) * 1e-6f;
+}
+
+TEST(token_to_float_matches_sscanf)
+{
+    char *cases[] = { "0", "0.5", ".5", "5.", "-.5", "+2.25", "1e3", "1E-3", "2.5e+2", "1e", "1e+", "3px", "-", ".", "", "e5", "0.0000001", "100000000000000000000000000" };
+    char buffer[64];
+
+    for (int i = 0; i < array_count(cases); ++i) {
+        float expected = 0.0f;
+        sscanf(cases[i], "%f", &expected);
+        expect(float_matches(token_to_float(make_token(cases[i])), expected));
+    }
+
+    uint64_t seed = 0xa4093822299f31d0ULL;
+    int mismatches = 0;
+
+    for (int i = 0; i < FUZZ_TOKENS; ++i) {
+        char text[64];
+        int length = 0;
+        uint64_t r = test_rand(&seed);
+
+        if (r & 1) text[length++] = r & 2 ? '-' : '+';
+
+        int digits = test_rand(&seed) % 8;
+        for (int j = 0; j < digits; ++j) text[length++] = '0' + test_rand(&seed) % 10;
+
+        if (r & 4) {
+            text[length++] = '.';
+            digits = test_rand(&seed) % 8;
+            for (int j = 0; j < digits; ++j) text[length++] = '0' + test_rand(&seed) % 10;
+        }
+
+        if (r & 8) {
+            text[length++] = r & 16 ? 'e' : 'E';
+            if (r & 32) text[length++] = r & 64 ? '-' : '+';
+            text[length++] = '0' + test_rand(&seed) % 10;
+            if (r & 128) text[length++] = '0' + test_rand(&seed) % 2;
+        }
+
+        if (r & 256) text[length++] = ':';
+
+        char *copy = malloc(length ? length : 1);
+        memcpy(copy, text, length);
+
+        struct token token = { copy, length };
+        float expected = 0.0f;
+        sscanf(terminated_copy(token, buffer), "%f", &expected);
+
+        float value = token_to_float(token);
+        if (!float_matches(value, expected)) {
+            if (mismatches++ < 8) fprintf(stderr, "token_to_float(\"%s\") = %.9g, sscanf = %.9g\n", buffer, value, expected);
+        }
+
+        free(copy);
+    }
+
+    expect_eq(mismatches, 0);
+}
+
+TEST(key_value_pairs_are_split_in_place)
+{
+    char *key, *value;
+    bool exclusion;
+
+    char pair[] = "app=Safari";
+    exclusion = true;
+    get_key_value_pair(pair, &key, &value, &exclusion);
+    expect_str(key, "app");
+    expect_str(value, "Safari");
+    expect(!exclusion);
+    expect(value == pair + 4);
+
+    char excluded[] = "title!=^Preferences$";
+    get_key_value_pair(excluded, &key, &value, &exclusion);
+    expect_str(key, "title");
+    expect_str(value, "^Preferences$");
+    expect(exclusion);
+
+    char nested[] = "action=yabai -m window --focus a=b";
+    get_key_value_pair(nested, &key, &value, &exclusion);
+    expect_str(key, "action");
+    expect_str(value, "yabai -m window --focus a=b");
+
+    char missing[] = "app=";
+    get_key_value_pair(missing, &key, &value, &exclusion);
+    expect(key == missing);
+    expect(value == NULL);
+
+    char plain[] = "manage";
+    get_key_value_pair(plain, &key, &value, &exclusion);
+    expect(key == NULL);
+    expect(value == NULL);
+}
+
+//
+// NOTE(koekeishiya): query --windows accepts --fresh anywhere after the command; the handler
+// then sees the remaining arguments in order, as if it had not been given.
+//
+
+TEST(flag_is_taken_from_any_position)
+{
+    char *messages[][5] = {
+        { "query", "--windows", "--fresh", "--space", "2" },
+        { "query", "--windows", "--space", "--fresh", "2" },
+        { "query", "--windows", "--space", "2", "--fresh" },
+        { "query", "--fresh", "--windows", "--space", "2" },
+    };
+
+    for (int i = 0; i < array_count(messages); ++i) {
+        char *message = make_message(messages[i], array_count(messages[i]));
+        struct token_index index;
+
+        expect(token_index_build(&index, message));
+        expect(token_equals(get_token(&index), "query"));
+
+        expect(take_flag(&index, "--fresh"));
+        expect(!take_flag(&index, "--fresh"));
+        expect_eq(index.count, 4);
+
+        expect(token_equals(get_token(&index), "--windows"));
+        expect(token_equals(get_token(&index), "--space"));
+        expect(token_equals(get_token(&index), "2"));
+        expect(!token_is_valid(get_token(&index)));
+
+        token_index_destroy(&index);
+        buf_free(message);
+    }
+
+    char *argv[] = { "--fresh", "query", "--windows", "--fresh", "--window", "--fresh" };
+    char *message = make_message(argv, array_count(argv));
+    struct token_index index;
+
+    expect(token_index_build(&index, message));
+    expect(token_equals(get_token(&index), "--fresh"));
+    expect(token_equals(get_token(&index), "query"));
+    expect(take_flag(&index, "--fresh"));
+    expect_eq(index.count, 4);
+    expect(token_equals(get_token(&index), "--windows"));
+    expect(token_equals(get_token(&index), "--window"));
+    expect(!token_is_valid(get_token(&index)));
+    expect(!take_flag(&index, "--fresh"));
+
+    token_index_destroy(&index);
+    buf_free(message);
+}
+
+//
+// NOTE(koekeishiya): The keyword tables are written by hand, switching on the length and on a byte
+// picked per length. They are checked against a plain list of the keywords that each of them is
+// supposed to recognize, both for the keywords themselves and for every keyword of every other
+// table with small edits applied, which is where a wrongly picked byte would show up.
+//
+
+struct keyword_case
+{
+    char *text;
+    enum keyword keyword;
+};
+
+static struct keyword_case config_command_keywords[] =
+{
+    { COMMAND_CONFIG_DEBUG_OUTPUT,          KEYWORD_COMMAND_CONFIG_DEBUG_OUTPUT },
+    { COMMAND_CONFIG_MFF,                   KEYWORD_COMMAND_CONFIG_MFF },
+    { COMMAND_CONFIG_FFM,                   KEYWORD_COMMAND_CONFIG_FFM },
+    { COMMAND_CONFIG_WINDOW_PLACEMENT,      KEYWORD_COMMAND_CONFIG_WINDOW_PLACEMENT },
+    { COMMAND_CONFIG_TOPMOST,               KEYWORD_COMMAND_CONFIG_TOPMOST },
+    { COMMAND_CONFIG_OPACITY,               KEYWORD_COMMAND_CONFIG_OPACITY },
+    { COMMAND_CONFIG_OPACITY_DURATION,      KEYWORD_COMMAND_CONFIG_OPACITY_DURATION },
+    { COMMAND_CONFIG_BORDER,                KEYWORD_COMMAND_CONFIG_BORDER },
+    { COMMAND_CONFIG_BORDER_WIDTH,          KEYWORD_COMMAND_CONFIG_BORDER_WIDTH },
+    { COMMAND_CONFIG_BORDER_ACTIVE_COLOR,   KEYWORD_COMMAND_CONFIG_BORDER_ACTIVE_COLOR },
+    { COMMAND_CONFIG_BORDER_NORMAL_COLOR,   KEYWORD_COMMAND_CONFIG_BORDER_NORMAL_COLOR },
+    { COMMAND_CONFIG_SHADOW,                KEYWORD_COMMAND_CONFIG_SHADOW },
+    { COMMAND_CONFIG_ACTIVE_WINDOW_OPACITY, KEYWORD_COMMAND_CONFIG_ACTIVE_WINDOW_OPACITY },
+    { COMMAND_CONFIG_NORMAL_WINDOW_OPACITY, KEYWORD_COMMAND_CONFIG_NORMAL_WINDOW_OPACITY },
+    { COMMAND_CONFIG_INSERT_FEEDBACK_COLOR, KEYWORD_COMMAND_CONFIG_INSERT_FEEDBACK_COLOR },
+    { COMMAND_CONFIG_TOP_PADDING,           KEYWORD_COMMAND_CONFIG_TOP_PADDING },
+    { COMMAND_CONFIG_BOTTOM_PADDING,        KEYWORD_COMMAND_CONFIG_BOTTOM_PADDING },
+    { COMMAND_CONFIG_LEFT_PADDING,          KEYWORD_COMMAND_CONFIG_LEFT_PADDING },
+    { COMMAND_CONFIG_RIGHT_PADDING,         KEYWORD_COMMAND_CONFIG_RIGHT_PADDING },
+    { COMMAND_CONFIG_WINDOW_GAP,            KEYWORD_COMMAND_CONFIG_WINDOW_GAP },
+    { COMMAND_CONFIG_LAYOUT,                KEYWORD_COMMAND_CONFIG_LAYOUT },
+    { COMMAND_CONFIG_SPLIT_RATIO,           KEYWORD_COMMAND_CONFIG_SPLIT_RATIO },
+    { COMMAND_CONFIG_AUTO_BALANCE,          KEYWORD_COMMAND_CONFIG_AUTO_BALANCE },
+    { COMMAND_CONFIG_MOUSE_MOD,             KEYWORD_COMMAND_CONFIG_MOUSE_MOD },
+    { COMMAND_CONFIG_MOUSE_ACTION1,         KEYWORD_COMMAND_CONFIG_MOUSE_ACTION1 },
+    { COMMAND_CONFIG_MOUSE_ACTION2,         KEYWORD_COMMAND_CONFIG_MOUSE_ACTION2 },
+    { COMMAND_CONFIG_MOUSE_DROP_ACTION,     KEYWORD_COMMAND_CONFIG_MOUSE_DROP_ACTION },
+    { COMMAND_CONFIG_EXTERNAL_BAR,          KEYWORD_COMMAND_CONFIG_EXTERNAL_BAR },
+};
+
+static struct keyword_case display_selector_keywords[] =
+{
+    { ARGUMENT_COMMON_SEL_NORTH,  KEYWORD_COMMON_SEL_NORTH },
+    { ARGUMENT_COMMON_SEL_EAST,   KEYWORD_COMMON_SEL_EAST },
+    { ARGUMENT_COMMON_SEL_SOUTH,  KEYWORD_COMMON_SEL_SOUTH },
+    { ARGUMENT_COMMON_SEL_WEST,   KEYWORD_COMMON_SEL_WEST },
+    { ARGUMENT_COMMON_SEL_PREV,   KEYWORD_COMMON_SEL_PREV },
+    { ARGUMENT_COMMON_SEL_NEXT,   KEYWORD_COMMON_SEL_NEXT },
+    { ARGUMENT_COMMON_SEL_FIRST,  KEYWORD_COMMON_SEL_FIRST },
+    { ARGUMENT_COMMON_SEL_LAST,   KEYWORD_COMMON_SEL_LAST },
+    { ARGUMENT_COMMON_SEL_RECENT, KEYWORD_COMMON_SEL_RECENT },
+    { ARGUMENT_COMMON_SEL_MOUSE,  KEYWORD_COMMON_SEL_MOUSE },
+};
+
+static struct keyword_case space_selector_keywords[] =
+{
+    { ARGUMENT_COMMON_SEL_PREV,   KEYWORD_COMMON_SEL_PREV },
+    { ARGUMENT_COMMON_SEL_NEXT,   KEYWORD_COMMON_SEL_NEXT },
+    { ARGUMENT_COMMON_SEL_FIRST,  KEYWORD_COMMON_SEL_FIRST },
+    { ARGUMENT_COMMON_SEL_LAST,   KEYWORD_COMMON_SEL_LAST },
+    { ARGUMENT_COMMON_SEL_RECENT, KEYWORD_COMMON_SEL_RECENT },
+    { ARGUMENT_COMMON_SEL_MOUSE,  KEYWORD_COMMON_SEL_MOUSE },
+};
+
+static struct keyword_case window_selector_keywords[] =
+{
+    { ARGUMENT_COMMON_SEL_NORTH,        KEYWORD_COMMON_SEL_NORTH },
+    { ARGUMENT_COMMON_SEL_EAST,         KEYWORD_COMMON_SEL_EAST },
+    { ARGUMENT_COMMON_SEL_SOUTH,        KEYWORD_COMMON_SEL_SOUTH },
+    { ARGUMENT_COMMON_SEL_WEST,         KEYWORD_COMMON_SEL_WEST },
+    { ARGUMENT_COMMON_SEL_PREV,         KEYWORD_COMMON_SEL_PREV },
+    { ARGUMENT_COMMON_SEL_NEXT,         KEYWORD_COMMON_SEL_NEXT },
+    { ARGUMENT_COMMON_SEL_FIRST,        KEYWORD_COMMON_SEL_FIRST },
+    { ARGUMENT_COMMON_SEL_LAST,         KEYWORD_COMMON_SEL_LAST },
+    { ARGUMENT_COMMON_SEL_RECENT,       KEYWORD_COMMON_SEL_RECENT },
+    { ARGUMENT_COMMON_SEL_MOUSE,        KEYWORD_COMMON_SEL_MOUSE },
+    { ARGUMENT_WINDOW_SEL_LARGEST,      KEYWORD_WINDOW_SEL_LARGEST },
+    { ARGUMENT_WINDOW_SEL_SMALLEST,     KEYWORD_WINDOW_SEL_SMALLEST },
+    { ARGUMENT_COMMON_SEL_STACK_PREV,   KEYWORD_COMMON_SEL_STACK_PREV },
+    { ARGUMENT_COMMON_SEL_STACK_NEXT,   KEYWORD_COMMON_SEL_STACK_NEXT },
+    { ARGUMENT_COMMON_SEL_STACK_FIRST,  KEYWORD_COMMON_SEL_STACK_FIRST },
+    { ARGUMENT_COMMON_SEL_STACK_LAST,   KEYWORD_COMMON_SEL_STACK_LAST },
+    { ARGUMENT_COMMON_SEL_STACK_RECENT, KEYWORD_COMMON_SEL_STACK_RECENT },
+};
+
+static struct keyword_case insert_selector_keywords[] =
+{
+    { ARGUMENT_COMMON_SEL_NORTH, KEYWORD_COMMON_SEL_NORTH },
+    { ARGUMENT_COMMON_SEL_EAST,  KEYWORD_COMMON_SEL_EAST },
+    { ARGUMENT_COMMON_SEL_SOUTH, KEYWORD_COMMON_SEL_SOUTH },
+    { ARGUMENT_COMMON_SEL_WEST,  KEYWORD_COMMON_SEL_WEST },
+    { ARGUMENT_COMMON_SEL_STACK, KEYWORD_COMMON_SEL_STACK },
+};
+
+static struct keyword_case display_command_keywords[] =
+{
+    { COMMAND_DISPLAY_FOCUS, KEYWORD_COMMAND_DISPLAY_FOCUS },
+};
+
+static struct keyword_case space_command_keywords[] =
+{
+    { COMMAND_SPACE_FOCUS,   KEYWORD_COMMAND_SPACE_FOCUS },
+    { COMMAND_SPACE_MOVE,    KEYWORD_COMMAND_SPACE_MOVE },
+    { COMMAND_SPACE_SWAP,    KEYWORD_COMMAND_SPACE_SWAP },
+    { COMMAND_SPACE_DISPLAY, KEYWORD_COMMAND_SPACE_DISPLAY },
+    { COMMAND_SPACE_CREATE,  KEYWORD_COMMAND_SPACE_CREATE },
+    { COMMAND_SPACE_DESTROY, KEYWORD_COMMAND_SPACE_DESTROY },
+    { COMMAND_SPACE_BALANCE, KEYWORD_COMMAND_SPACE_BALANCE },
+    { COMMAND_SPACE_MIRROR,  KEYWORD_COMMAND_SPACE_MIRROR },
+    { COMMAND_SPACE_ROTATE,  KEYWORD_COMMAND_SPACE_ROTATE },
+    { COMMAND_SPACE_PADDING, KEYWORD_COMMAND_SPACE_PADDING },
+    { COMMAND_SPACE_GAP,     KEYWORD_COMMAND_SPACE_GAP },
+    { COMMAND_SPACE_TOGGLE,  KEYWORD_COMMAND_SPACE_TOGGLE },
+    { COMMAND_SPACE_LAYOUT,  KEYWORD_COMMAND_SPACE_LAYOUT },
+    { COMMAND_SPACE_LABEL,   KEYWORD_COMMAND_SPACE_LABEL },
+};
+
+static struct keyword_case window_command_keywords[] =
+{
+    { COMMAND_WINDOW_FOCUS,   KEYWORD_COMMAND_WINDOW_FOCUS },
+    { COMMAND_WINDOW_SWAP,    KEYWORD_COMMAND_WINDOW_SWAP },
+    { COMMAND_WINDOW_WARP,    KEYWORD_COMMAND_WINDOW_WARP },
+    { COMMAND_WINDOW_STACK,   KEYWORD_COMMAND_WINDOW_STACK },
+    { COMMAND_WINDOW_INSERT,  KEYWORD_COMMAND_WINDOW_INSERT },
+    { COMMAND_WINDOW_GRID,    KEYWORD_COMMAND_WINDOW_GRID },
+    { COMMAND_WINDOW_MOVE,    KEYWORD_COMMAND_WINDOW_MOVE },
+    { COMMAND_WINDOW_RESIZE,  KEYWORD_COMMAND_WINDOW_RESIZE },
+    { COMMAND_WINDOW_RATIO,   KEYWORD_COMMAND_WINDOW_RATIO },
+    { COMMAND_WINDOW_MIN,     KEYWORD_COMMAND_WINDOW_MIN },
+    { COMMAND_WINDOW_DEMIN,   KEYWORD_COMMAND_WINDOW_DEMIN },
+    { COMMAND_WINDOW_CLOSE,   KEYWORD_COMMAND_WINDOW_CLOSE },
+    { COMMAND_WINDOW_LAYER,   KEYWORD_COMMAND_WINDOW_LAYER },
+    { COMMAND_WINDOW_OPACITY, KEYWORD_COMMAND_WINDOW_OPACITY },
+    { COMMAND_WINDOW_TOGGLE,  KEYWORD_COMMAND_WINDOW_TOGGLE },
+    { COMMAND_WINDOW_DISPLAY, KEYWORD_COMMAND_WINDOW_DISPLAY },
+    { COMMAND_WINDOW_SPACE,   KEYWORD_COMMAND_WINDOW_SPACE },
+};
+
+static struct keyword_case query_command_keywords[] =
+{
+    { COMMAND_QUERY_DISPLAYS, KEYWORD_COMMAND_QUERY_DISPLAYS },
+    { COMMAND_QUERY_SPACES,   KEYWORD_COMMAND_QUERY_SPACES },
+    { COMMAND_QUERY_WINDOWS,  KEYWORD_COMMAND_QUERY_WINDOWS },
+};
+
+static struct keyword_case rule_command_keywords[] =
+{
+    { COMMAND_RULE_ADD, KEYWORD_COMMAND_RULE_ADD },
+    { COMMAND_RULE_REM, KEYWORD_COMMAND_RULE_REM },
+    { COMMAND_RULE_LS,  KEYWORD_COMMAND_RULE_LS },
+};
+
+static struct keyword_case signal_command_keywords[] =
+{
+    { COMMAND_SIGNAL_ADD, KEYWORD_COMMAND_SIGNAL_ADD },
+    { COMMAND_SIGNAL_REM, KEYWORD_COMMAND_SIGNAL_REM },
+    { COMMAND_SIGNAL_LS,  KEYWORD_COMMAND_SIGNAL_LS },
+};
+
+static struct keyword_case domain_keywords[] =
+{
+    { DOMAIN_CONFIG,    KEYWORD_DOMAIN_CONFIG },
+    { DOMAIN_DISPLAY,   KEYWORD_DOMAIN_DISPLAY },
+    { DOMAIN_SPACE,     KEYWORD_DOMAIN_SPACE },
+    { DOMAIN_WINDOW,    KEYWORD_DOMAIN_WINDOW },
+    { DOMAIN_QUERY,     KEYWORD_DOMAIN_QUERY },
+    { DOMAIN_RULE,      KEYWORD_DOMAIN_RULE },
+    { DOMAIN_SIGNAL,    KEYWORD_DOMAIN_SIGNAL },
+    { DOMAIN_BATCH,     KEYWORD_DOMAIN_BATCH },
+    { DOMAIN_SUBSCRIBE, KEYWORD_DOMAIN_SUBSCRIBE },
+};
+
+struct keyword_table
+{
+    char *name;
+    enum keyword (*lookup)(struct token token);
+    struct keyword_case *keywords;
+    int count;
+};
+
+#define KEYWORD_TABLE(name) { #name, keyword_##name, name##_keywords, array_count(name##_keywords) }
+
+static struct keyword_table keyword_tables[] =
+{
+    KEYWORD_TABLE(config_command),
+    KEYWORD_TABLE(display_selector),
+    KEYWORD_TABLE(space_selector),
+    KEYWORD_TABLE(window_selector),
+    KEYWORD_TABLE(insert_selector),
+    KEYWORD_TABLE(display_command),
+    KEYWORD_TABLE(space_command),
+    KEYWORD_TABLE(window_command),
+    KEYWORD_TABLE(query_command),
+    KEYWORD_TABLE(rule_command),
+    KEYWORD_TABLE(signal_command),
+    KEYWORD_TABLE(domain),
+};
+
+static enum keyword keyword_table_find(struct keyword_table *table, struct token token)
+{
+    for (int i = 0; i < table->count; ++i) {
+        if (token_equals(token, table->keywords[i].text)) return table->keywords[i].keyword;
+    }
+
+    return KEYWORD_UNKNOWN;
+}
+
+static void push_candidate(struct token **candidates, char *text, int length)
+{
+    char *copy = malloc(length ? length : 1);
+    memcpy(copy, text, length);
+    buf_push(*candidates, ((struct token) { copy, length }));
+}
+
+static struct token *keyword_candidates(void)
+{
+    struct token *candidates = NULL;
+    char buffer[64];
+
+    push_candidate(&candidates, "", 0);
+
+    for (int i = 0; i < array_count(keyword_tables); ++i) {
+        for (int j = 0; j < keyword_tables[i].count; ++j) {
+            char *text = keyword_tables[i].keywords[j].text;
+            int length = strlen(text);
+
+            push_candidate(&candidates, text, length);
+            push_candidate(&candidates, text, length - 1);
+            push_candidate(&candidates, text + 1, length - 1);
+
+            memcpy(buffer, text, length);
+            buffer[length] = 'x';
+            push_candidate(&candidates, buffer, length + 1);
+
+            for (int k = 0; k < length; ++k) {
+                memcpy(buffer, text, length);
+                buffer[k] = buffer[k] + 1;
+                push_candidate(&candidates, buffer, length);
+
+                buffer[k] = text[k] >= 'a' && text[k] <= 'z' ? text[k] - 'a' + 'A' : text[k];
+                push_candidate(&candidates, buffer, length);
+            }
+        }
+    }
+
+    return candidates;
+}
+
+TEST(keyword_tables_match_their_keywords)
+{
+    for (int i = 0; i < array_count(keyword_tables); ++i) {
+        struct keyword_table *table = &keyword_tables[i];
+
+        for (int j = 0; j < table->count; ++j) {
+            struct token token = make_token(table->keywords[j].text);
+            expect_eq(table->lookup(token), table->keywords[j].keyword);
+        }
+    }
+}
+
+TEST(keyword_tables_reject_near_misses)
+{
+    struct token *candidates = keyword_candidates();
+    int mismatches = 0;
+
+    for (int i = 0; i < array_count(keyword_tables); ++i) {
+        struct keyword_table *table = &keyword_tables[i];
+
+        for (int j = 0; j < buf_len(candidates); ++j) {
+            enum keyword expected = keyword_table_find(table, candidates[j]);
+            enum keyword keyword = table->lookup(candidates[j]);
+
+            if (keyword != expected) {
+                if (mismatches++ < 8) fprintf(stderr, "keyword_%s(\"%.*s\") = %d, expected %d\n", table->name, candidates[j].length, candidates[j].text, keyword, expected);
+            }
+        }
+    }
+
+    expect_eq(mismatches, 0);
+    expect(buf_len(candidates) > 1000);
+
+    for (int i = 0; i < buf_len(candidates); ++i) free(candidates[i].text);
+    buf_free(candidates);
+}
+
+int main(int argc, char **argv)
+{
+    run_test(token_index_points_into_message);
+    run_test(token_index_grows_past_inline_capacity);
+    run_test(exhausted_index_returns_empty_token);
+    run_test(empty_argument_ends_message);
+    run_test(token_to_string_copies_token);
+    run_test(token_to_int_matches_sscanf);
+    run_test(token_to_int_clamps_on_overflow);
+    run_test(token_to_uint32t_matches_sscanf);
+    run_test(token_to_float_matches_sscanf);
+    run_test(key_value_pairs_are_split_in_place);
+    run_test(flag_is_taken_from_any_position);
+    run_test(keyword_tables_match_their_keywords);
+    run_test(keyword_tables_reject_near_misses);
+
+    return test_report("message_token");
+}
@@ -0,0 +1,193 @@
+#ifndef PATTERN_HARNESS_H
+#define PATTERN_HARNESS_H
+
+#include "compat.h"
+
+#define HASHTABLE_IMPLEMENTATION
+#include "misc/hashtable.h"
+#undef HASHTABLE_IMPLEMENTATION
+
+#include <regex.h>
+
+//
+// NOTE(koekeishiya): Same definitions as misc/helpers.h, which can not be included here because
+// it depends on the accessibility API.
+//
+
+static inline bool string_equals(const char *a, const char *b)
+{
+    return a && b && strcmp(a, b) == 0;
+}
+
+static inline char *string_copy(char *s)
+{
+    int length = strlen(s);
+    char *result = malloc(length + 1);
+    if (!result) return NULL;
+
+    memcpy(result, s, length);
+    result[length] = '\0';
+    return result;
+}
+
+#include "misc/pattern.h"
+#include "misc/pattern.c"
+
+//
+// NOTE(koekeishiya): The patterns that rules and signals compile into a pattern set, the way
+// people write them: literal prefixes and suffixes, alternations of application names, optional
+// parts and a few bracket expressions. Literal patterns are matched through the literal table
+// instead, so every pattern here needs at least one operator.
+//
+
+static char *harness_apps[] =
+{
+    "Safari", "Firefox", "Google Chrome", "Terminal", "iTerm2", "Mail", "Finder", "Xcode", "Slack", "Spotify",
+    "Preview", "Calendar", "Notes", "Messages", "Discord", "Zoom", "Music", "Photos", "Activity Monitor", "Code"
+};
+
+static char *harness_rule_patterns[] =
+{
+    "^(Calculator|System Preferences|System Settings|Archive Utility)$",
+    "^(Karabiner-Elements|Karabiner-EventViewer|Alfred Preferences)$",
+    "(Preferences|Settings)$",
+    "^Picture.in.Picture$",
+    "^(Copy|Move|Delete|Bin)$",
+    " - YouTube$",
+    "^Inbox \\([0-9]+\\) - .*@.* - Gmail$",
+    "[0-9]+ unread",
+    "\\.(pdf|png|jpe?g|gif)$",
+    "\\.(c|h|m|cpp)( - Edited)?$",
+    "^zsh|^bash|^fish",
+    "(Private Browsing)|(Incognito)",
+    "^Open( File)?$",
+    "^Save( As)?\\.*$",
+    "^(About|Welcome to) ",
+    "Software Update|Install(ing)? Update",
+    "^\\[[A-Z]+-[0-9]+\\]",
+    "(DEBUG|RELEASE|TEST) build",
+    "^Untitled( [0-9]+)?$",
+    "^.* — Edited$",
+    "Meeting|Webinar|Huddle",
+    "^(General|Advanced|Accounts|Privacy)$",
+    "Downloads?$",
+    "^(Error|Warning|Alert)s?:? ",
+    "#[a-z0-9_-]+ \\| ",
+    "Now Playing|Up Next",
+    "^Screen Shot [0-9-]+ at ",
+    "\\((Not Responding|Not responding)\\)$",
+    "^Tab [0-9]+ of [0-9]+$",
+    "^(Main|Popup|Dialog|Sheet)Window$",
+    "yabai|skhd|spacebar",
+    "^[0-9]+(\\.[0-9]+)* MB$",
+    "@github\\.com|@gitlab\\.com",
+    "(^| )[A-Z][a-z]+ [0-9]+, [0-9]+$",
+    "^Welcome$|^Getting Started$",
+    "Pull Request #[0-9]+",
+    "^\\* |^\\+ ",
+    "(Read|Write)[- ]Only",
+    "^Keychain|^Password",
+    "localhost:[0-9]+"
+};
+
+static void harness_rule_patterns_create(char ***patterns)
+{
+    for (int i = 0; i < array_count(harness_rule_patterns); ++i) {
+        buf_push(*patterns, string_copy(harness_rule_patterns[i]));
+    }
+
+    for (int i = 0; i < array_count(harness_apps); ++i) {
+        char buffer[256];
+
+        snprintf(buffer, sizeof(buffer), "^%s( .*)?$", harness_apps[i]);
+        buf_push(*patterns, string_copy(buffer));
+
+        snprintf(buffer, sizeof(buffer), "%s (Preferences|Settings)", harness_apps[i]);
+        buf_push(*patterns, string_copy(buffer));
+
+        snprintf(buffer, sizeof(buffer), " (-|—) %s$", harness_apps[i]);
+        buf_push(*patterns, string_copy(buffer));
+    }
+}
+
+static void harness_patterns_destroy(char ***patterns)
+{
+    for (int i = 0; i < buf_len(*patterns); ++i) {
+        free((*patterns)[i]);
+    }
+
+    buf_free(*patterns);
+    *patterns = NULL;
+}
+
+//
+// NOTE(koekeishiya): Window titles the way applications set them; documents with and without an
+// edited marker, browser tabs, chat channels with unread counts, terminal sessions, dialogs,
+// and the occasional empty title.
+//
+
+static char *harness_documents[] =
+{
+    "main", "window_manager", "Quarterly Report", "IMG_2041", "notes", "Screen Shot 2020-03-14 at 10.21.07",
+    "README", "invoice-0042", "Untitled", "Untitled 3", "draft", "presentation"
+};
+
+static char *harness_extensions[] = { "c", "h", "pdf", "png", "jpg", "txt", "md", "key" };
+
+static char *harness_pages[] =
+{
+    "How to tile windows on macOS", "koekeishiya/yabai: A tiling window manager for macOS",
+    "Pull Request #512 · koekeishiya/yabai", "Hacker News", "localhost:8080/dashboard",
+    "Inbox (12) - someone@example.com - Gmail", "Lo-fi beats to code to - YouTube", "Private Browsing"
+};
+
+static char *harness_dialogs[] =
+{
+    "", "Open", "Save As", "Copy", "Preferences", "General", "Software Update", "Picture in Picture",
+    "About This Mac", "Welcome", "Calculator", "Error: file not found"
+};
+
+static void harness_title(char *buffer, int size, uint64_t *seed)
+{
+    uint64_t r = test_rand(seed);
+    char *app = harness_apps[(r >> 8) % array_count(harness_apps)];
+    char *document = harness_documents[(r >> 16) % array_count(harness_documents)];
+    char *extension = harness_extensions[(r >> 24) % array_count(harness_extensions)];
+    char *page = harness_pages[(r >> 32) % array_count(harness_pages)];
+    char *dialog = harness_dialogs[(r >> 40) % array_count(harness_dialogs)];
+    int number = (r >> 48) % 100;
+
+    switch (r % 8) {
+    case 0: snprintf(buffer, size, "%s.%s — Edited", document, extension); break;
+    case 1: snprintf(buffer, size, "%s.%s - %s", document, extension, app); break;
+    case 2: snprintf(buffer, size, "%s - %s", page, app); break;
+    case 3: snprintf(buffer, size, "#general | %d unread - %s", number, app); break;
+    case 4: snprintf(buffer, size, "someone@host: ~/src/yabai — zsh — %dx24", 80 + number); break;
+    case 5: snprintf(buffer, size, "%s", dialog); break;
+    case 6: snprintf(buffer, size, "%s %s", app, number & 1 ? "Preferences" : "Settings"); break;
+    case 7: snprintf(buffer, size, "[YABAI-%d] %s - %s", number, document, app); break;
+    }
+}
+
+//
+// NOTE(koekeishiya): What the pattern set replaces: regexec once per pattern. The result uses the
+// same layout as pattern_set_match, so that the two can be compared word by word.
+//
+
+static bool harness_regex_compile(regex_t *regex, const char *pattern)
+{
+    return regcomp(regex, pattern, REG_EXTENDED | REG_NOSUB) == 0;
+}
+
+static void harness_regex_match(regex_t *regex, int count, const char *str, uint64_t *result)
+{
+    memset(result, 0, ((count + 63) / 64) * sizeof(uint64_t));
+
+    for (int i = 0; i < count; ++i) {
+        if (regexec(&regex[i], str, 0, NULL, 0) == 0) {
+            result[i >> 6] |= 1ULL << (i & 63);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,336 @@
+#include "test.h"
+#include "pattern_harness.h"
+
+#define RANDOM_PATTERNS 80
+#define BLOWUP_SUBJECTS 20
+#define BLOWUP_LENGTH   2000
+
+#if PATTERN_SET_MAX_STATES < 4096
+#define TITLES          1000
+#define RANDOM_ROUNDS   20
+#define RANDOM_SUBJECTS 100
+#else
+#define TITLES          5000
+#define RANDOM_ROUNDS   50
+#define RANDOM_SUBJECTS 300
+#endif
+
+//
+// NOTE(koekeishiya): Every test compares the pattern set against regexec for the same patterns.
+// Built with -DPATTERN_SET_MAX_STATES=4 (pattern_flush_test) the state cache is cleared on almost
+// every transition, so that the same tests cover matching across a flush.
+//
+
+static int compare_with_regexec(struct pattern_set *set, regex_t *regex, int *id, int count, const char *str)
+{
+    uint64_t expected[(RANDOM_PATTERNS + 63) / 64 + 2];
+    assert(count <= (int) array_count(expected) * 64);
+    harness_regex_match(regex, count, str, expected);
+
+    uint64_t *result = pattern_set_match(set, str);
+    int mismatches = 0;
+
+    for (int i = 0; i < count; ++i) {
+        if (id[i] == -1) continue;
+
+        bool actual = pattern_set_has(result, id[i]);
+        bool wanted = (expected[i >> 6] >> (i & 63)) & 1;
+
+        if (actual != wanted) {
+            if (!mismatches++) fprintf(stderr, "'%s' on '%s': pattern set %d, regexec %d\n", set->pattern[id[i]], str, actual, wanted);
+        }
+    }
+
+    return mismatches;
+}
+
+TEST(rule_patterns_match_regexec_on_titles)
+{
+    char **patterns = NULL;
+    harness_rule_patterns_create(&patterns);
+
+    int count = buf_len(patterns);
+    regex_t *regex = malloc(count * sizeof(regex_t));
+    int *id = malloc(count * sizeof(int));
+    struct pattern_set set = {};
+
+    expect_eq(count, 100);
+    for (int i = 0; i < count; ++i) {
+        expect(harness_regex_compile(&regex[i], patterns[i]));
+        id[i] = pattern_set_add(&set, patterns[i]);
+        expect_eq(id[i], i);
+    }
+
+    uint64_t seed = 0x5851f42d4c957f2dULL;
+    int mismatches = 0;
+    int matched = 0;
+
+    for (int i = 0; i < TITLES; ++i) {
+        char title[256];
+        harness_title(title, sizeof(title), &seed);
+        mismatches += compare_with_regexec(&set, regex, id, count, title) != 0;
+
+        uint64_t *result = pattern_set_match(&set, title);
+        for (int j = 0; j < set.word_count; ++j) matched += __builtin_popcountll(result[j]);
+    }
+
+    expect_eq(mismatches, 0);
+    expect(matched > TITLES / 2);
+
+    for (int i = 0; i < count; ++i) regfree(&regex[i]);
+    pattern_set_free(&set);
+    harness_patterns_destroy(&patterns);
+    free(regex);
+    free(id);
+}
+
+//
+// NOTE(koekeishiya): Random patterns over a three letter alphabet, so that subjects drawn from
+// the same letters match often enough to be interesting. Subjects also contain a byte of a
+// multi-byte sequence, which '.' and negated brackets have to accept.
+//
+// Anchors only begin or end a top-level alternative, and subjects never contain a newline. glibc
+// lets an anchor in the middle of a pattern match next to a newline even without REG_NEWLINE, and
+// lets an anchor inside a repeated group match away from the start or end of the string, neither
+// of which POSIX or the macOS regexec do. Anchors inside groups are covered by the fixed cases in
+// anchors_inside_groups instead.
+//
+
+static void random_pattern(char **buffer, int depth, uint64_t *seed);
+
+static void random_atom(char **buffer, int depth, uint64_t *seed)
+{
+    static char *brackets[] = { "[ab]", "[^a]", "[a-c]", "[]a]", "[^]b]", "[b-]", "[.]" };
+    uint64_t r = test_rand(seed);
+
+    switch (r % 14) {
+    case 0: case 1: case 2: case 3: case 4: case 5: {
+        buf_push(*buffer, "abc"[(r >> 8) % 3]);
+    } break;
+    case 6: case 7: {
+        buf_push(*buffer, '.');
+    } break;
+    case 8: {
+        buf_push(*buffer, '\\');
+        buf_push(*buffer, "\\.]("[(r >> 8) % 4]);
+    } break;
+    case 9: case 10: {
+        char *bracket = brackets[(r >> 8) % array_count(brackets)];
+        while (*bracket) buf_push(*buffer, *bracket++);
+    } break;
+    case 11: case 12: case 13: {
+        if (depth < 3) {
+            buf_push(*buffer, '(');
+            random_pattern(buffer, depth + 1, seed);
+            buf_push(*buffer, ')');
+        } else {
+            buf_push(*buffer, 'a');
+        }
+    } break;
+    }
+
+    r = test_rand(seed);
+    if (r % 4 == 0) buf_push(*buffer, "*+?"[(r >> 8) % 3]);
+}
+
+static void random_pattern(char **buffer, int depth, uint64_t *seed)
+{
+    int alternatives = 1 + (test_rand(seed) % 8 == 0) + (test_rand(seed) % 8 == 0);
+
+    for (int i = 0; i < alternatives; ++i) {
+        if (i > 0) buf_push(*buffer, '|');
+
+        uint64_t r = test_rand(seed);
+        if (depth == 0 && r % 6 == 0) buf_push(*buffer, '^');
+
+        int atoms = 1 + (r >> 8) % 4;
+        for (int j = 0; j < atoms; ++j) {
+            random_atom(buffer, depth, seed);
+        }
+
+        if (depth == 0 && (r >> 16) % 6 == 0) buf_push(*buffer, '$');
+    }
+}
+
+static void random_subject(char *buffer, int size, uint64_t *seed)
+{
+    static const char alphabet[] = "abcabc.-]\xe2";
+    int length = test_rand(seed) % (size < 13 ? size : 13);
+
+    for (int i = 0; i < length; ++i) {
+        buffer[i] = alphabet[test_rand(seed) % (sizeof(alphabet) - 1)];
+    }
+
+    buffer[length] = '\0';
+}
+
+TEST(random_patterns_match_regexec)
+{
+    uint64_t seed = 0x9e3779b97f4a7c15ULL;
+    int mismatches = 0;
+    int rejected = 0;
+    int compared = 0;
+
+    for (int round = 0; round < RANDOM_ROUNDS; ++round) {
+        regex_t regex[RANDOM_PATTERNS];
+        int id[RANDOM_PATTERNS];
+        struct pattern_set set = {};
+        int count = 0;
+
+        while (count < RANDOM_PATTERNS) {
+            char *pattern = NULL;
+            random_pattern(&pattern, 0, &seed);
+            buf_push(pattern, '\0');
+
+            if (harness_regex_compile(&regex[count], pattern)) {
+                id[count] = pattern_set_add(&set, pattern);
+                rejected += id[count] == -1;
+                ++count;
+            }
+
+            buf_free(pattern);
+        }
+
+        for (int i = 0; i < RANDOM_SUBJECTS; ++i) {
+            char subject[16];
+            random_subject(subject, sizeof(subject), &seed);
+            mismatches += compare_with_regexec(&set, regex, id, count, subject) != 0;
+            ++compared;
+        }
+
+        for (int i = 0; i < count; ++i) regfree(&regex[i]);
+        pattern_set_free(&set);
+    }
+
+    expect_eq(mismatches, 0);
+    expect(rejected < RANDOM_ROUNDS * RANDOM_PATTERNS / 10);
+    expect_eq(compared, RANDOM_ROUNDS * RANDOM_SUBJECTS);
+}
+
+TEST(anchors_inside_groups)
+{
+    struct { char *pattern; char *str; bool match; } cases[] = {
+        { "(^b|^.)+bc",    "abc",   true  },
+        { "(^b|^.)+bc",    "aabc",  false },
+        { "x(^a|b)",       "xa",    false },
+        { "(a|^b)c",       "bc",    true  },
+        { "(a|^b)c",       "xbc",   false },
+        { "a(bc|$)+b\\.", "abcb.", true  },
+        { "a(bc|$b)+\\.", "abcb.", false },
+        { "a(b$|c)",       "ab",    true  },
+        { "a(b$|c)",       "abc",   false },
+        { "(a$)+",         "aa",    true  },
+        { "x(a$)*b",       "xab",   false },
+        { ".^a",           "b\na",  false },
+        { "a$.",           "a\nb",  false },
+    };
+
+    for (int i = 0; i < array_count(cases); ++i) {
+        struct pattern_set set = {};
+        expect_eq(pattern_set_add(&set, cases[i].pattern), 0);
+        expect_eq(pattern_set_has(pattern_set_match(&set, cases[i].str), 0), cases[i].match);
+        pattern_set_free(&set);
+    }
+}
+
+TEST(unsupported_patterns_are_rejected)
+{
+    char *cases[] = {
+        "a{2}", "a{1,3}", "[[:alpha:]]+", "[[.a.]]", "[[=a=]]", "\\d+", "\\w", "\\1",
+        "(a", "a)", "()", "*a", "a|", "|a", "[a", "[z-a]", "^*", "a$+", "a\\"
+    };
+
+    struct pattern_set set = {};
+    expect_eq(pattern_set_add(&set, "ab+c"), 0);
+    int node_count = buf_len(set.node);
+
+    for (int i = 0; i < array_count(cases); ++i) {
+        expect_eq(pattern_set_add(&set, cases[i]), -1);
+        expect_eq(buf_len(set.node), node_count);
+    }
+
+    expect_eq(pattern_set_count(&set), 1);
+    expect(pattern_set_has(pattern_set_match(&set, "xabbbcx"), 0));
+    expect(!pattern_set_has(pattern_set_match(&set, "xacx"), 0));
+
+    pattern_set_free(&set);
+}
+
+TEST(duplicate_patterns_share_an_id)
+{
+    struct pattern_set set = {};
+
+    expect_eq(pattern_set_add(&set, "^Safari$|^Firefox$"), 0);
+    expect_eq(pattern_set_add(&set, "Preferences$"), 1);
+    expect_eq(pattern_set_add(&set, "^Safari$|^Firefox$"), 0);
+    expect_eq(pattern_set_count(&set), 2);
+
+    pattern_set_free(&set);
+}
+
+//
+// NOTE(koekeishiya): The first pattern needs a distinct state for every combination of the last
+// fifteen letters, which is more than the cache holds even with the default limit. Matching long
+// strings has to clear the cache many times over without changing the answer or growing the cache
+// past its limit.
+//
+
+TEST(state_cache_is_cleared_when_full)
+{
+    char *patterns[] = { "(a|b)*a(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)$", "b(a|b)*b$", "^(ab)+$" };
+
+    regex_t regex[array_count(patterns)];
+    int id[array_count(patterns)];
+    struct pattern_set set = {};
+
+    for (int i = 0; i < array_count(patterns); ++i) {
+        expect(harness_regex_compile(&regex[i], patterns[i]));
+        id[i] = pattern_set_add(&set, patterns[i]);
+        expect_eq(id[i], i);
+    }
+
+    uint64_t seed = 0xd1b54a32d192ed03ULL;
+    char *subject = malloc(BLOWUP_LENGTH + 1);
+    int mismatches = 0;
+    int max_states = 0;
+    int flushes = 0;
+
+    for (int i = 0; i < BLOWUP_SUBJECTS; ++i) {
+        for (int j = 0; j < BLOWUP_LENGTH; ++j) {
+            subject[j] = "ab"[test_rand(&seed) & 1];
+        }
+
+        subject[i % 2 ? BLOWUP_LENGTH : BLOWUP_LENGTH / 2] = '\0';
+        if (i == BLOWUP_SUBJECTS - 1) strcpy(subject, "abababab");
+
+        int state_count = buf_len(set.state);
+
+        mismatches += compare_with_regexec(&set, regex, id, array_count(patterns), subject) != 0;
+        flushes += buf_len(set.state) < state_count;
+        if (buf_len(set.state) > max_states) max_states = buf_len(set.state);
+    }
+
+    expect_eq(mismatches, 0);
+    expect(flushes > 0);
+    expect(max_states <= PATTERN_SET_MAX_STATES + 1);
+
+    for (int i = 0; i < array_count(patterns); ++i) regfree(&regex[i]);
+    pattern_set_free(&set);
+    free(subject);
+}
+
+int main(int argc, char **argv)
+{
+    run_test(rule_patterns_match_regexec_on_titles);
+    run_test(random_patterns_match_regexec);
+    run_test(anchors_inside_groups);
+    run_test(unsupported_patterns_are_rejected);
+    run_test(duplicate_patterns_share_an_id);
+    run_test(state_cache_is_cleared_when_full);
+
+#if PATTERN_SET_MAX_STATES < 4096
+    return test_report("pattern (PATTERN_SET_MAX_STATES)");
+#else
+    return test_report("pattern");
+#endif
+}
@@ -0,0 +1,347 @@
+#include "test.h"
+#include "osax/protocol.h"
+
+#define FUZZ_FRAMES 20000
+
+//
+// NOTE(koekeishiya): Fills exactly the fields that the given opcode puts on the wire and leaves
+// everything else zeroed, which is also what sa_decode_command produces. A command that survives
+// a roundtrip is therefore bytewise equal to the one that was encoded.
+//
+
+static void random_command(struct sa_command *command, uint8_t op, uint64_t *seed)
+{
+    memset(command, 0, sizeof(struct sa_command));
+    command->op = op;
+
+    uint32_t a = (uint32_t) test_rand(seed);
+    uint32_t b = (uint32_t) test_rand(seed);
+    float f = (float)(int32_t) test_rand(seed) / 65536.0f;
+    float g = (float)(int32_t) test_rand(seed) / 1048576.0f;
+
+    switch (op) {
+    case SA_OP_HANDSHAKE: {
+        command->handshake.version = (uint16_t) a;
+    } break;
+    case SA_OP_SPACE_FOCUS:
+    case SA_OP_SPACE_CREATE:
+    case SA_OP_SPACE_DESTROY: {
+        command->space.sid = test_rand(seed);
+    } break;
+    case SA_OP_SPACE_MOVE: {
+        command->space_move.src_sid = test_rand(seed);
+        command->space_move.dst_sid = test_rand(seed);
+        command->space_move.focus = a & 1;
+    } break;
+    case SA_OP_WINDOW_SCALE: {
+        command->window_scale.wid = a;
+        command->window_scale.x = f;
+        command->window_scale.y = -f;
+        command->window_scale.w = g;
+        command->window_scale.h = f * 0.5f;
+    } break;
+    case SA_OP_WINDOW_MOVE: {
+        command->window_move.wid = a;
+        command->window_move.x = (int32_t) b;
+        command->window_move.y = -(int32_t)(b >> 1);
+    } break;
+    case SA_OP_WINDOW_ALPHA: {
+        command->window_alpha.wid = a;
+        command->window_alpha.alpha = g;
+    } break;
+    case SA_OP_WINDOW_ALPHA_FADE: {
+        command->window_alpha.wid = a;
+        command->window_alpha.alpha = g;
+        command->window_alpha.duration = f;
+    } break;
+    case SA_OP_WINDOW_LEVEL: {
+        command->window_level.wid = a;
+        command->window_level.key = (int32_t) b;
+    } break;
+    case SA_OP_WINDOW_STICKY:
+    case SA_OP_WINDOW_SHADOW: {
+        command->window_flag.wid = a;
+        command->window_flag.value = b & 1;
+    } break;
+    case SA_OP_WINDOW_FOCUS: {
+        command->window.wid = a;
+    } break;
+    case SA_OP_WINDOW_GROUP_ADD:
+    case SA_OP_WINDOW_GROUP_REMOVE: {
+        command->window_group.parent_wid = a;
+        command->window_group.child_wid = b;
+    } break;
+    }
+}
+
+static bool command_equals(struct sa_command *a, struct sa_command *b)
+{
+    return memcmp(a, b, sizeof(struct sa_command)) == 0;
+}
+
+//
+// NOTE(koekeishiya): Frames are copied into an allocation of exactly their length, so that the
+// address sanitizer reports any read past the end of a frame.
+//
+
+static uint8_t *copy_frame(const uint8_t *bytes, uint32_t length)
+{
+    uint8_t *frame = malloc(length ? length : 1);
+    memcpy(frame, bytes, length);
+    return frame;
+}
+
+TEST(every_opcode_roundtrips)
+{
+    uint64_t seed = 0x3c6ef372fe94f82bULL;
+
+    for (int op = SA_OP_INVALID + 1; op < SA_OP_COUNT; ++op) {
+        for (int i = 0; i < 100; ++i) {
+            struct sa_buffer buffer;
+            struct sa_reader reader;
+            struct sa_command command, decoded;
+
+            random_command(&command, op, &seed);
+            sa_buffer_init(&buffer);
+
+            expect(sa_encode_command(&buffer, &command));
+            expect_eq(buffer.length, sa_command_size(op));
+            expect_eq(buffer.data[0], op);
+
+            uint8_t *frame = copy_frame(buffer.data, buffer.length);
+            sa_reader_init(&reader, frame, buffer.length);
+
+            expect(sa_decode_command(&reader, &decoded));
+            expect(sa_reader_is_empty(&reader));
+            expect(command_equals(&command, &decoded));
+            expect(!sa_decode_command(&reader, &decoded));
+
+            free(frame);
+        }
+    }
+}
+
+TEST(encoding_is_little_endian_and_packed)
+{
+    struct sa_buffer buffer;
+    struct sa_command command = { .op = SA_OP_WINDOW_MOVE, .window_move = { 0x01020304, -1, 2 } };
+    uint8_t expected[] = { SA_OP_WINDOW_MOVE, 0x04, 0x03, 0x02, 0x01, 0xff, 0xff, 0xff, 0xff, 0x02, 0x00, 0x00, 0x00 };
+
+    sa_buffer_init(&buffer);
+    expect(sa_encode_command(&buffer, &command));
+    expect_eq(buffer.length, sizeof(expected));
+    expect(memcmp(buffer.data, expected, sizeof(expected)) == 0);
+
+    struct sa_command handshake = { .op = SA_OP_HANDSHAKE, .handshake.version = 0xbeef };
+    sa_buffer_init(&buffer);
+    expect(sa_encode_command(&buffer, &handshake));
+    expect_eq(buffer.length, 3);
+    expect_eq(buffer.data[1], 0xef);
+    expect_eq(buffer.data[2], 0xbe);
+}
+
+TEST(full_frame_roundtrips_in_order)
+{
+    uint64_t seed = 0xa54ff53a5f1d36f1ULL;
+    struct sa_buffer buffer;
+    struct sa_command *sent = NULL;
+    struct sa_command command;
+
+    sa_buffer_init(&buffer);
+
+    for (;;) {
+        random_command(&command, 1 + test_rand(&seed) % (SA_OP_COUNT - 1), &seed);
+
+        uint32_t length = buffer.length;
+        if (!sa_encode_command(&buffer, &command)) {
+            expect_eq(buffer.length, length);
+            expect(length + sa_command_size(command.op) > SA_MAX_FRAME_SIZE);
+            break;
+        }
+
+        buf_push(sent, command);
+    }
+
+    expect(buf_len(sent) > SA_MAX_FRAME_SIZE / 32);
+    expect(buf_len(sent) <= SA_MAX_COMMAND_COUNT);
+
+    struct sa_reader reader;
+    uint8_t *frame = copy_frame(buffer.data, buffer.length);
+    sa_reader_init(&reader, frame, buffer.length);
+
+    int matched = 0;
+    for (int i = 0; i < buf_len(sent); ++i) {
+        matched += sa_decode_command(&reader, &command) && command_equals(&sent[i], &command);
+    }
+
+    expect_eq(matched, buf_len(sent));
+    expect(sa_reader_is_empty(&reader));
+
+    free(frame);
+    buf_free(sent);
+}
+
+TEST(unknown_opcodes_are_rejected)
+{
+    struct sa_buffer buffer;
+    struct sa_command command;
+    uint8_t bytes[SA_MAX_FRAME_SIZE];
+    uint64_t seed = 0x510e527fade682d1ULL;
+
+    for (int i = 0; i < sizeof(bytes); ++i) bytes[i] = (uint8_t) test_rand(&seed);
+
+    for (int op = 0; op < 256; ++op) {
+        if (op > SA_OP_INVALID && op < SA_OP_COUNT) continue;
+
+        expect_eq(sa_command_size(op), 0);
+
+        memset(&command, 0, sizeof(command));
+        command.op = op;
+        sa_buffer_init(&buffer);
+        expect(!sa_encode_command(&buffer, &command));
+        expect_eq(buffer.length, 0);
+
+        struct sa_reader reader;
+        bytes[0] = op;
+        uint8_t *frame = copy_frame(bytes, 1 + op % 32);
+        sa_reader_init(&reader, frame, 1 + op % 32);
+
+        expect(!sa_decode_command(&reader, &command));
+        expect(reader.cursor == frame);
+
+        free(frame);
+    }
+}
+
+TEST(truncated_commands_are_rejected)
+{
+    uint64_t seed = 0x9b05688c2b3e6c1fULL;
+
+    for (int op = SA_OP_INVALID + 1; op < SA_OP_COUNT; ++op) {
+        struct sa_buffer buffer;
+        struct sa_command command;
+
+        random_command(&command, op, &seed);
+        sa_buffer_init(&buffer);
+        expect(sa_encode_command(&buffer, &command));
+
+        for (uint32_t length = 0; length < buffer.length; ++length) {
+            struct sa_reader reader;
+            uint8_t *frame = copy_frame(buffer.data, length);
+            sa_reader_init(&reader, frame, length);
+
+            expect(!sa_decode_command(&reader, &command));
+            expect(reader.cursor == frame);
+
+            free(frame);
+        }
+    }
+}
+
+//
+// NOTE(koekeishiya): A frame cut at an arbitrary offset must yield exactly the commands that
+// were completely contained in it, in order, and then stop without consuming the partial one.
+//
+
+TEST(truncated_frames_yield_complete_prefix)
+{
+    uint64_t seed = 0x1f83d9abfb41bd6bULL;
+
+    for (int round = 0; round < 500; ++round) {
+        struct sa_buffer buffer;
+        struct sa_command sent[64];
+        uint32_t ends[64];
+        int count = 1 + test_rand(&seed) % array_count(sent);
+
+        sa_buffer_init(&buffer);
+        for (int i = 0; i < count; ++i) {
+            random_command(&sent[i], 1 + test_rand(&seed) % (SA_OP_COUNT - 1), &seed);
+            sa_encode_command(&buffer, &sent[i]);
+            ends[i] = buffer.length;
+        }
+
+        uint32_t cut = test_rand(&seed) % (buffer.length + 1);
+        int complete = 0;
+        while (complete < count && ends[complete] <= cut) ++complete;
+
+        struct sa_reader reader;
+        struct sa_command command;
+        uint8_t *frame = copy_frame(buffer.data, cut);
+        sa_reader_init(&reader, frame, cut);
+
+        int decoded = 0, matched = 0;
+        while (sa_decode_command(&reader, &command)) {
+            matched += decoded < complete && command_equals(&sent[decoded], &command);
+            ++decoded;
+        }
+
+        expect_eq(decoded, complete);
+        expect_eq(matched, complete);
+        expect(reader.cursor == frame + (complete ? ends[complete - 1] : 0));
+
+        free(frame);
+    }
+}
+
+//
+// NOTE(koekeishiya): Random frames, biased towards valid opcodes so that decoding gets past the
+// first byte. Whatever is decoded has to stay inside the frame, and has to encode back to exactly
+// the bytes it was decoded from.
+//
+
+TEST(random_frames_decode_safely)
+{
+    uint64_t seed = 0x6a09e667f3bcc908ULL;
+    uint8_t bytes[SA_MAX_FRAME_SIZE];
+    int total_decoded = 0;
+
+    for (int round = 0; round < FUZZ_FRAMES; ++round) {
+        uint32_t length = test_rand(&seed) % 256;
+        for (uint32_t i = 0; i < length; ++i) {
+            uint64_t r = test_rand(&seed);
+            bytes[i] = r & 1 ? (uint8_t)(r >> 8) % (SA_OP_COUNT + 2) : (uint8_t)(r >> 8);
+        }
+
+        struct sa_reader reader;
+        struct sa_command command;
+        uint8_t *frame = copy_frame(bytes, length);
+        sa_reader_init(&reader, frame, length);
+
+        int mismatches = 0;
+        const uint8_t *start = reader.cursor;
+
+        while (sa_decode_command(&reader, &command)) {
+            struct sa_buffer buffer;
+            sa_buffer_init(&buffer);
+
+            if (!sa_encode_command(&buffer, &command) ||
+                buffer.length != (uint32_t)(reader.cursor - start) ||
+                memcmp(buffer.data, start, buffer.length) != 0) {
+                ++mismatches;
+            }
+
+            start = reader.cursor;
+            ++total_decoded;
+        }
+
+        expect_eq(mismatches, 0);
+        expect(reader.cursor <= reader.end);
+
+        free(frame);
+    }
+
+    expect(total_decoded > FUZZ_FRAMES / 2);
+}
+
+int main(int argc, char **argv)
+{
+    run_test(every_opcode_roundtrips);
+    run_test(encoding_is_little_endian_and_packed);
+    run_test(full_frame_roundtrips_in_order);
+    run_test(unknown_opcodes_are_rejected);
+    run_test(truncated_commands_are_rejected);
+    run_test(truncated_frames_yield_complete_prefix);
+    run_test(random_frames_decode_safely);
+
+    return test_report("protocol");
+}
@@ -0,0 +1,197 @@
+#ifndef SA_CLIENT_HARNESS_H
+#define SA_CLIENT_HARNESS_H
+
+#include "misc/socket.h"
+#include "misc/socket.c"
+#include "osax/sa.h"
+
+char g_sa_socket_file[MAXLEN];
+
+#include "osax/client.c"
+
+//
+// NOTE(koekeishiya): A stand-in for the payload that runs in a thread of the test itself. It
+// speaks the same protocol as payload.m: every frame is decoded and answered by exactly one
+// frame, which is empty unless the frame was a handshake. Instead of being applied, every
+// command is recorded together with the connection and the frame it arrived in. Connections are
+// served one at a time, which is all yabai ever opens.
+//
+
+struct harness_record
+{
+    uint32_t connection;
+    uint32_t frame;
+    struct sa_command command;
+};
+
+struct harness_payload
+{
+    int sockfd;
+    int client_sockfd;
+    bool is_running;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    struct harness_record *records;
+    volatile uint32_t connections;
+    volatile uint32_t frames;
+    volatile uint32_t malformed;
+};
+
+static struct harness_payload harness_payload;
+
+static void harness_payload_reply_handshake(int sockfd, uint16_t version)
+{
+    struct sa_buffer buffer;
+    sa_buffer_init(&buffer);
+
+    for (const char *at = OSAX_VERSION; *at; ++at) sa_put_u8(&buffer, *at);
+    sa_put_u8(&buffer, '\0');
+    sa_put_u32(&buffer, OSAX_ATTRIB_ALL);
+    sa_put_u16(&buffer, version < SA_PROTOCOL_VERSION ? version : SA_PROTOCOL_VERSION);
+
+    socket_write_frame(sockfd, (char *) buffer.data, buffer.length);
+}
+
+static void harness_payload_handle_frame(int sockfd, uint8_t *bytes, uint32_t length)
+{
+    struct sa_reader reader;
+    struct sa_command command;
+    bool is_handshake = false;
+
+    sa_reader_init(&reader, bytes, length);
+
+    pthread_mutex_lock(&harness_payload.lock);
+    while (sa_decode_command(&reader, &command)) {
+        buf_push(harness_payload.records, ((struct harness_record) {
+            .connection = harness_payload.connections,
+            .frame = harness_payload.frames,
+            .command = command
+        }));
+
+        if (command.op == SA_OP_HANDSHAKE) {
+            is_handshake = true;
+            break;
+        }
+    }
+
+    if (!is_handshake && !sa_reader_is_empty(&reader)) ++harness_payload.malformed;
+    pthread_mutex_unlock(&harness_payload.lock);
+
+    __atomic_add_fetch(&harness_payload.frames, 1, __ATOMIC_RELEASE);
+
+    if (is_handshake) {
+        harness_payload_reply_handshake(sockfd, command.handshake.version);
+    } else {
+        socket_write_frame(sockfd, NULL, 0);
+    }
+}
+
+static void *harness_payload_main(void *context)
+{
+    uint32_t length;
+    uint8_t frame[SA_MAX_FRAME_SIZE];
+
+    while (__atomic_load_n(&harness_payload.is_running, __ATOMIC_ACQUIRE)) {
+        int sockfd = accept(harness_payload.sockfd, NULL, NULL);
+        if (sockfd == -1) continue;
+
+        pthread_mutex_lock(&harness_payload.lock);
+        harness_payload.client_sockfd = sockfd;
+        pthread_mutex_unlock(&harness_payload.lock);
+        __atomic_add_fetch(&harness_payload.connections, 1, __ATOMIC_RELEASE);
+
+        while (socket_read_frame(sockfd, (char *) frame, sizeof(frame), &length)) {
+            harness_payload_handle_frame(sockfd, frame, length);
+        }
+
+        pthread_mutex_lock(&harness_payload.lock);
+        harness_payload.client_sockfd = -1;
+        pthread_mutex_unlock(&harness_payload.lock);
+        close(sockfd);
+    }
+
+    return NULL;
+}
+
+static bool harness_payload_begin(void)
+{
+    struct sockaddr_un socket_address;
+    socket_address.sun_family = AF_UNIX;
+
+    snprintf(socket_address.sun_path, sizeof(socket_address.sun_path), "/tmp/yabai-sa-harness_%d.socket", getpid());
+    snprintf(g_sa_socket_file, sizeof(g_sa_socket_file), "%s", socket_address.sun_path);
+    unlink(g_sa_socket_file);
+
+    signal(SIGPIPE, SIG_IGN);
+    memset(&harness_payload, 0, sizeof(harness_payload));
+    harness_payload.client_sockfd = -1;
+    pthread_mutex_init(&harness_payload.lock, NULL);
+
+    if ((harness_payload.sockfd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1) return false;
+    if (bind(harness_payload.sockfd, (struct sockaddr *) &socket_address, sizeof(socket_address)) == -1) return false;
+    if (listen(harness_payload.sockfd, SOMAXCONN) == -1) return false;
+
+    harness_payload.is_running = true;
+    return pthread_create(&harness_payload.thread, NULL, harness_payload_main, NULL) == 0;
+}
+
+//
+// NOTE(koekeishiya): Closes the connection that is currently being served, as if Dock.app had
+// been restarted, and returns once the payload is ready to accept a new one. Nothing is written
+// to the client, so it only notices once it touches the socket again.
+//
+
+static void harness_payload_drop_connection(void)
+{
+    pthread_mutex_lock(&harness_payload.lock);
+    if (harness_payload.client_sockfd != -1) shutdown(harness_payload.client_sockfd, SHUT_RDWR);
+    pthread_mutex_unlock(&harness_payload.lock);
+
+    for (;;) {
+        pthread_mutex_lock(&harness_payload.lock);
+        bool is_closed = harness_payload.client_sockfd == -1;
+        pthread_mutex_unlock(&harness_payload.lock);
+
+        if (is_closed) break;
+        usleep(100);
+    }
+}
+
+static bool harness_payload_wait_frames(uint32_t count)
+{
+    uint64_t deadline = test_now_ns() + 10ULL * 1000000000ULL;
+
+    while (__atomic_load_n(&harness_payload.frames, __ATOMIC_ACQUIRE) < count) {
+        if (test_now_ns() > deadline) return false;
+        usleep(50);
+    }
+
+    return true;
+}
+
+static void harness_payload_reset(void)
+{
+    pthread_mutex_lock(&harness_payload.lock);
+    buf_free(harness_payload.records);
+    harness_payload.records = NULL;
+    harness_payload.frames = 0;
+    harness_payload.malformed = 0;
+    pthread_mutex_unlock(&harness_payload.lock);
+}
+
+static void harness_payload_end(void)
+{
+    scripting_addition_disconnect();
+    __atomic_store_n(&harness_payload.is_running, false, __ATOMIC_RELEASE);
+
+    harness_payload_drop_connection();
+    shutdown(harness_payload.sockfd, SHUT_RDWR);
+    pthread_join(harness_payload.thread, NULL);
+
+    close(harness_payload.sockfd);
+    unlink(g_sa_socket_file);
+    buf_free(harness_payload.records);
+    harness_payload.records = NULL;
+}
+
+#endif
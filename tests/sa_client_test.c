@@ -0,0 +1,194 @@
+#include "test.h"
+#include "sa_client_harness.h"
+
+#define MOVES_PER_FRAME (SA_MAX_FRAME_SIZE / 13)
+
+static struct harness_record *record(int index)
+{
+    return index < buf_len(harness_payload.records) ? &harness_payload.records[index] : NULL;
+}
+
+static int count_in_order(uint8_t op, int first, int count, uint32_t first_wid)
+{
+    int result = 0;
+
+    for (int i = 0; i < count; ++i) {
+        struct harness_record *r = record(first + i);
+        result += r && r->command.op == op && r->command.window.wid == first_wid + i;
+    }
+
+    return result;
+}
+
+static void begin(void)
+{
+    scripting_addition_disconnect();
+    harness_payload_drop_connection();
+    harness_payload_reset();
+}
+
+TEST(full_frame_is_sent_mid_batch)
+{
+    int count = MOVES_PER_FRAME + 100;
+    begin();
+
+    scripting_addition_begin_batch();
+    scripting_addition_begin_batch();
+    for (int i = 0; i < count; ++i) {
+        expect(scripting_addition_move_window(i + 1, i, i));
+    }
+
+    //
+    // NOTE(koekeishiya): The first frame went out the moment the next move did not fit; the rest
+    // is still held back, also by the inner end_batch, until the outermost batch ends.
+    //
+
+    expect(harness_payload_wait_frames(1));
+    usleep(10000);
+    expect_eq(harness_payload.frames, 1);
+    expect_eq(buf_len(harness_payload.records), MOVES_PER_FRAME);
+
+    scripting_addition_end_batch();
+    usleep(10000);
+    expect_eq(harness_payload.frames, 1);
+
+    scripting_addition_end_batch();
+    expect(harness_payload_wait_frames(2));
+
+    expect_eq(buf_len(harness_payload.records), count);
+    expect_eq(count_in_order(SA_OP_WINDOW_MOVE, 0, count, 1), count);
+    expect_eq(record(MOVES_PER_FRAME - 1)->frame, 0);
+    expect_eq(record(MOVES_PER_FRAME)->frame, 1);
+    expect_eq(harness_payload.malformed, 0);
+    expect_eq(sa_batch.length, 0);
+}
+
+TEST(waiting_command_flushes_batch_in_order)
+{
+    begin();
+
+    scripting_addition_begin_batch();
+    expect(scripting_addition_move_window(1, 0, 0));
+    expect(scripting_addition_set_opacity(2, 0.5f, 0.0f));
+    expect_eq(harness_payload.frames, 0);
+
+    //
+    // NOTE(koekeishiya): focus_window waits for its reply, so by the time it returns the payload
+    // has already received it, in the same frame as and after the commands queued before it.
+    //
+
+    expect(scripting_addition_focus_window(3));
+    expect_eq(harness_payload.frames, 1);
+    expect_eq(buf_len(harness_payload.records), 3);
+    expect_eq(sa_pending, 0);
+
+    expect(scripting_addition_move_window(4, 0, 0));
+    scripting_addition_end_batch();
+    expect(harness_payload_wait_frames(2));
+
+    int frames[] = { 0, 0, 0, 1 };
+    uint8_t ops[] = { SA_OP_WINDOW_MOVE, SA_OP_WINDOW_ALPHA_FADE, SA_OP_WINDOW_FOCUS, SA_OP_WINDOW_MOVE };
+
+    expect_eq(buf_len(harness_payload.records), 4);
+    for (int i = 0; i < array_count(ops); ++i) {
+        struct harness_record *r = record(i);
+        expect(r && r->command.op == ops[i] && r->command.window.wid == (uint32_t) i + 1 && r->frame == frames[i]);
+    }
+}
+
+TEST(failed_write_reconnects_and_retries)
+{
+    begin();
+
+    expect(scripting_addition_focus_window(1));
+    uint32_t connection = harness_payload.connections;
+
+    harness_payload_drop_connection();
+    expect(scripting_addition_focus_window(2));
+    expect_eq(harness_payload.connections, connection + 1);
+
+    harness_payload_drop_connection();
+    expect(scripting_addition_move_window(3, 0, 0));
+    expect(harness_payload_wait_frames(3));
+    expect_eq(harness_payload.connections, connection + 2);
+
+    //
+    // NOTE(koekeishiya): The connection is also lost while a batch is open; the batch is
+    // written when it ends, which is when the client notices and reconnects.
+    //
+
+    scripting_addition_begin_batch();
+    expect(scripting_addition_move_window(4, 0, 0));
+    harness_payload_drop_connection();
+    expect(scripting_addition_move_window(5, 0, 0));
+    scripting_addition_end_batch();
+    expect(harness_payload_wait_frames(4));
+    expect_eq(harness_payload.connections, connection + 3);
+
+    expect_eq(buf_len(harness_payload.records), 5);
+    expect_eq(count_in_order(SA_OP_WINDOW_FOCUS, 0, 2, 1), 2);
+    expect_eq(count_in_order(SA_OP_WINDOW_MOVE, 2, 3, 3), 3);
+    expect_eq(record(0)->connection, connection);
+    expect_eq(record(1)->connection, connection + 1);
+    expect_eq(record(2)->connection, connection + 2);
+    expect_eq(record(3)->connection, connection + 3);
+    expect_eq(record(4)->connection, connection + 3);
+    expect_eq(record(4)->frame, record(3)->frame);
+}
+
+TEST(handshake_inside_open_batch)
+{
+    char version[MAXLEN] = {0};
+    uint32_t attrib = 0;
+
+    begin();
+    uint32_t connection = harness_payload.connections + 1;
+
+    scripting_addition_begin_batch();
+    expect(scripting_addition_move_window(1, 0, 0));
+    expect(scripting_addition_move_window(2, 0, 0));
+
+    //
+    // NOTE(koekeishiya): The handshake has to go out on its own, on a fresh connection, and its
+    // reply must not be mistaken for the reply to the batch that was still open.
+    //
+
+    expect(scripting_addition_request_handshake(version, &attrib));
+    expect_str(version, OSAX_VERSION);
+    expect_eq(attrib, OSAX_ATTRIB_ALL);
+    expect_eq(sa_protocol_version, SA_PROTOCOL_VERSION);
+    expect_eq(sa_pending, 0);
+    expect_eq(harness_payload.connections, connection + 1);
+
+    expect(scripting_addition_move_window(3, 0, 0));
+    scripting_addition_end_batch();
+    expect(harness_payload_wait_frames(3));
+
+    expect_eq(buf_len(harness_payload.records), 4);
+    expect_eq(count_in_order(SA_OP_WINDOW_MOVE, 0, 2, 1), 2);
+    expect_eq(record(0)->connection, connection);
+    expect_eq(record(1)->frame, 0);
+    expect(record(2)->command.op == SA_OP_HANDSHAKE);
+    expect_eq(record(2)->command.handshake.version, SA_PROTOCOL_VERSION);
+    expect_eq(record(2)->connection, connection + 1);
+    expect_eq(record(2)->frame, 1);
+    expect_eq(count_in_order(SA_OP_WINDOW_MOVE, 3, 1, 3), 1);
+    expect_eq(record(3)->connection, connection + 1);
+    expect_eq(record(3)->frame, 2);
+
+    expect(scripting_addition_focus_window(4));
+    expect_eq(harness_payload.connections, connection + 1);
+}
+
+int main(int argc, char **argv)
+{
+    expect(harness_payload_begin());
+
+    run_test(full_frame_is_sent_mid_batch);
+    run_test(waiting_command_flushes_batch_in_order);
+    run_test(failed_write_reconnects_and_retries);
+    run_test(handshake_inside_open_batch);
+
+    harness_payload_end();
+    return test_report("sa_client");
+}
@@ -0,0 +1,366 @@
+#include "test.h"
+#include "misc/socket.h"
+#include "misc/socket.c"
+
+#include <sys/resource.h>
+
+#define CLIENTS         300
+#define SLOWLORIS       200
+#define TRICKLERS       20
+#define MAX_CLIENTS     SOCKET_DAEMON_MAX_CLIENTS
+#define CLIENT_TIMEOUT  400
+
+#define REPLY_PREFIX    "ok:"
+#define TIMEOUT_REPLY   FAILURE_MESSAGE"timed out waiting for message\n"
+#define REJECT_REPLY    FAILURE_MESSAGE"too many clients, try again\n"
+
+static struct daemon g_daemon;
+static char socket_file[MAXLEN];
+static volatile uint32_t handled;
+static volatile uint32_t handled_empty;
+
+//
+// NOTE(koekeishiya): Answers like the daemon does: the message is echoed back after a prefix,
+// and the socket, which the handler owns from here on, is closed.
+//
+
+static SOCKET_DAEMON_HANDLER(echo_handler)
+{
+    char reply[MAXLEN];
+    __atomic_add_fetch(&handled, 1, __ATOMIC_RELEASE);
+
+    if (!message || !length) {
+        __atomic_add_fetch(&handled_empty, 1, __ATOMIC_RELAXED);
+    } else {
+        snprintf(reply, sizeof(reply), REPLY_PREFIX"%.*s", length, message);
+        socket_write(sockfd, reply);
+    }
+
+    socket_close(sockfd);
+    free(message);
+}
+
+static int daemon_client_count(void)
+{
+    return __atomic_load_n(&g_daemon.client_count, __ATOMIC_ACQUIRE);
+}
+
+static bool wait_for_client_count(int count)
+{
+    uint64_t deadline = test_now_ns() + 10ULL * 1000000000ULL;
+
+    while (daemon_client_count() != count) {
+        if (test_now_ns() > deadline) return false;
+        usleep(500);
+    }
+
+    return true;
+}
+
+static int connect_client(void)
+{
+    int sockfd;
+    if (!socket_connect_un(&sockfd, socket_file)) {
+        if (sockfd != -1) close(sockfd);
+        return -1;
+    }
+
+    return sockfd;
+}
+
+//
+// NOTE(koekeishiya): Reads until the daemon closes the connection, which it does after every
+// reply, so this never returns a partial reply.
+//
+
+static int read_reply(int sockfd, char *buffer, int size)
+{
+    int length = 0;
+
+    while (length < size - 1) {
+        ssize_t bytes = recv(sockfd, buffer + length, size - 1 - length, 0);
+        if (bytes <= 0) break;
+        length += bytes;
+    }
+
+    buffer[length] = '\0';
+    return length;
+}
+
+//
+// NOTE(koekeishiya): Connections that the daemon has not accepted yet wait in the backlog of the
+// listening socket; once it gets to them, the excess ones are answered and closed right away.
+// Returns the number of connections that have a reply waiting, once that reaches count.
+//
+
+static int wait_for_replies(int *sockfd, int count, int expected)
+{
+    struct pollfd fds[CLIENTS];
+    uint64_t deadline = test_now_ns() + 10ULL * 1000000000ULL;
+    int ready = 0;
+
+    for (int i = 0; i < count; ++i) {
+        fds[i] = (struct pollfd) { sockfd[i], POLLIN, 0 };
+    }
+
+    while (test_now_ns() < deadline) {
+        if (poll(fds, count, 100) == -1) break;
+
+        ready = 0;
+        for (int i = 0; i < count; ++i) ready += fds[i].revents != 0;
+        if (ready >= expected) break;
+    }
+
+    return ready;
+}
+
+static void begin(void)
+{
+    handled = 0;
+    handled_empty = 0;
+
+    memset(&g_daemon, 0, sizeof(g_daemon));
+    g_daemon.limits.max_clients = MAX_CLIENTS;
+    g_daemon.limits.client_timeout = CLIENT_TIMEOUT;
+
+    snprintf(socket_file, sizeof(socket_file), "/tmp/yabai-daemon-test_%d.socket", getpid());
+    expect(socket_daemon_begin_un(&g_daemon, socket_file, echo_handler));
+}
+
+static void end(void)
+{
+    socket_daemon_end(&g_daemon);
+    unlink(socket_file);
+}
+
+struct trickler
+{
+    int *sockfd;
+    int count;
+    volatile bool is_done;
+};
+
+static void *trickler_main(void *context)
+{
+    struct trickler *trickler = context;
+
+    while (!trickler->is_done) {
+        for (int i = 0; i < trickler->count; ++i) {
+            send(trickler->sockfd[i], "w", 1, MSG_NOSIGNAL);
+        }
+
+        usleep(CLIENT_TIMEOUT * 1000 / 8);
+    }
+
+    return NULL;
+}
+
+//
+// NOTE(koekeishiya): Slowloris clients connect and send part of a message, and never finish it;
+// some of them keep trickling a byte at a time. While they hold their slots, the remaining slots
+// must keep serving regular clients without any delay. Every stalled client is then disconnected
+// once its timeout expires, trickling or not, and none of them ever reaches the handler.
+//
+
+TEST(slowloris_clients_time_out_without_blocking_others)
+{
+    int slow[SLOWLORIS];
+    char reply[MAXLEN];
+    struct trickler trickler = { slow, TRICKLERS, false };
+    pthread_t trickler_thread;
+
+    begin();
+
+    uint64_t slow_start = test_now_ns();
+    int slow_connected = 0;
+    for (int i = 0; i < SLOWLORIS; ++i) {
+        slow[i] = connect_client();
+        slow_connected += slow[i] != -1 && send(slow[i], "query --win", 11, MSG_NOSIGNAL) == 11;
+    }
+
+    expect_eq(slow_connected, SLOWLORIS);
+    expect(wait_for_client_count(SLOWLORIS));
+    pthread_create(&trickler_thread, NULL, trickler_main, &trickler);
+
+    //
+    // NOTE(koekeishiya): The regular clients run in waves small enough to fit in the slots that
+    // are left, so every one of them must be served.
+    //
+
+    int wave = MAX_CLIENTS - SLOWLORIS;
+    int served = 0;
+    uint64_t clients_start = test_now_ns();
+
+    for (int first = 0; first < CLIENTS; first += wave) {
+        int sockfd[CLIENTS];
+        int count = min(wave, CLIENTS - first);
+
+        for (int i = 0; i < count; ++i) {
+            char message[64];
+            int length = snprintf(message, sizeof(message), "query --windows --window %d", first + i);
+
+            sockfd[i] = connect_client();
+            socket_write_bytes(sockfd[i], message, length);
+            shutdown(sockfd[i], SHUT_WR);
+        }
+
+        for (int i = 0; i < count; ++i) {
+            char expected[64];
+            snprintf(expected, sizeof(expected), REPLY_PREFIX"query --windows --window %d", first + i);
+
+            read_reply(sockfd[i], reply, sizeof(reply));
+            served += strcmp(reply, expected) == 0;
+            close(sockfd[i]);
+        }
+    }
+
+    uint64_t clients_elapsed_ms = (test_now_ns() - clients_start) / 1000000;
+    expect_eq(served, CLIENTS);
+    expect(clients_elapsed_ms < CLIENT_TIMEOUT);
+    expect(wait_for_client_count(SLOWLORIS));
+
+    int timed_out = 0;
+    for (int i = 0; i < SLOWLORIS; ++i) {
+        read_reply(slow[i], reply, sizeof(reply));
+        timed_out += strcmp(reply, TIMEOUT_REPLY) == 0;
+    }
+
+    uint64_t slow_elapsed_ms = (test_now_ns() - slow_start) / 1000000;
+    trickler.is_done = true;
+    pthread_join(trickler_thread, NULL);
+
+    expect_eq(timed_out, SLOWLORIS);
+    expect(slow_elapsed_ms >= CLIENT_TIMEOUT);
+    expect(slow_elapsed_ms < CLIENT_TIMEOUT + 2000);
+    expect(wait_for_client_count(0));
+    expect_eq(handled, CLIENTS);
+    expect_eq(handled_empty, 0);
+
+    for (int i = 0; i < SLOWLORIS; ++i) close(slow[i]);
+    end();
+}
+
+//
+// NOTE(koekeishiya): All regular clients connect before any of them sends its message, while the
+// slowloris clients are still holding their slots. Exactly the slots that are left are handed
+// out; everyone else is told to try again and disconnected right away, instead of being queued
+// behind the stalled clients. Once those have timed out, every slot is available again.
+//
+
+TEST(clients_beyond_max_clients_are_rejected)
+{
+    int slow[SLOWLORIS];
+    int sockfd[CLIENTS];
+    char reply[MAXLEN];
+
+    begin();
+
+    for (int i = 0; i < SLOWLORIS; ++i) {
+        slow[i] = connect_client();
+        send(slow[i], "query", 5, MSG_NOSIGNAL);
+    }
+
+    expect(wait_for_client_count(SLOWLORIS));
+
+    for (int i = 0; i < CLIENTS; ++i) {
+        sockfd[i] = connect_client();
+    }
+
+    expect(wait_for_client_count(MAX_CLIENTS));
+    expect_eq(wait_for_replies(sockfd, CLIENTS, CLIENTS - (MAX_CLIENTS - SLOWLORIS)), CLIENTS - (MAX_CLIENTS - SLOWLORIS));
+
+    int accepted = 0, rejected = 0;
+    for (int i = 0; i < CLIENTS; ++i) {
+        socket_write_bytes(sockfd[i], "query --spaces", 14);
+        shutdown(sockfd[i], SHUT_WR);
+    }
+
+    for (int i = 0; i < CLIENTS; ++i) {
+        read_reply(sockfd[i], reply, sizeof(reply));
+        accepted += strcmp(reply, REPLY_PREFIX"query --spaces") == 0;
+        rejected += strcmp(reply, REJECT_REPLY) == 0;
+        close(sockfd[i]);
+    }
+
+    expect_eq(accepted, MAX_CLIENTS - SLOWLORIS);
+    expect_eq(rejected, CLIENTS - (MAX_CLIENTS - SLOWLORIS));
+    expect_eq(handled, MAX_CLIENTS - SLOWLORIS);
+
+    int timed_out = 0;
+    for (int i = 0; i < SLOWLORIS; ++i) {
+        read_reply(slow[i], reply, sizeof(reply));
+        timed_out += strcmp(reply, TIMEOUT_REPLY) == 0;
+        close(slow[i]);
+    }
+
+    expect_eq(timed_out, SLOWLORIS);
+    expect(wait_for_client_count(0));
+
+    for (int i = 0; i < MAX_CLIENTS; ++i) {
+        sockfd[i] = connect_client();
+    }
+
+    expect(wait_for_client_count(MAX_CLIENTS));
+
+    accepted = 0;
+    for (int i = 0; i < MAX_CLIENTS; ++i) {
+        socket_write_bytes(sockfd[i], "query --spaces", 14);
+        shutdown(sockfd[i], SHUT_WR);
+        read_reply(sockfd[i], reply, sizeof(reply));
+        accepted += strcmp(reply, REPLY_PREFIX"query --spaces") == 0;
+        close(sockfd[i]);
+    }
+
+    expect_eq(accepted, MAX_CLIENTS);
+    expect_eq(handled, 2 * MAX_CLIENTS - SLOWLORIS);
+
+    end();
+}
+
+//
+// NOTE(koekeishiya): A client that connects and closes without sending anything never reaches
+// the handler, and a slot that was held by a stalled client can be reused after it times out.
+//
+
+TEST(idle_client_does_not_reach_handler)
+{
+    char reply[MAXLEN];
+    begin();
+
+    int sockfd = connect_client();
+    expect(wait_for_client_count(1));
+    close(sockfd);
+    expect(wait_for_client_count(0));
+
+    sockfd = connect_client();
+    expect(wait_for_client_count(1));
+    expect(read_reply(sockfd, reply, sizeof(reply)) > 0);
+    expect_str(reply, TIMEOUT_REPLY);
+    close(sockfd);
+
+    expect(wait_for_client_count(0));
+    expect_eq(handled, 0);
+
+    end();
+}
+
+int main(int argc, char **argv)
+{
+    struct rlimit limit;
+
+    //
+    // NOTE(koekeishiya): Both ends of every connection live in this process.
+    //
+
+    signal(SIGPIPE, SIG_IGN);
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < 4096) {
+        limit.rlim_cur = limit.rlim_max < 4096 ? limit.rlim_max : 4096;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    run_test(slowloris_clients_time_out_without_blocking_others);
+    run_test(clients_beyond_max_clients_are_rejected);
+    run_test(idle_client_does_not_reach_handler);
+
+    return test_report("socket_daemon");
+}
@@ -0,0 +1,101 @@
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <semaphore.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <math.h>
+#include <limits.h>
+
+#include "misc/macros.h"
+#include "misc/log.h"
+#include "misc/sbuffer.h"
+
+bool g_verbose;
+
+//
+// NOTE(koekeishiya): Every test is a single translation unit that includes the sources it
+// covers, the same way manifest.m builds the daemon. A failed expectation is reported and the
+// test keeps going, so that one run shows every failure; main returns the failure count.
+//
+
+static int test_failures;
+static int test_checks;
+
+#define expect(x) \
+    do { \
+        ++test_checks; \
+        if (!(x)) { \
+            ++test_failures; \
+            fprintf(stderr, "%s:%d: %s: expected %s\n", __FILE__, __LINE__, __FUNCTION__, #x); \
+        } \
+    } while (0)
+
+#define expect_eq(a, b) \
+    do { \
+        long long _a = (long long)(a), _b = (long long)(b); \
+        ++test_checks; \
+        if (_a != _b) { \
+            ++test_failures; \
+            fprintf(stderr, "%s:%d: %s: expected %s == %s (%lld != %lld)\n", __FILE__, __LINE__, __FUNCTION__, #a, #b, _a, _b); \
+        } \
+    } while (0)
+
+#define expect_str(a, b) \
+    do { \
+        const char *_a = (a), *_b = (b); \
+        ++test_checks; \
+        if (!_a || !_b || strcmp(_a, _b) != 0) { \
+            ++test_failures; \
+            fprintf(stderr, "%s:%d: %s: expected \"%s\" == \"%s\"\n", __FILE__, __LINE__, __FUNCTION__, _a ? _a : "(null)", _b ? _b : "(null)"); \
+        } \
+    } while (0)
+
+#define TEST(name) static void name(void)
+
+#define run_test(name) \
+    do { \
+        int _failures = test_failures; \
+        name(); \
+        printf("%-48s %s\n", #name, test_failures == _failures ? "ok" : "FAILED"); \
+    } while (0)
+
+static inline int test_report(const char *suite)
+{
+    printf("%s: %d checks, %d failures\n", suite, test_checks, test_failures);
+    return test_failures != 0;
+}
+
+static inline uint64_t test_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+//
+// NOTE(koekeishiya): Deterministic xorshift generator, so that a failing randomized test can
+// be reproduced from the seed it prints.
+//
+
+static inline uint64_t test_rand(uint64_t *state)
+{
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+#endif
@@ -0,0 +1,165 @@
+#ifndef VIEW_NODE_HARNESS_H
+#define VIEW_NODE_HARNESS_H
+
+#include "compat.h"
+
+#define HASHTABLE_IMPLEMENTATION
+#include "misc/hashtable.h"
+#undef HASHTABLE_IMPLEMENTATION
+#include "misc/json.h"
+
+#include "view.h"
+
+//
+// NOTE(koekeishiya): Same definition as misc/helpers.h, which can not be included here because
+// it depends on the accessibility API.
+//
+
+static inline int euclidean_distance(CGPoint p1, CGPoint p2)
+{
+    int dx = p1.x - p2.x;
+    int dy = p1.y - p2.y;
+    return dx*dx + dy*dy;
+}
+
+#include "view_node.c"
+
+//
+// NOTE(koekeishiya): The directional query as it was before the edge index: a walk over every
+// leaf, keeping the first closest leaf that lies entirely in the requested direction. The index
+// must return exactly the same node.
+//
+
+static struct window_node *harness_find_window_node_in_direction(struct view *view, struct window_node *source, int direction)
+{
+    int best_distance = INT_MAX;
+    struct window_node *best_node = NULL;
+    CGPoint source_point = area_center(source->area);
+
+    struct window_node *target = window_node_find_first_leaf(view->root);
+    while (target) {
+        CGPoint target_point = area_center(target->area);
+        int distance = euclidean_distance(source_point, target_point);
+        if (distance >= best_distance) goto next;
+
+        switch (direction) {
+        case DIR_EAST: {
+            if (target->area.x >= source->area.x + source->area.w) {
+                best_node = target;
+                best_distance = distance;
+            }
+        } break;
+        case DIR_SOUTH: {
+            if (target->area.y >= source->area.y + source->area.h) {
+                best_node = target;
+                best_distance = distance;
+            }
+        } break;
+        case DIR_WEST: {
+            if (target->area.x + target->area.w <= source->area.x) {
+                best_node = target;
+                best_distance = distance;
+            }
+        } break;
+        case DIR_NORTH: {
+            if (target->area.y + target->area.h <= source->area.y) {
+                best_node = target;
+                best_distance = distance;
+            }
+        } break;
+        }
+
+next:
+        target = window_node_find_next_leaf(target);
+    }
+
+    return best_node;
+}
+
+//
+// NOTE(koekeishiya): Builds a layout of leaf_count leaves by repeatedly splitting a random leaf,
+// the way windows are inserted, with the split rules of area_make_pair. With random_ratio unset
+// every split is even, which produces many leaves at equal distance from each other. A leaf is
+// only split along a side of at least HARNESS_MIN_SPLIT points, so that no leaf ends up with a
+// negative size, which a real layout never has either.
+//
+
+#define HARNESS_MIN_SPLIT 40.0f
+
+static struct window_node *harness_build_layout(struct view *view, int leaf_count, float gap, bool random_ratio, uint64_t *seed)
+{
+    struct window_node **leaves = malloc(sizeof(struct window_node *) * leaf_count);
+    struct window_node *root = window_node_create(view);
+
+    root->area = (struct area) { 0, 25, 2560, 1415 };
+    root->window_list[0] = root->window_order[0] = 1;
+    root->window_count = 1;
+    leaves[0] = root;
+
+    for (int i = 1; i < leaf_count; ++i) {
+        int index = test_rand(seed) % i;
+        while (leaves[index]->area.w < HARNESS_MIN_SPLIT && leaves[index]->area.h < HARNESS_MIN_SPLIT) {
+            index = (index + 1) % i;
+        }
+
+        struct window_node *node = leaves[index];
+        struct window_node *left = window_node_create(view);
+        struct window_node *right = window_node_create(view);
+
+        left->window_list[0] = left->window_order[0] = node->window_list[0];
+        left->window_count = 1;
+        right->window_list[0] = right->window_order[0] = i + 1;
+        right->window_count = 1;
+        left->parent = right->parent = node;
+
+        node->window_count = 0;
+        node->left = left;
+        node->right = right;
+        node->split = test_rand(seed) % 3 == 0 ? (node->area.w >= node->area.h ? SPLIT_X : SPLIT_Y) : (node->area.w >= node->area.h ? SPLIT_Y : SPLIT_X);
+        if (node->split == SPLIT_Y && node->area.w < HARNESS_MIN_SPLIT) node->split = SPLIT_X;
+        if (node->split == SPLIT_X && node->area.h < HARNESS_MIN_SPLIT) node->split = SPLIT_Y;
+        node->ratio = random_ratio ? 0.2f + (test_rand(seed) % 61) / 100.0f : 0.5f;
+
+        left->area = right->area = node->area;
+        if (node->split == SPLIT_Y) {
+            left->area.w = node->area.w * node->ratio - gap;
+            right->area.x += node->area.w * node->ratio + gap;
+            right->area.w = node->area.w * (1 - node->ratio) - gap;
+        } else {
+            left->area.h = node->area.h * node->ratio - gap;
+            right->area.y += node->area.h * node->ratio + gap;
+            right->area.h = node->area.h * (1 - node->ratio) - gap;
+        }
+
+        leaves[index] = left;
+        leaves[i] = right;
+    }
+
+    free(leaves);
+    view->root = root;
+    view->edge_index.is_dirty = true;
+    return root;
+}
+
+static void harness_destroy_layout(struct view *view, struct window_node *node)
+{
+    if (node->left)  harness_destroy_layout(view, node->left);
+    if (node->right) harness_destroy_layout(view, node->right);
+    window_node_release(view, node);
+}
+
+static void harness_view_free(struct view *view)
+{
+    for (struct window_node_chunk *chunk = view->pool.chunks, *next; chunk; chunk = next) {
+        next = chunk->next;
+        free(chunk);
+    }
+
+    for (int dir = 0; dir < EDGE_DIR_COUNT; ++dir) {
+        free(view->edge_index.edges[dir]);
+    }
+
+    memset(view, 0, sizeof(struct view));
+}
+
+#endif
@@ -0,0 +1,173 @@
+#include "test.h"
+#include "view_node_harness.h"
+
+static int directions[] = { DIR_NORTH, DIR_EAST, DIR_SOUTH, DIR_WEST };
+
+static int collect_leaves(struct view *view, struct window_node **leaves)
+{
+    int count = 0;
+
+    for (struct window_node *node = window_node_find_first_leaf(view->root); node; node = window_node_find_next_leaf(node)) {
+        leaves[count++] = node;
+    }
+
+    return count;
+}
+
+static int count_mismatches(struct view *view, struct window_node **leaves, int count)
+{
+    int mismatches = 0;
+
+    for (int i = 0; i < count; ++i) {
+        for (int d = 0; d < array_count(directions); ++d) {
+            struct window_node *expected = harness_find_window_node_in_direction(view, leaves[i], directions[d]);
+            struct window_node *actual = view_find_window_node_in_direction(view, leaves[i], directions[d]);
+            mismatches += expected != actual;
+        }
+    }
+
+    return mismatches;
+}
+
+TEST(pool_reuses_released_nodes)
+{
+    struct view view = {0};
+    struct window_node *nodes[NODE_POOL_CHUNK_SIZE + 1];
+
+    for (int i = 0; i < array_count(nodes); ++i) {
+        nodes[i] = window_node_create(&view);
+        nodes[i]->window_list[0] = i + 1;
+        nodes[i]->window_count = 1;
+        nodes[i]->feedback_window->id = i + 1;
+    }
+
+    int chunks = 0;
+    for (struct window_node_chunk *chunk = view.pool.chunks; chunk; chunk = chunk->next) ++chunks;
+    expect_eq(chunks, 2);
+
+    int distinct_data = 0;
+    for (int i = 0; i < array_count(nodes); ++i) {
+        distinct_data += nodes[i]->window_list[0] == (uint32_t)(i + 1);
+    }
+    expect_eq(distinct_data, array_count(nodes));
+
+    window_node_release(&view, nodes[3]);
+    struct window_node *reused = window_node_create(&view);
+
+    expect(reused == nodes[3]);
+    expect_eq(reused->window_count, 0);
+    expect(reused->parent == NULL);
+    expect(reused->window_list != NULL);
+    expect_eq(reused->feedback_window->id, 0);
+
+    harness_view_free(&view);
+}
+
+TEST(leaf_walk_visits_every_leaf_once)
+{
+    struct view view = {0};
+    struct window_node *leaves[512];
+    uint64_t seed = 0x106689d45497fdb5ULL;
+
+    harness_build_layout(&view, 300, 4.0f, true, &seed);
+
+    int count = collect_leaves(&view, leaves);
+    expect_eq(count, 300);
+    expect(leaves[count - 1] == window_node_find_last_leaf(view.root));
+
+    int are_leaves = 0;
+    uint64_t window_sum = 0;
+    for (int i = 0; i < count; ++i) {
+        are_leaves += window_node_is_leaf(leaves[i]);
+        window_sum += leaves[i]->window_list[0];
+    }
+
+    expect_eq(are_leaves, 300);
+    expect_eq(window_sum, 300 * 301 / 2);
+
+    harness_destroy_layout(&view, view.root);
+    harness_view_free(&view);
+}
+
+//
+// NOTE(koekeishiya): Even splits put many leaves at the same distance from the source, which
+// exercises the tie-breaking; random ratios and gaps exercise the pruning of the sorted walk.
+//
+
+TEST(edge_index_matches_linear_walk)
+{
+    int leaf_counts[] = { 1, 2, 4, 7, 16, 33, 100, 250, 1000 };
+    struct window_node **leaves = malloc(sizeof(struct window_node *) * 1000);
+
+    for (int i = 0; i < array_count(leaf_counts); ++i) {
+        for (int variant = 0; variant < 4; ++variant) {
+            struct view view = {0};
+            uint64_t seed = 0x9e3779b97f4a7c15ULL * (i + 1) + variant;
+            float gap = variant & 1 ? 0.0f : 4.5f;
+            bool random_ratio = variant & 2;
+
+            harness_build_layout(&view, leaf_counts[i], gap, random_ratio, &seed);
+            int count = collect_leaves(&view, leaves);
+
+            expect_eq(count, leaf_counts[i]);
+            expect_eq(count_mismatches(&view, leaves, count), 0);
+            expect_eq(view.edge_index.count, count);
+
+            harness_destroy_layout(&view, view.root);
+            harness_view_free(&view);
+        }
+    }
+
+    free(leaves);
+}
+
+TEST(edge_index_is_rebuilt_after_layout_change)
+{
+    struct view view = {0};
+    struct window_node *leaves[64];
+    uint64_t seed = 0x5851f42d4c957f2dULL;
+
+    harness_build_layout(&view, 64, 0.0f, true, &seed);
+    int count = collect_leaves(&view, leaves);
+    expect_eq(count_mismatches(&view, leaves, count), 0);
+    expect(!view.edge_index.is_dirty);
+
+    //
+    // NOTE(koekeishiya): Mirror the layout horizontally; every east neighbour becomes a west
+    // neighbour, so a stale index would answer almost every query wrong.
+    //
+
+    for (int i = 0; i < count; ++i) {
+        leaves[i]->area.x = 2560 - (leaves[i]->area.x + leaves[i]->area.w);
+    }
+
+    view.edge_index.is_dirty = true;
+    expect_eq(count_mismatches(&view, leaves, count), 0);
+
+    harness_destroy_layout(&view, view.root);
+    harness_view_free(&view);
+}
+
+TEST(edge_index_rejects_unknown_direction)
+{
+    struct view view = {0};
+    uint64_t seed = 1;
+
+    harness_build_layout(&view, 4, 0.0f, false, &seed);
+    expect(view_find_window_node_in_direction(&view, view.root->left, STACK) == NULL);
+    expect(view_find_window_node_in_direction(&view, view.root->left, 0) == NULL);
+
+    harness_destroy_layout(&view, view.root);
+    harness_view_free(&view);
+}
+
+int main(int argc, char **argv)
+{
+    run_test(pool_reuses_released_nodes);
+    run_test(leaf_walk_visits_every_leaf_once);
+    run_test(edge_index_matches_linear_walk);
+    run_test(edge_index_is_rebuilt_after_layout_change);
+    run_test(edge_index_rejects_unknown_direction);
+
+    return test_report("view_node");
+}